@@ -0,0 +1,614 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include "Sampling.h"
+
+// Object-space bounds of a model, see CalculateBoundingVolumes()
+struct SBoundingVolumes
+{
+	// Smallest sphere around the vertices
+	XMFLOAT3	SphereCenter{};
+	float		SphereRadius{ SBoundingSphere::KDefaultRadius };
+
+	XMFLOAT3	BoxMin{ -1, -1, -1 };
+	XMFLOAT3	BoxMax{ +1, +1, +1 };
+
+	// Unit axes and the half extents along them
+	XMFLOAT3	OrientedCenter{};
+	XMFLOAT3	OrientedAxes[3]{ { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+	XMFLOAT3	OrientedExtents{ 1, 1, 1 };
+
+	// How far PN-triangle tessellation can bulge out of the flat triangles.
+	// The edge control points are at most a third of an edge off the triangle and the center one half an edge, but their Bernstein weights
+	// never add up to more than a third of the longest edge: e/3 * (1 - u^2 - v^2 - w^2 + uv + vw + wu) <= e/3.
+	float		TessellationMargin{};
+};
+
+// An oriented box after a (possibly non-uniform) scaling, i.e. a parallelepiped: Center + sum of t_i * HalfAxes[i], t_i in [-1, 1]
+struct SOrientedBox
+{
+	XMVECTOR	Center{};
+	XMVECTOR	HalfAxes[3]{ XMVectorSet(1, 0, 0, 0), XMVectorSet(0, 1, 0, 0), XMVectorSet(0, 0, 1, 0) };
+};
+
+// Sphere: Ritter's approximation, then Welzl's exact minimum sphere with Ritter's extreme points tried first.
+// Oriented box: principal axes of the area-weighted triangle covariance (Gottschalk et al., "OBBTree", 1996), or the AABB when that is smaller.
+// A model without vertices keeps the defaults, the unit sphere (e.g. patches, see DSQuadSphere.hlsl).
+static SBoundingVolumes CalculateBoundingVolumes(const std::vector<SMesh>& vMeshes);
+// xyz: center, w: radius
+static XMFLOAT4 CalculateRitterSphere(const std::vector<XMFLOAT3>& vPoints, size_t(&OutExtremeIndices)[6]);
+static XMFLOAT4 CalculateMinimumSphere(const std::vector<XMFLOAT3>& vPoints, const size_t(&ExtremeIndices)[6]);
+
+// Margin and Bias (SBoundingSphere::RadiusBias) grow the box about its center before it is transformed
+static SOrientedBox TransformOrientedBox(const SBoundingVolumes& Volumes, float Margin, float Bias, const XMMATRIX& Matrix);
+static bool IsOrientedBoxOutsideFrustum(const XMVECTOR(&Planes)[6], const SOrientedBox& Box);
+// In the space of Volumes (object space); OutPtrT may be null
+static bool IntersectRayOrientedBox(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, const SBoundingVolumes& Volumes, float Margin, float* const OutPtrT);
+// Entry distance (0 if the origin is inside) in OutPtrT
+static bool IntersectRayAxisAlignedBox(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, const XMVECTOR& BoxMin, const XMVECTOR& BoxMax, float* const OutPtrT);
+
+namespace BoundingVolumeInternal
+{
+	struct SSphere
+	{
+		double	Center[3]{};
+		double	RadiusSq{ -1.0 };
+	};
+
+	static void Subtract(const double(&A)[3], const double(&B)[3], double(&Out)[3])
+	{
+		for (int i = 0; i < 3; ++i) Out[i] = A[i] - B[i];
+	}
+
+	static double Dot(const double(&A)[3], const double(&B)[3])
+	{
+		return A[0] * B[0] + A[1] * B[1] + A[2] * B[2];
+	}
+
+	static void Cross(const double(&A)[3], const double(&B)[3], double(&Out)[3])
+	{
+		Out[0] = A[1] * B[2] - A[2] * B[1];
+		Out[1] = A[2] * B[0] - A[0] * B[2];
+		Out[2] = A[0] * B[1] - A[1] * B[0];
+	}
+
+	static void ToDouble(const XMFLOAT3& Point, double(&Out)[3])
+	{
+		Out[0] = Point.x;
+		Out[1] = Point.y;
+		Out[2] = Point.z;
+	}
+
+	// Relative tolerance, so that the points that define a sphere count as inside it despite rounding
+	static bool IsOutside(const SSphere& Sphere, const XMFLOAT3& Point)
+	{
+		double P[3]{};
+		ToDouble(Point, P);
+		double D[3]{};
+		Subtract(P, Sphere.Center, D);
+		return Dot(D, D) > Sphere.RadiusSq * (1.0 + 1e-9) + 1e-18;
+	}
+
+	static SSphere MakeSphere(const XMFLOAT3& A)
+	{
+		SSphere Result{};
+		ToDouble(A, Result.Center);
+		Result.RadiusSq = 0.0;
+		return Result;
+	}
+
+	static SSphere MakeSphere(const XMFLOAT3& A, const XMFLOAT3& B)
+	{
+		double PA[3]{}, PB[3]{};
+		ToDouble(A, PA);
+		ToDouble(B, PB);
+
+		SSphere Result{};
+		for (int i = 0; i < 3; ++i) Result.Center[i] = (PA[i] + PB[i]) * 0.5;
+		double D[3]{};
+		Subtract(PA, Result.Center, D);
+		Result.RadiusSq = Dot(D, D);
+		return Result;
+	}
+
+	// Circumscribed sphere centered in the plane of the triangle; the largest two-point sphere if the points are collinear
+	static SSphere MakeSphere(const XMFLOAT3& A, const XMFLOAT3& B, const XMFLOAT3& C)
+	{
+		double PA[3]{}, PB[3]{}, PC[3]{};
+		ToDouble(A, PA);
+		ToDouble(B, PB);
+		ToDouble(C, PC);
+
+		double AB[3]{}, AC[3]{}, N[3]{};
+		Subtract(PB, PA, AB);
+		Subtract(PC, PA, AC);
+		Cross(AB, AC, N);
+		const double KDenominator{ 2.0 * Dot(N, N) };
+		if (KDenominator <= 1e-30 * Dot(AB, AB) * Dot(AC, AC) || KDenominator == 0.0)
+		{
+			const SSphere KSpheres[3]{ MakeSphere(A, B), MakeSphere(A, C), MakeSphere(B, C) };
+			const SSphere* PtrLargest{ &KSpheres[0] };
+			for (const SSphere& Sphere : KSpheres) if (Sphere.RadiusSq > PtrLargest->RadiusSq) PtrLargest = &Sphere;
+			return *PtrLargest;
+		}
+
+		// A + (|AC|^2 (N x AB) + |AB|^2 (AC x N)) / (2 |N|^2)
+		double NxAB[3]{}, ACxN[3]{};
+		Cross(N, AB, NxAB);
+		Cross(AC, N, ACxN);
+		const double KAB2{ Dot(AB, AB) };
+		const double KAC2{ Dot(AC, AC) };
+
+		SSphere Result{};
+		double Offset[3]{};
+		for (int i = 0; i < 3; ++i)
+		{
+			Offset[i] = (KAC2 * NxAB[i] + KAB2 * ACxN[i]) / KDenominator;
+			Result.Center[i] = PA[i] + Offset[i];
+		}
+		Result.RadiusSq = Dot(Offset, Offset);
+		return Result;
+	}
+
+	// Circumscribed sphere; the smallest of the triangle spheres that contains the fourth point if the points are coplanar
+	static SSphere MakeSphere(const XMFLOAT3& A, const XMFLOAT3& B, const XMFLOAT3& C, const XMFLOAT3& D)
+	{
+		double PA[3]{}, PB[3]{}, PC[3]{}, PD[3]{};
+		ToDouble(A, PA);
+		ToDouble(B, PB);
+		ToDouble(C, PC);
+		ToDouble(D, PD);
+
+		// Rows (X - A), right-hand side |X - A|^2 / 2
+		double Rows[3][3]{};
+		Subtract(PB, PA, Rows[0]);
+		Subtract(PC, PA, Rows[1]);
+		Subtract(PD, PA, Rows[2]);
+		const double KRHS[3]{ Dot(Rows[0], Rows[0]) * 0.5, Dot(Rows[1], Rows[1]) * 0.5, Dot(Rows[2], Rows[2]) * 0.5 };
+
+		double Cofactors[3][3]{};
+		Cross(Rows[1], Rows[2], Cofactors[0]);
+		Cross(Rows[2], Rows[0], Cofactors[1]);
+		Cross(Rows[0], Rows[1], Cofactors[2]);
+		const double KDeterminant{ Dot(Rows[0], Cofactors[0]) };
+		const double KScale{ sqrt(Dot(Rows[0], Rows[0]) * Dot(Rows[1], Rows[1]) * Dot(Rows[2], Rows[2])) };
+		if (fabs(KDeterminant) <= 1e-12 * KScale || KDeterminant == 0.0)
+		{
+			const SSphere KSpheres[4]{ MakeSphere(A, B, C), MakeSphere(A, B, D), MakeSphere(A, C, D), MakeSphere(B, C, D) };
+			const XMFLOAT3* const KOthers[4]{ &D, &C, &B, &A };
+			const SSphere* PtrBest{};
+			const SSphere* PtrLargest{ &KSpheres[0] };
+			for (int iSphere = 0; iSphere < 4; ++iSphere)
+			{
+				if (KSpheres[iSphere].RadiusSq > PtrLargest->RadiusSq) PtrLargest = &KSpheres[iSphere];
+				if (IsOutside(KSpheres[iSphere], *KOthers[iSphere])) continue;
+				if (!PtrBest || KSpheres[iSphere].RadiusSq < PtrBest->RadiusSq) PtrBest = &KSpheres[iSphere];
+			}
+			return PtrBest ? *PtrBest : *PtrLargest;
+		}
+
+		// Inverse = transposed cofactors / determinant
+		SSphere Result{};
+		double Offset[3]{};
+		for (int i = 0; i < 3; ++i)
+		{
+			Offset[i] = (Cofactors[0][i] * KRHS[0] + Cofactors[1][i] * KRHS[1] + Cofactors[2][i] * KRHS[2]) / KDeterminant;
+			Result.Center[i] = PA[i] + Offset[i];
+		}
+		Result.RadiusSq = Dot(Offset, Offset);
+		return Result;
+	}
+
+	// Cyclic Jacobi rotations; the columns of OutEigenvectors are the eigenvectors
+	static void DiagonalizeSymmetric(double(&Matrix)[3][3], double(&OutEigenvectors)[3][3])
+	{
+		for (int i = 0; i < 3; ++i) for (int j = 0; j < 3; ++j) OutEigenvectors[i][j] = (i == j) ? 1.0 : 0.0;
+
+		for (int iSweep = 0; iSweep < 32; ++iSweep)
+		{
+			const double KOffDiagonal{ fabs(Matrix[0][1]) + fabs(Matrix[0][2]) + fabs(Matrix[1][2]) };
+			const double KDiagonal{ fabs(Matrix[0][0]) + fabs(Matrix[1][1]) + fabs(Matrix[2][2]) };
+			if (KOffDiagonal <= 1e-15 * KDiagonal || KOffDiagonal == 0.0) break;
+
+			for (int P = 0; P < 2; ++P)
+			{
+				for (int Q = P + 1; Q < 3; ++Q)
+				{
+					if (Matrix[P][Q] == 0.0) continue;
+
+					const double KTheta{ (Matrix[Q][Q] - Matrix[P][P]) / (2.0 * Matrix[P][Q]) };
+					const double KT{ ((KTheta >= 0.0) ? 1.0 : -1.0) / (fabs(KTheta) + sqrt(KTheta * KTheta + 1.0)) };
+					const double KC{ 1.0 / sqrt(KT * KT + 1.0) };
+					const double KS{ KT * KC };
+
+					// Matrix = J^T Matrix J
+					for (int K = 0; K < 3; ++K)
+					{
+						const double KKP{ Matrix[K][P] };
+						const double KKQ{ Matrix[K][Q] };
+						Matrix[K][P] = KC * KKP - KS * KKQ;
+						Matrix[K][Q] = KS * KKP + KC * KKQ;
+					}
+					for (int K = 0; K < 3; ++K)
+					{
+						const double KPK{ Matrix[P][K] };
+						const double KQK{ Matrix[Q][K] };
+						Matrix[P][K] = KC * KPK - KS * KQK;
+						Matrix[Q][K] = KS * KPK + KC * KQK;
+					}
+					for (int K = 0; K < 3; ++K)
+					{
+						const double KKP{ OutEigenvectors[K][P] };
+						const double KKQ{ OutEigenvectors[K][Q] };
+						OutEigenvectors[K][P] = KC * KKP - KS * KKQ;
+						OutEigenvectors[K][Q] = KS * KKP + KC * KKQ;
+					}
+				}
+			}
+		}
+	}
+
+	// Half extents along the axes, and the center, of the points projected onto them
+	static float FitBoxToAxes(const std::vector<XMFLOAT3>& vPoints, const XMFLOAT3(&Axes)[3], XMFLOAT3& OutCenter, XMFLOAT3& OutExtents)
+	{
+		const XMVECTOR KAxes[3]{ XMLoadFloat3(&Axes[0]), XMLoadFloat3(&Axes[1]), XMLoadFloat3(&Axes[2]) };
+		const XMMATRIX KToAxes{ XMMatrixTranspose(XMMATRIX(KAxes[0], KAxes[1], KAxes[2], XMVectorSet(0, 0, 0, 1))) };
+		XMVECTOR Min{ XMVectorReplicate(+FLT_MAX) };
+		XMVECTOR Max{ XMVectorReplicate(-FLT_MAX) };
+		for (const XMFLOAT3& Point : vPoints)
+		{
+			const XMVECTOR KProjected{ XMVector3TransformNormal(XMLoadFloat3(&Point), KToAxes) };
+			Min = XMVectorMin(Min, KProjected);
+			Max = XMVectorMax(Max, KProjected);
+		}
+
+		const XMVECTOR KMid{ (Min + Max) * 0.5f };
+		XMStoreFloat3(&OutCenter, KAxes[0] * XMVectorGetX(KMid) + KAxes[1] * XMVectorGetY(KMid) + KAxes[2] * XMVectorGetZ(KMid));
+		XMStoreFloat3(&OutExtents, (Max - Min) * 0.5f);
+		return OutExtents.x * OutExtents.y * OutExtents.z;
+	}
+}
+
+static SBoundingVolumes CalculateBoundingVolumes(const std::vector<SMesh>& vMeshes)
+{
+	using namespace BoundingVolumeInternal;
+
+	SBoundingVolumes Result{};
+
+	size_t VertexCount{};
+	for (const SMesh& Mesh : vMeshes) VertexCount += Mesh.vVertices.size();
+	if (VertexCount == 0) return Result;
+
+	std::vector<XMFLOAT3> vPoints{};
+	vPoints.reserve(VertexCount);
+	for (const SMesh& Mesh : vMeshes)
+	{
+		for (const SVertex3D& Vertex : Mesh.vVertices)
+		{
+			vPoints.emplace_back();
+			XMStoreFloat3(&vPoints.back(), Vertex.Position);
+		}
+	}
+
+	// Sphere
+	size_t ExtremeIndices[6]{};
+	const XMFLOAT4 KRitterSphere{ CalculateRitterSphere(vPoints, ExtremeIndices) };
+	XMFLOAT4 Sphere{ CalculateMinimumSphere(vPoints, ExtremeIndices) };
+	if (Sphere.w > KRitterSphere.w) Sphere = KRitterSphere;
+	Result.SphereCenter = XMFLOAT3(Sphere.x, Sphere.y, Sphere.z);
+	Result.SphereRadius = Sphere.w;
+
+	// AABB
+	XMVECTOR BoxMin{ XMVectorReplicate(+FLT_MAX) };
+	XMVECTOR BoxMax{ XMVectorReplicate(-FLT_MAX) };
+	for (const XMFLOAT3& Point : vPoints)
+	{
+		BoxMin = XMVectorMin(BoxMin, XMLoadFloat3(&Point));
+		BoxMax = XMVectorMax(BoxMax, XMLoadFloat3(&Point));
+	}
+	XMStoreFloat3(&Result.BoxMin, BoxMin);
+	XMStoreFloat3(&Result.BoxMax, BoxMax);
+
+	// Covariance of the surface (the sum over the triangles of the second moments, Area / 12 * (9 m m^T + a a^T + b b^T + c c^T)),
+	// so that densely tessellated regions don't pull the axes; the vertices' covariance for meshes without area
+	double Mean[3]{};
+	double Moments[3][3]{};
+	double TotalArea{};
+	float MaxEdgeLengthSq{};
+	for (const SMesh& Mesh : vMeshes)
+	{
+		for (const STriangle& Triangle : Mesh.vTriangles)
+		{
+			const XMVECTOR KA{ Mesh.vVertices[Triangle.I0].Position };
+			const XMVECTOR KB{ Mesh.vVertices[Triangle.I1].Position };
+			const XMVECTOR KC{ Mesh.vVertices[Triangle.I2].Position };
+			MaxEdgeLengthSq = std::max(MaxEdgeLengthSq, std::max(XMVectorGetX(XMVector3LengthSq(KB - KA)),
+				std::max(XMVectorGetX(XMVector3LengthSq(KC - KB)), XMVectorGetX(XMVector3LengthSq(KA - KC)))));
+
+			const double KArea{ 0.5 * XMVectorGetX(XMVector3Length(XMVector3Cross(KB - KA, KC - KA))) };
+			if (KArea <= 0.0) continue;
+
+			XMFLOAT3 Corners[3]{};
+			XMStoreFloat3(&Corners[0], KA);
+			XMStoreFloat3(&Corners[1], KB);
+			XMStoreFloat3(&Corners[2], KC);
+			double P[3][3]{};
+			for (int iCorner = 0; iCorner < 3; ++iCorner) ToDouble(Corners[iCorner], P[iCorner]);
+			const double KCentroid[3]{ (P[0][0] + P[1][0] + P[2][0]) / 3.0, (P[0][1] + P[1][1] + P[2][1]) / 3.0, (P[0][2] + P[1][2] + P[2][2]) / 3.0 };
+
+			for (int i = 0; i < 3; ++i)
+			{
+				Mean[i] += KArea * KCentroid[i];
+				for (int j = 0; j < 3; ++j)
+				{
+					Moments[i][j] += KArea / 12.0 * (9.0 * KCentroid[i] * KCentroid[j] + P[0][i] * P[0][j] + P[1][i] * P[1][j] + P[2][i] * P[2][j]);
+				}
+			}
+			TotalArea += KArea;
+		}
+	}
+	Result.TessellationMargin = sqrt(MaxEdgeLengthSq) / 3.0f;
+
+	if (TotalArea <= 0.0)
+	{
+		for (const XMFLOAT3& Point : vPoints)
+		{
+			double P[3]{};
+			ToDouble(Point, P);
+			for (int i = 0; i < 3; ++i)
+			{
+				Mean[i] += P[i];
+				for (int j = 0; j < 3; ++j) Moments[i][j] += P[i] * P[j];
+			}
+		}
+		TotalArea = static_cast<double>(vPoints.size());
+	}
+
+	double Covariance[3][3]{};
+	for (int i = 0; i < 3; ++i) Mean[i] /= TotalArea;
+	for (int i = 0; i < 3; ++i)
+	{
+		for (int j = 0; j < 3; ++j) Covariance[i][j] = Moments[i][j] / TotalArea - Mean[i] * Mean[j];
+	}
+
+	double Eigenvectors[3][3]{};
+	DiagonalizeSymmetric(Covariance, Eigenvectors);
+
+	XMFLOAT3 Axes[3]{};
+	for (int iAxis = 0; iAxis < 3; ++iAxis)
+	{
+		Axes[iAxis] = XMFLOAT3(static_cast<float>(Eigenvectors[0][iAxis]), static_cast<float>(Eigenvectors[1][iAxis]), static_cast<float>(Eigenvectors[2][iAxis]));
+	}
+	// Orthonormal and right-handed despite float rounding
+	const XMVECTOR KAxis0{ XMVector3Normalize(XMLoadFloat3(&Axes[0])) };
+	const XMVECTOR KAxis1{ XMVector3Normalize(XMLoadFloat3(&Axes[1]) - KAxis0 * XMVector3Dot(XMLoadFloat3(&Axes[1]), KAxis0)) };
+	XMStoreFloat3(&Axes[0], KAxis0);
+	XMStoreFloat3(&Axes[1], KAxis1);
+	XMStoreFloat3(&Axes[2], XMVector3Cross(KAxis0, KAxis1));
+
+	const float KPCAVolume{ FitBoxToAxes(vPoints, Axes, Result.OrientedCenter, Result.OrientedExtents) };
+	const XMFLOAT3 KBoxExtents{ (Result.BoxMax.x - Result.BoxMin.x) * 0.5f, (Result.BoxMax.y - Result.BoxMin.y) * 0.5f, (Result.BoxMax.z - Result.BoxMin.z) * 0.5f };
+	if (KBoxExtents.x * KBoxExtents.y * KBoxExtents.z <= KPCAVolume)
+	{
+		Result.OrientedCenter = XMFLOAT3((Result.BoxMin.x + Result.BoxMax.x) * 0.5f, (Result.BoxMin.y + Result.BoxMax.y) * 0.5f, (Result.BoxMin.z + Result.BoxMax.z) * 0.5f);
+		Result.OrientedExtents = KBoxExtents;
+	}
+	else
+	{
+		memcpy(Result.OrientedAxes, Axes, sizeof(Axes));
+	}
+
+	return Result;
+}
+
+// Ritter, "An Efficient Bounding Sphere", 1990: start from the most separated pair of axis extremes and grow the sphere over the points
+static XMFLOAT4 CalculateRitterSphere(const std::vector<XMFLOAT3>& vPoints, size_t(&OutExtremeIndices)[6])
+{
+	assert(!vPoints.empty());
+
+	// Min x, max x, min y, ...
+	for (size_t& Index : OutExtremeIndices) Index = 0;
+	for (size_t iPoint = 1; iPoint < vPoints.size(); ++iPoint)
+	{
+		const float KValues[3]{ vPoints[iPoint].x, vPoints[iPoint].y, vPoints[iPoint].z };
+		for (int iAxis = 0; iAxis < 3; ++iAxis)
+		{
+			const XMFLOAT3& KMin{ vPoints[OutExtremeIndices[iAxis * 2 + 0]] };
+			const XMFLOAT3& KMax{ vPoints[OutExtremeIndices[iAxis * 2 + 1]] };
+			const float KMinValue{ (iAxis == 0) ? KMin.x : (iAxis == 1) ? KMin.y : KMin.z };
+			const float KMaxValue{ (iAxis == 0) ? KMax.x : (iAxis == 1) ? KMax.y : KMax.z };
+			if (KValues[iAxis] < KMinValue) OutExtremeIndices[iAxis * 2 + 0] = iPoint;
+			if (KValues[iAxis] > KMaxValue) OutExtremeIndices[iAxis * 2 + 1] = iPoint;
+		}
+	}
+
+	XMVECTOR Center{};
+	float Radius{ -1.0f };
+	for (int iAxis = 0; iAxis < 3; ++iAxis)
+	{
+		const XMVECTOR KMin{ XMLoadFloat3(&vPoints[OutExtremeIndices[iAxis * 2 + 0]]) };
+		const XMVECTOR KMax{ XMLoadFloat3(&vPoints[OutExtremeIndices[iAxis * 2 + 1]]) };
+		const float KHalfLength{ XMVectorGetX(XMVector3Length(KMax - KMin)) * 0.5f };
+		if (KHalfLength > Radius)
+		{
+			Radius = KHalfLength;
+			Center = (KMin + KMax) * 0.5f;
+		}
+	}
+
+	for (const XMFLOAT3& Point : vPoints)
+	{
+		const XMVECTOR KOffset{ XMLoadFloat3(&Point) - Center };
+		const float KDistance{ XMVectorGetX(XMVector3Length(KOffset)) };
+		if (KDistance > Radius)
+		{
+			// Moves the near side of the sphere no further than it was, so the old sphere stays inside
+			const float KNewRadius{ (Radius + KDistance) * 0.5f };
+			Center += KOffset * ((KNewRadius - Radius) / KDistance);
+			Radius = KNewRadius;
+		}
+	}
+
+	// Rounding in the updates above can leave points a hair outside
+	for (const XMFLOAT3& Point : vPoints)
+	{
+		Radius = std::max(Radius, XMVectorGetX(XMVector3Length(XMLoadFloat3(&Point) - Center)));
+	}
+
+	XMFLOAT4 Result{};
+	XMStoreFloat4(&Result, XMVectorSetW(Center, Radius));
+	return Result;
+}
+
+// Welzl, "Smallest enclosing disks (balls and ellipsoids)", 1991, in its iterative form over a shuffled order (expected linear time).
+// The extreme points go first: they are likely on the final sphere, so fewer points restart the inner loops.
+static XMFLOAT4 CalculateMinimumSphere(const std::vector<XMFLOAT3>& vPoints, const size_t(&ExtremeIndices)[6])
+{
+	using namespace BoundingVolumeInternal;
+
+	assert(!vPoints.empty());
+
+	std::vector<uint32_t> vOrder(vPoints.size());
+	for (size_t iPoint = 0; iPoint < vPoints.size(); ++iPoint) vOrder[iPoint] = static_cast<uint32_t>(iPoint);
+
+	// Fixed seed, so that the result doesn't change between runs
+	CRandom Random{ vPoints.size() };
+	for (size_t iPoint = vOrder.size() - 1; iPoint > 0; --iPoint)
+	{
+		std::swap(vOrder[iPoint], vOrder[static_cast<size_t>(Random.NextInt(0, static_cast<int>(iPoint)))]);
+	}
+	for (size_t iExtreme = 0; iExtreme < 6; ++iExtreme)
+	{
+		const auto KFound{ std::find(vOrder.begin() + iExtreme, vOrder.end(), static_cast<uint32_t>(ExtremeIndices[iExtreme])) };
+		if (KFound != vOrder.end()) std::iter_swap(vOrder.begin() + iExtreme, KFound);
+	}
+
+	auto GetPoint{ [&](size_t i)->const XMFLOAT3& { return vPoints[vOrder[i]]; } };
+
+	SSphere Sphere{ MakeSphere(GetPoint(0)) };
+	for (size_t i = 1; i < vOrder.size(); ++i)
+	{
+		if (!IsOutside(Sphere, GetPoint(i))) continue;
+
+		// Point i is on the sphere of points [0, i]
+		Sphere = MakeSphere(GetPoint(i));
+		for (size_t j = 0; j < i; ++j)
+		{
+			if (!IsOutside(Sphere, GetPoint(j))) continue;
+
+			Sphere = MakeSphere(GetPoint(i), GetPoint(j));
+			for (size_t k = 0; k < j; ++k)
+			{
+				if (!IsOutside(Sphere, GetPoint(k))) continue;
+
+				Sphere = MakeSphere(GetPoint(i), GetPoint(j), GetPoint(k));
+				for (size_t l = 0; l < k; ++l)
+				{
+					if (!IsOutside(Sphere, GetPoint(l))) continue;
+
+					Sphere = MakeSphere(GetPoint(i), GetPoint(j), GetPoint(k), GetPoint(l));
+				}
+			}
+		}
+	}
+
+	// Enclose every point in float, whatever the tolerance let through
+	const XMVECTOR KCenter{ XMVectorSet(static_cast<float>(Sphere.Center[0]), static_cast<float>(Sphere.Center[1]), static_cast<float>(Sphere.Center[2]), 0) };
+	float Radius{ static_cast<float>(sqrt(std::max(Sphere.RadiusSq, 0.0))) };
+	for (const XMFLOAT3& Point : vPoints)
+	{
+		Radius = std::max(Radius, XMVectorGetX(XMVector3Length(XMLoadFloat3(&Point) - KCenter)));
+	}
+
+	XMFLOAT4 Result{};
+	XMStoreFloat4(&Result, XMVectorSetW(KCenter, Radius));
+	return Result;
+}
+
+static SOrientedBox TransformOrientedBox(const SBoundingVolumes& Volumes, float Margin, float Bias, const XMMATRIX& Matrix)
+{
+	SOrientedBox Result{};
+	Result.Center = XMVector3TransformCoord(XMLoadFloat3(&Volumes.OrientedCenter), Matrix);
+
+	const float KExtents[3]{ Volumes.OrientedExtents.x, Volumes.OrientedExtents.y, Volumes.OrientedExtents.z };
+	for (int iAxis = 0; iAxis < 3; ++iAxis)
+	{
+		const float KHalfLength{ (KExtents[iAxis] + Margin) * Bias };
+		Result.HalfAxes[iAxis] = XMVector3TransformNormal(XMLoadFloat3(&Volumes.OrientedAxes[iAxis]) * KHalfLength, Matrix);
+	}
+	return Result;
+}
+
+static bool IsOrientedBoxOutsideFrustum(const XMVECTOR(&Planes)[6], const SOrientedBox& Box)
+{
+	for (const XMVECTOR& Plane : Planes)
+	{
+		// The box's extent along the plane normal
+		const XMVECTOR KReach{ XMVectorAbs(XMVector3Dot(Plane, Box.HalfAxes[0])) + XMVectorAbs(XMVector3Dot(Plane, Box.HalfAxes[1])) +
+			XMVectorAbs(XMVector3Dot(Plane, Box.HalfAxes[2])) };
+		if (XMVectorGetX(XMPlaneDotCoord(Plane, Box.Center) + KReach) < 0.0f) return true;
+	}
+	return false;
+}
+
+static bool IntersectRayOrientedBox(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, const SBoundingVolumes& Volumes, float Margin, float* const OutPtrT)
+{
+	const XMVECTOR KOffset{ RayOrigin - XMLoadFloat3(&Volumes.OrientedCenter) };
+	const float KExtents[3]{ Volumes.OrientedExtents.x + Margin, Volumes.OrientedExtents.y + Margin, Volumes.OrientedExtents.z + Margin };
+
+	float Entry{ 0.0f };
+	float Exit{ FLT_MAX };
+	for (int iAxis = 0; iAxis < 3; ++iAxis)
+	{
+		const XMVECTOR KAxis{ XMLoadFloat3(&Volumes.OrientedAxes[iAxis]) };
+		const float KOrigin{ XMVectorGetX(XMVector3Dot(KOffset, KAxis)) };
+		const float KDirection{ XMVectorGetX(XMVector3Dot(RayDirection, KAxis)) };
+		if (KDirection == 0.0f)
+		{
+			if (fabsf(KOrigin) > KExtents[iAxis]) return false;
+			continue;
+		}
+
+		const float KT0{ (-KExtents[iAxis] - KOrigin) / KDirection };
+		const float KT1{ (+KExtents[iAxis] - KOrigin) / KDirection };
+		Entry = std::max(Entry, std::min(KT0, KT1));
+		Exit = std::min(Exit, std::max(KT0, KT1));
+		if (Entry > Exit) return false;
+	}
+
+	if (OutPtrT) *OutPtrT = Entry;
+	return true;
+}
+
+static bool IntersectRayAxisAlignedBox(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, const XMVECTOR& BoxMin, const XMVECTOR& BoxMax, float* const OutPtrT)
+{
+	XMFLOAT3 Origin{}, Direction{}, Min{}, Max{};
+	XMStoreFloat3(&Origin, RayOrigin);
+	XMStoreFloat3(&Direction, RayDirection);
+	XMStoreFloat3(&Min, BoxMin);
+	XMStoreFloat3(&Max, BoxMax);
+	const float KOrigins[3]{ Origin.x, Origin.y, Origin.z };
+	const float KDirections[3]{ Direction.x, Direction.y, Direction.z };
+	const float KMins[3]{ Min.x, Min.y, Min.z };
+	const float KMaxs[3]{ Max.x, Max.y, Max.z };
+
+	float Entry{ 0.0f };
+	float Exit{ FLT_MAX };
+	for (int iAxis = 0; iAxis < 3; ++iAxis)
+	{
+		if (KDirections[iAxis] == 0.0f)
+		{
+			if (KOrigins[iAxis] < KMins[iAxis] || KOrigins[iAxis] > KMaxs[iAxis]) return false;
+			continue;
+		}
+
+		const float KT0{ (KMins[iAxis] - KOrigins[iAxis]) / KDirections[iAxis] };
+		const float KT1{ (KMaxs[iAxis] - KOrigins[iAxis]) / KDirections[iAxis] };
+		Entry = std::max(Entry, std::min(KT0, KT1));
+		Exit = std::min(Exit, std::max(KT0, KT1));
+		if (Entry > Exit) return false;
+	}
+
+	if (OutPtrT) *OutPtrT = Entry;
+	return true;
+}
@@ -0,0 +1,140 @@
+#include "DisplacementMap.h"
+
+using std::vector;
+using std::min;
+using std::max;
+using std::isfinite;
+
+void CDisplacementMap::Create(uint32_t Width, uint32_t Height, const float* const PtrTexels)
+{
+	assert(Width > 0 && Height > 0);
+	assert(PtrTexels);
+
+	m_vLevels.clear();
+	m_vLevels.emplace_back();
+	m_vLevels.back().Width = Width;
+	m_vLevels.back().Height = Height;
+	m_vLevels.back().vTexels.assign(PtrTexels, PtrTexels + static_cast<size_t>(Width) * Height);
+
+	// Odd sizes drop their last row or column, as the hardware's mip generation usually does
+	while (m_vLevels.back().Width > 1 || m_vLevels.back().Height > 1)
+	{
+		const SLevel& KSource{ m_vLevels.back() };
+		SLevel Level{};
+		Level.Width = max(KSource.Width / 2, 1u);
+		Level.Height = max(KSource.Height / 2, 1u);
+		Level.vTexels.resize(static_cast<size_t>(Level.Width) * Level.Height);
+		for (uint32_t Y = 0; Y < Level.Height; ++Y)
+		{
+			const uint32_t KY0{ min(Y * 2, KSource.Height - 1) };
+			const uint32_t KY1{ min(Y * 2 + 1, KSource.Height - 1) };
+			for (uint32_t X = 0; X < Level.Width; ++X)
+			{
+				const uint32_t KX0{ min(X * 2, KSource.Width - 1) };
+				const uint32_t KX1{ min(X * 2 + 1, KSource.Width - 1) };
+				Level.vTexels[static_cast<size_t>(Y) * Level.Width + X] = 0.25f * (
+					KSource.vTexels[static_cast<size_t>(KY0) * KSource.Width + KX0] + KSource.vTexels[static_cast<size_t>(KY0) * KSource.Width + KX1] +
+					KSource.vTexels[static_cast<size_t>(KY1) * KSource.Width + KX0] + KSource.vTexels[static_cast<size_t>(KY1) * KSource.Width + KX1]);
+			}
+		}
+		m_vLevels.emplace_back(std::move(Level));
+	}
+}
+
+bool CDisplacementMap::Create(ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext, ID3D11Texture2D* const PtrTexture)
+{
+	assert(PtrDevice);
+	assert(PtrDeviceContext);
+	if (!PtrTexture) return false;
+
+	ScratchImage CapturedImage{};
+	if (FAILED(CaptureTexture(PtrDevice, PtrDeviceContext, PtrTexture, CapturedImage))) return false;
+
+	// Only the first mip; the chain is rebuilt here so that the result doesn't depend on the driver
+	const Image* PtrImage{ CapturedImage.GetImage(0, 0, 0) };
+	if (!PtrImage) return false;
+
+	ScratchImage DecompressedImage{};
+	if (IsCompressed(PtrImage->format))
+	{
+		if (FAILED(Decompress(*PtrImage, DXGI_FORMAT_UNKNOWN, DecompressedImage))) return false;
+		PtrImage = DecompressedImage.GetImage(0, 0, 0);
+	}
+
+	ScratchImage ConvertedImage{};
+	if (FAILED(Convert(*PtrImage, DXGI_FORMAT_R32_FLOAT, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, ConvertedImage))) return false;
+
+	const Image& KImage{ *ConvertedImage.GetImage(0, 0, 0) };
+	const uint32_t KWidth{ static_cast<uint32_t>(KImage.width) };
+	const uint32_t KHeight{ static_cast<uint32_t>(KImage.height) };
+	vector<float> vTexels(static_cast<size_t>(KWidth) * KHeight);
+	for (uint32_t Y = 0; Y < KHeight; ++Y)
+	{
+		memcpy(&vTexels[static_cast<size_t>(Y) * KWidth], KImage.pixels + Y * KImage.rowPitch, KWidth * sizeof(float));
+	}
+	Create(KWidth, KHeight, vTexels.data());
+	return true;
+}
+
+float CDisplacementMap::SampleLevel(float U, float V, float Level) const
+{
+	assert(IsCreated());
+
+	const float KLevel{ min(max(Level, 0.0f), static_cast<float>(m_vLevels.size() - 1)) };
+	const size_t KLevel0{ static_cast<size_t>(KLevel) };
+	const float KFraction{ KLevel - static_cast<float>(KLevel0) };
+	const float KSample0{ SampleBilinear(m_vLevels[KLevel0], U, V) };
+	if (KFraction == 0.0f) return KSample0;
+
+	const float KSample1{ SampleBilinear(m_vLevels[KLevel0 + 1], U, V) };
+	return KSample0 + (KSample1 - KSample0) * KFraction;
+}
+
+float CDisplacementMap::GetLevel(const SMesh& Mesh, float TessFactor) const
+{
+	assert(IsCreated());
+	if (Mesh.vTriangles.empty() || !(TessFactor > 0.0f)) return 0.0f;
+
+	const XMVECTOR KTextureSize{ XMVectorSet(static_cast<float>(GetWidth()), static_cast<float>(GetHeight()), 0, 0) };
+	double LengthSum{};
+	for (const STriangle& KTriangle : Mesh.vTriangles)
+	{
+		const XMVECTOR KUV0{ Mesh.vVertices[KTriangle.I0].TexCoord * KTextureSize };
+		const XMVECTOR KUV1{ Mesh.vVertices[KTriangle.I1].TexCoord * KTextureSize };
+		const XMVECTOR KUV2{ Mesh.vVertices[KTriangle.I2].TexCoord * KTextureSize };
+		LengthSum += XMVectorGetX(XMVector2Length(KUV1 - KUV0)) + XMVectorGetX(XMVector2Length(KUV2 - KUV1)) + XMVectorGetX(XMVector2Length(KUV0 - KUV2));
+	}
+	const float KTexelsPerSegment{ static_cast<float>(LengthSum / (Mesh.vTriangles.size() * 3)) / TessFactor };
+	if (!(KTexelsPerSegment > 1.0f)) return 0.0f;
+	return min(log2f(KTexelsPerSegment), static_cast<float>(m_vLevels.size() - 1));
+}
+
+float CDisplacementMap::SampleBilinear(const SLevel& Level, float U, float V)
+{
+	// Repeats every 1, so the texel coordinates below stay within [-1, Size] whatever the texcoord is; non-finite texcoords sample 0
+	auto Reduce{ [](float Coordinate) { return (isfinite(Coordinate)) ? Coordinate - floorf(Coordinate) : 0.0f; } };
+
+	// Texel centers are at (i + 0.5) / Size
+	const float KX{ Reduce(U) * static_cast<float>(Level.Width) - 0.5f };
+	const float KY{ Reduce(V) * static_cast<float>(Level.Height) - 0.5f };
+	const float KFloorX{ floorf(KX) };
+	const float KFloorY{ floorf(KY) };
+	const float KFractionX{ KX - KFloorX };
+	const float KFractionY{ KY - KFloorY };
+
+	// Coordinate is a whole number in [-1, Size]
+	auto Wrap{ [](float Coordinate, uint32_t Size)
+		{
+			const int64_t KSize{ static_cast<int64_t>(Size) };
+			const int64_t KCoordinate{ static_cast<int64_t>(Coordinate) };
+			return static_cast<size_t>((KCoordinate < 0) ? KCoordinate + KSize : ((KCoordinate >= KSize) ? KCoordinate - KSize : KCoordinate));
+		} };
+	const size_t KX0{ Wrap(KFloorX, Level.Width) };
+	const size_t KX1{ Wrap(KFloorX + 1.0f, Level.Width) };
+	const size_t KRow0{ Wrap(KFloorY, Level.Height) * Level.Width };
+	const size_t KRow1{ Wrap(KFloorY + 1.0f, Level.Height) * Level.Width };
+
+	const float KTop{ Level.vTexels[KRow0 + KX0] + (Level.vTexels[KRow0 + KX1] - Level.vTexels[KRow0 + KX0]) * KFractionX };
+	const float KBottom{ Level.vTexels[KRow1 + KX0] + (Level.vTexels[KRow1 + KX1] - Level.vTexels[KRow1 + KX0]) * KFractionX };
+	return KTop + (KBottom - KTop) * KFractionY;
+}
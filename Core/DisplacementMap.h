@@ -0,0 +1,46 @@
+#pragma once
+
+#include "SharedHeader.h"
+
+// A displacement texture on the CPU, for baking displaced meshes (see CTessellationBaker::Displace()).
+// Holds the red channel as floats with a 2x2 box-filtered mip chain and samples it the way SampleLevel() does with a linear, wrapping sampler:
+// bilinear within a level, linear between levels.
+class CDisplacementMap
+{
+	struct SLevel
+	{
+		uint32_t			Width{};
+		uint32_t			Height{};
+		std::vector<float>	vTexels{};
+	};
+
+public:
+	CDisplacementMap() {}
+	~CDisplacementMap() {}
+
+public:
+	// Texels are row-major
+	void Create(uint32_t Width, uint32_t Height, const float* const PtrTexels);
+	// Reads back the first mip of a texture (CMaterialTextureSet's textures only keep their data on the GPU).
+	// sRGB texels are linearized, as the sampler does. Returns false if the texture can't be read or converted.
+	bool Create(ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext, ID3D11Texture2D* const PtrTexture);
+
+	// Wraps (U, V); Level is clamped to the mip chain
+	float SampleLevel(float U, float V, float Level) const;
+
+	// The level whose texels are as far apart as the vertices of Mesh tessellated with TessFactor: the mean length of its UV edges
+	// in texels, divided by TessFactor
+	float GetLevel(const SMesh& Mesh, float TessFactor) const;
+
+public:
+	bool IsCreated() const { return !m_vLevels.empty(); }
+	size_t GetLevelCount() const { return m_vLevels.size(); }
+	uint32_t GetWidth() const { return (m_vLevels.empty()) ? 0 : m_vLevels[0].Width; }
+	uint32_t GetHeight() const { return (m_vLevels.empty()) ? 0 : m_vLevels[0].Height; }
+
+private:
+	static float SampleBilinear(const SLevel& Level, float U, float V);
+
+private:
+	std::vector<SLevel>		m_vLevels{};
+};
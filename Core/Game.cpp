@@ -24,6 +24,16 @@ static constexpr D3D11_INPUT_ELEMENT_DESC KBaseInputElementDescs[]
 	{ "TANGENT"		, 0, DXGI_FORMAT_R32G32B32A32_FLOAT	, 0, 64, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 };
 
+// SPackedVertex3D
+static constexpr D3D11_INPUT_ELEMENT_DESC KPackedInputElementDescs[]
+{
+	{ "POSITION"	, 0, DXGI_FORMAT_R16G16B16A16_UNORM	, 0,  0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "COLOR"		, 0, DXGI_FORMAT_R8G8B8A8_UNORM		, 0,  8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TEXCOORD"	, 0, DXGI_FORMAT_R16G16_FLOAT		, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "NORMAL"		, 0, DXGI_FORMAT_R16G16_SNORM		, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TANGENT"		, 0, DXGI_FORMAT_R10G10B10A2_UNORM	, 0, 20, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
 // FOR DEBUGGING SHADER...
 static constexpr D3D11_INPUT_ELEMENT_DESC KScreenQuadInputElementDescs[]
 {
@@ -377,8 +387,12 @@ void CGame::CreateConstantBuffers()
 		&m_CBSpace2DData, sizeof(m_CBSpace2DData));
 	m_CBTessFactor = make_unique<CConstantBuffer>(m_Device.Get(), m_DeviceContext.Get(),
 		&m_CBTessFactorData, sizeof(m_CBTessFactorData));
+	m_CBTessCamera = make_unique<CConstantBuffer>(m_Device.Get(), m_DeviceContext.Get(),
+		&m_CBTessCameraData, sizeof(m_CBTessCameraData));
 	m_CBDisplacement = make_unique<CConstantBuffer>(m_Device.Get(), m_DeviceContext.Get(),
 		&m_CBDisplacementData, sizeof(m_CBDisplacementData));
+	m_CBVertexQuantization = make_unique<CConstantBuffer>(m_Device.Get(), m_DeviceContext.Get(),
+		&m_CBVertexQuantizationData, sizeof(m_CBVertexQuantizationData));
 	m_CBLight = make_unique<CConstantBuffer>(m_Device.Get(), m_DeviceContext.Get(),
 		&m_CBLightData, sizeof(m_CBLightData));
 	m_CBMaterial = make_unique<CConstantBuffer>(m_Device.Get(), m_DeviceContext.Get(),
@@ -398,7 +412,9 @@ void CGame::CreateConstantBuffers()
 	m_CBSpaceVP->Create();
 	m_CBSpace2D->Create();
 	m_CBTessFactor->Create();
+	m_CBTessCamera->Create();
 	m_CBDisplacement->Create();
+	m_CBVertexQuantization->Create();
 	m_CBLight->Create();
 	m_CBMaterial->Create();
 	m_CBPSFlags->Create();
@@ -415,6 +431,12 @@ void CGame::CreateBaseShaders()
 		KBaseInputElementDescs, ARRAYSIZE(KBaseInputElementDescs));
 	m_VSBase->AttachConstantBuffer(m_CBSpaceWVP.get());
 
+	m_VSBasePacked = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_VSBasePacked->Create(EShaderType::VertexShader, L"Shader\\VSBase.hlsl", "packed",
+		KPackedInputElementDescs, ARRAYSIZE(KPackedInputElementDescs));
+	m_VSBasePacked->AttachConstantBuffer(m_CBSpaceWVP.get());
+	m_VSBasePacked->AttachConstantBuffer(m_CBVertexQuantization.get());
+
 	m_VSSky = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
 	m_VSSky->Create(EShaderType::VertexShader, L"Shader\\VSSky.hlsl", "main", 
 		KBaseInputElementDescs, ARRAYSIZE(KBaseInputElementDescs));
@@ -446,14 +468,17 @@ void CGame::CreateBaseShaders()
 	m_HSTriOdd = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
 	m_HSTriOdd->Create(EShaderType::HullShader, L"Shader\\HSTri.hlsl", "main");
 	m_HSTriOdd->AttachConstantBuffer(m_CBTessFactor.get());
+	m_HSTriOdd->AttachConstantBuffer(m_CBTessCamera.get());
 
 	m_HSTriEven = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
 	m_HSTriEven->Create(EShaderType::HullShader, L"Shader\\HSTri.hlsl", "even");
 	m_HSTriEven->AttachConstantBuffer(m_CBTessFactor.get());
+	m_HSTriEven->AttachConstantBuffer(m_CBTessCamera.get());
 
 	m_HSTriInteger = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
 	m_HSTriInteger->Create(EShaderType::HullShader, L"Shader\\HSTri.hlsl", "integer");
 	m_HSTriInteger->AttachConstantBuffer(m_CBTessFactor.get());
+	m_HSTriInteger->AttachConstantBuffer(m_CBTessCamera.get());
 
 	m_HSQuadSphere = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
 	m_HSQuadSphere->Create(EShaderType::HullShader, L"Shader\\HSQuadSphere.hlsl", "main");
@@ -776,6 +801,10 @@ void CGame::UpdateCBTessFactorData(const CObject3D::SCBTessFactorData& Data)
 {
 	m_CBTessFactorData = Data;
 	m_CBTessFactor->Update();
+
+	m_CBTessCameraData = GetTessCameraData();
+	m_CBTessCameraData.ViewProjection = XMMatrixTranspose(m_CBTessCameraData.ViewProjection);
+	m_CBTessCamera->Update();
 }
 
 void CGame::UpdateCBDisplacementData(const CObject3D::SCBDisplacementData& Data)
@@ -784,6 +813,12 @@ void CGame::UpdateCBDisplacementData(const CObject3D::SCBDisplacementData& Data)
 	m_CBDisplacement->Update();
 }
 
+void CGame::UpdateCBVertexQuantizationData(const SPositionQuantization& Data)
+{
+	m_CBVertexQuantizationData = Data;
+	m_CBVertexQuantization->Update();
+}
+
 void CGame::UpdateCBMaterialData(const CMaterialData& MaterialData)
 {
 	m_CBMaterialData.AmbientColor = MaterialData.AmbientColor();
@@ -1013,6 +1048,9 @@ CShader* CGame::GetBaseShader(EBaseShader eShader) const
 	case EBaseShader::VSBase:
 		Result = m_VSBase.get();
 		break;
+	case EBaseShader::VSBasePacked:
+		Result = m_VSBasePacked.get();
+		break;
 	case EBaseShader::VSSky:
 		Result = m_VSSky.get();
 		break;
@@ -1106,6 +1144,7 @@ bool CGame::InsertObject3D(const string& Name)
 	m_vObject3Ds.emplace_back(make_unique<CObject3D>(Name, m_Device.Get(), m_DeviceContext.Get(), this));
 	m_vObject3Ds.back()->ComponentRender.PtrVS = m_VSBase.get();
 	m_vObject3Ds.back()->ComponentRender.PtrPS = m_PSBase.get();
+	m_vObject3Ds.back()->InsertIntoTree(&m_Object3DTree);
 
 	m_mapObject3DNameToIndex[Name] = m_vObject3Ds.size() - 1;
 
@@ -1123,6 +1162,10 @@ void CGame::DeleteObject3D(const string& Name)
 	}
 
 	size_t iObject3D{ m_mapObject3DNameToIndex[Name] };
+	const CObject3D* const KPtrObject3D{ m_vObject3Ds[iObject3D].get() };
+	m_vPendingPrimitives.erase(std::remove_if(m_vPendingPrimitives.begin(), m_vPendingPrimitives.end(),
+		[&](const SPendingPrimitive& Pending) { return Pending.PtrObject3D == KPtrObject3D; }), m_vPendingPrimitives.end());
+
 	if (iObject3D < m_vObject3Ds.size() - 1)
 	{
 		const string& SwappedName{ m_vObject3Ds.back()->GetName() };
@@ -1145,6 +1188,7 @@ void CGame::DeleteObject3D(const string& Name)
 
 void CGame::ClearObject3Ds()
 {
+	m_vPendingPrimitives.clear();
 	m_mapObject3DNameToIndex.clear();
 	m_vObject3Ds.clear();
 
@@ -1625,7 +1669,7 @@ void CGame::Select3DGizmos()
 		default:
 			break;
 		}
-		m_PtrSelectedObject3D->UpdateWorldMatrix();
+		m_PtrSelectedObject3D->MarkTransformDirty();
 	}
 	else
 	{
@@ -1822,20 +1866,11 @@ void CGame::PickBoundingSphere()
 	m_vObject3DPickingCandidates.clear();
 	m_PtrPickedObject3D = nullptr;
 
-	XMVECTOR T{ KVectorGreatest };
-	for (auto& i : m_vObject3Ds)
-	{
-		auto* Object3D{ i.get() };
-		if (Object3D->ComponentPhysics.bIsPickable)
+	m_Object3DTree.QueryRay(m_PickingRayWorldSpaceOrigin, m_PickingRayWorldSpaceDirection,
+		[&](CObject3D* const PtrObject3D, const XMVECTOR& T)
 		{
-			XMVECTOR NewT{ KVectorGreatest };
-			if (IntersectRaySphere(m_PickingRayWorldSpaceOrigin, m_PickingRayWorldSpaceDirection,
-				Object3D->ComponentPhysics.BoundingSphere.Radius, Object3D->ComponentTransform.Translation + Object3D->ComponentPhysics.BoundingSphere.CenterOffset, &NewT))
-			{
-				m_vObject3DPickingCandidates.emplace_back(Object3D, NewT);
-			}
-		}
-	}
+			if (PtrObject3D->ComponentPhysics.bIsPickable) m_vObject3DPickingCandidates.emplace_back(PtrObject3D, T);
+		});
 }
 
 bool CGame::PickTriangle()
@@ -1847,36 +1882,59 @@ bool CGame::PickTriangle()
 		{
 			Candidate.bHasFailedPickingTest = true;
 			XMMATRIX WorldMatrix{ Candidate.PtrObject3D->ComponentTransform.MatrixWorld };
-			for (const SMesh& Mesh : Candidate.PtrObject3D->GetModel().vMeshes)
+
+			// The ray goes to object space instead of every vertex to world space; T is the same in both
+			XMMATRIX WorldMatrixInverse{ XMMatrixInverse(nullptr, WorldMatrix) };
+			XMVECTOR ObjectSpaceRayOrigin{ XMVector3TransformCoord(m_PickingRayWorldSpaceOrigin, WorldMatrixInverse) };
+			XMVECTOR ObjectSpaceRayDirection{ XMVector3TransformNormal(m_PickingRayWorldSpaceDirection, WorldMatrixInverse) };
+
+			// The sphere test that made this a candidate is loose for long or flat objects; skip those the box says are missed or farther than the best hit
+			float BoxT{};
+			if (!IntersectRayOrientedBox(ObjectSpaceRayOrigin, ObjectSpaceRayDirection, Candidate.PtrObject3D->GetBoundingVolumes(),
+				Candidate.PtrObject3D->GetBoundingMargin(), &BoxT)) continue;
+			if (BoxT >= XMVectorGetX(T)) continue;
+
+			// Tessellated objects are picked on the surface that is drawn, not on their base triangles
+			if (Candidate.PtrObject3D->ShouldTessellate())
 			{
-				for (const STriangle& Triangle : Mesh.vTriangles)
+				float HitT{};
+				XMVECTOR Triangle[3]{};
+				if (Candidate.PtrObject3D->IntersectTessellatedSurface(m_PickingRayWorldSpaceOrigin, m_PickingRayWorldSpaceDirection, GetTessCameraData(),
+					XMVectorGetX(T), &HitT, Triangle))
 				{
-					XMVECTOR V0{ Mesh.vVertices[Triangle.I0].Position };
-					XMVECTOR V1{ Mesh.vVertices[Triangle.I1].Position };
-					XMVECTOR V2{ Mesh.vVertices[Triangle.I2].Position };
-					V0 = XMVector3TransformCoord(V0, WorldMatrix);
-					V1 = XMVector3TransformCoord(V1, WorldMatrix);
-					V2 = XMVector3TransformCoord(V2, WorldMatrix);
-
-					XMVECTOR NewT{};
-					if (IntersectRayTriangle(m_PickingRayWorldSpaceOrigin, m_PickingRayWorldSpaceDirection, V0, V1, V2, &NewT))
-					{
-						if (XMVector3Less(NewT, T))
-						{
-							T = NewT;
+					T = XMVectorReplicate(HitT);
+
+					Candidate.bHasFailedPickingTest = false;
+					Candidate.T = T;
 
-							Candidate.bHasFailedPickingTest = false;
-							Candidate.T = NewT;
+					XMVECTOR N{ CalculateTriangleNormal(Triangle[0], Triangle[1], Triangle[2]) };
+					m_PickedTriangleV0 = Triangle[0] + N * 0.01f;
+					m_PickedTriangleV1 = Triangle[1] + N * 0.01f;
+					m_PickedTriangleV2 = Triangle[2] + N * 0.01f;
+				}
+				continue;
+			}
 
-							XMVECTOR N{ CalculateTriangleNormal(V0, V1, V2) };
+			for (size_t iMesh = 0; iMesh < Candidate.PtrObject3D->GetModel().vMeshes.size(); ++iMesh)
+			{
+				const SMesh& Mesh{ Candidate.PtrObject3D->GetModel().vMeshes[iMesh] };
+				SRayTriangleHit Hit{};
+				if (Candidate.PtrObject3D->GetMeshBVH(iMesh).Intersect(ObjectSpaceRayOrigin, ObjectSpaceRayDirection, XMVectorGetX(T), &Hit))
+				{
+					T = XMVectorReplicate(Hit.T);
 
-							m_PickedTriangleV0 = V0 + N * 0.01f;
-							m_PickedTriangleV1 = V1 + N * 0.01f;
-							m_PickedTriangleV2 = V2 + N * 0.01f;
+					Candidate.bHasFailedPickingTest = false;
+					Candidate.T = T;
 
-							continue;
-						}
-					}
+					const STriangle& Triangle{ Mesh.vTriangles[Hit.TriangleIndex] };
+					XMVECTOR V0{ XMVector3TransformCoord(Mesh.vVertices[Triangle.I0].Position, WorldMatrix) };
+					XMVECTOR V1{ XMVector3TransformCoord(Mesh.vVertices[Triangle.I1].Position, WorldMatrix) };
+					XMVECTOR V2{ XMVector3TransformCoord(Mesh.vVertices[Triangle.I2].Position, WorldMatrix) };
+					XMVECTOR N{ CalculateTriangleNormal(V0, V1, V2) };
+
+					m_PickedTriangleV0 = V0 + N * 0.01f;
+					m_PickedTriangleV1 = V1 + N * 0.01f;
+					m_PickedTriangleV2 = V2 + N * 0.01f;
 				}
 			}
 		}
@@ -1894,6 +1952,7 @@ bool CGame::PickTriangle()
 				if (XMVector3Less(FilteredCandidate.T, TCmp))
 				{
 					m_PtrPickedObject3D = FilteredCandidate.PtrObject3D;
+					TCmp = FilteredCandidate.T;
 				}
 			}
 			return true;
@@ -1944,6 +2003,8 @@ void CGame::Update()
 		m_PreviousFrameTime = m_TimeNow;
 	}
 
+	CreatePendingPrimitives();
+
 	// Capture inputs
 	m_CapturedKeyboardState = GetKeyState();
 	m_CapturedMouseState = GetMouseState();
@@ -2090,17 +2151,26 @@ void CGame::Draw()
 
 	DrawSky(m_DeltaTimeF);
 
+	if (m_Terrain) DrawTerrain();
+
 	if (EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::DrawNormals))
 	{
 		UpdateCBSpace();
 		m_GSNormal->Use();
 	}
 
+	UpdateObject3DWorldMatrices();
+
+	XMVECTOR FrustumPlanes[6]{};
+	ExtractFrustumPlanes(m_MatrixView * m_MatrixProjection, FrustumPlanes);
+
 	// Opaque Object3Ds
 	for (auto& Object3D : m_vObject3Ds)
 	{
 		if (Object3D->ComponentRender.bIsTransparent) continue;
 
+		if (Object3D->IsOutsideFrustum(FrustumPlanes)) continue;
+
 		UpdateObject3D(Object3D.get());
 		DrawObject3D(Object3D.get());
 
@@ -2115,6 +2185,8 @@ void CGame::Draw()
 	{
 		if (!Object3D->ComponentRender.bIsTransparent) continue;
 
+		if (Object3D->IsOutsideFrustum(FrustumPlanes)) continue;
+
 		UpdateObject3D(Object3D.get());
 		DrawObject3D(Object3D.get());
 
@@ -2129,11 +2201,56 @@ void CGame::Draw()
 	DrawObject2Ds();
 }
 
+void CGame::CreatePendingPrimitives()
+{
+	for (size_t iPending = 0; iPending < m_vPendingPrimitives.size();)
+	{
+		SPendingPrimitive& Pending{ m_vPendingPrimitives[iPending] };
+		if (Pending.FuturePrimitive.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++iPending;
+			continue;
+		}
+
+		SPendingPrimitive Ready{ std::move(Pending) };
+		m_vPendingPrimitives.erase(m_vPendingPrimitives.begin() + iPending);
+
+		// Generation errors arrive through the future; the object that was waiting for the mesh is removed
+		std::shared_ptr<const SCachedPrimitive> Primitive{};
+		try
+		{
+			Primitive = Ready.FuturePrimitive.get();
+		}
+		catch (const std::exception& Exception)
+		{
+			const string KName{ Ready.PtrObject3D->GetName() };
+			MB_WARN(("  ߽ϴ. (" + KName + ": " + Exception.what() + ")").c_str(), "Object3D  ");
+			DeleteObject3D(KName);
+			continue;
+		}
+
+		if (!Ready.PtrObject3D->IsCreated()) Ready.PtrObject3D->Create(Primitive, Ready.MaterialData, Ready.bShouldOptimizeMesh);
+	}
+}
+
+void CGame::UpdateObject3DWorldMatrices()
+{
+	m_vPtrDirtyObject3Ds.clear();
+	for (auto& Object3D : m_vObject3Ds)
+	{
+		if (Object3D->IsTransformDirty()) m_vPtrDirtyObject3Ds.emplace_back(Object3D.get());
+	}
+
+	CObject3D::UpdateWorldMatrices(m_vPtrDirtyObject3Ds.data(), m_vPtrDirtyObject3Ds.size(), &m_ThreadPool);
+	m_UpdatedWorldMatrixCount = m_vPtrDirtyObject3Ds.size();
+}
+
 void CGame::UpdateObject3D(CObject3D* const PtrObject3D)
 {
 	if (!PtrObject3D) return;
 
-	PtrObject3D->UpdateWorldMatrix();
+	PtrObject3D->UpdateLOD(m_PtrCurrentCamera->GetEyePosition(), m_WindowSize.y * 0.5f * XMVectorGetY(m_MatrixProjection.r[1]));
+	PtrObject3D->CullMeshlets(m_MatrixView * m_MatrixProjection, m_PtrCurrentCamera->GetEyePosition());
 	UpdateCBSpace(PtrObject3D->ComponentTransform.MatrixWorld);
 
 	SetUniversalbUseLighiting();
@@ -2150,11 +2267,39 @@ void CGame::UpdateObject3D(CObject3D* const PtrObject3D)
 	{
 		PS = m_PSVertexColor.get();
 	}
+	if (PtrObject3D->ShouldPackVertices() && VS == m_VSBase.get())
+	{
+		VS = m_VSBasePacked.get();
+	}
 
 	VS->Use();
 	PS->Use();
 }
 
+CObject3D::SCBTessCameraData CGame::GetTessCameraData() const
+{
+	CObject3D::SCBTessCameraData Result{};
+	Result.ViewProjection = m_MatrixView * m_MatrixProjection;
+	Result.ProjectionScale = m_WindowSize.y * 0.5f * XMVectorGetY(m_MatrixProjection.r[1]);
+	return Result;
+}
+
+void CGame::CountTessellatedTriangles()
+{
+	const CObject3D::SCBTessCameraData KCamera{ GetTessCameraData() };
+
+	m_TessellatedTriangleCount = 0;
+	m_UniformTessellatedTriangleCount = 0;
+	for (const auto& Object3D : m_vObject3Ds)
+	{
+		CObject3D::SCBTessFactorData UniformFactors{ Object3D->GetTessFactorData() };
+		UniformFactors.TargetEdgePixelLength = 0.0f;
+
+		m_TessellatedTriangleCount += Object3D->CountTessellatedTriangles(Object3D->GetTessFactorData(), KCamera);
+		m_UniformTessellatedTriangleCount += Object3D->CountTessellatedTriangles(UniformFactors, KCamera);
+	}
+}
+
 void CGame::DrawObject3D(const CObject3D* const PtrObject3D, bool bIgnoreInstances, bool bIgnoreOwnTexture)
 {
 	if (!PtrObject3D) return;
@@ -2216,8 +2361,7 @@ void CGame::DrawObject3DBoundingSphere(const CObject3D* const PtrObject3D)
 {
 	m_VSBase->Use();
 
-	XMMATRIX Translation{ XMMatrixTranslationFromVector(PtrObject3D->ComponentTransform.Translation + 
-		PtrObject3D->ComponentPhysics.BoundingSphere.CenterOffset) };
+	XMMATRIX Translation{ XMMatrixTranslationFromVector(PtrObject3D->ComponentPhysics.BoundingSphere.Center) };
 	XMMATRIX Scaling{ XMMatrixScaling(PtrObject3D->ComponentPhysics.BoundingSphere.Radius,
 		PtrObject3D->ComponentPhysics.BoundingSphere.Radius, PtrObject3D->ComponentPhysics.BoundingSphere.Radius) };
 	UpdateCBSpace(Scaling * Translation);
@@ -2280,6 +2424,7 @@ void CGame::DrawMiniAxes()
 
 	for (auto& Object3D : m_vObject3DMiniAxes)
 	{
+		Object3D->UpdateWorldMatrix();
 		UpdateObject3D(Object3D.get());
 		DrawObject3D(Object3D.get());
 
@@ -2337,11 +2482,30 @@ void CGame::DrawSky(float DeltaTime)
 	{
 		m_Object3DSkySphere->ComponentTransform.Translation = m_PtrCurrentCamera->GetEyePosition();
 
+		m_Object3DSkySphere->UpdateWorldMatrix();
 		UpdateObject3D(m_Object3DSkySphere.get());
 		DrawObject3D(m_Object3DSkySphere.get(), true, true);
 	}
 }
 
+void CGame::DrawTerrain()
+{
+	m_Terrain->Update(m_PtrCurrentCamera->GetEyePosition(), m_MatrixView * m_MatrixProjection);
+
+	UpdateCBSpace();
+	SetUniversalbUseLighiting();
+	m_CBPSFlagsData.bUseLighting = TRUE;
+	m_CBPSFlagsData.bUseTexture = FALSE;
+	m_CBPSFlags->Update();
+	UpdateCBMaterialData(m_TerrainMaterialData);
+
+	m_VSBase->Use();
+	m_PSBase->Use();
+	SetUniversalRSState();
+
+	m_Terrain->Draw();
+}
+
 void CGame::Draw3DGizmos()
 {
 	if (!IsAnyObject3DSelected()) return;
@@ -2533,15 +2697,19 @@ void CGame::DrawEditorGUIPopupObjectAdder()
 		static const char* const KOptions[2]{ u8"3D  (ﰢ)", u8"2-ġ  ( 1)" };
 		static int iSelectedOption{};
 
-		static const char* const K3DPrimitiveTypes[10]{ u8"簢(XY)", u8"簢(XZ)", u8"簢(YZ)",
-				u8"", u8"ü", u8"", u8"", u8"", u8"(Torus)", u8" ﰢ" };
+		static const char* const K3DPrimitiveTypes[12]{ u8"簢(XY)", u8"簢(XZ)", u8"簢(YZ)",
+				u8"", u8"ü", u8"", u8"", u8"", u8"(Torus)", u8" ﰢ", u8"Icosphere", u8"Cube sphere" };
 		static int iSelected3DPrimitiveType{};
 		static uint32_t SideCount{ KDefaultPrimitiveDetail };
 		static uint32_t SegmentCount{ KDefaultPrimitiveDetail };
 		static float RadiusFactor{ 0.0f };
 		static float InnerRadius{ 0.5f };
+		static constexpr int KMaxIcosphereUISubdivisionLevel{ 6 }; // 81920 triangles
+		static uint32_t SubdivisionLevel{ 3 };
+		static float MaxChordalError{ 0.0f };
 		static float WidthScalar3D{ 1.0f };
 		static float HeightScalar3D{ 1.0f };
+		static bool bShouldOptimizeMesh{ false };
 		static float PixelWidth{ 50.0f };
 		static float PixelHeight{ 50.0f };
 
@@ -2615,8 +2783,25 @@ void CGame::DrawEditorGUIPopupObjectAdder()
 								ImGui::SliderInt(u8"##-  ", (int*)&SideCount, KMinPrimitiveDetail, KMaxPrimitiveDetail);
 							}
 
+							// Error-bounded spheres (a max error of 0 uses the subdivision level or SegmentCount instead)
+							if (iSelected3DPrimitiveType == 10 || iSelected3DPrimitiveType == 11)
+							{
+								ImGui::AlignTextToFramePadding();
+								ImGui::Text(u8"- Max error");
+								ImGui::SameLine(KItemsOffetX);
+								ImGui::SliderFloat(u8"##- Max error", &MaxChordalError, 0.0f, 0.05f, "%.4f", 3.0f);
+
+								if (iSelected3DPrimitiveType == 10 && MaxChordalError <= 0.0f)
+								{
+									ImGui::AlignTextToFramePadding();
+									ImGui::Text(u8"- Subdivision level");
+									ImGui::SameLine(KItemsOffetX);
+									ImGui::SliderInt(u8"##- Subdivision level", (int*)&SubdivisionLevel, 0, KMaxIcosphereUISubdivisionLevel);
+								}
+							}
+
 							// 3D primitives that require SegmentCount
-							if (iSelected3DPrimitiveType == 7 || iSelected3DPrimitiveType == 8)
+							if (iSelected3DPrimitiveType == 7 || iSelected3DPrimitiveType == 8 || (iSelected3DPrimitiveType == 11 && MaxChordalError <= 0.0f))
 							{
 								if (iSelected3DPrimitiveType == 8)
 								{
@@ -2633,6 +2818,18 @@ void CGame::DrawEditorGUIPopupObjectAdder()
 								ImGui::SliderInt(u8"##- Segment ", (int*)&SegmentCount, KMinPrimitiveDetail, KMaxPrimitiveDetail);
 							}
 
+							ImGui::AlignTextToFramePadding();
+							ImGui::Text(u8"- Optimize mesh");
+							ImGui::SameLine(KItemsOffetX);
+							ImGui::Checkbox(u8"##- Optimize mesh", &bShouldOptimizeMesh);
+
+							const SPrimitiveCacheStats KCacheStats{ m_PrimitiveCache.GetStats() };
+							ImGui::AlignTextToFramePadding();
+							ImGui::Text(u8"- Primitive cache");
+							ImGui::SameLine(KItemsOffetX);
+							ImGui::Text(u8"%d hits / %d misses, %d entries (%.1f KB)", (int)KCacheStats.HitCount, (int)KCacheStats.MissCount,
+								(int)KCacheStats.EntryCount, KCacheStats.ByteSize / 1024.0f);
+
 							ImGui::PopItemWidth();
 
 							ImGui::Unindent(KIndentPerDepth);
@@ -2665,46 +2862,54 @@ void CGame::DrawEditorGUIPopupObjectAdder()
 				CMaterialData MaterialData{};
 				MaterialData.SetUniformColor(XMFLOAT3(MaterialUniformColor.x, MaterialUniformColor.y, MaterialUniformColor.z));
 
+				// Primitives are generated on the thread pool and the object is created once its mesh is ready (see CreatePendingPrimitives())
+				SPrimitiveDesc PrimitiveDesc{};
+				PrimitiveDesc.SideCount = SideCount;
+				PrimitiveDesc.SegmentCount = SegmentCount;
+				PrimitiveDesc.RadiusFactor = RadiusFactor;
+				PrimitiveDesc.InnerRadius = InnerRadius;
+				PrimitiveDesc.SubdivisionLevel = SubdivisionLevel;
+				PrimitiveDesc.MaxChordalError = MaxChordalError;
+				bool bIsGeneratedAsync{ true };
+
 				switch (iSelected3DPrimitiveType)
 				{
 				case 0:
-					Mesh = GenerateSquareXYPlane();
-					ScaleMesh(Mesh, XMVectorSet(WidthScalar3D, HeightScalar3D, 1.0f, 0));
-					Object3D->ComponentPhysics.BoundingSphere.Radius = sqrt(2.0f);
+					PrimitiveDesc.eType = EPrimitiveType::SquareXYPlane;
+					PrimitiveDesc.Scaling = XMVectorSet(WidthScalar3D, HeightScalar3D, 1.0f, 0);
 					break;
 				case 1:
-					Mesh = GenerateSquareXZPlane();
-					ScaleMesh(Mesh, XMVectorSet(WidthScalar3D, 1.0f, HeightScalar3D, 0));
-					Object3D->ComponentPhysics.BoundingSphere.Radius = sqrt(2.0f);
+					PrimitiveDesc.eType = EPrimitiveType::SquareXZPlane;
+					PrimitiveDesc.Scaling = XMVectorSet(WidthScalar3D, 1.0f, HeightScalar3D, 0);
 					break;
 				case 2:
-					Mesh = GenerateSquareYZPlane();
-					ScaleMesh(Mesh, XMVectorSet(1.0f, WidthScalar3D, HeightScalar3D, 0));
-					Object3D->ComponentPhysics.BoundingSphere.Radius = sqrt(2.0f);
+					PrimitiveDesc.eType = EPrimitiveType::SquareYZPlane;
+					PrimitiveDesc.Scaling = XMVectorSet(1.0f, WidthScalar3D, HeightScalar3D, 0);
 					break;
 				case 3:
-					Mesh = GenerateCircleXZPlane(SideCount);
-					ScaleMesh(Mesh, XMVectorSet(WidthScalar3D, 1.0f, HeightScalar3D, 0));
+					PrimitiveDesc.eType = EPrimitiveType::CircleXZPlane;
+					PrimitiveDesc.Scaling = XMVectorSet(WidthScalar3D, 1.0f, HeightScalar3D, 0);
 					break;
 				case 4:
-					Mesh = GenerateCube();
+					PrimitiveDesc.eType = EPrimitiveType::Cube;
 					break;
 				case 5:
-					Mesh = GenerateCone(RadiusFactor, 1.0f, 1.0f, SideCount);
+					PrimitiveDesc.eType = EPrimitiveType::Cone;
 					Object3D->ComponentPhysics.BoundingSphere.CenterOffset = XMVectorSetY(Object3D->ComponentPhysics.BoundingSphere.CenterOffset, -0.5f);
+					Object3D->MarkTransformDirty();
 					break;
 				case 6:
-					Mesh = GenerateCylinder(1.0f, 1.0f, SideCount);
-					Object3D->ComponentPhysics.BoundingSphere.Radius = sqrt(1.5f);
+					PrimitiveDesc.eType = EPrimitiveType::Cylinder;
 					break;
 				case 7:
-					Mesh = GenerateSphere(SegmentCount);
+					PrimitiveDesc.eType = EPrimitiveType::Sphere;
 					break;
 				case 8:
-					Mesh = GenerateTorus(InnerRadius, SideCount, SegmentCount);
-					Object3D->ComponentPhysics.BoundingSphere.Radius += InnerRadius;
+					PrimitiveDesc.eType = EPrimitiveType::Torus;
 					break;
 				case 9:
+					bIsGeneratedAsync = false;
+
 					Mesh = GenerateTriangle(
 						XMVectorSet(0, 1.732f, 0, 1), XMVectorSet(+1.0f, 0, 0, 1), XMVectorSet(-1.0f, 0, 0, 1),
 						XMVectorSet(1, 0, 0, 1), XMVectorSet(0, 1, 0, 1), XMVectorSet(0, 0, 1, 1));
@@ -2715,11 +2920,28 @@ void CGame::DrawEditorGUIPopupObjectAdder()
 
 					Object3D->ComponentRender.PtrPS = m_PSVertexColor.get();
 					break;
+				case 10:
+					PrimitiveDesc.eType = EPrimitiveType::Icosphere;
+					break;
+				case 11:
+					PrimitiveDesc.eType = EPrimitiveType::CubeSphere;
+					break;
 				default:
 					break;
 				}
 
-				Object3D->Create(Mesh, MaterialData);
+				if (bIsGeneratedAsync)
+				{
+					m_vPendingPrimitives.emplace_back();
+					m_vPendingPrimitives.back().PtrObject3D = Object3D;
+					m_vPendingPrimitives.back().FuturePrimitive = m_ThreadPool.Submit([this, PrimitiveDesc]() { return m_PrimitiveCache.Get(PrimitiveDesc); });
+					m_vPendingPrimitives.back().MaterialData = MaterialData;
+					m_vPendingPrimitives.back().bShouldOptimizeMesh = bShouldOptimizeMesh;
+				}
+				else
+				{
+					Object3D->Create(Mesh, MaterialData, bShouldOptimizeMesh);
+				}
 
 				++m_PrimitiveCreationCounter;
 			}
@@ -2822,7 +3044,7 @@ void CGame::DrawEditorGUIWindowPropertyEditor()
 								KTranslationMinLimit, KTranslationMaxLimit, "%.2f"))
 							{
 								Object3D->ComponentTransform.Translation = XMVectorSet(Translation[0], Translation[1], Translation[2], 1.0f);
-								Object3D->UpdateWorldMatrix();
+								Object3D->MarkTransformDirty();
 							}
 
 							ImGui::AlignTextToFramePadding();
@@ -2837,7 +3059,7 @@ void CGame::DrawEditorGUIWindowPropertyEditor()
 								Object3D->ComponentTransform.Pitch = PitchYawRoll360[0] * KRotation360To2PI;
 								Object3D->ComponentTransform.Yaw = PitchYawRoll360[1] * KRotation360To2PI;
 								Object3D->ComponentTransform.Roll = PitchYawRoll360[2] * KRotation360To2PI;
-								Object3D->UpdateWorldMatrix();
+								Object3D->MarkTransformDirty();
 							}
 
 							ImGui::AlignTextToFramePadding();
@@ -2849,7 +3071,7 @@ void CGame::DrawEditorGUIWindowPropertyEditor()
 								KScalingMinLimit, KScalingMaxLimit, "%.3f"))
 							{
 								Object3D->ComponentTransform.Scaling = XMVectorSet(Scaling[0], Scaling[1], Scaling[2], 0.0f);
-								Object3D->UpdateWorldMatrix();
+								Object3D->MarkTransformDirty();
 							}
 
 							ImGui::Separator();
@@ -2866,6 +3088,7 @@ void CGame::DrawEditorGUIWindowPropertyEditor()
 							{
 								Object3D->ComponentPhysics.BoundingSphere.CenterOffset =
 									XMVectorSet(BSCenterOffset[0], BSCenterOffset[1], BSCenterOffset[2], 1.0f);
+								Object3D->MarkTransformDirty();
 							}
 
 							ImGui::AlignTextToFramePadding();
@@ -2876,6 +3099,7 @@ void CGame::DrawEditorGUIWindowPropertyEditor()
 								KBSRadiusBiasMinLimit, KBSRadiusBiasMaxLimit, "%.2f"))
 							{
 								Object3D->ComponentPhysics.BoundingSphere.RadiusBias = BSRadiusBias;
+								Object3D->MarkTransformDirty();
 							}
 
 							ImGui::AlignTextToFramePadding();
@@ -2920,6 +3144,75 @@ void CGame::DrawEditorGUIWindowPropertyEditor()
 									TriangleCount += (int)Mesh.vTriangles.size();
 								}
 								ImGui::Text(u8"%d", TriangleCount);
+
+								for (const SMeshOptimizationStats& Stats : Object3D->GetMeshOptimizationStats())
+								{
+									ImGui::AlignTextToFramePadding();
+									ImGui::Text(u8"ACMR");
+									ImGui::SameLine(ItemsOffsetX);
+									ImGui::Text(u8"%.3f -> %.3f", Stats.ACMRBefore, Stats.ACMRAfter);
+
+									ImGui::AlignTextToFramePadding();
+									ImGui::Text(u8"ATVR");
+									ImGui::SameLine(ItemsOffsetX);
+									ImGui::Text(u8"%.3f -> %.3f", Stats.ATVRBefore, Stats.ATVRAfter);
+								}
+
+								static int LODLevelCount{ 4 };
+								ImGui::AlignTextToFramePadding();
+								ImGui::Text(u8"LOD");
+								ImGui::SameLine(ItemsOffsetX);
+								ImGui::Text(u8"%d / %d (error %.4f)", (int)Object3D->GetCurrentLOD(), (int)Object3D->GetLODCount(),
+									Object3D->GetLODError(Object3D->GetCurrentLOD()));
+
+								ImGui::AlignTextToFramePadding();
+								ImGui::Text(u8"LOD levels");
+								ImGui::SameLine(ItemsOffsetX);
+								ImGui::SetNextItemWidth(ItemsWidth * 0.5f);
+								ImGui::SliderInt(u8"##LOD levels", &LODLevelCount, 1, 8);
+								ImGui::SameLine();
+								if (ImGui::Button(u8"Generate LODs"))
+								{
+									Object3D->CreateLODs(static_cast<size_t>(LODLevelCount));
+								}
+
+								ImGui::AlignTextToFramePadding();
+								ImGui::Text(u8"Meshlets");
+								ImGui::SameLine(ItemsOffsetX);
+								ImGui::Text(u8"%d / %d", (int)Object3D->GetVisibleMeshletCount(), (int)Object3D->GetMeshletCount());
+								ImGui::SameLine();
+								if (ImGui::Button(u8"Build meshlets"))
+								{
+									Object3D->CreateMeshlets();
+								}
+
+								ImGui::AlignTextToFramePadding();
+								ImGui::Text(u8"Tangents");
+								ImGui::SameLine(ItemsOffsetX);
+								if (ImGui::Button(u8"Regenerate tangents"))
+								{
+									Object3D->GenerateTangents(&m_ThreadPool);
+								}
+
+								bool bShouldPackVertices{ Object3D->ShouldPackVertices() };
+								ImGui::AlignTextToFramePadding();
+								ImGui::Text(u8"Packed vertices");
+								ImGui::SameLine(ItemsOffsetX);
+								if (ImGui::Checkbox(u8"##Packed vertices", &bShouldPackVertices))
+								{
+									Object3D->ShouldPackVertices(bShouldPackVertices);
+								}
+								ImGui::SameLine();
+								ImGui::Text(u8"%.1f KB", Object3D->GetMeshBufferByteSize() / 1024.0f);
+
+								if (Object3D->ShouldPackVertices())
+								{
+									const SVertexPackingError KError{ Object3D->GetVertexPackingError() };
+									ImGui::AlignTextToFramePadding();
+									ImGui::Text(u8"Packing error");
+									ImGui::SameLine(ItemsOffsetX);
+									ImGui::Text(u8"P %.5f, N %.3f deg, T %.3f deg, UV %.5f", KError.Position, KError.NormalDegrees, KError.TangentDegrees, KError.TexCoord);
+								}
 							}
 
 							// Tessellation data
@@ -2935,6 +3228,23 @@ void CGame::DrawEditorGUIWindowPropertyEditor()
 								{
 									Object3D->ShouldTessellate(bShouldTessellate);
 								}
+								if (Object3D->ShouldTessellate())
+								{
+									// Bakes the current look into the meshes
+									ImGui::SameLine();
+									if (ImGui::Button(u8"Freeze"))
+									{
+										Object3D->FreezeTessellation(Object3D->GetTessFactorData(), Object3D->TessellationType(), Object3D->GetDisplacementData(),
+											&m_ThreadPool, &m_TessellationCache);
+									}
+								}
+
+								const STessellationCacheStats KCacheStats{ m_TessellationCache.GetStats() };
+								ImGui::AlignTextToFramePadding();
+								ImGui::Text(u8"Tessellation cache");
+								ImGui::SameLine(ItemsOffsetX);
+								ImGui::Text(u8"%d hits / %d misses (%.0f%%), %d entries (%.1f KB)", (int)KCacheStats.HitCount, (int)KCacheStats.MissCount,
+									KCacheStats.GetHitRate() * 100.0f, (int)KCacheStats.EntryCount, KCacheStats.ByteSize / 1024.0f);
 							}
 							
 							ImGui::AlignTextToFramePadding();
@@ -2963,6 +3273,15 @@ void CGame::DrawEditorGUIWindowPropertyEditor()
 								Object3D->SetTessFactorData(TessFactorData);
 							}
 
+							ImGui::AlignTextToFramePadding();
+							ImGui::Text(u8"Target edge length");
+							ImGui::SameLine(ItemsOffsetX);
+							// 0 applies the factors above uniformly; otherwise they are the maximums
+							if (ImGui::SliderFloat(u8"##Target edge length", &TessFactorData.TargetEdgePixelLength, 0.0f, 64.0f, "%.1f px"))
+							{
+								Object3D->SetTessFactorData(TessFactorData);
+							}
+
 							CObject3D::SCBDisplacementData DisplacementData{ Object3D->GetDisplacementData() };
 							ImGui::AlignTextToFramePadding();
 							ImGui::Text(u8" ");
@@ -3189,6 +3508,21 @@ void CGame::DrawEditorGUIWindowPropertyEditor()
 							ImGui::AlignTextToFramePadding();
 							ImGui::Text(u8"%d", m_FPS);
 
+							ImGui::AlignTextToFramePadding();
+							ImGui::Text(u8"World matrices updated:");
+							ImGui::SameLine(ItemsOffsetX);
+							ImGui::AlignTextToFramePadding();
+							ImGui::Text(u8"%d / %d", (int)m_UpdatedWorldMatrixCount, (int)m_vObject3Ds.size());
+
+							ImGui::AlignTextToFramePadding();
+							ImGui::Text(u8"Tessellated triangles:");
+							ImGui::SameLine(ItemsOffsetX);
+							if (ImGui::Button(u8"Count")) CountTessellatedTriangles();
+							ImGui::SameLine();
+							ImGui::AlignTextToFramePadding();
+							ImGui::Text(u8"%d / %d uniform (%.1f%%)", (int)m_TessellatedTriangleCount, (int)m_UniformTessellatedTriangleCount,
+								(m_UniformTessellatedTriangleCount) ? 100.0 * m_TessellatedTriangleCount / m_UniformTessellatedTriangleCount : 100.0);
+
 							ImGui::TreePop();
 						}
 
@@ -3632,6 +3966,29 @@ void CGame::DrawEditorGUIWindowSceneEditor()
 
 			ImGui::Separator();
 
+			bool bUseTerrain{ m_Terrain != nullptr };
+			if (ImGui::Checkbox(u8"Streaming terrain", &bUseTerrain))
+			{
+				if (bUseTerrain)
+				{
+					m_Terrain = make_unique<CTerrain>(m_Device.Get(), m_DeviceContext.Get(), m_ThreadPool);
+					m_Terrain->Create(STerrainDesc());
+				}
+				else
+				{
+					m_Terrain.reset();
+				}
+			}
+			if (m_Terrain)
+			{
+				const STerrainStats KStats{ m_Terrain->GetStats() };
+				ImGui::Text(u8"Chunks: %d visible / %d resident, %d pending", (int)KStats.VisibleChunkCount, (int)KStats.ResidentChunkCount,
+					(int)KStats.PendingChunkCount);
+				ImGui::Text(u8"Vertex buffers: %d created, %d pooled", (int)KStats.CreatedVertexBufferCount, (int)KStats.PooledVertexBufferCount);
+			}
+
+			ImGui::Separator();
+
 			ImGui::Text(u8"Ʈ");
 			ImGui::Separator();
 
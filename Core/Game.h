@@ -6,6 +6,7 @@
 #include <chrono>
 
 #include "Math.h"
+#include "RayTriangleSoA.h"
 #include "Camera.h"
 #include "Shader.h"
 #include "ConstantBuffer.h"
@@ -14,6 +15,9 @@
 #include "Object3DLine.h"
 #include "Object2D.h"
 #include "PrimitiveGenerator.h"
+#include "PrimitiveCache.h"
+#include "TessellationCache.h"
+#include "Terrain.h"
 
 #include "TinyXml2/tinyxml2.h"
 #include "ImGui/imgui.h"
@@ -26,6 +30,7 @@ public:
 	enum class EBaseShader
 	{
 		VSBase,
+		VSBasePacked,
 		VSSky,
 		VSLine,
 		VSGizmo,
@@ -188,6 +193,16 @@ public:
 		bool		bHasFailedPickingTest{ false };
 	};
 
+	// DeleteObject3D() and ClearObject3Ds() drop the entries of the objects they remove, so PtrObject3D never dangles
+	// and a new object that reuses the name can't receive the mesh
+	struct SPendingPrimitive
+	{
+		CObject3D*			PtrObject3D{};
+		std::future<std::shared_ptr<const SCachedPrimitive>>	FuturePrimitive{};
+		CMaterialData		MaterialData{};
+		bool				bShouldOptimizeMesh{};
+	};
+
 	struct SScreenQuadVertex
 	{
 		SScreenQuadVertex(const XMFLOAT4& _Position, const XMFLOAT3& _TexCoord) : Position{ _Position }, TexCoord{ _TexCoord } {}
@@ -240,10 +255,12 @@ public:
 	// Shader-related settings
 public:
 	void UpdateCBMaterialData(const CMaterialData& MaterialData);
+	void UpdateCBVertexQuantizationData(const SPositionQuantization& Data);
 
 private:
 	void UpdateCBSpace(const XMMATRIX& World = KMatrixIdentity);
 
+	// Also updates the camera that screen-space factors are measured with
 	void UpdateCBTessFactorData(const CObject3D::SCBTessFactorData& Data);
 	void UpdateCBDisplacementData(const CObject3D::SCBDisplacementData& Data);
 
@@ -372,9 +389,16 @@ public:
 	auto GetBlendStateAlphaToCoverage() const->ID3D11BlendState* { return m_BlendAlphaToCoverage.Get(); }
 	auto GetWorkingDirectory() const->const char* { return m_WorkingDirectory; }
 	auto GetDeltaTime() const->float { return m_DeltaTimeF; }
+	auto GetThreadPool()->CThreadPool& { return m_ThreadPool; }
 
 private:
+	void CreatePendingPrimitives();
+	// Rebuilds the world matrices of the Object3Ds whose transforms were marked dirty, in one batch
+	void UpdateObject3DWorldMatrices();
 	void UpdateObject3D(CObject3D* const PtrObject3D);
+	CObject3D::SCBTessCameraData GetTessCameraData() const;
+	// Triangles the tessellator outputs for the whole scene, with each object's factors and with them applied uniformly (for comparison)
+	void CountTessellatedTriangles();
 	void DrawObject3D(const CObject3D* const PtrObject3D, bool bIgnoreInstances = false, bool bIgnoreOwnTexture = false);
 	void DrawObject3DBoundingSphere(const CObject3D* const PtrObject3D);
 
@@ -390,6 +414,8 @@ private:
 
 	void DrawSky(float DeltaTime);
 
+	void DrawTerrain();
+
 	void Draw3DGizmos();
 	void Draw3DGizmoTranslations(E3DGizmoAxis Axis);
 	void Draw3DGizmoRotations(E3DGizmoAxis Axis);
@@ -463,6 +489,7 @@ private:
 
 private:
 	std::unique_ptr<CShader>	m_VSBase{};
+	std::unique_ptr<CShader>	m_VSBasePacked{};
 	std::unique_ptr<CShader>	m_VSSky{};
 	std::unique_ptr<CShader>	m_VSLine{};
 	std::unique_ptr<CShader>	m_VSGizmo{};
@@ -494,7 +521,9 @@ private:
 	std::unique_ptr<CConstantBuffer> m_CBSpaceVP{};
 	std::unique_ptr<CConstantBuffer> m_CBSpace2D{};
 	std::unique_ptr<CConstantBuffer> m_CBTessFactor{};
+	std::unique_ptr<CConstantBuffer> m_CBTessCamera{};
 	std::unique_ptr<CConstantBuffer> m_CBDisplacement{};
+	std::unique_ptr<CConstantBuffer> m_CBVertexQuantization{};
 	std::unique_ptr<CConstantBuffer> m_CBLight{};
 	std::unique_ptr<CConstantBuffer> m_CBMaterial{};
 	std::unique_ptr<CConstantBuffer> m_CBPSFlags{}; // ...
@@ -508,7 +537,9 @@ private:
 	SCBSpace2DData				m_CBSpace2DData{};
 
 	CObject3D::SCBTessFactorData	m_CBTessFactorData{};
+	CObject3D::SCBTessCameraData	m_CBTessCameraData{};
 	CObject3D::SCBDisplacementData	m_CBDisplacementData{};
+	SPositionQuantization			m_CBVertexQuantizationData{};
 
 	SCBLightData					m_CBLightData{};
 	SCBMaterialData					m_CBMaterialData{};
@@ -521,10 +552,19 @@ private:
 
 private:
 	std::vector<std::unique_ptr<CShader>>				m_vShaders{};
+	// Declared before m_vObject3Ds so that it outlives the objects, which remove themselves from it
+	CObject3DTree										m_Object3DTree{};
 	std::vector<std::unique_ptr<CObject3D>>				m_vObject3Ds{};
+	std::vector<CObject3D*>								m_vPtrDirtyObject3Ds{};
+	// Of the last frame
+	size_t												m_UpdatedWorldMatrixCount{};
+	// Of the last CountTessellatedTriangles()
+	size_t												m_TessellatedTriangleCount{};
+	size_t												m_UniformTessellatedTriangleCount{};
 	std::vector<std::unique_ptr<CObject3DLine>>			m_vObject3DLines{};
 	std::vector<std::unique_ptr<CObject2D>>				m_vObject2Ds{};
 	std::vector<CMaterialData>							m_vMaterialData{};
+	CMaterialData										m_TerrainMaterialData{};
 	std::vector<std::unique_ptr<CMaterialTextureSet>>	m_vMaterialTextureSets{};
 
 	std::unique_ptr<CObject3DLine>				m_Object3DLinePickingRay{};
@@ -544,6 +584,7 @@ private:
 	std::map<std::string, size_t>	m_mapObject2DNameToIndex{};
 
 	size_t							m_PrimitiveCreationCounter{};
+	std::vector<SPendingPrimitive>	m_vPendingPrimitives{};
 
 private:
 	std::unique_ptr<CObject3D>		m_Object3D_3DGizmoRotationPitch{};
@@ -662,6 +703,13 @@ private:
 	std::unique_ptr<SpriteFont>			m_SpriteFont{};
 	std::unique_ptr<CommonStates>		m_CommonStates{};
 	bool								m_IsDestroyed{ false };
+
+private:
+	// Declared before the thread pool, which may still be running primitive or terrain chunk generation while it is destroyed
+	CPrimitiveCache						m_PrimitiveCache{};
+	CTessellationCache					m_TessellationCache{};
+	std::unique_ptr<CTerrain>			m_Terrain{};
+	CThreadPool							m_ThreadPool{};
 };
 
 ENUM_CLASS_FLAG(CGame::EFlagsRendering)
\ No newline at end of file
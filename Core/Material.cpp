@@ -413,6 +413,11 @@ ID3D11ShaderResourceView* CMaterialTextureSet::GetTextureSRV(STextureData::EType
 	return m_Textures[(int)eType].GetShaderResourceViewPtr();
 }
 
+ID3D11Texture2D* CMaterialTextureSet::GetTexture2D(STextureData::EType eType) const
+{
+	return m_Textures[(int)eType].GetTexture2DPtr();
+}
+
 void CMaterialData::Name(const string& Name)
 {
 	m_Name = Name;
@@ -219,6 +219,7 @@ public:
 
 public:
 	ID3D11ShaderResourceView* GetTextureSRV(STextureData::EType eType);
+	ID3D11Texture2D* GetTexture2D(STextureData::EType eType) const;
 
 private:
 	ID3D11Device* const			m_PtrDevice{};
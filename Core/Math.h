@@ -1,6 +1,7 @@
 #pragma once
 
 #include "SharedHeader.h"
+#include "Sampling.h"
 
 using namespace DirectX;
 
@@ -20,6 +21,8 @@ static bool IntersectRayTriangle(const XMVECTOR& RayOrigin, const XMVECTOR& RayD
 	const XMVECTOR& TriangleV0, const XMVECTOR& TriangleV1, const XMVECTOR& TriangleV2, XMVECTOR* OutPtrT);
 static float GetPlanePointDistnace(const XMVECTOR& PlaneP, const XMVECTOR& PlaneN, const XMVECTOR& Point);
 static bool IntersectRayCylinder(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, float CylinderHeight, float CylinderRadius);
+static void ExtractFrustumPlanes(const XMMATRIX& Matrix, XMVECTOR(&OutPlanes)[6]);
+static bool IsSphereOutsideFrustum(const XMVECTOR(&Planes)[6], const XMVECTOR& Center, float Radius);
 
 static float Lerp(float a, float b, float t)
 {
@@ -52,23 +55,20 @@ static XMVECTOR Slerp(const XMVECTOR& P0, const XMVECTOR& P1, float t)
 	}
 }
 
+// [Min, Max], from the calling thread's generator (see CRandom)
 static int GetRandom(int Min, int Max)
 {
 	if (Min >= Max) return Min;
 
-	return (rand() % (Max - Min + 1)) + Min;
+	return CRandom::GetThreadLocal().NextInt(Min, Max);
 }
 
+// [Min, Max)
 static float GetRandom(float Min, float Max)
 {
 	if (Min >= Max) return Min;
 
-	constexpr float KFreedom{ 100.0f };
-	float Range{ Max - Min };
-	int IntRange{ (int)(KFreedom * Range) };
-	int IntRangeHalf{ (int)(IntRange / 2) };
-
-	return static_cast<float>((rand() % (IntRange + 1) / KFreedom) + Min);
+	return CRandom::GetThreadLocal().NextFloat(Min, Max);
 }
 
 static bool IntersectRaySphere(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, float Radius, const XMVECTOR& Center, XMVECTOR* const OutPtrT) noexcept
@@ -245,4 +245,30 @@ static bool IntersectRayCylinder(const XMVECTOR& RayOrigin, const XMVECTOR& RayD
 	}
 
 	return false;
-}
\ No newline at end of file
+}
+
+// Planes of the clip volume of Matrix (row vectors, D3D clip space 0 <= z <= w), pointing inwards and normalized.
+// Pass World * View * Projection to get the planes in object space.
+static void ExtractFrustumPlanes(const XMMATRIX& Matrix, XMVECTOR(&OutPlanes)[6])
+{
+	const XMMATRIX KColumns{ XMMatrixTranspose(Matrix) };
+	OutPlanes[0] = KColumns.r[3] + KColumns.r[0]; // left
+	OutPlanes[1] = KColumns.r[3] - KColumns.r[0]; // right
+	OutPlanes[2] = KColumns.r[3] + KColumns.r[1]; // bottom
+	OutPlanes[3] = KColumns.r[3] - KColumns.r[1]; // top
+	OutPlanes[4] = KColumns.r[2]; // near
+	OutPlanes[5] = KColumns.r[3] - KColumns.r[2]; // far
+	for (auto& Plane : OutPlanes)
+	{
+		Plane = XMPlaneNormalize(Plane);
+	}
+}
+
+static bool IsSphereOutsideFrustum(const XMVECTOR(&Planes)[6], const XMVECTOR& Center, float Radius)
+{
+	for (const auto& Plane : Planes)
+	{
+		if (XMVectorGetX(XMPlaneDotCoord(Plane, Center)) < -Radius) return true;
+	}
+	return false;
+}
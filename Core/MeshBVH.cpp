@@ -0,0 +1,416 @@
+#include "MeshBVH.h"
+
+using std::vector;
+using std::pair;
+using std::min;
+using std::max;
+
+static constexpr uint32_t KInvalidIndex{ UINT32_MAX };
+
+// Bounds may be off by a few ulps against the sheared-ray triangle test, so the exit distance is widened (Ize 2013)
+static constexpr float KExitDistanceScale{ 1.0f + 2.0f * 3.6e-7f };
+
+static float GetHalfSurfaceArea(const XMFLOAT3& Min, const XMFLOAT3& Max)
+{
+	const float KX{ Max.x - Min.x };
+	const float KY{ Max.y - Min.y };
+	const float KZ{ Max.z - Min.z };
+	return KX * KY + KY * KZ + KZ * KX;
+}
+
+static void ExpandBounds(XMFLOAT3& Min, XMFLOAT3& Max, const XMFLOAT3& PointMin, const XMFLOAT3& PointMax)
+{
+	Min.x = min(Min.x, PointMin.x);
+	Min.y = min(Min.y, PointMin.y);
+	Min.z = min(Min.z, PointMin.z);
+	Max.x = max(Max.x, PointMax.x);
+	Max.y = max(Max.y, PointMax.y);
+	Max.z = max(Max.z, PointMax.z);
+}
+
+static float GetAxis(const XMFLOAT3& Value, uint32_t Axis)
+{
+	return (Axis == 0) ? Value.x : (Axis == 1) ? Value.y : Value.z;
+}
+
+// Leaves are tested a batch at a time
+static float GetLeafCost(size_t TriangleCount)
+{
+	return static_cast<float>((TriangleCount + STriangleSoA::KBatchSize - 1) / STriangleSoA::KBatchSize);
+}
+
+void CMeshBVH::Build(const SMesh& Mesh)
+{
+	m_vNodes.clear();
+	m_vSlotTriangles.clear();
+	m_Triangles = STriangleSoA();
+
+	const size_t KTriangleCount{ Mesh.vTriangles.size() };
+	if (KTriangleCount == 0) return;
+
+	vector<SBuildTriangle> vBuildTriangles(KTriangleCount);
+	for (size_t iTriangle = 0; iTriangle < KTriangleCount; ++iTriangle)
+	{
+		const STriangle& KTriangle{ Mesh.vTriangles[iTriangle] };
+		const XMVECTOR KV0{ Mesh.vVertices[KTriangle.I0].Position };
+		const XMVECTOR KV1{ Mesh.vVertices[KTriangle.I1].Position };
+		const XMVECTOR KV2{ Mesh.vVertices[KTriangle.I2].Position };
+
+		SBuildTriangle& BuildTriangle{ vBuildTriangles[iTriangle] };
+		XMStoreFloat3(&BuildTriangle.BoundsMin, XMVectorMin(XMVectorMin(KV0, KV1), KV2));
+		XMStoreFloat3(&BuildTriangle.BoundsMax, XMVectorMax(XMVectorMax(KV0, KV1), KV2));
+		XMStoreFloat3(&BuildTriangle.Centroid, (KV0 + KV1 + KV2) / 3.0f);
+		BuildTriangle.TriangleIndex = static_cast<uint32_t>(iTriangle);
+	}
+
+	m_Triangles.TriangleCount = KTriangleCount;
+	m_vNodes.reserve(KTriangleCount / STriangleSoA::KBatchSize * 4 + 1);
+	m_vSlotTriangles.reserve((KTriangleCount / STriangleSoA::KBatchSize + 1) * STriangleSoA::KBatchSize * 2);
+	m_vNodes.emplace_back();
+
+	// Depth first, without recursion: SAH splits can be arbitrarily unbalanced
+	struct SRange
+	{
+		uint32_t	NodeIndex{};
+		size_t		Begin{};
+		size_t		End{};
+	};
+	vector<SRange> vStack{};
+	vStack.push_back(SRange{ 0, 0, KTriangleCount });
+	while (!vStack.empty())
+	{
+		const SRange KRange{ vStack.back() };
+		vStack.pop_back();
+
+		const size_t KSplit{ SplitNode(KRange.NodeIndex, Mesh, vBuildTriangles, KRange.Begin, KRange.End) };
+		if (KSplit == 0) continue;
+
+		const uint32_t KChildIndex{ m_vNodes[KRange.NodeIndex].ChildOrFirstSlot };
+		vStack.push_back(SRange{ KChildIndex + 1, KSplit, KRange.End });
+		vStack.push_back(SRange{ KChildIndex, KRange.Begin, KSplit });
+	}
+}
+
+size_t CMeshBVH::SplitNode(uint32_t NodeIndex, const SMesh& Mesh, vector<SBuildTriangle>& vBuildTriangles, size_t Begin, size_t End)
+{
+	const size_t KCount{ End - Begin };
+
+	XMFLOAT3 BoundsMin{ FLT_MAX, FLT_MAX, FLT_MAX };
+	XMFLOAT3 BoundsMax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	XMFLOAT3 CentroidMin{ FLT_MAX, FLT_MAX, FLT_MAX };
+	XMFLOAT3 CentroidMax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (size_t iTriangle = Begin; iTriangle < End; ++iTriangle)
+	{
+		const SBuildTriangle& KBuildTriangle{ vBuildTriangles[iTriangle] };
+		ExpandBounds(BoundsMin, BoundsMax, KBuildTriangle.BoundsMin, KBuildTriangle.BoundsMax);
+		ExpandBounds(CentroidMin, CentroidMax, KBuildTriangle.Centroid, KBuildTriangle.Centroid);
+	}
+	m_vNodes[NodeIndex].BoundsMin = BoundsMin;
+	m_vNodes[NodeIndex].BoundsMax = BoundsMax;
+
+	// A leaf fills one batch
+	if (KCount <= STriangleSoA::KBatchSize)
+	{
+		const size_t KFirstSlot{ m_vSlotTriangles.size() };
+		const size_t KSlotEnd{ KFirstSlot + STriangleSoA::KBatchSize };
+		m_vSlotTriangles.resize(KSlotEnd, KInvalidIndex);
+		for (auto& Corner : m_Triangles.vPositions)
+		{
+			for (auto& Axis : Corner)
+			{
+				Axis.resize(KSlotEnd);
+			}
+		}
+		for (size_t iTriangle = Begin; iTriangle < End; ++iTriangle)
+		{
+			WriteSlot(KFirstSlot + (iTriangle - Begin), Mesh, vBuildTriangles[iTriangle].TriangleIndex);
+		}
+
+		m_vNodes[NodeIndex].ChildOrFirstSlot = static_cast<uint32_t>(KFirstSlot);
+		m_vNodes[NodeIndex].TriangleCount = static_cast<uint32_t>(KCount);
+		return 0;
+	}
+
+	// Binned SAH over the centroids, on every axis
+	struct SBin
+	{
+		XMFLOAT3	BoundsMin{ FLT_MAX, FLT_MAX, FLT_MAX };
+		XMFLOAT3	BoundsMax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		size_t		Count{};
+	};
+	auto GetBin{ [&](const SBuildTriangle& BuildTriangle, uint32_t Axis)
+		{
+			const float KMin{ GetAxis(CentroidMin, Axis) };
+			const float KExtent{ GetAxis(CentroidMax, Axis) - KMin };
+			const uint32_t KBin{ static_cast<uint32_t>((GetAxis(BuildTriangle.Centroid, Axis) - KMin) / KExtent * KBinCount) };
+			return min(KBin, KBinCount - 1);
+		}
+	};
+
+	const float KNodeArea{ GetHalfSurfaceArea(BoundsMin, BoundsMax) };
+	float BestCost{ FLT_MAX };
+	uint32_t BestAxis{ KInvalidIndex };
+	uint32_t BestBin{};
+	for (uint32_t iAxis = 0; iAxis < 3; ++iAxis)
+	{
+		if (GetAxis(CentroidMax, iAxis) <= GetAxis(CentroidMin, iAxis)) continue;
+
+		SBin Bins[KBinCount]{};
+		for (size_t iTriangle = Begin; iTriangle < End; ++iTriangle)
+		{
+			const SBuildTriangle& KBuildTriangle{ vBuildTriangles[iTriangle] };
+			SBin& Bin{ Bins[GetBin(KBuildTriangle, iAxis)] };
+			ExpandBounds(Bin.BoundsMin, Bin.BoundsMax, KBuildTriangle.BoundsMin, KBuildTriangle.BoundsMax);
+			++Bin.Count;
+		}
+
+		// Right-to-left sweep first, then evaluate every plane in the left-to-right sweep
+		float RightCosts[KBinCount]{};
+		{
+			SBin Right{};
+			for (uint32_t iBin = KBinCount - 1; iBin > 0; --iBin)
+			{
+				ExpandBounds(Right.BoundsMin, Right.BoundsMax, Bins[iBin].BoundsMin, Bins[iBin].BoundsMax);
+				Right.Count += Bins[iBin].Count;
+				RightCosts[iBin] = (Right.Count == 0) ? 0.0f : GetHalfSurfaceArea(Right.BoundsMin, Right.BoundsMax) * GetLeafCost(Right.Count);
+			}
+		}
+
+		SBin Left{};
+		for (uint32_t iBin = 0; iBin < KBinCount - 1; ++iBin)
+		{
+			ExpandBounds(Left.BoundsMin, Left.BoundsMax, Bins[iBin].BoundsMin, Bins[iBin].BoundsMax);
+			Left.Count += Bins[iBin].Count;
+			if (Left.Count == 0 || Left.Count == KCount) continue;
+
+			const float KCost{ KTraversalCost + (GetHalfSurfaceArea(Left.BoundsMin, Left.BoundsMax) * GetLeafCost(Left.Count) + RightCosts[iBin + 1]) /
+				max(KNodeArea, FLT_MIN) };
+			if (KCost < BestCost)
+			{
+				BestCost = KCost;
+				BestAxis = iAxis;
+				BestBin = iBin;
+			}
+		}
+	}
+
+	size_t Split{};
+	if (BestAxis != KInvalidIndex)
+	{
+		auto KPtrSplit{ std::partition(vBuildTriangles.begin() + Begin, vBuildTriangles.begin() + End,
+			[&](const SBuildTriangle& BuildTriangle) { return GetBin(BuildTriangle, BestAxis) <= BestBin; }) };
+		Split = static_cast<size_t>(KPtrSplit - vBuildTriangles.begin());
+	}
+	else
+	{
+		// Every centroid is the same point
+		Split = Begin + KCount / 2;
+	}
+	assert(Split > Begin && Split < End);
+
+	const uint32_t KChildIndex{ static_cast<uint32_t>(m_vNodes.size()) };
+	m_vNodes.emplace_back();
+	m_vNodes.emplace_back();
+	m_vNodes[NodeIndex].ChildOrFirstSlot = KChildIndex;
+	m_vNodes[NodeIndex].TriangleCount = 0;
+	return Split;
+}
+
+void CMeshBVH::Refit(const SMesh& Mesh)
+{
+	// The triangles changed after all
+	if (!IsBuilt() || Mesh.vTriangles.size() != GetTriangleCount())
+	{
+		Build(Mesh);
+		return;
+	}
+
+	for (size_t iSlot = 0; iSlot < m_vSlotTriangles.size(); ++iSlot)
+	{
+		if (m_vSlotTriangles[iSlot] != KInvalidIndex) WriteSlot(iSlot, Mesh, m_vSlotTriangles[iSlot]);
+	}
+
+	// Children always come after their parent
+	for (size_t iNode = m_vNodes.size(); iNode-- > 0;)
+	{
+		SNode& Node{ m_vNodes[iNode] };
+		XMFLOAT3 BoundsMin{ FLT_MAX, FLT_MAX, FLT_MAX };
+		XMFLOAT3 BoundsMax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		if (Node.TriangleCount > 0)
+		{
+			for (size_t iSlot = Node.ChildOrFirstSlot; iSlot < Node.ChildOrFirstSlot + Node.TriangleCount; ++iSlot)
+			{
+				for (const auto& Corner : m_Triangles.vPositions)
+				{
+					const XMFLOAT3 KPosition{ Corner[0][iSlot], Corner[1][iSlot], Corner[2][iSlot] };
+					ExpandBounds(BoundsMin, BoundsMax, KPosition, KPosition);
+				}
+			}
+		}
+		else
+		{
+			const SNode& KLeft{ m_vNodes[Node.ChildOrFirstSlot] };
+			const SNode& KRight{ m_vNodes[Node.ChildOrFirstSlot + 1] };
+			ExpandBounds(BoundsMin, BoundsMax, KLeft.BoundsMin, KLeft.BoundsMax);
+			ExpandBounds(BoundsMin, BoundsMax, KRight.BoundsMin, KRight.BoundsMax);
+		}
+		Node.BoundsMin = BoundsMin;
+		Node.BoundsMax = BoundsMax;
+	}
+}
+
+bool CMeshBVH::Intersect(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, float MaxT, SRayTriangleHit* const OutPtrHit) const
+{
+	if (!IsBuilt() || XMVector3Equal(RayDirection, XMVectorZero())) return false;
+
+	XMFLOAT3 Origin{};
+	XMFLOAT3 Direction{};
+	XMStoreFloat3(&Origin, RayOrigin);
+	XMStoreFloat3(&Direction, RayDirection);
+
+	// A zero component gives huge but finite slab distances, so that no 0 * inf appears
+	const XMFLOAT3 KInverseDirection{
+		(Direction.x != 0.0f) ? 1.0f / Direction.x : FLT_MAX,
+		(Direction.y != 0.0f) ? 1.0f / Direction.y : FLT_MAX,
+		(Direction.z != 0.0f) ? 1.0f / Direction.z : FLT_MAX };
+
+	SRayTriangleHit Hit{};
+	Hit.T = MaxT;
+
+	// Entry distance, or -1 if the ray misses the node before Hit.T
+	auto GetEntry{ [&](const SNode& Node)
+		{
+			float Entry{ 0.0f };
+			float Exit{ Hit.T };
+			const float KT0X{ (Node.BoundsMin.x - Origin.x) * KInverseDirection.x }, KT1X{ (Node.BoundsMax.x - Origin.x) * KInverseDirection.x };
+			const float KT0Y{ (Node.BoundsMin.y - Origin.y) * KInverseDirection.y }, KT1Y{ (Node.BoundsMax.y - Origin.y) * KInverseDirection.y };
+			const float KT0Z{ (Node.BoundsMin.z - Origin.z) * KInverseDirection.z }, KT1Z{ (Node.BoundsMax.z - Origin.z) * KInverseDirection.z };
+			Entry = max(Entry, max(min(KT0X, KT1X), max(min(KT0Y, KT1Y), min(KT0Z, KT1Z))));
+			Exit = min(Exit, min(max(KT0X, KT1X), min(max(KT0Y, KT1Y), max(KT0Z, KT1Z))) * KExitDistanceScale);
+			return (Entry <= Exit) ? Entry : -1.0f;
+		}
+	};
+
+	const SShearedRay KRay{ MakeShearedRay(RayOrigin, RayDirection) };
+
+	vector<pair<uint32_t, float>> vStack{};
+	vStack.reserve(64);
+	const float KRootEntry{ GetEntry(m_vNodes[0]) };
+	if (KRootEntry >= 0.0f) vStack.emplace_back(0, KRootEntry);
+	while (!vStack.empty())
+	{
+		const pair<uint32_t, float> KEntry{ vStack.back() };
+		vStack.pop_back();
+
+		// A closer hit was found after the node was pushed
+		if (KEntry.second >= Hit.T) continue;
+
+		const SNode& KNode{ m_vNodes[KEntry.first] };
+		if (KNode.TriangleCount > 0)
+		{
+			IntersectRayTriangleRange(KRay, m_Triangles, KNode.ChildOrFirstSlot, KNode.ChildOrFirstSlot + STriangleSoA::KBatchSize, Hit);
+			continue;
+		}
+
+		// The nearer child is visited first
+		const uint32_t KLeftIndex{ KNode.ChildOrFirstSlot };
+		const float KLeftEntry{ GetEntry(m_vNodes[KLeftIndex]) };
+		const float KRightEntry{ GetEntry(m_vNodes[KLeftIndex + 1]) };
+		if (KLeftEntry <= KRightEntry)
+		{
+			if (KRightEntry >= 0.0f) vStack.emplace_back(KLeftIndex + 1, KRightEntry);
+			if (KLeftEntry >= 0.0f) vStack.emplace_back(KLeftIndex, KLeftEntry);
+		}
+		else
+		{
+			if (KLeftEntry >= 0.0f) vStack.emplace_back(KLeftIndex, KLeftEntry);
+			if (KRightEntry >= 0.0f) vStack.emplace_back(KLeftIndex + 1, KRightEntry);
+		}
+	}
+
+	if (Hit.TriangleIndex == KInvalidIndex) return false;
+
+	Hit.TriangleIndex = m_vSlotTriangles[Hit.TriangleIndex];
+	if (OutPtrHit) *OutPtrHit = Hit;
+	return true;
+}
+
+void CMeshBVH::QueryRay(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, float Margin, float MaxT,
+	const std::function<float(uint32_t, float)>& Callback) const
+{
+	if (!IsBuilt() || XMVector3Equal(RayDirection, XMVectorZero())) return;
+
+	XMFLOAT3 Origin{};
+	XMFLOAT3 Direction{};
+	XMStoreFloat3(&Origin, RayOrigin);
+	XMStoreFloat3(&Direction, RayDirection);
+
+	const XMFLOAT3 KInverseDirection{
+		(Direction.x != 0.0f) ? 1.0f / Direction.x : FLT_MAX,
+		(Direction.y != 0.0f) ? 1.0f / Direction.y : FLT_MAX,
+		(Direction.z != 0.0f) ? 1.0f / Direction.z : FLT_MAX };
+
+	float CurrentMaxT{ MaxT };
+	auto GetEntry{ [&](const SNode& Node)
+		{
+			float Entry{ 0.0f };
+			float Exit{ CurrentMaxT };
+			const float KT0X{ (Node.BoundsMin.x - Margin - Origin.x) * KInverseDirection.x }, KT1X{ (Node.BoundsMax.x + Margin - Origin.x) * KInverseDirection.x };
+			const float KT0Y{ (Node.BoundsMin.y - Margin - Origin.y) * KInverseDirection.y }, KT1Y{ (Node.BoundsMax.y + Margin - Origin.y) * KInverseDirection.y };
+			const float KT0Z{ (Node.BoundsMin.z - Margin - Origin.z) * KInverseDirection.z }, KT1Z{ (Node.BoundsMax.z + Margin - Origin.z) * KInverseDirection.z };
+			Entry = max(Entry, max(min(KT0X, KT1X), max(min(KT0Y, KT1Y), min(KT0Z, KT1Z))));
+			Exit = min(Exit, min(max(KT0X, KT1X), min(max(KT0Y, KT1Y), max(KT0Z, KT1Z))) * KExitDistanceScale);
+			return (Entry <= Exit) ? Entry : -1.0f;
+		}
+	};
+
+	vector<pair<uint32_t, float>> vStack{};
+	vStack.reserve(64);
+	const float KRootEntry{ GetEntry(m_vNodes[0]) };
+	if (KRootEntry >= 0.0f) vStack.emplace_back(0, KRootEntry);
+	while (!vStack.empty())
+	{
+		const pair<uint32_t, float> KEntry{ vStack.back() };
+		vStack.pop_back();
+		if (KEntry.second >= CurrentMaxT) continue;
+
+		const SNode& KNode{ m_vNodes[KEntry.first] };
+		if (KNode.TriangleCount > 0)
+		{
+			for (uint32_t iSlot = KNode.ChildOrFirstSlot; iSlot < KNode.ChildOrFirstSlot + KNode.TriangleCount; ++iSlot)
+			{
+				CurrentMaxT = Callback(m_vSlotTriangles[iSlot], CurrentMaxT);
+			}
+			continue;
+		}
+
+		const uint32_t KLeftIndex{ KNode.ChildOrFirstSlot };
+		const float KLeftEntry{ GetEntry(m_vNodes[KLeftIndex]) };
+		const float KRightEntry{ GetEntry(m_vNodes[KLeftIndex + 1]) };
+		if (KLeftEntry <= KRightEntry)
+		{
+			if (KRightEntry >= 0.0f) vStack.emplace_back(KLeftIndex + 1, KRightEntry);
+			if (KLeftEntry >= 0.0f) vStack.emplace_back(KLeftIndex, KLeftEntry);
+		}
+		else
+		{
+			if (KLeftEntry >= 0.0f) vStack.emplace_back(KLeftIndex, KLeftEntry);
+			if (KRightEntry >= 0.0f) vStack.emplace_back(KLeftIndex + 1, KRightEntry);
+		}
+	}
+}
+
+void CMeshBVH::WriteSlot(size_t Slot, const SMesh& Mesh, uint32_t TriangleIndex)
+{
+	const STriangle& KTriangle{ Mesh.vTriangles[TriangleIndex] };
+	const uint32_t KIndices[3]{ KTriangle.I0, KTriangle.I1, KTriangle.I2 };
+	for (int iCorner = 0; iCorner < 3; ++iCorner)
+	{
+		XMFLOAT3 Position{};
+		XMStoreFloat3(&Position, Mesh.vVertices[KIndices[iCorner]].Position);
+		m_Triangles.vPositions[iCorner][0][Slot] = Position.x;
+		m_Triangles.vPositions[iCorner][1][Slot] = Position.y;
+		m_Triangles.vPositions[iCorner][2][Slot] = Position.z;
+	}
+	m_vSlotTriangles[Slot] = TriangleIndex;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include "RayTriangleSoA.h"
+#include <functional>
+
+// Bounding volume hierarchy over the triangles of one SMesh, in the mesh's (object) space.
+// Splits are chosen with the surface area heuristic over binned centroids.
+// A leaf holds at most STriangleSoA::KBatchSize triangles and starts on a batch boundary of the triangle SoA,
+// so every leaf costs a single AVX2 batch (two SSE batches); the heuristic counts leaf costs in batches accordingly.
+// Refit() keeps the topology and only recomputes the bounds, for meshes whose vertices move but whose triangles stay the same.
+class CMeshBVH
+{
+	struct SNode
+	{
+		XMFLOAT3	BoundsMin{};
+		// Interior: index of the first child (the second one follows it); leaf: first slot in m_Triangles
+		uint32_t	ChildOrFirstSlot{};
+		XMFLOAT3	BoundsMax{};
+		// Zero for interior nodes
+		uint32_t	TriangleCount{};
+	};
+
+	struct SBuildTriangle
+	{
+		XMFLOAT3	BoundsMin{};
+		XMFLOAT3	BoundsMax{};
+		XMFLOAT3	Centroid{};
+		uint32_t	TriangleIndex{};
+	};
+
+public:
+	CMeshBVH() {}
+	~CMeshBVH() {}
+
+public:
+	void Build(const SMesh& Mesh);
+
+	// Recomputes the bounds for moved vertices. The mesh must have the same triangles as when it was built (a different count rebuilds).
+	void Refit(const SMesh& Mesh);
+
+	// Closest two-sided hit with 0 < T < MaxT (see IntersectRayTriangles()); OutPtrHit->TriangleIndex indexes Mesh.vTriangles.
+	bool Intersect(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, float MaxT, SRayTriangleHit* const OutPtrHit) const;
+
+	// Calls back with the triangles (indices into Mesh.vTriangles) of every leaf whose bounds, grown by Margin, the ray enters before MaxT;
+	// nearer leaves first. The callback returns the new MaxT (e.g. its closest hit so far), which prunes the remaining leaves.
+	// For surfaces that stay within Margin of the triangles, such as their tessellation.
+	void QueryRay(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, float Margin, float MaxT,
+		const std::function<float(uint32_t TriangleIndex, float MaxT)>& Callback) const;
+
+public:
+	bool IsBuilt() const { return !m_vNodes.empty(); }
+	size_t GetNodeCount() const { return m_vNodes.size(); }
+	size_t GetTriangleCount() const { return m_Triangles.GetTriangleCount(); }
+
+private:
+	// Makes the node a leaf (returns 0) or gives it two children and partitions [Begin, End) between them (returns where the right child starts)
+	size_t SplitNode(uint32_t NodeIndex, const SMesh& Mesh, std::vector<SBuildTriangle>& vBuildTriangles, size_t Begin, size_t End);
+	void WriteSlot(size_t Slot, const SMesh& Mesh, uint32_t TriangleIndex);
+
+public:
+	static constexpr uint32_t KBinCount{ 16 };
+
+	// Relative to the cost of one leaf batch
+	static constexpr float KTraversalCost{ 0.5f };
+
+private:
+	std::vector<SNode>		m_vNodes{};
+
+	// Slot -> index in SMesh::vTriangles (UINT32_MAX for the padding after short leaves)
+	std::vector<uint32_t>	m_vSlotTriangles{};
+	STriangleSoA			m_Triangles{};
+};
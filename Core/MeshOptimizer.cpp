@@ -0,0 +1,447 @@
+#include "MeshOptimizer.h"
+#include "PositionWelder.h"
+
+using std::vector;
+
+static constexpr uint32_t KInvalidIndex{ UINT32_MAX };
+static constexpr float KAttributeEpsilon{ 0.00001f };
+
+static bool AreVertexAttributesEqual(const SVertex3D& A, const SVertex3D& B)
+{
+	const XMVECTOR KEpsilon{ XMVectorReplicate(KAttributeEpsilon) };
+	return XMVector4NearEqual(A.Color, B.Color, KEpsilon) && XMVector4NearEqual(A.TexCoord, B.TexCoord, KEpsilon) &&
+		XMVector4NearEqual(A.Normal, B.Normal, KEpsilon) && XMVector4NearEqual(A.Tangent, B.Tangent, KEpsilon);
+}
+
+CMeshOptimizer::CMeshOptimizer(uint32_t CacheSize, float OverdrawThreshold) : m_CacheSize{ CacheSize }, m_OverdrawThreshold{ OverdrawThreshold }
+{
+	assert(m_CacheSize >= 3);
+	assert(m_OverdrawThreshold >= 1.0f);
+}
+
+const SMeshOptimizationStats& CMeshOptimizer::Optimize(SMesh& Mesh)
+{
+	m_Stats.VertexCountBefore = Mesh.vVertices.size();
+	m_Stats.TriangleCountBefore = Mesh.vTriangles.size();
+	m_Stats.ACMRBefore = CalculateACMR(Mesh);
+	m_Stats.ATVRBefore = CalculateATVR(Mesh);
+
+	WeldVertices(Mesh);
+	RemoveDegenerateTriangles(Mesh);
+	RemoveUnreferencedVertices(Mesh);
+	OptimizeVertexCache(Mesh);
+	OptimizeOverdraw(Mesh);
+	OptimizeVertexFetch(Mesh);
+
+	m_Stats.VertexCountAfter = Mesh.vVertices.size();
+	m_Stats.TriangleCountAfter = Mesh.vTriangles.size();
+	m_Stats.ACMRAfter = CalculateACMR(Mesh);
+	m_Stats.ATVRAfter = CalculateATVR(Mesh);
+
+	return m_Stats;
+}
+
+void CMeshOptimizer::WeldVertices(SMesh& Mesh) const
+{
+	const size_t KVertexCount{ Mesh.vVertices.size() };
+	if (KVertexCount == 0) return;
+
+	CPositionWelder Welder{};
+	const size_t KGroupCount{ Welder.Weld(Mesh.vVertices) };
+
+	// Vertices of a position group are only merged if all of their other attributes match as well,
+	// so hard edges and UV seams survive.
+	vector<SVertex3D> vUniqueVertices{};
+	vector<uint32_t> vGroupFirstUnique(KGroupCount, KInvalidIndex);
+	vector<uint32_t> vNextUniqueInGroup{};
+	vector<uint32_t> vRemap(KVertexCount);
+	vUniqueVertices.reserve(KVertexCount);
+	vNextUniqueInGroup.reserve(KVertexCount);
+	for (size_t iVertex = 0; iVertex < KVertexCount; ++iVertex)
+	{
+		const SVertex3D& Vertex{ Mesh.vVertices[iVertex] };
+		const uint32_t KGroup{ Welder.GetGroup(iVertex) };
+
+		uint32_t Unique{ vGroupFirstUnique[KGroup] };
+		while (Unique != KInvalidIndex && !AreVertexAttributesEqual(vUniqueVertices[Unique], Vertex))
+		{
+			Unique = vNextUniqueInGroup[Unique];
+		}
+
+		if (Unique == KInvalidIndex)
+		{
+			Unique = static_cast<uint32_t>(vUniqueVertices.size());
+			vUniqueVertices.emplace_back(Vertex);
+			vUniqueVertices.back().Position = Mesh.vVertices[Welder.GetGroupRepresentative(KGroup)].Position;
+			vNextUniqueInGroup.emplace_back(vGroupFirstUnique[KGroup]);
+			vGroupFirstUnique[KGroup] = Unique;
+		}
+
+		vRemap[iVertex] = Unique;
+	}
+
+	if (vUniqueVertices.size() == KVertexCount) return;
+
+	for (auto& Triangle : Mesh.vTriangles)
+	{
+		Triangle.I0 = vRemap[Triangle.I0];
+		Triangle.I1 = vRemap[Triangle.I1];
+		Triangle.I2 = vRemap[Triangle.I2];
+	}
+	Mesh.vVertices = std::move(vUniqueVertices);
+}
+
+void CMeshOptimizer::RemoveDegenerateTriangles(SMesh& Mesh) const
+{
+	if (Mesh.vTriangles.empty()) return;
+
+	// A triangle is degenerate if two of its corners share a position (e.g. sphere poles), even if the attributes differ.
+	CPositionWelder Welder{};
+	Welder.Weld(Mesh.vVertices);
+
+	auto IsDegenerate{ [&](const STriangle& Triangle)
+		{
+			const uint32_t KGroup0{ Welder.GetGroup(Triangle.I0) };
+			const uint32_t KGroup1{ Welder.GetGroup(Triangle.I1) };
+			const uint32_t KGroup2{ Welder.GetGroup(Triangle.I2) };
+			return (KGroup0 == KGroup1 || KGroup1 == KGroup2 || KGroup2 == KGroup0);
+		}
+	};
+	Mesh.vTriangles.erase(std::remove_if(Mesh.vTriangles.begin(), Mesh.vTriangles.end(), IsDegenerate), Mesh.vTriangles.end());
+}
+
+void CMeshOptimizer::RemoveUnreferencedVertices(SMesh& Mesh) const
+{
+	const size_t KVertexCount{ Mesh.vVertices.size() };
+
+	vector<uint32_t> vRemap(KVertexCount, KInvalidIndex);
+	for (const auto& Triangle : Mesh.vTriangles)
+	{
+		vRemap[Triangle.I0] = 0;
+		vRemap[Triangle.I1] = 0;
+		vRemap[Triangle.I2] = 0;
+	}
+
+	// Keep the original order of the surviving vertices
+	uint32_t NewIndex{};
+	for (size_t iVertex = 0; iVertex < KVertexCount; ++iVertex)
+	{
+		if (vRemap[iVertex] == KInvalidIndex) continue;
+
+		Mesh.vVertices[NewIndex] = Mesh.vVertices[iVertex];
+		vRemap[iVertex] = NewIndex++;
+	}
+	if (NewIndex == KVertexCount) return;
+
+	Mesh.vVertices.resize(NewIndex);
+	for (auto& Triangle : Mesh.vTriangles)
+	{
+		Triangle.I0 = vRemap[Triangle.I0];
+		Triangle.I1 = vRemap[Triangle.I1];
+		Triangle.I2 = vRemap[Triangle.I2];
+	}
+}
+
+void CMeshOptimizer::OptimizeVertexCache(SMesh& Mesh) const
+{
+	const size_t KVertexCount{ Mesh.vVertices.size() };
+	const size_t KTriangleCount{ Mesh.vTriangles.size() };
+	if (KTriangleCount == 0) return;
+
+	// Vertex -> triangles adjacency, stored contiguously
+	vector<uint32_t> vLiveTriangleCounts(KVertexCount);
+	for (const auto& Triangle : Mesh.vTriangles)
+	{
+		++vLiveTriangleCounts[Triangle.I0];
+		++vLiveTriangleCounts[Triangle.I1];
+		++vLiveTriangleCounts[Triangle.I2];
+	}
+
+	vector<uint32_t> vAdjacencyOffsets(KVertexCount + 1);
+	for (size_t iVertex = 0; iVertex < KVertexCount; ++iVertex)
+	{
+		vAdjacencyOffsets[iVertex + 1] = vAdjacencyOffsets[iVertex] + vLiveTriangleCounts[iVertex];
+	}
+
+	vector<uint32_t> vAdjacency(KTriangleCount * 3);
+	{
+		vector<uint32_t> vCursors(vAdjacencyOffsets.begin(), vAdjacencyOffsets.end() - 1);
+		for (size_t iTriangle = 0; iTriangle < KTriangleCount; ++iTriangle)
+		{
+			const STriangle& Triangle{ Mesh.vTriangles[iTriangle] };
+			vAdjacency[vCursors[Triangle.I0]++] = static_cast<uint32_t>(iTriangle);
+			vAdjacency[vCursors[Triangle.I1]++] = static_cast<uint32_t>(iTriangle);
+			vAdjacency[vCursors[Triangle.I2]++] = static_cast<uint32_t>(iTriangle);
+		}
+	}
+
+	vector<uint32_t> vCacheTimeStamps(KVertexCount);
+	uint32_t TimeStamp{ m_CacheSize + 1 };
+	vector<uint8_t> vbIsEmitted(KTriangleCount);
+	vector<uint32_t> vDeadEndStack{};
+	vector<uint32_t> vCandidates{};
+	size_t NextScannedVertex{};
+
+	// When the fanning vertex has no candidates left, resume from the most recently used vertex that still has live triangles,
+	// and then from the first such vertex in input order.
+	auto SkipDeadEnd{ [&]()
+		{
+			while (!vDeadEndStack.empty())
+			{
+				uint32_t Vertex{ vDeadEndStack.back() };
+				vDeadEndStack.pop_back();
+				if (vLiveTriangleCounts[Vertex] > 0) return Vertex;
+			}
+			while (NextScannedVertex < KVertexCount)
+			{
+				uint32_t Vertex{ static_cast<uint32_t>(NextScannedVertex++) };
+				if (vLiveTriangleCounts[Vertex] > 0) return Vertex;
+			}
+			return KInvalidIndex;
+		}
+	};
+
+	vector<STriangle> vOrderedTriangles{};
+	vOrderedTriangles.reserve(KTriangleCount);
+	uint32_t FanningVertex{ SkipDeadEnd() };
+	while (FanningVertex != KInvalidIndex)
+	{
+		vCandidates.clear();
+
+		// Emit every remaining triangle around the fanning vertex
+		for (uint32_t iAdjacency = vAdjacencyOffsets[FanningVertex]; iAdjacency < vAdjacencyOffsets[FanningVertex + 1]; ++iAdjacency)
+		{
+			const uint32_t KTriangle{ vAdjacency[iAdjacency] };
+			if (vbIsEmitted[KTriangle]) continue;
+
+			const STriangle& Triangle{ Mesh.vTriangles[KTriangle] };
+			for (uint32_t Vertex : { Triangle.I0, Triangle.I1, Triangle.I2 })
+			{
+				vDeadEndStack.emplace_back(Vertex);
+				vCandidates.emplace_back(Vertex);
+				--vLiveTriangleCounts[Vertex];
+				if (TimeStamp - vCacheTimeStamps[Vertex] > m_CacheSize) vCacheTimeStamps[Vertex] = TimeStamp++;
+			}
+			vOrderedTriangles.emplace_back(Triangle);
+			vbIsEmitted[KTriangle] = 1;
+		}
+
+		// Prefer the oldest candidate that will still be in the cache after its remaining triangles are emitted
+		uint32_t NextVertex{ KInvalidIndex };
+		int64_t BestPriority{ -1 };
+		for (uint32_t Candidate : vCandidates)
+		{
+			if (vLiveTriangleCounts[Candidate] == 0) continue;
+
+			int64_t Priority{};
+			const uint32_t KAge{ TimeStamp - vCacheTimeStamps[Candidate] };
+			if (KAge + 2 * vLiveTriangleCounts[Candidate] <= m_CacheSize) Priority = KAge;
+			if (Priority > BestPriority)
+			{
+				BestPriority = Priority;
+				NextVertex = Candidate;
+			}
+		}
+		if (NextVertex == KInvalidIndex) NextVertex = SkipDeadEnd();
+
+		FanningVertex = NextVertex;
+	}
+
+	assert(vOrderedTriangles.size() == KTriangleCount);
+	Mesh.vTriangles = std::move(vOrderedTriangles);
+}
+
+void CMeshOptimizer::OptimizeOverdraw(SMesh& Mesh) const
+{
+	const size_t KTriangleCount{ Mesh.vTriangles.size() };
+	if (KTriangleCount == 0) return;
+
+	const STriangle* const KPtrTriangles{ Mesh.vTriangles.data() };
+	vector<uint32_t> vCacheTimeStamps(Mesh.vVertices.size());
+	uint32_t TimeStamp{ m_CacheSize + 1 };
+	auto ResetCache{ [&]() { TimeStamp += m_CacheSize + 1; } };
+
+	// Hard boundaries: triangles all of whose vertices miss the cache. Reordering at them costs (almost) nothing.
+	vector<size_t> vHardBoundaries{};
+	{
+		vector<uint8_t> vMissCounts{};
+		SimulateVertexCache(KPtrTriangles, KTriangleCount, vCacheTimeStamps, TimeStamp, &vMissCounts);
+		for (size_t iTriangle = 0; iTriangle < KTriangleCount; ++iTriangle)
+		{
+			if (iTriangle == 0 || vMissCounts[iTriangle] == 3) vHardBoundaries.emplace_back(iTriangle);
+		}
+		vHardBoundaries.emplace_back(KTriangleCount);
+	}
+
+	// Soft boundaries: split a hard cluster wherever its running ACMR is already within the threshold of the whole cluster's
+	vector<size_t> vClusterBegins{};
+	for (size_t iHardCluster = 0; iHardCluster + 1 < vHardBoundaries.size(); ++iHardCluster)
+	{
+		const size_t KBegin{ vHardBoundaries[iHardCluster] };
+		const size_t KEnd{ vHardBoundaries[iHardCluster + 1] };
+
+		ResetCache();
+		const size_t KClusterMissCount{ SimulateVertexCache(KPtrTriangles + KBegin, KEnd - KBegin, vCacheTimeStamps, TimeStamp) };
+		const float KThreshold{ m_OverdrawThreshold * static_cast<float>(KClusterMissCount) / static_cast<float>(KEnd - KBegin) };
+
+		ResetCache();
+		vClusterBegins.emplace_back(KBegin);
+		size_t ClusterBegin{ KBegin };
+		size_t RunningMissCount{};
+		for (size_t iTriangle = KBegin; iTriangle < KEnd; ++iTriangle)
+		{
+			RunningMissCount += SimulateVertexCache(KPtrTriangles + iTriangle, 1, vCacheTimeStamps, TimeStamp);
+			if (iTriangle + 1 < KEnd && static_cast<float>(RunningMissCount) <= KThreshold * static_cast<float>(iTriangle + 1 - ClusterBegin))
+			{
+				ClusterBegin = iTriangle + 1;
+				vClusterBegins.emplace_back(ClusterBegin);
+				RunningMissCount = 0;
+				ResetCache();
+			}
+		}
+	}
+	vClusterBegins.emplace_back(KTriangleCount);
+	const size_t KClusterCount{ vClusterBegins.size() - 1 };
+
+	// Area-weighted centroids and normals
+	vector<XMVECTOR> vClusterCentroids(KClusterCount);
+	vector<XMVECTOR> vClusterNormals(KClusterCount);
+	XMVECTOR MeshCentroid{};
+	float MeshArea{};
+	for (size_t iCluster = 0; iCluster < KClusterCount; ++iCluster)
+	{
+		XMVECTOR Centroid{};
+		XMVECTOR Normal{};
+		float Area{};
+		for (size_t iTriangle = vClusterBegins[iCluster]; iTriangle < vClusterBegins[iCluster + 1]; ++iTriangle)
+		{
+			const STriangle& Triangle{ KPtrTriangles[iTriangle] };
+			const XMVECTOR& V0{ Mesh.vVertices[Triangle.I0].Position };
+			const XMVECTOR& V1{ Mesh.vVertices[Triangle.I1].Position };
+			const XMVECTOR& V2{ Mesh.vVertices[Triangle.I2].Position };
+
+			const XMVECTOR KCross{ XMVector3Cross(V1 - V0, V2 - V0) };
+			const float KArea{ XMVectorGetX(XMVector3Length(KCross)) };
+			Centroid += (V0 + V1 + V2) * (KArea / 3.0f);
+			Normal += KCross;
+			Area += KArea;
+		}
+
+		MeshCentroid += Centroid;
+		MeshArea += Area;
+		vClusterCentroids[iCluster] = (Area > 0.0f) ? Centroid / Area : Centroid;
+		vClusterNormals[iCluster] = XMVector3Normalize(Normal);
+	}
+	if (MeshArea > 0.0f) MeshCentroid /= MeshArea;
+
+	// Clusters that face away from the centre of the mesh are likely to occlude the others, so draw them first.
+	vector<float> vSortKeys(KClusterCount);
+	vector<uint32_t> vClusterOrder(KClusterCount);
+	for (size_t iCluster = 0; iCluster < KClusterCount; ++iCluster)
+	{
+		vSortKeys[iCluster] = XMVectorGetX(XMVector3Dot(vClusterCentroids[iCluster] - MeshCentroid, vClusterNormals[iCluster]));
+		vClusterOrder[iCluster] = static_cast<uint32_t>(iCluster);
+	}
+	std::stable_sort(vClusterOrder.begin(), vClusterOrder.end(), [&](uint32_t A, uint32_t B) { return vSortKeys[A] > vSortKeys[B]; });
+
+	vector<STriangle> vOrderedTriangles{};
+	vOrderedTriangles.reserve(KTriangleCount);
+	for (uint32_t Cluster : vClusterOrder)
+	{
+		vOrderedTriangles.insert(vOrderedTriangles.end(), KPtrTriangles + vClusterBegins[Cluster], KPtrTriangles + vClusterBegins[Cluster + 1]);
+	}
+	Mesh.vTriangles = std::move(vOrderedTriangles);
+}
+
+void CMeshOptimizer::OptimizeVertexFetch(SMesh& Mesh) const
+{
+	const size_t KVertexCount{ Mesh.vVertices.size() };
+
+	// Vertices are stored in order of first use by the (already reordered) triangles
+	vector<uint32_t> vRemap(KVertexCount, KInvalidIndex);
+	vector<SVertex3D> vOrderedVertices{};
+	vOrderedVertices.reserve(KVertexCount);
+	for (auto& Triangle : Mesh.vTriangles)
+	{
+		for (uint32_t* PtrIndex : { &Triangle.I0, &Triangle.I1, &Triangle.I2 })
+		{
+			uint32_t& NewIndex{ vRemap[*PtrIndex] };
+			if (NewIndex == KInvalidIndex)
+			{
+				NewIndex = static_cast<uint32_t>(vOrderedVertices.size());
+				vOrderedVertices.emplace_back(Mesh.vVertices[*PtrIndex]);
+			}
+			*PtrIndex = NewIndex;
+		}
+	}
+
+	// Unreferenced vertices are kept at the end
+	for (size_t iVertex = 0; iVertex < KVertexCount; ++iVertex)
+	{
+		if (vRemap[iVertex] == KInvalidIndex) vOrderedVertices.emplace_back(Mesh.vVertices[iVertex]);
+	}
+	Mesh.vVertices = std::move(vOrderedVertices);
+}
+
+float CMeshOptimizer::CalculateACMR(const SMesh& Mesh) const
+{
+	if (Mesh.vTriangles.empty()) return 0.0f;
+
+	vector<uint32_t> vCacheTimeStamps(Mesh.vVertices.size());
+	uint32_t TimeStamp{ m_CacheSize + 1 };
+	const size_t KMissCount{ SimulateVertexCache(Mesh.vTriangles.data(), Mesh.vTriangles.size(), vCacheTimeStamps, TimeStamp) };
+	return static_cast<float>(KMissCount) / static_cast<float>(Mesh.vTriangles.size());
+}
+
+float CMeshOptimizer::CalculateATVR(const SMesh& Mesh) const
+{
+	const size_t KReferencedVertexCount{ CountReferencedVertices(Mesh) };
+	if (KReferencedVertexCount == 0) return 0.0f;
+
+	vector<uint32_t> vCacheTimeStamps(Mesh.vVertices.size());
+	uint32_t TimeStamp{ m_CacheSize + 1 };
+	const size_t KMissCount{ SimulateVertexCache(Mesh.vTriangles.data(), Mesh.vTriangles.size(), vCacheTimeStamps, TimeStamp) };
+	return static_cast<float>(KMissCount) / static_cast<float>(KReferencedVertexCount);
+}
+
+size_t CMeshOptimizer::SimulateVertexCache(const STriangle* const PtrTriangles, size_t TriangleCount, vector<uint32_t>& vCacheTimeStamps,
+	uint32_t& TimeStamp, vector<uint8_t>* const PtrvMissCounts) const
+{
+	// A vertex is in the cache if it was one of the last m_CacheSize vertices that missed
+	size_t MissCount{};
+	if (PtrvMissCounts) PtrvMissCounts->resize(TriangleCount);
+	for (size_t iTriangle = 0; iTriangle < TriangleCount; ++iTriangle)
+	{
+		const STriangle& Triangle{ PtrTriangles[iTriangle] };
+		uint8_t TriangleMissCount{};
+		for (uint32_t Vertex : { Triangle.I0, Triangle.I1, Triangle.I2 })
+		{
+			if (TimeStamp - vCacheTimeStamps[Vertex] > m_CacheSize)
+			{
+				vCacheTimeStamps[Vertex] = TimeStamp++;
+				++TriangleMissCount;
+			}
+		}
+		MissCount += TriangleMissCount;
+		if (PtrvMissCounts) (*PtrvMissCounts)[iTriangle] = TriangleMissCount;
+	}
+	return MissCount;
+}
+
+size_t CMeshOptimizer::CountReferencedVertices(const SMesh& Mesh) const
+{
+	vector<uint8_t> vbIsReferenced(Mesh.vVertices.size());
+	size_t Count{};
+	for (const auto& Triangle : Mesh.vTriangles)
+	{
+		for (uint32_t Vertex : { Triangle.I0, Triangle.I1, Triangle.I2 })
+		{
+			if (!vbIsReferenced[Vertex])
+			{
+				vbIsReferenced[Vertex] = 1;
+				++Count;
+			}
+		}
+	}
+	return Count;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "SharedHeader.h"
+
+struct SMeshOptimizationStats
+{
+	size_t		VertexCountBefore{};
+	size_t		VertexCountAfter{};
+	size_t		TriangleCountBefore{};
+	size_t		TriangleCountAfter{};
+
+	float		ACMRBefore{};
+	float		ACMRAfter{};
+	float		ATVRBefore{};
+	float		ATVRAfter{};
+};
+
+// Reorders and cleans up SMesh data for the GPU. Optimize() runs every stage in this order:
+//  1. weld duplicate vertices (same position and attributes)
+//  2. remove degenerate triangles and unreferenced vertices
+//  3. reorder triangles for the post-transform vertex cache (Tipsify, Sander et al. 2007)
+//  4. reorder clusters of triangles front-to-back from the outside to reduce overdraw
+//  5. reorder vertices in order of first use for fetch locality
+// The rendered surface is unchanged; only zero-area triangles are dropped.
+class CMeshOptimizer
+{
+public:
+	CMeshOptimizer(uint32_t CacheSize = KDefaultCacheSize, float OverdrawThreshold = KDefaultOverdrawThreshold);
+	~CMeshOptimizer() {}
+
+public:
+	const SMeshOptimizationStats& Optimize(SMesh& Mesh);
+
+	void WeldVertices(SMesh& Mesh) const;
+	void RemoveDegenerateTriangles(SMesh& Mesh) const;
+	void RemoveUnreferencedVertices(SMesh& Mesh) const;
+	void OptimizeVertexCache(SMesh& Mesh) const;
+	void OptimizeOverdraw(SMesh& Mesh) const;
+	void OptimizeVertexFetch(SMesh& Mesh) const;
+
+public:
+	// Average cache miss ratio: transformed vertices per triangle (3.0 worst, ~0.5 best for regular meshes)
+	float CalculateACMR(const SMesh& Mesh) const;
+
+	// Average transform to vertex ratio: transformed vertices per referenced vertex (1.0 is optimal)
+	float CalculateATVR(const SMesh& Mesh) const;
+
+	const SMeshOptimizationStats& GetStats() const { return m_Stats; }
+
+private:
+	// Simulates a FIFO post-transform cache of m_CacheSize entries and returns the number of misses
+	size_t SimulateVertexCache(const STriangle* const PtrTriangles, size_t TriangleCount, std::vector<uint32_t>& vCacheTimeStamps,
+		uint32_t& TimeStamp, std::vector<uint8_t>* const PtrvMissCounts = nullptr) const;
+	size_t CountReferencedVertices(const SMesh& Mesh) const;
+
+public:
+	static constexpr uint32_t KDefaultCacheSize{ 16 };
+
+	// A cluster is split wherever its running ACMR drops to (OverdrawThreshold * cluster ACMR)
+	static constexpr float KDefaultOverdrawThreshold{ 1.05f };
+
+private:
+	uint32_t				m_CacheSize{ KDefaultCacheSize };
+	float					m_OverdrawThreshold{ KDefaultOverdrawThreshold };
+	SMeshOptimizationStats	m_Stats{};
+};
@@ -0,0 +1,384 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "PositionWelder.h"
+
+using std::vector;
+using std::pair;
+
+void CMeshSimplifier::SQuadric::AddPlane(const XMFLOAT3& Normal, float D, float PlaneWeight)
+{
+	const double KNX{ Normal.x }, KNY{ Normal.y }, KNZ{ Normal.z }, KD{ D }, KW{ PlaneWeight };
+	A00 += KW * KNX * KNX; A01 += KW * KNX * KNY; A02 += KW * KNX * KNZ;
+	A11 += KW * KNY * KNY; A12 += KW * KNY * KNZ;
+	A22 += KW * KNZ * KNZ;
+	B0 += KW * KNX * KD; B1 += KW * KNY * KD; B2 += KW * KNZ * KD;
+	C += KW * KD * KD;
+	Weight += KW;
+}
+
+void CMeshSimplifier::SQuadric::Add(const SQuadric& B)
+{
+	A00 += B.A00; A01 += B.A01; A02 += B.A02;
+	A11 += B.A11; A12 += B.A12;
+	A22 += B.A22;
+	B0 += B.B0; B1 += B.B1; B2 += B.B2;
+	C += B.C;
+	Weight += B.Weight;
+}
+
+double CMeshSimplifier::SQuadric::Evaluate(const XMFLOAT3& Position) const
+{
+	const double KX{ Position.x }, KY{ Position.y }, KZ{ Position.z };
+	const double KValue{
+		A00 * KX * KX + 2.0 * A01 * KX * KY + 2.0 * A02 * KX * KZ +
+		A11 * KY * KY + 2.0 * A12 * KY * KZ +
+		A22 * KZ * KZ +
+		2.0 * (B0 * KX + B1 * KY + B2 * KZ) + C };
+	return (KValue > 0.0) ? KValue : 0.0;
+}
+
+SMesh CMeshSimplifier::Simplify(const SMesh& Mesh, size_t TargetTriangleCount, float TargetError)
+{
+	Setup(Mesh);
+
+	const double KMaxCost{ (TargetError == FLT_MAX) ? DBL_MAX : static_cast<double>(TargetError) * TargetError };
+	while (m_TriangleCount > TargetTriangleCount && !m_Collapses.empty())
+	{
+		SCollapse Collapse{ m_Collapses.top() };
+		m_Collapses.pop();
+
+		if (m_vbIsGroupRemoved[Collapse.From] || m_vbIsGroupRemoved[Collapse.To]) continue;
+		if (m_vGroupVersions[Collapse.From] != Collapse.FromVersion || m_vGroupVersions[Collapse.To] != Collapse.ToVersion) continue;
+		if (Collapse.Cost > KMaxCost) break;
+
+		if (!TryCollapse(Collapse.From, Collapse.To))
+		{
+			m_vbHasRejectedCollapse[Collapse.From] = 1;
+			continue;
+		}
+
+		m_Error = std::max(m_Error, sqrtf(Collapse.Cost));
+
+		// Only the quadric of the surviving vertex changed, which invalidates the costs of its own collapses.
+		// Its neighbors only changed topologically, so the collapses they had rejected are pushed again in case they have become valid.
+		++m_vGroupVersions[Collapse.To];
+		PushCollapses(Collapse.To, true);
+		GetNeighborGroups(Collapse.To, m_vChangedGroups);
+		for (uint32_t Group : m_vChangedGroups)
+		{
+			if (!m_vbHasRejectedCollapse[Group]) continue;
+
+			m_vbHasRejectedCollapse[Group] = 0;
+			PushCollapses(Group, false);
+		}
+	}
+
+	SMesh Result{};
+	Result.MaterialID = Mesh.MaterialID;
+	Result.vVertices = std::move(m_Mesh.vVertices);
+	Result.vTriangles.reserve(m_TriangleCount);
+	for (size_t iTriangle = 0; iTriangle < m_Mesh.vTriangles.size(); ++iTriangle)
+	{
+		if (!m_vbIsTriangleRemoved[iTriangle]) Result.vTriangles.emplace_back(m_Mesh.vTriangles[iTriangle]);
+	}
+	CMeshOptimizer{}.RemoveUnreferencedVertices(Result);
+
+	m_Mesh = SMesh();
+	m_Collapses = decltype(m_Collapses)();
+	return Result;
+}
+
+vector<SMeshLOD> CMeshSimplifier::BuildLODChain(const SMesh& Mesh, size_t LevelCount, float TriangleRatio, float MaxError)
+{
+	assert(TriangleRatio > 0.0f && TriangleRatio < 1.0f);
+
+	vector<SMeshLOD> vLODs{};
+	vLODs.emplace_back();
+	vLODs.back().Mesh = Mesh;
+
+	for (size_t iLevel = 1; iLevel < LevelCount; ++iLevel)
+	{
+		const size_t KPreviousTriangleCount{ vLODs.back().Mesh.vTriangles.size() };
+		const size_t KTargetTriangleCount{ static_cast<size_t>(static_cast<float>(KPreviousTriangleCount) * TriangleRatio) };
+
+		SMesh Simplified{ Simplify(Mesh, KTargetTriangleCount, MaxError) };
+		if (Simplified.vTriangles.empty() || Simplified.vTriangles.size() >= KPreviousTriangleCount) break;
+
+		const float KError{ std::max(m_Error, vLODs.back().Error) };
+		vLODs.emplace_back();
+		vLODs.back().Mesh = std::move(Simplified);
+		vLODs.back().Error = KError;
+
+		// MaxError stopped the collapses before the target was reached
+		if (vLODs.back().Mesh.vTriangles.size() > KTargetTriangleCount) break;
+	}
+	return vLODs;
+}
+
+void CMeshSimplifier::Setup(const SMesh& Mesh)
+{
+	m_Error = 0.0f;
+
+	// Exact duplicates would look like seams, and zero-area triangles have no plane
+	m_Mesh = Mesh;
+	CMeshOptimizer MeshOptimizer{};
+	MeshOptimizer.WeldVertices(m_Mesh);
+	MeshOptimizer.RemoveDegenerateTriangles(m_Mesh);
+	MeshOptimizer.RemoveUnreferencedVertices(m_Mesh);
+
+	CPositionWelder Welder{};
+	const size_t KGroupCount{ Welder.Weld(m_Mesh.vVertices) };
+	m_vVertexToGroup = Welder.GetVertexToGroup();
+
+	m_vGroupPositions.resize(KGroupCount);
+	for (size_t iGroup = 0; iGroup < KGroupCount; ++iGroup)
+	{
+		XMStoreFloat3(&m_vGroupPositions[iGroup], m_Mesh.vVertices[Welder.GetGroupRepresentative(iGroup)].Position);
+	}
+	m_vGroupQuadrics.assign(KGroupCount, SQuadric());
+	m_vGroupVersions.assign(KGroupCount, 0);
+	m_vbIsGroupRemoved.assign(KGroupCount, 0);
+	m_vbHasRejectedCollapse.assign(KGroupCount, 0);
+	m_vGroupTriangles.assign(KGroupCount, vector<uint32_t>());
+
+	const size_t KTriangleCount{ m_Mesh.vTriangles.size() };
+	m_vbIsTriangleRemoved.assign(KTriangleCount, 0);
+	m_TriangleCount = KTriangleCount;
+
+	// Face planes, weighted by area
+	std::unordered_map<uint64_t, uint32_t> umEdgeTriangleCounts{};
+	umEdgeTriangleCounts.reserve(KTriangleCount * 3);
+	for (size_t iTriangle = 0; iTriangle < KTriangleCount; ++iTriangle)
+	{
+		const STriangle& Triangle{ m_Mesh.vTriangles[iTriangle] };
+		const uint32_t KIndices[3]{ Triangle.I0, Triangle.I1, Triangle.I2 };
+		const uint32_t KGroups[3]{ m_vVertexToGroup[Triangle.I0], m_vVertexToGroup[Triangle.I1], m_vVertexToGroup[Triangle.I2] };
+
+		const XMVECTOR KP0{ XMLoadFloat3(&GetGroupPosition(KGroups[0])) };
+		const XMVECTOR KP1{ XMLoadFloat3(&GetGroupPosition(KGroups[1])) };
+		const XMVECTOR KP2{ XMLoadFloat3(&GetGroupPosition(KGroups[2])) };
+		const XMVECTOR KCross{ XMVector3Cross(KP1 - KP0, KP2 - KP0) };
+		const float KArea{ 0.5f * XMVectorGetX(XMVector3Length(KCross)) };
+		if (KArea > 0.0f)
+		{
+			XMFLOAT3 Normal{};
+			XMStoreFloat3(&Normal, XMVector3Normalize(KCross));
+			const float KD{ -XMVectorGetX(XMVector3Dot(XMLoadFloat3(&Normal), KP0)) };
+			for (uint32_t Group : KGroups)
+			{
+				m_vGroupQuadrics[Group].AddPlane(Normal, KD, KArea);
+			}
+		}
+
+		for (int iCorner = 0; iCorner < 3; ++iCorner)
+		{
+			m_vGroupTriangles[KGroups[iCorner]].emplace_back(static_cast<uint32_t>(iTriangle));
+
+			const uint32_t KA{ KIndices[iCorner] };
+			const uint32_t KB{ KIndices[(iCorner + 1) % 3] };
+			++umEdgeTriangleCounts[(static_cast<uint64_t>(std::min(KA, KB)) << 32) | std::max(KA, KB)];
+		}
+	}
+
+	// Border and seam edges (vertex edges used by only one triangle): planes through the edge, perpendicular to the face
+	for (size_t iTriangle = 0; iTriangle < KTriangleCount; ++iTriangle)
+	{
+		const STriangle& Triangle{ m_Mesh.vTriangles[iTriangle] };
+		const uint32_t KIndices[3]{ Triangle.I0, Triangle.I1, Triangle.I2 };
+		const XMVECTOR KP0{ XMLoadFloat3(&GetGroupPosition(m_vVertexToGroup[KIndices[0]])) };
+		const XMVECTOR KP1{ XMLoadFloat3(&GetGroupPosition(m_vVertexToGroup[KIndices[1]])) };
+		const XMVECTOR KP2{ XMLoadFloat3(&GetGroupPosition(m_vVertexToGroup[KIndices[2]])) };
+		const XMVECTOR KFaceNormal{ XMVector3Normalize(XMVector3Cross(KP1 - KP0, KP2 - KP0)) };
+
+		for (int iCorner = 0; iCorner < 3; ++iCorner)
+		{
+			const uint32_t KA{ KIndices[iCorner] };
+			const uint32_t KB{ KIndices[(iCorner + 1) % 3] };
+			if (umEdgeTriangleCounts[(static_cast<uint64_t>(std::min(KA, KB)) << 32) | std::max(KA, KB)] != 1) continue;
+
+			const uint32_t KGroupA{ m_vVertexToGroup[KA] };
+			const uint32_t KGroupB{ m_vVertexToGroup[KB] };
+			const XMVECTOR KPA{ XMLoadFloat3(&GetGroupPosition(KGroupA)) };
+			const XMVECTOR KEdge{ XMLoadFloat3(&GetGroupPosition(KGroupB)) - KPA };
+			const float KEdgeLengthSquare{ XMVectorGetX(XMVector3LengthSq(KEdge)) };
+			const XMVECTOR KPlaneNormal{ XMVector3Normalize(XMVector3Cross(KEdge, KFaceNormal)) };
+			if (KEdgeLengthSquare == 0.0f || XMVector3Equal(KPlaneNormal, XMVectorZero())) continue;
+
+			XMFLOAT3 Normal{};
+			XMStoreFloat3(&Normal, KPlaneNormal);
+			const float KD{ -XMVectorGetX(XMVector3Dot(KPlaneNormal, KPA)) };
+			m_vGroupQuadrics[KGroupA].AddPlane(Normal, KD, KBorderWeight * KEdgeLengthSquare);
+			m_vGroupQuadrics[KGroupB].AddPlane(Normal, KD, KBorderWeight * KEdgeLengthSquare);
+		}
+	}
+
+	m_Collapses = decltype(m_Collapses)();
+	for (uint32_t iGroup = 0; iGroup < static_cast<uint32_t>(KGroupCount); ++iGroup)
+	{
+		GetNeighborGroups(iGroup, m_vNeighborsA);
+		for (uint32_t Neighbor : m_vNeighborsA)
+		{
+			PushCollapse(iGroup, Neighbor);
+		}
+	}
+}
+
+void CMeshSimplifier::PushCollapses(uint32_t Group, bool bShouldIncludeIncoming)
+{
+	GetNeighborGroups(Group, m_vNeighborsB);
+	for (uint32_t Neighbor : m_vNeighborsB)
+	{
+		PushCollapse(Group, Neighbor);
+		if (bShouldIncludeIncoming) PushCollapse(Neighbor, Group);
+	}
+}
+
+bool CMeshSimplifier::PushCollapse(uint32_t From, uint32_t To)
+{
+	if (m_vbIsGroupRemoved[From] || m_vbIsGroupRemoved[To]) return false;
+
+	// From moves onto To, so the error is the merged quadric at To's position
+	SQuadric Merged{ m_vGroupQuadrics[From] };
+	Merged.Add(m_vGroupQuadrics[To]);
+	const double KCost{ (Merged.Weight > 0.0) ? Merged.Evaluate(GetGroupPosition(To)) / Merged.Weight : 0.0 };
+
+	SCollapse Collapse{};
+	Collapse.Cost = static_cast<float>(KCost);
+	Collapse.From = From;
+	Collapse.To = To;
+	Collapse.FromVersion = m_vGroupVersions[From];
+	Collapse.ToVersion = m_vGroupVersions[To];
+	m_Collapses.push(Collapse);
+	return true;
+}
+
+bool CMeshSimplifier::TryCollapse(uint32_t From, uint32_t To)
+{
+	// Every vertex at From must map onto exactly one vertex at To through a shared edge
+	m_vVertexMap.clear();
+	size_t SharedTriangleCount{};
+	for (uint32_t iTriangle : m_vGroupTriangles[From])
+	{
+		if (m_vbIsTriangleRemoved[iTriangle]) continue;
+
+		const STriangle& Triangle{ m_Mesh.vTriangles[iTriangle] };
+		uint32_t FromVertex{ UINT32_MAX };
+		uint32_t ToVertex{ UINT32_MAX };
+		for (uint32_t Vertex : { Triangle.I0, Triangle.I1, Triangle.I2 })
+		{
+			if (m_vVertexToGroup[Vertex] == From) FromVertex = Vertex;
+			if (m_vVertexToGroup[Vertex] == To) ToVertex = Vertex;
+		}
+		if (ToVertex == UINT32_MAX) continue;
+
+		++SharedTriangleCount;
+		auto Found{ std::find_if(m_vVertexMap.begin(), m_vVertexMap.end(), [&](const pair<uint32_t, uint32_t>& Map) { return Map.first == FromVertex; }) };
+		if (Found == m_vVertexMap.end())
+		{
+			m_vVertexMap.emplace_back(FromVertex, ToVertex);
+		}
+		else if (Found->second != ToVertex)
+		{
+			return false;
+		}
+	}
+	if (SharedTriangleCount == 0) return false;
+
+	const XMVECTOR KToPosition{ XMLoadFloat3(&GetGroupPosition(To)) };
+	for (uint32_t iTriangle : m_vGroupTriangles[From])
+	{
+		if (m_vbIsTriangleRemoved[iTriangle]) continue;
+
+		const STriangle& Triangle{ m_Mesh.vTriangles[iTriangle] };
+		const uint32_t KIndices[3]{ Triangle.I0, Triangle.I1, Triangle.I2 };
+		const uint32_t KGroups[3]{ m_vVertexToGroup[KIndices[0]], m_vVertexToGroup[KIndices[1]], m_vVertexToGroup[KIndices[2]] };
+		if (KGroups[0] == To || KGroups[1] == To || KGroups[2] == To) continue;
+
+		for (uint32_t Vertex : KIndices)
+		{
+			if (m_vVertexToGroup[Vertex] != From) continue;
+			auto Found{ std::find_if(m_vVertexMap.begin(), m_vVertexMap.end(), [&](const pair<uint32_t, uint32_t>& Map) { return Map.first == Vertex; }) };
+			if (Found == m_vVertexMap.end()) return false;
+		}
+
+		// The triangle must not flip
+		XMVECTOR OldPositions[3]{};
+		XMVECTOR NewPositions[3]{};
+		for (int iCorner = 0; iCorner < 3; ++iCorner)
+		{
+			OldPositions[iCorner] = XMLoadFloat3(&GetGroupPosition(KGroups[iCorner]));
+			NewPositions[iCorner] = (KGroups[iCorner] == From) ? KToPosition : OldPositions[iCorner];
+		}
+		const XMVECTOR KOldNormal{ XMVector3Cross(OldPositions[1] - OldPositions[0], OldPositions[2] - OldPositions[0]) };
+		const XMVECTOR KNewNormal{ XMVector3Cross(NewPositions[1] - NewPositions[0], NewPositions[2] - NewPositions[0]) };
+		if (XMVectorGetX(XMVector3Dot(KOldNormal, KNewNormal)) <= 0.0f) return false;
+	}
+
+	// Link condition: From and To may only share the neighbors of the triangles on their edge, otherwise the surface folds
+	GetNeighborGroups(From, m_vNeighborsA);
+	GetNeighborGroups(To, m_vNeighborsB);
+	size_t SharedNeighborCount{};
+	{
+		auto IterA{ m_vNeighborsA.begin() };
+		auto IterB{ m_vNeighborsB.begin() };
+		while (IterA != m_vNeighborsA.end() && IterB != m_vNeighborsB.end())
+		{
+			if (*IterA < *IterB) { ++IterA; }
+			else if (*IterB < *IterA) { ++IterB; }
+			else
+			{
+				++SharedNeighborCount;
+				++IterA;
+				++IterB;
+			}
+		}
+	}
+	if (SharedNeighborCount > SharedTriangleCount) return false;
+
+	vector<uint32_t>& vToTriangles{ m_vGroupTriangles[To] };
+	for (uint32_t iTriangle : m_vGroupTriangles[From])
+	{
+		if (m_vbIsTriangleRemoved[iTriangle]) continue;
+
+		STriangle& Triangle{ m_Mesh.vTriangles[iTriangle] };
+		if (m_vVertexToGroup[Triangle.I0] == To || m_vVertexToGroup[Triangle.I1] == To || m_vVertexToGroup[Triangle.I2] == To)
+		{
+			m_vbIsTriangleRemoved[iTriangle] = 1;
+			--m_TriangleCount;
+			continue;
+		}
+
+		for (uint32_t* PtrIndex : { &Triangle.I0, &Triangle.I1, &Triangle.I2 })
+		{
+			if (m_vVertexToGroup[*PtrIndex] != From) continue;
+			*PtrIndex = std::find_if(m_vVertexMap.begin(), m_vVertexMap.end(), [&](const pair<uint32_t, uint32_t>& Map) { return Map.first == *PtrIndex; })->second;
+		}
+		vToTriangles.emplace_back(iTriangle);
+	}
+	vToTriangles.erase(std::remove_if(vToTriangles.begin(), vToTriangles.end(), [&](uint32_t iTriangle) { return m_vbIsTriangleRemoved[iTriangle] != 0; }),
+		vToTriangles.end());
+
+	m_vGroupTriangles[From].clear();
+	m_vGroupTriangles[From].shrink_to_fit();
+	m_vbIsGroupRemoved[From] = 1;
+	m_vGroupQuadrics[To].Add(m_vGroupQuadrics[From]);
+	return true;
+}
+
+void CMeshSimplifier::GetNeighborGroups(uint32_t Group, vector<uint32_t>& vNeighbors) const
+{
+	vNeighbors.clear();
+	for (uint32_t iTriangle : m_vGroupTriangles[Group])
+	{
+		if (m_vbIsTriangleRemoved[iTriangle]) continue;
+
+		const STriangle& Triangle{ m_Mesh.vTriangles[iTriangle] };
+		for (uint32_t Vertex : { Triangle.I0, Triangle.I1, Triangle.I2 })
+		{
+			const uint32_t KNeighbor{ m_vVertexToGroup[Vertex] };
+			if (KNeighbor != Group) vNeighbors.emplace_back(KNeighbor);
+		}
+	}
+	std::sort(vNeighbors.begin(), vNeighbors.end());
+	vNeighbors.erase(std::unique(vNeighbors.begin(), vNeighbors.end()), vNeighbors.end());
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include <queue>
+#include <cfloat>
+
+struct SMeshLOD
+{
+	SMesh		Mesh{};
+
+	// Object-space RMS distance to the surface of the original mesh (0 for the original itself)
+	float		Error{};
+};
+
+// Quadric error metric simplifier (Garland & Heckbert 1997) based on half-edge collapses.
+// Vertices only ever move onto existing vertices, so every surviving vertex keeps its own attributes.
+// A vertex on a UV/normal seam (a position shared by several vertices) only collapses along the seam:
+// every one of its vertices must have an edge to a vertex at the target position, so both sides of the seam stay matched.
+// Borders and seams also get perpendicular constraint planes, which keeps their shape.
+class CMeshSimplifier
+{
+	struct SQuadric
+	{
+		void AddPlane(const XMFLOAT3& Normal, float D, float Weight);
+		void Add(const SQuadric& B);
+		double Evaluate(const XMFLOAT3& Position) const;
+
+		double		A00{}, A01{}, A02{}, A11{}, A12{}, A22{};
+		double		B0{}, B1{}, B2{};
+		double		C{};
+		double		Weight{};
+	};
+
+	struct SCollapse
+	{
+		bool operator>(const SCollapse& B) const { return Cost > B.Cost; }
+
+		float		Cost{};
+		uint32_t	From{};
+		uint32_t	To{};
+		uint32_t	FromVersion{};
+		uint32_t	ToVersion{};
+	};
+
+public:
+	CMeshSimplifier() {}
+	~CMeshSimplifier() {}
+
+public:
+	// Collapses edges in order of increasing error until Mesh has at most TargetTriangleCount triangles
+	// or the next collapse would exceed TargetError (object-space distance).
+	SMesh Simplify(const SMesh& Mesh, size_t TargetTriangleCount, float TargetError = FLT_MAX);
+
+	// Level 0 is Mesh itself; level i has about TriangleRatio times the triangles of level (i - 1).
+	// Every level is simplified from Mesh, so its Error is measured against the original.
+	// The chain ends early if a level hits MaxError or cannot be simplified further.
+	std::vector<SMeshLOD> BuildLODChain(const SMesh& Mesh, size_t LevelCount, float TriangleRatio = 0.5f, float MaxError = FLT_MAX);
+
+	// Error of the last Simplify()
+	float GetError() const { return m_Error; }
+
+private:
+	void Setup(const SMesh& Mesh);
+	void PushCollapses(uint32_t Group, bool bShouldIncludeIncoming);
+	bool PushCollapse(uint32_t From, uint32_t To);
+	bool TryCollapse(uint32_t From, uint32_t To);
+	void GetNeighborGroups(uint32_t Group, std::vector<uint32_t>& vNeighbors) const;
+	const XMFLOAT3& GetGroupPosition(uint32_t Group) const { return m_vGroupPositions[Group]; }
+
+public:
+	// Constraint planes of border and seam edges are weighted by (KBorderWeight * edge length^2)
+	static constexpr float KBorderWeight{ 10.0f };
+
+private:
+	SMesh								m_Mesh{};
+	float								m_Error{};
+
+	std::vector<uint32_t>				m_vVertexToGroup{};
+	std::vector<XMFLOAT3>				m_vGroupPositions{};
+	std::vector<SQuadric>				m_vGroupQuadrics{};
+	std::vector<uint32_t>				m_vGroupVersions{};
+	std::vector<uint8_t>				m_vbIsGroupRemoved{};
+	std::vector<uint8_t>				m_vbHasRejectedCollapse{};
+	std::vector<std::vector<uint32_t>>	m_vGroupTriangles{};
+
+	std::vector<uint8_t>				m_vbIsTriangleRemoved{};
+	size_t								m_TriangleCount{};
+
+	std::priority_queue<SCollapse, std::vector<SCollapse>, std::greater<SCollapse>> m_Collapses{};
+
+	std::vector<uint32_t>				m_vChangedGroups{};
+	std::vector<uint32_t>				m_vNeighborsA{};
+	std::vector<uint32_t>				m_vNeighborsB{};
+	std::vector<std::pair<uint32_t, uint32_t>>	m_vVertexMap{};
+};
@@ -0,0 +1,324 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include "SIMD.h"
+
+// One float array per component of an SVertex3D member
+struct SVertexStream
+{
+	void Resize(size_t Count)
+	{
+		vX.resize(Count);
+		vY.resize(Count);
+		vZ.resize(Count);
+		vW.resize(Count);
+	}
+
+	std::vector<float>	vX{};
+	std::vector<float>	vY{};
+	std::vector<float>	vZ{};
+	std::vector<float>	vW{};
+};
+
+// Structure-of-arrays companion of SMesh.
+// Conversion in both directions is lossless (every component of every SVertex3D member is kept).
+struct SMeshSoA
+{
+	size_t GetVertexCount() const { return Positions.vX.size(); }
+
+	SVertexStream			Positions{};
+	SVertexStream			Colors{};
+	SVertexStream			TexCoords{};
+	SVertexStream			Normals{};
+	SVertexStream			Tangents{};
+
+	std::vector<STriangle>	vTriangles{};
+
+	size_t					MaterialID{};
+};
+
+static SMeshSoA ConvertMeshToSoA(const SMesh& Mesh);
+static SMesh ConvertSoAToMesh(const SMeshSoA& MeshSoA);
+static void TransformPositionStream(SVertexStream& Stream, const XMMATRIX& Matrix);
+static void TransformDirectionStream(SVertexStream& Stream, const XMMATRIX& Matrix, bool bShouldNormalize);
+
+namespace MeshSoAInternal
+{
+	static void DeinterleaveMember(const SMesh& Mesh, XMVECTOR SVertex3D::* Member, SVertexStream& Stream)
+	{
+		const size_t KCount{ Mesh.vVertices.size() };
+		size_t iVertex{};
+		for (; iVertex + 4 <= KCount; iVertex += 4)
+		{
+			XMVECTOR V0{ Mesh.vVertices[iVertex + 0].*Member };
+			XMVECTOR V1{ Mesh.vVertices[iVertex + 1].*Member };
+			XMVECTOR V2{ Mesh.vVertices[iVertex + 2].*Member };
+			XMVECTOR V3{ Mesh.vVertices[iVertex + 3].*Member };
+			_MM_TRANSPOSE4_PS(V0, V1, V2, V3);
+			_mm_storeu_ps(&Stream.vX[iVertex], V0);
+			_mm_storeu_ps(&Stream.vY[iVertex], V1);
+			_mm_storeu_ps(&Stream.vZ[iVertex], V2);
+			_mm_storeu_ps(&Stream.vW[iVertex], V3);
+		}
+		for (; iVertex < KCount; ++iVertex)
+		{
+			XMFLOAT4 Value{};
+			XMStoreFloat4(&Value, Mesh.vVertices[iVertex].*Member);
+			Stream.vX[iVertex] = Value.x;
+			Stream.vY[iVertex] = Value.y;
+			Stream.vZ[iVertex] = Value.z;
+			Stream.vW[iVertex] = Value.w;
+		}
+	}
+
+	static void InterleaveMember(const SVertexStream& Stream, XMVECTOR SVertex3D::* Member, SMesh& Mesh)
+	{
+		const size_t KCount{ Mesh.vVertices.size() };
+		size_t iVertex{};
+		for (; iVertex + 4 <= KCount; iVertex += 4)
+		{
+			XMVECTOR V0{ _mm_loadu_ps(&Stream.vX[iVertex]) };
+			XMVECTOR V1{ _mm_loadu_ps(&Stream.vY[iVertex]) };
+			XMVECTOR V2{ _mm_loadu_ps(&Stream.vZ[iVertex]) };
+			XMVECTOR V3{ _mm_loadu_ps(&Stream.vW[iVertex]) };
+			_MM_TRANSPOSE4_PS(V0, V1, V2, V3);
+			Mesh.vVertices[iVertex + 0].*Member = V0;
+			Mesh.vVertices[iVertex + 1].*Member = V1;
+			Mesh.vVertices[iVertex + 2].*Member = V2;
+			Mesh.vVertices[iVertex + 3].*Member = V3;
+		}
+		for (; iVertex < KCount; ++iVertex)
+		{
+			Mesh.vVertices[iVertex].*Member = XMVectorSet(Stream.vX[iVertex], Stream.vY[iVertex], Stream.vZ[iVertex], Stream.vW[iVertex]);
+		}
+	}
+
+	// The kernels below evaluate in the same order as XMVector3TransformCoord()/XMVector3TransformNormal() (no FMA),
+	// so every lane width produces the same bits as the XMVECTOR code path.
+
+	static void TransformPositionsAVX2(float* X, float* Y, float* Z, float* W, size_t Begin, size_t End, const XMFLOAT4X4& M)
+	{
+		const __m256 M00{ _mm256_set1_ps(M._11) }, M01{ _mm256_set1_ps(M._12) }, M02{ _mm256_set1_ps(M._13) };
+		const __m256 M10{ _mm256_set1_ps(M._21) }, M11{ _mm256_set1_ps(M._22) }, M12{ _mm256_set1_ps(M._23) };
+		const __m256 M20{ _mm256_set1_ps(M._31) }, M21{ _mm256_set1_ps(M._32) }, M22{ _mm256_set1_ps(M._33) };
+		const __m256 M30{ _mm256_set1_ps(M._41) }, M31{ _mm256_set1_ps(M._42) }, M32{ _mm256_set1_ps(M._43) };
+		const __m256 KOne{ _mm256_set1_ps(1.0f) };
+		for (size_t i = Begin; i < End; i += 8)
+		{
+			const __m256 VX{ _mm256_loadu_ps(X + i) };
+			const __m256 VY{ _mm256_loadu_ps(Y + i) };
+			const __m256 VZ{ _mm256_loadu_ps(Z + i) };
+			_mm256_storeu_ps(X + i, _mm256_add_ps(_mm256_mul_ps(VX, M00), _mm256_add_ps(_mm256_mul_ps(VY, M10), _mm256_add_ps(_mm256_mul_ps(VZ, M20), M30))));
+			_mm256_storeu_ps(Y + i, _mm256_add_ps(_mm256_mul_ps(VX, M01), _mm256_add_ps(_mm256_mul_ps(VY, M11), _mm256_add_ps(_mm256_mul_ps(VZ, M21), M31))));
+			_mm256_storeu_ps(Z + i, _mm256_add_ps(_mm256_mul_ps(VX, M02), _mm256_add_ps(_mm256_mul_ps(VY, M12), _mm256_add_ps(_mm256_mul_ps(VZ, M22), M32))));
+			_mm256_storeu_ps(W + i, KOne);
+		}
+	}
+
+	static void TransformPositionsSSE(float* X, float* Y, float* Z, float* W, size_t Begin, size_t End, const XMFLOAT4X4& M)
+	{
+		const __m128 M00{ _mm_set1_ps(M._11) }, M01{ _mm_set1_ps(M._12) }, M02{ _mm_set1_ps(M._13) };
+		const __m128 M10{ _mm_set1_ps(M._21) }, M11{ _mm_set1_ps(M._22) }, M12{ _mm_set1_ps(M._23) };
+		const __m128 M20{ _mm_set1_ps(M._31) }, M21{ _mm_set1_ps(M._32) }, M22{ _mm_set1_ps(M._33) };
+		const __m128 M30{ _mm_set1_ps(M._41) }, M31{ _mm_set1_ps(M._42) }, M32{ _mm_set1_ps(M._43) };
+		const __m128 KOne{ _mm_set1_ps(1.0f) };
+		for (size_t i = Begin; i < End; i += 4)
+		{
+			const __m128 VX{ _mm_loadu_ps(X + i) };
+			const __m128 VY{ _mm_loadu_ps(Y + i) };
+			const __m128 VZ{ _mm_loadu_ps(Z + i) };
+			_mm_storeu_ps(X + i, _mm_add_ps(_mm_mul_ps(VX, M00), _mm_add_ps(_mm_mul_ps(VY, M10), _mm_add_ps(_mm_mul_ps(VZ, M20), M30))));
+			_mm_storeu_ps(Y + i, _mm_add_ps(_mm_mul_ps(VX, M01), _mm_add_ps(_mm_mul_ps(VY, M11), _mm_add_ps(_mm_mul_ps(VZ, M21), M31))));
+			_mm_storeu_ps(Z + i, _mm_add_ps(_mm_mul_ps(VX, M02), _mm_add_ps(_mm_mul_ps(VY, M12), _mm_add_ps(_mm_mul_ps(VZ, M22), M32))));
+			_mm_storeu_ps(W + i, KOne);
+		}
+	}
+
+	static void TransformDirectionsAVX2(float* X, float* Y, float* Z, size_t Begin, size_t End, const XMFLOAT4X4& M, bool bShouldNormalize)
+	{
+		const __m256 M00{ _mm256_set1_ps(M._11) }, M01{ _mm256_set1_ps(M._12) }, M02{ _mm256_set1_ps(M._13) };
+		const __m256 M10{ _mm256_set1_ps(M._21) }, M11{ _mm256_set1_ps(M._22) }, M12{ _mm256_set1_ps(M._23) };
+		const __m256 M20{ _mm256_set1_ps(M._31) }, M21{ _mm256_set1_ps(M._32) }, M22{ _mm256_set1_ps(M._33) };
+		const __m256 KZero{ _mm256_setzero_ps() };
+		for (size_t i = Begin; i < End; i += 8)
+		{
+			const __m256 VX{ _mm256_loadu_ps(X + i) };
+			const __m256 VY{ _mm256_loadu_ps(Y + i) };
+			const __m256 VZ{ _mm256_loadu_ps(Z + i) };
+			__m256 RX{ _mm256_add_ps(_mm256_mul_ps(VX, M00), _mm256_add_ps(_mm256_mul_ps(VY, M10), _mm256_mul_ps(VZ, M20))) };
+			__m256 RY{ _mm256_add_ps(_mm256_mul_ps(VX, M01), _mm256_add_ps(_mm256_mul_ps(VY, M11), _mm256_mul_ps(VZ, M21))) };
+			__m256 RZ{ _mm256_add_ps(_mm256_mul_ps(VX, M02), _mm256_add_ps(_mm256_mul_ps(VY, M12), _mm256_mul_ps(VZ, M22))) };
+			if (bShouldNormalize)
+			{
+				const __m256 KLength{ _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(RX, RX), _mm256_mul_ps(RY, RY)), _mm256_mul_ps(RZ, RZ))) };
+				const __m256 KIsNonZero{ _mm256_cmp_ps(KLength, KZero, _CMP_NEQ_OQ) };
+				RX = _mm256_and_ps(_mm256_div_ps(RX, KLength), KIsNonZero);
+				RY = _mm256_and_ps(_mm256_div_ps(RY, KLength), KIsNonZero);
+				RZ = _mm256_and_ps(_mm256_div_ps(RZ, KLength), KIsNonZero);
+			}
+			_mm256_storeu_ps(X + i, RX);
+			_mm256_storeu_ps(Y + i, RY);
+			_mm256_storeu_ps(Z + i, RZ);
+		}
+	}
+
+	static void TransformDirectionsSSE(float* X, float* Y, float* Z, size_t Begin, size_t End, const XMFLOAT4X4& M, bool bShouldNormalize)
+	{
+		const __m128 M00{ _mm_set1_ps(M._11) }, M01{ _mm_set1_ps(M._12) }, M02{ _mm_set1_ps(M._13) };
+		const __m128 M10{ _mm_set1_ps(M._21) }, M11{ _mm_set1_ps(M._22) }, M12{ _mm_set1_ps(M._23) };
+		const __m128 M20{ _mm_set1_ps(M._31) }, M21{ _mm_set1_ps(M._32) }, M22{ _mm_set1_ps(M._33) };
+		const __m128 KZero{ _mm_setzero_ps() };
+		for (size_t i = Begin; i < End; i += 4)
+		{
+			const __m128 VX{ _mm_loadu_ps(X + i) };
+			const __m128 VY{ _mm_loadu_ps(Y + i) };
+			const __m128 VZ{ _mm_loadu_ps(Z + i) };
+			__m128 RX{ _mm_add_ps(_mm_mul_ps(VX, M00), _mm_add_ps(_mm_mul_ps(VY, M10), _mm_mul_ps(VZ, M20))) };
+			__m128 RY{ _mm_add_ps(_mm_mul_ps(VX, M01), _mm_add_ps(_mm_mul_ps(VY, M11), _mm_mul_ps(VZ, M21))) };
+			__m128 RZ{ _mm_add_ps(_mm_mul_ps(VX, M02), _mm_add_ps(_mm_mul_ps(VY, M12), _mm_mul_ps(VZ, M22))) };
+			if (bShouldNormalize)
+			{
+				const __m128 KLength{ _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(RX, RX), _mm_mul_ps(RY, RY)), _mm_mul_ps(RZ, RZ))) };
+				const __m128 KIsNonZero{ _mm_cmpneq_ps(KLength, KZero) };
+				RX = _mm_and_ps(_mm_div_ps(RX, KLength), KIsNonZero);
+				RY = _mm_and_ps(_mm_div_ps(RY, KLength), KIsNonZero);
+				RZ = _mm_and_ps(_mm_div_ps(RZ, KLength), KIsNonZero);
+			}
+			_mm_storeu_ps(X + i, RX);
+			_mm_storeu_ps(Y + i, RY);
+			_mm_storeu_ps(Z + i, RZ);
+		}
+	}
+}
+
+static SMeshSoA ConvertMeshToSoA(const SMesh& Mesh)
+{
+	using namespace MeshSoAInternal;
+
+	const size_t KCount{ Mesh.vVertices.size() };
+
+	SMeshSoA MeshSoA{};
+	MeshSoA.Positions.Resize(KCount);
+	MeshSoA.Colors.Resize(KCount);
+	MeshSoA.TexCoords.Resize(KCount);
+	MeshSoA.Normals.Resize(KCount);
+	MeshSoA.Tangents.Resize(KCount);
+
+	DeinterleaveMember(Mesh, &SVertex3D::Position, MeshSoA.Positions);
+	DeinterleaveMember(Mesh, &SVertex3D::Color, MeshSoA.Colors);
+	DeinterleaveMember(Mesh, &SVertex3D::TexCoord, MeshSoA.TexCoords);
+	DeinterleaveMember(Mesh, &SVertex3D::Normal, MeshSoA.Normals);
+	DeinterleaveMember(Mesh, &SVertex3D::Tangent, MeshSoA.Tangents);
+
+	MeshSoA.vTriangles = Mesh.vTriangles;
+	MeshSoA.MaterialID = Mesh.MaterialID;
+	return MeshSoA;
+}
+
+static SMesh ConvertSoAToMesh(const SMeshSoA& MeshSoA)
+{
+	using namespace MeshSoAInternal;
+
+	SMesh Mesh{};
+	Mesh.vVertices.resize(MeshSoA.GetVertexCount());
+
+	InterleaveMember(MeshSoA.Positions, &SVertex3D::Position, Mesh);
+	InterleaveMember(MeshSoA.Colors, &SVertex3D::Color, Mesh);
+	InterleaveMember(MeshSoA.TexCoords, &SVertex3D::TexCoord, Mesh);
+	InterleaveMember(MeshSoA.Normals, &SVertex3D::Normal, Mesh);
+	InterleaveMember(MeshSoA.Tangents, &SVertex3D::Tangent, Mesh);
+
+	Mesh.vTriangles = MeshSoA.vTriangles;
+	Mesh.MaterialID = MeshSoA.MaterialID;
+	return Mesh;
+}
+
+// Affine transform of points: XYZ = XYZ1 * Matrix, W = 1
+static void TransformPositionStream(SVertexStream& Stream, const XMMATRIX& Matrix)
+{
+	using namespace MeshSoAInternal;
+
+	XMFLOAT4X4 M{};
+	XMStoreFloat4x4(&M, Matrix);
+
+	float* const X{ Stream.vX.data() };
+	float* const Y{ Stream.vY.data() };
+	float* const Z{ Stream.vZ.data() };
+	float* const W{ Stream.vW.data() };
+	const size_t KCount{ Stream.vX.size() };
+
+	size_t i{};
+	if (IsAVX2Supported())
+	{
+		const size_t KEnd{ KCount - KCount % 8 };
+		TransformPositionsAVX2(X, Y, Z, W, 0, KEnd, M);
+		i = KEnd;
+	}
+	const size_t KEnd{ KCount - KCount % 4 };
+	if (i < KEnd)
+	{
+		TransformPositionsSSE(X, Y, Z, W, i, KEnd, M);
+		i = KEnd;
+	}
+	for (; i < KCount; ++i)
+	{
+		const float VX{ X[i] }, VY{ Y[i] }, VZ{ Z[i] };
+		X[i] = VX * M._11 + (VY * M._21 + (VZ * M._31 + M._41));
+		Y[i] = VX * M._12 + (VY * M._22 + (VZ * M._32 + M._42));
+		Z[i] = VX * M._13 + (VY * M._23 + (VZ * M._33 + M._43));
+		W[i] = 1.0f;
+	}
+}
+
+// XYZ = XYZ * (upper 3x3 of Matrix), W is left untouched.
+// Pass the inverse-transpose for normals and the matrix itself for tangents.
+static void TransformDirectionStream(SVertexStream& Stream, const XMMATRIX& Matrix, bool bShouldNormalize)
+{
+	using namespace MeshSoAInternal;
+
+	XMFLOAT4X4 M{};
+	XMStoreFloat4x4(&M, Matrix);
+
+	float* const X{ Stream.vX.data() };
+	float* const Y{ Stream.vY.data() };
+	float* const Z{ Stream.vZ.data() };
+	const size_t KCount{ Stream.vX.size() };
+
+	size_t i{};
+	if (IsAVX2Supported())
+	{
+		const size_t KEnd{ KCount - KCount % 8 };
+		TransformDirectionsAVX2(X, Y, Z, 0, KEnd, M, bShouldNormalize);
+		i = KEnd;
+	}
+	const size_t KEnd{ KCount - KCount % 4 };
+	if (i < KEnd)
+	{
+		TransformDirectionsSSE(X, Y, Z, i, KEnd, M, bShouldNormalize);
+		i = KEnd;
+	}
+	for (; i < KCount; ++i)
+	{
+		const float VX{ X[i] }, VY{ Y[i] }, VZ{ Z[i] };
+		float RX{ VX * M._11 + (VY * M._21 + VZ * M._31) };
+		float RY{ VX * M._12 + (VY * M._22 + VZ * M._32) };
+		float RZ{ VX * M._13 + (VY * M._23 + VZ * M._33) };
+		if (bShouldNormalize)
+		{
+			const float KLength{ sqrt(RX * RX + RY * RY + RZ * RZ) };
+			if (KLength != 0.0f)
+			{
+				RX /= KLength;
+				RY /= KLength;
+				RZ /= KLength;
+			}
+			else
+			{
+				RX = RY = RZ = 0.0f;
+			}
+		}
+		X[i] = RX;
+		Y[i] = RY;
+		Z[i] = RZ;
+	}
+}
@@ -0,0 +1,213 @@
+#include "MeshletBuilder.h"
+#include "Math.h"
+
+using std::vector;
+
+static constexpr uint32_t KInvalidIndex{ UINT32_MAX };
+
+vector<SMeshlet> CMeshletBuilder::Build(SMesh& Mesh)
+{
+	const size_t KVertexCount{ Mesh.vVertices.size() };
+	const size_t KTriangleCount{ Mesh.vTriangles.size() };
+
+	vector<SMeshlet> vMeshlets{};
+	if (KTriangleCount == 0) return vMeshlets;
+
+	// Vertex -> triangles adjacency, stored contiguously
+	vector<uint32_t> vAdjacencyOffsets(KVertexCount + 1);
+	for (const auto& Triangle : Mesh.vTriangles)
+	{
+		++vAdjacencyOffsets[Triangle.I0 + 1];
+		++vAdjacencyOffsets[Triangle.I1 + 1];
+		++vAdjacencyOffsets[Triangle.I2 + 1];
+	}
+	for (size_t iVertex = 0; iVertex < KVertexCount; ++iVertex)
+	{
+		vAdjacencyOffsets[iVertex + 1] += vAdjacencyOffsets[iVertex];
+	}
+
+	vector<uint32_t> vAdjacency(KTriangleCount * 3);
+	vector<XMFLOAT3> vTriangleCentroids(KTriangleCount);
+	{
+		vector<uint32_t> vCursors(vAdjacencyOffsets.begin(), vAdjacencyOffsets.end() - 1);
+		for (size_t iTriangle = 0; iTriangle < KTriangleCount; ++iTriangle)
+		{
+			const STriangle& Triangle{ Mesh.vTriangles[iTriangle] };
+			vAdjacency[vCursors[Triangle.I0]++] = static_cast<uint32_t>(iTriangle);
+			vAdjacency[vCursors[Triangle.I1]++] = static_cast<uint32_t>(iTriangle);
+			vAdjacency[vCursors[Triangle.I2]++] = static_cast<uint32_t>(iTriangle);
+
+			XMStoreFloat3(&vTriangleCentroids[iTriangle],
+				(Mesh.vVertices[Triangle.I0].Position + Mesh.vVertices[Triangle.I1].Position + Mesh.vVertices[Triangle.I2].Position) / 3.0f);
+		}
+	}
+
+	vector<uint8_t> vbIsTriangleUsed(KTriangleCount);
+	vector<uint32_t> vVertexMeshlets(KVertexCount, KInvalidIndex);
+	vector<uint32_t> vCandidates{};
+	vector<STriangle> vOrderedTriangles{};
+	vOrderedTriangles.reserve(KTriangleCount);
+
+	SMeshlet Meshlet{};
+	XMFLOAT3 CentroidSum{};
+	auto CountNewVertices{ [&](const STriangle& Triangle)
+		{
+			const uint32_t KMeshlet{ static_cast<uint32_t>(vMeshlets.size()) };
+			return static_cast<uint32_t>(vVertexMeshlets[Triangle.I0] != KMeshlet) +
+				static_cast<uint32_t>(vVertexMeshlets[Triangle.I1] != KMeshlet) +
+				static_cast<uint32_t>(vVertexMeshlets[Triangle.I2] != KMeshlet);
+		}
+	};
+	auto AddTriangle{ [&](uint32_t iTriangle)
+		{
+			const uint32_t KMeshlet{ static_cast<uint32_t>(vMeshlets.size()) };
+			const STriangle& Triangle{ Mesh.vTriangles[iTriangle] };
+			for (uint32_t Vertex : { Triangle.I0, Triangle.I1, Triangle.I2 })
+			{
+				if (vVertexMeshlets[Vertex] == KMeshlet) continue;
+
+				vVertexMeshlets[Vertex] = KMeshlet;
+				++Meshlet.VertexCount;
+				for (uint32_t iAdjacency = vAdjacencyOffsets[Vertex]; iAdjacency < vAdjacencyOffsets[Vertex + 1]; ++iAdjacency)
+				{
+					if (!vbIsTriangleUsed[vAdjacency[iAdjacency]]) vCandidates.emplace_back(vAdjacency[iAdjacency]);
+				}
+			}
+
+			vbIsTriangleUsed[iTriangle] = 1;
+			vOrderedTriangles.emplace_back(Triangle);
+			++Meshlet.TriangleCount;
+			CentroidSum.x += vTriangleCentroids[iTriangle].x;
+			CentroidSum.y += vTriangleCentroids[iTriangle].y;
+			CentroidSum.z += vTriangleCentroids[iTriangle].z;
+		}
+	};
+
+	size_t NextSeed{};
+	while (vOrderedTriangles.size() < KTriangleCount)
+	{
+		while (vbIsTriangleUsed[NextSeed]) ++NextSeed;
+
+		Meshlet = SMeshlet();
+		Meshlet.TriangleOffset = static_cast<uint32_t>(vOrderedTriangles.size());
+		CentroidSum = XMFLOAT3();
+		vCandidates.clear();
+		AddTriangle(static_cast<uint32_t>(NextSeed));
+
+		while (Meshlet.TriangleCount < KMaxTriangleCount)
+		{
+			const float KInverseCount{ 1.0f / static_cast<float>(Meshlet.TriangleCount) };
+			const XMFLOAT3 KCentroid{ CentroidSum.x * KInverseCount, CentroidSum.y * KInverseCount, CentroidSum.z * KInverseCount };
+
+			uint32_t BestTriangle{ KInvalidIndex };
+			uint32_t BestNewVertexCount{ UINT32_MAX };
+			float BestDistanceSquare{ FLT_MAX };
+			size_t LiveCandidateCount{};
+			for (uint32_t Candidate : vCandidates)
+			{
+				if (vbIsTriangleUsed[Candidate]) continue;
+				vCandidates[LiveCandidateCount++] = Candidate;
+
+				const uint32_t KNewVertexCount{ CountNewVertices(Mesh.vTriangles[Candidate]) };
+				if (Meshlet.VertexCount + KNewVertexCount > KMaxVertexCount) continue;
+
+				const XMFLOAT3& KTriangleCentroid{ vTriangleCentroids[Candidate] };
+				const float KDX{ KTriangleCentroid.x - KCentroid.x };
+				const float KDY{ KTriangleCentroid.y - KCentroid.y };
+				const float KDZ{ KTriangleCentroid.z - KCentroid.z };
+				const float KDistanceSquare{ KDX * KDX + KDY * KDY + KDZ * KDZ };
+				if (KNewVertexCount < BestNewVertexCount || (KNewVertexCount == BestNewVertexCount && KDistanceSquare < BestDistanceSquare))
+				{
+					BestTriangle = Candidate;
+					BestNewVertexCount = KNewVertexCount;
+					BestDistanceSquare = KDistanceSquare;
+				}
+			}
+			vCandidates.resize(LiveCandidateCount);
+
+			if (BestTriangle == KInvalidIndex) break;
+			AddTriangle(BestTriangle);
+		}
+
+		vMeshlets.emplace_back(Meshlet);
+	}
+
+	Mesh.vTriangles = std::move(vOrderedTriangles);
+	for (auto& Built : vMeshlets)
+	{
+		CalculateBounds(Mesh, Built);
+	}
+	return vMeshlets;
+}
+
+bool CMeshletBuilder::IsMeshletCulled(const SMeshlet& Meshlet, const XMVECTOR(&ObjectSpaceFrustumPlanes)[6], const XMVECTOR& ObjectSpaceEyePosition)
+{
+	if (IsSphereOutsideFrustum(ObjectSpaceFrustumPlanes, XMLoadFloat3(&Meshlet.BoundingSphereCenter), Meshlet.BoundingSphereRadius)) return true;
+
+	if (Meshlet.ConeCutoff > 1.0f) return false;
+	const XMVECTOR KViewDirection{ XMVector3Normalize(XMLoadFloat3(&Meshlet.ConeApex) - ObjectSpaceEyePosition) };
+	return XMVectorGetX(XMVector3Dot(KViewDirection, XMLoadFloat3(&Meshlet.ConeAxis))) >= Meshlet.ConeCutoff;
+}
+
+void CMeshletBuilder::CalculateBounds(const SMesh& Mesh, SMeshlet& Meshlet) const
+{
+	const STriangle* const KPtrTriangles{ &Mesh.vTriangles[Meshlet.TriangleOffset] };
+
+	// Sphere around the center of the AABB
+	XMVECTOR Min{ KVectorGreatest };
+	XMVECTOR Max{ -KVectorGreatest };
+	for (uint32_t iTriangle = 0; iTriangle < Meshlet.TriangleCount; ++iTriangle)
+	{
+		const STriangle& Triangle{ KPtrTriangles[iTriangle] };
+		for (uint32_t Vertex : { Triangle.I0, Triangle.I1, Triangle.I2 })
+		{
+			Min = XMVectorMin(Min, Mesh.vVertices[Vertex].Position);
+			Max = XMVectorMax(Max, Mesh.vVertices[Vertex].Position);
+		}
+	}
+	const XMVECTOR KCenter{ XMVectorSetW((Min + Max) * 0.5f, 1.0f) };
+	float Radius{};
+	for (uint32_t iTriangle = 0; iTriangle < Meshlet.TriangleCount; ++iTriangle)
+	{
+		const STriangle& Triangle{ KPtrTriangles[iTriangle] };
+		for (uint32_t Vertex : { Triangle.I0, Triangle.I1, Triangle.I2 })
+		{
+			Radius = std::max(Radius, XMVectorGetX(XMVector3Length(Mesh.vVertices[Vertex].Position - KCenter)));
+		}
+	}
+	XMStoreFloat3(&Meshlet.BoundingSphereCenter, KCenter);
+	Meshlet.BoundingSphereRadius = Radius;
+
+	// Normal cone: the axis is the average face normal and the apex is placed so that every face plane lies in front of it
+	XMVECTOR NormalSum{};
+	for (uint32_t iTriangle = 0; iTriangle < Meshlet.TriangleCount; ++iTriangle)
+	{
+		const STriangle& Triangle{ KPtrTriangles[iTriangle] };
+		NormalSum += CalculateTriangleNormal(Mesh.vVertices[Triangle.I0].Position, Mesh.vVertices[Triangle.I1].Position, Mesh.vVertices[Triangle.I2].Position);
+	}
+	if (XMVectorGetX(XMVector3LengthSq(NormalSum)) == 0.0f) return;
+	const XMVECTOR KAxis{ XMVector3Normalize(NormalSum) };
+
+	float MinDot{ 1.0f };
+	float MaxT{};
+	for (uint32_t iTriangle = 0; iTriangle < Meshlet.TriangleCount; ++iTriangle)
+	{
+		const STriangle& Triangle{ KPtrTriangles[iTriangle] };
+		const XMVECTOR& KP0{ Mesh.vVertices[Triangle.I0].Position };
+		const XMVECTOR KNormal{ CalculateTriangleNormal(KP0, Mesh.vVertices[Triangle.I1].Position, Mesh.vVertices[Triangle.I2].Position) };
+		if (XMVectorGetX(XMVector3LengthSq(KNormal)) == 0.0f) continue;
+
+		const float KDot{ XMVectorGetX(XMVector3Dot(KNormal, KAxis)) };
+		MinDot = std::min(MinDot, KDot);
+		if (KDot <= 0.0f) break;
+
+		MaxT = std::max(MaxT, XMVectorGetX(XMVector3Dot(KCenter - KP0, KNormal)) / KDot);
+	}
+
+	// Cones wider than ~84 degrees (half angle) hardly ever cull anything
+	if (MinDot <= 0.1f) return;
+
+	XMStoreFloat3(&Meshlet.ConeApex, KCenter - KAxis * MaxT);
+	XMStoreFloat3(&Meshlet.ConeAxis, KAxis);
+	Meshlet.ConeCutoff = sqrt(1.0f - MinDot * MinDot);
+}
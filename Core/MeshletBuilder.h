@@ -0,0 +1,44 @@
+#pragma once
+
+#include "SharedHeader.h"
+
+struct SMeshlet
+{
+	// Range in SMesh::vTriangles (the builder reorders the triangles so that every meshlet is contiguous)
+	uint32_t	TriangleOffset{};
+	uint32_t	TriangleCount{};
+	uint32_t	VertexCount{};
+
+	// Object space
+	XMFLOAT3	BoundingSphereCenter{};
+	float		BoundingSphereRadius{};
+
+	// The whole meshlet faces away from any eye position P with dot(normalize(ConeApex - P), ConeAxis) >= ConeCutoff.
+	// ConeCutoff > 1 means the normals are too spread out for cone culling.
+	XMFLOAT3	ConeApex{};
+	XMFLOAT3	ConeAxis{};
+	float		ConeCutoff{ 2.0f };
+};
+
+// Splits a mesh into clusters of at most KMaxVertexCount vertices and KMaxTriangleCount triangles.
+// A meshlet grows into the neighboring triangle that adds the fewest new vertices (ties go to the one closest to the meshlet's centroid),
+// so meshlets are compact and their bounds are tight.
+class CMeshletBuilder
+{
+public:
+	CMeshletBuilder() {}
+	~CMeshletBuilder() {}
+
+public:
+	// Reorders Mesh.vTriangles in meshlet order; vertices are left untouched.
+	std::vector<SMeshlet> Build(SMesh& Mesh);
+
+	static bool IsMeshletCulled(const SMeshlet& Meshlet, const XMVECTOR(&ObjectSpaceFrustumPlanes)[6], const XMVECTOR& ObjectSpaceEyePosition);
+
+private:
+	void CalculateBounds(const SMesh& Mesh, SMeshlet& Meshlet) const;
+
+public:
+	static constexpr uint32_t KMaxVertexCount{ 64 };
+	static constexpr uint32_t KMaxTriangleCount{ 124 };
+};
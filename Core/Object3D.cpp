@@ -1,5 +1,10 @@
 #include "Object3D.h"
 #include "Game.h"
+#include "PrimitiveCache.h"
+#include "PNTriangle.h"
+#include "TessellationBaker.h"
+#include "TessellationCache.h"
+#include "DisplacementMap.h"
 
 using std::max;
 using std::min;
@@ -8,27 +13,40 @@ using std::string;
 using std::to_string;
 using std::make_unique;
 
-void CObject3D::Create(const SMesh& Mesh)
+// HSTri.hlsl's KMinEdgeDepth
+static constexpr float KMinEdgeDepth{ 0.001f };
+
+void CObject3D::Create(const SMesh& Mesh, bool bShouldOptimizeMesh)
 {
+	m_SharedPrimitive.reset();
+
 	m_Model.vMeshes.clear();
 	m_Model.vMeshes.emplace_back(Mesh);
 
 	m_Model.vMaterialData.clear();
 	m_Model.vMaterialData.emplace_back();
 
+	m_vMeshOptimizationStats.clear();
+	if (bShouldOptimizeMesh) OptimizeMeshes();
+
 	CreateMeshBuffers();
 	CreateMaterialTextures();
 
 	m_bIsCreated = true;
 }
 
-void CObject3D::Create(const SMesh& Mesh, const CMaterialData& MaterialData)
+void CObject3D::Create(const SMesh& Mesh, const CMaterialData& MaterialData, bool bShouldOptimizeMesh)
 {
+	m_SharedPrimitive.reset();
+
 	m_Model.vMeshes.clear();
 	m_Model.vMeshes.emplace_back(Mesh);
 
 	m_Model.vMaterialData.clear();
 	m_Model.vMaterialData.emplace_back(MaterialData);
+
+	m_vMeshOptimizationStats.clear();
+	if (bShouldOptimizeMesh) OptimizeMeshes();
 	
 	CreateMeshBuffers();
 	CreateMaterialTextures();
@@ -36,10 +54,42 @@ void CObject3D::Create(const SMesh& Mesh, const CMaterialData& MaterialData)
 	m_bIsCreated = true;
 }
 
-void CObject3D::Create(const SModel& Model)
+void CObject3D::Create(const SModel& Model, bool bShouldOptimizeMesh)
 {
+	m_SharedPrimitive.reset();
+
 	m_Model = Model;
 
+	m_vMeshOptimizationStats.clear();
+	if (bShouldOptimizeMesh) OptimizeMeshes();
+
+	CreateMeshBuffers();
+	CreateMaterialTextures();
+
+	m_bIsCreated = true;
+}
+
+void CObject3D::Create(const std::shared_ptr<const SCachedPrimitive>& Primitive, const CMaterialData& MaterialData, bool bShouldOptimizeMesh)
+{
+	assert(Primitive);
+
+	// The optimizer changes the mesh, so the buffers could not be shared anyway
+	if (bShouldOptimizeMesh)
+	{
+		Create(Primitive->Mesh, MaterialData, true);
+		return;
+	}
+
+	m_SharedPrimitive = Primitive;
+
+	m_Model.vMeshes.clear();
+	m_Model.vMeshes.emplace_back(Primitive->Mesh);
+
+	m_Model.vMaterialData.clear();
+	m_Model.vMaterialData.emplace_back(MaterialData);
+
+	m_vMeshOptimizationStats.clear();
+
 	CreateMeshBuffers();
 	CreateMaterialTextures();
 
@@ -83,8 +133,30 @@ size_t CObject3D::GetMaterialCount() const
 	return m_Model.vMaterialData.size();
 }
 
+void CObject3D::OptimizeMeshes()
+{
+	CMeshOptimizer MeshOptimizer{};
+	m_vMeshOptimizationStats.reserve(m_Model.vMeshes.size());
+	for (SMesh& Mesh : m_Model.vMeshes)
+	{
+		m_vMeshOptimizationStats.emplace_back(MeshOptimizer.Optimize(Mesh));
+	}
+}
+
 void CObject3D::CreateMeshBuffers()
 {
+	// LODs, meshlets and BVHs are derived from the meshes
+	m_vLODs.clear();
+	m_CurrentLOD = 0;
+	m_vMeshMeshlets.clear();
+	m_vMeshVisibleRanges.clear();
+	m_VisibleMeshletCount = 0;
+	m_vMeshBVHs.clear();
+	m_vMeshBVHRefitFlags.clear();
+
+	m_BoundingVolumes = CalculateBoundingVolumes(m_Model.vMeshes);
+	m_bIsTransformDirty = true;
+
 	m_vMeshBuffers.clear();
 	m_vMeshBuffers.resize(m_Model.vMeshes.size());
 	for (size_t iMesh = 0; iMesh < m_Model.vMeshes.size(); ++iMesh)
@@ -95,34 +167,82 @@ void CObject3D::CreateMeshBuffers()
 
 void CObject3D::CreateMeshBuffer(size_t MeshIndex)
 {
-	const SMesh& Mesh{ m_Model.vMeshes[MeshIndex] };
+	// The first object created from a cached primitive creates its buffers, the others only reference them
+	if (m_SharedPrimitive && !m_bShouldPackVertices)
+	{
+		assert(MeshIndex == 0);
+		if (!m_SharedPrimitive->bHasMeshBuffers)
+		{
+			CreateMeshBuffer(m_SharedPrimitive->Mesh, m_SharedPrimitive->MeshBuffers);
+			m_SharedPrimitive->bHasMeshBuffers = true;
+		}
+		m_vMeshBuffers[MeshIndex] = m_SharedPrimitive->MeshBuffers;
+		return;
+	}
 
+	CreateMeshBuffer(m_Model.vMeshes[MeshIndex], m_vMeshBuffers[MeshIndex]);
+}
+
+void CObject3D::CreateMeshBuffer(const SMesh& Mesh, SMeshBuffers& MeshBuffers)
+{
 	{
+		vector<SPackedVertex3D> vPackedVertices{};
+		if (m_bShouldPackVertices)
+		{
+			MeshBuffers.PositionQuantization = CalculatePositionQuantization(Mesh.vVertices);
+			PackVertices(Mesh.vVertices, MeshBuffers.PositionQuantization, vPackedVertices);
+			MeshBuffers.PackingError = MeasureVertexPackingError(Mesh.vVertices, vPackedVertices, MeshBuffers.PositionQuantization);
+		}
+		else
+		{
+			MeshBuffers.PackingError = SVertexPackingError();
+		}
+		MeshBuffers.VertexBufferStride = (m_bShouldPackVertices) ? sizeof(SPackedVertex3D) : sizeof(SVertex3D);
+
 		D3D11_BUFFER_DESC BufferDesc{};
 		BufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-		BufferDesc.ByteWidth = static_cast<UINT>(sizeof(SVertex3D) * Mesh.vVertices.size());
+		BufferDesc.ByteWidth = static_cast<UINT>(MeshBuffers.VertexBufferStride * Mesh.vVertices.size());
 		BufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 		BufferDesc.MiscFlags = 0;
 		BufferDesc.StructureByteStride = 0;
 		BufferDesc.Usage = D3D11_USAGE_DYNAMIC;
 
 		D3D11_SUBRESOURCE_DATA SubresourceData{};
-		SubresourceData.pSysMem = &Mesh.vVertices[0];
-		m_PtrDevice->CreateBuffer(&BufferDesc, &SubresourceData, &m_vMeshBuffers[MeshIndex].VertexBuffer);
+		SubresourceData.pSysMem = (m_bShouldPackVertices) ? static_cast<const void*>(&vPackedVertices[0]) : &Mesh.vVertices[0];
+		m_PtrDevice->CreateBuffer(&BufferDesc, &SubresourceData, &MeshBuffers.VertexBuffer);
 	}
 
 	{
+		// 16-bit indices whenever every vertex can be addressed
+		vector<uint16_t> vIndices16{};
+		if (Mesh.vVertices.size() <= UINT16_MAX)
+		{
+			vIndices16.reserve(Mesh.vTriangles.size() * 3);
+			for (const STriangle& Triangle : Mesh.vTriangles)
+			{
+				vIndices16.emplace_back(static_cast<uint16_t>(Triangle.I0));
+				vIndices16.emplace_back(static_cast<uint16_t>(Triangle.I1));
+				vIndices16.emplace_back(static_cast<uint16_t>(Triangle.I2));
+			}
+			MeshBuffers.IndexFormat = DXGI_FORMAT_R16_UINT;
+		}
+		else
+		{
+			MeshBuffers.IndexFormat = DXGI_FORMAT_R32_UINT;
+		}
+
 		D3D11_BUFFER_DESC BufferDesc{};
 		BufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-		BufferDesc.ByteWidth = static_cast<UINT>(sizeof(STriangle) * Mesh.vTriangles.size());
+		BufferDesc.ByteWidth = (vIndices16.empty()) ?
+			static_cast<UINT>(sizeof(STriangle) * Mesh.vTriangles.size()) : static_cast<UINT>(sizeof(uint16_t) * vIndices16.size());
 		BufferDesc.CPUAccessFlags = 0;
 		BufferDesc.MiscFlags = 0;
 		BufferDesc.StructureByteStride = 0;
 		BufferDesc.Usage = D3D11_USAGE_DEFAULT;
 
 		D3D11_SUBRESOURCE_DATA SubresourceData{};
-		SubresourceData.pSysMem = &Mesh.vTriangles[0];
-		m_PtrDevice->CreateBuffer(&BufferDesc, &SubresourceData, &m_vMeshBuffers[MeshIndex].IndexBuffer);
+		SubresourceData.pSysMem = (vIndices16.empty()) ? static_cast<const void*>(&Mesh.vTriangles[0]) : &vIndices16[0];
+		m_PtrDevice->CreateBuffer(&BufferDesc, &SubresourceData, &MeshBuffers.IndexBuffer);
 	}
 }
 
@@ -172,22 +292,577 @@ void CObject3D::UpdateQuadUV(const XMFLOAT2& UVOffset, const XMFLOAT2& UVSize)
 
 void CObject3D::UpdateMeshBuffer(size_t MeshIndex)
 {
+	if (MeshIndex < m_vMeshBVHRefitFlags.size()) m_vMeshBVHRefitFlags[MeshIndex] = true;
+	m_BoundingVolumes = CalculateBoundingVolumes(m_Model.vMeshes);
+	m_bIsTransformDirty = true;
+
+	// Other objects use the shared buffers, so this object gets its own (created from the current mesh)
+	if (m_SharedPrimitive)
+	{
+		m_SharedPrimitive.reset();
+		CreateMeshBuffer(MeshIndex);
+		return;
+	}
+
+	const SMesh& Mesh{ m_Model.vMeshes[MeshIndex] };
+	SMeshBuffers& MeshBuffers{ m_vMeshBuffers[MeshIndex] };
+
+	// The vertices may have moved out of the old quantization range
+	vector<SPackedVertex3D> vPackedVertices{};
+	if (m_bShouldPackVertices)
+	{
+		MeshBuffers.PositionQuantization = CalculatePositionQuantization(Mesh.vVertices);
+		PackVertices(Mesh.vVertices, MeshBuffers.PositionQuantization, vPackedVertices);
+		MeshBuffers.PackingError = MeasureVertexPackingError(Mesh.vVertices, vPackedVertices, MeshBuffers.PositionQuantization);
+	}
+
 	D3D11_MAPPED_SUBRESOURCE MappedSubresource{};
 	if (SUCCEEDED(m_PtrDeviceContext->Map(m_vMeshBuffers[MeshIndex].VertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedSubresource)))
 	{
-		memcpy(MappedSubresource.pData, &m_Model.vMeshes[MeshIndex].vVertices[0], sizeof(SVertex3D) * m_Model.vMeshes[MeshIndex].vVertices.size());
+		if (m_bShouldPackVertices)
+		{
+			memcpy(MappedSubresource.pData, &vPackedVertices[0], sizeof(SPackedVertex3D) * vPackedVertices.size());
+		}
+		else
+		{
+			memcpy(MappedSubresource.pData, &Mesh.vVertices[0], sizeof(SVertex3D) * Mesh.vVertices.size());
+		}
 
 		m_PtrDeviceContext->Unmap(m_vMeshBuffers[MeshIndex].VertexBuffer.Get(), 0);
 	}
 }
 
+void CObject3D::CreateLODs(size_t LevelCount, float TriangleRatio, float MaxError)
+{
+	assert(LevelCount > 0);
+
+	m_vLODs.clear();
+	m_CurrentLOD = 0;
+	if (IsPatches()) return;
+
+	CMeshSimplifier MeshSimplifier{};
+	vector<vector<SMeshLOD>> vMeshLODChains{};
+	size_t LODCount{ 1 };
+	for (const SMesh& Mesh : m_Model.vMeshes)
+	{
+		vMeshLODChains.emplace_back(MeshSimplifier.BuildLODChain(Mesh, LevelCount, TriangleRatio, MaxError));
+		LODCount = max(LODCount, vMeshLODChains.back().size());
+	}
+
+	// Meshes with shorter chains use their coarsest level for the remaining levels
+	m_vLODs.resize(LODCount - 1);
+	for (size_t iLOD = 1; iLOD < LODCount; ++iLOD)
+	{
+		SLOD& LOD{ m_vLODs[iLOD - 1] };
+		LOD.vMeshes.reserve(vMeshLODChains.size());
+		LOD.vMeshBuffers.resize(vMeshLODChains.size());
+		for (size_t iMesh = 0; iMesh < vMeshLODChains.size(); ++iMesh)
+		{
+			const SMeshLOD& MeshLOD{ vMeshLODChains[iMesh][min(iLOD, vMeshLODChains[iMesh].size() - 1)] };
+			LOD.vMeshes.emplace_back(MeshLOD.Mesh);
+			LOD.Error = max(LOD.Error, MeshLOD.Error);
+
+			CreateMeshBuffer(LOD.vMeshes.back(), LOD.vMeshBuffers[iMesh]);
+		}
+	}
+}
+
+void CObject3D::UpdateLOD(const XMVECTOR& EyePosition, float ProjectionScale)
+{
+	if (m_vLODs.empty()) return;
+
+	const SBoundingSphere& BoundingSphere{ ComponentPhysics.BoundingSphere };
+	const float KDistance{ XMVectorGetX(XMVector3Length(BoundingSphere.Center - EyePosition)) };
+
+	// Inside the bounding sphere
+	if (KDistance <= BoundingSphere.Radius)
+	{
+		m_CurrentLOD = 0;
+		return;
+	}
+
+	// Errors are in object space and so is this radius, so the thresholds don't depend on the scaling.
+	const float KObjectSpaceRadius{ (m_BoundingVolumes.SphereRadius + GetBoundingMargin()) * BoundingSphere.RadiusBias };
+	const float KProjectedRadius{ BoundingSphere.Radius * ProjectionScale / KDistance };
+	auto GetCoarsestLOD{ [&](float ProjectedRadius)
+		{
+			size_t LOD{};
+			for (size_t iLOD = 1; iLOD < GetLODCount(); ++iLOD)
+			{
+				const float KError{ GetLODError(iLOD) };
+				if (KError <= 0.0f || ProjectedRadius * KError <= KLODPixelError * KObjectSpaceRadius) LOD = iLOD;
+			}
+			return LOD;
+		}
+	};
+
+	const size_t KCoarserLOD{ GetCoarsestLOD(KProjectedRadius * (1.0f + KLODHysteresis)) };
+	const size_t KFinerLOD{ GetCoarsestLOD(KProjectedRadius * (1.0f - KLODHysteresis)) };
+	if (KCoarserLOD > m_CurrentLOD)
+	{
+		m_CurrentLOD = KCoarserLOD;
+	}
+	else if (KFinerLOD < m_CurrentLOD)
+	{
+		m_CurrentLOD = KFinerLOD;
+	}
+}
+
+void CObject3D::CreateMeshlets()
+{
+	if (IsPatches()) return;
+
+	// The triangles are reordered, so the buffers of a cached primitive cannot be shared any more
+	m_SharedPrimitive.reset();
+
+	// CreateMeshBuffers() clears the meshlets, so the index buffers are recreated mesh by mesh instead
+	m_vMeshBVHs.clear();
+	m_vMeshBVHRefitFlags.clear();
+	CMeshletBuilder MeshletBuilder{};
+	m_vMeshMeshlets.clear();
+	m_vMeshMeshlets.reserve(m_Model.vMeshes.size());
+	for (size_t iMesh = 0; iMesh < m_Model.vMeshes.size(); ++iMesh)
+	{
+		m_vMeshMeshlets.emplace_back(MeshletBuilder.Build(m_Model.vMeshes[iMesh]));
+		CreateMeshBuffer(iMesh);
+	}
+
+	// Everything is visible until the first CullMeshlets()
+	m_vMeshVisibleRanges.clear();
+	m_VisibleMeshletCount = 0;
+	for (size_t iMesh = 0; iMesh < m_Model.vMeshes.size(); ++iMesh)
+	{
+		m_vMeshVisibleRanges.emplace_back();
+		m_vMeshVisibleRanges.back().emplace_back(0, static_cast<uint32_t>(m_Model.vMeshes[iMesh].vTriangles.size()));
+		m_VisibleMeshletCount += m_vMeshMeshlets[iMesh].size();
+	}
+}
+
+void CObject3D::GenerateTangents(CThreadPool* const PtrThreadPool)
+{
+	if (IsPatches()) return;
+
+	// Mirrored UVs may split vertices, so the buffers are recreated rather than updated
+	m_SharedPrimitive.reset();
+
+	CTangentGenerator TangentGenerator{};
+	for (SMesh& Mesh : m_Model.vMeshes)
+	{
+		TangentGenerator.Generate(Mesh, PtrThreadPool);
+	}
+	CreateMeshBuffers();
+}
+
+void CObject3D::FreezeTessellation(const SCBTessFactorData& Factors, ETessellationType eType, const SCBDisplacementData& Displacement,
+	CThreadPool* const PtrThreadPool, CTessellationCache* const PtrTessellationCache)
+{
+	if (IsPatches()) return;
+
+	m_SharedPrimitive.reset();
+
+	CTessellationBaker TessellationBaker{};
+	// Per material, read back from the GPU on first use
+	vector<CDisplacementMap> vDisplacementMaps(m_Model.vMaterialData.size());
+	for (SMesh& Mesh : m_Model.vMeshes)
+	{
+		SMesh BakedMesh{};
+		if (PtrTessellationCache)
+		{
+			const auto PtrCachedMesh{ PtrTessellationCache->Get(Mesh, Factors.EdgeTessFactor, Factors.InsideTessFactor, eType, PtrThreadPool) };
+			if (!PtrCachedMesh) continue;
+
+			// The cached mesh might have been baked from another object's mesh with another material
+			BakedMesh = *PtrCachedMesh;
+			BakedMesh.MaterialID = Mesh.MaterialID;
+		}
+		else if (!TessellationBaker.Bake(Mesh, Factors.EdgeTessFactor, Factors.InsideTessFactor, eType, BakedMesh, PtrThreadPool))
+		{
+			continue;
+		}
+
+		if (Displacement.bUseDisplacement && Mesh.MaterialID < m_vMaterialTextureSets.size() &&
+			m_Model.vMaterialData[Mesh.MaterialID].HasTexture(STextureData::EType::DisplacementTexture))
+		{
+			CDisplacementMap& DisplacementMap{ vDisplacementMaps[Mesh.MaterialID] };
+			if (!DisplacementMap.IsCreated())
+			{
+				DisplacementMap.Create(m_PtrDevice, m_PtrDeviceContext,
+					m_vMaterialTextureSets[Mesh.MaterialID]->GetTexture2D(STextureData::EType::DisplacementTexture));
+			}
+			if (DisplacementMap.IsCreated())
+			{
+				// The level is measured on the base mesh's UV edges
+				TessellationBaker.Displace(BakedMesh, DisplacementMap, DisplacementMap.GetLevel(Mesh, Factors.EdgeTessFactor),
+					Displacement.DisplacementFactor, PtrThreadPool);
+			}
+		}
+		Mesh = std::move(BakedMesh);
+	}
+	ShouldTessellate(false);
+	CreateMeshBuffers();
+}
+
+const CMeshBVH& CObject3D::GetMeshBVH(size_t MeshIndex)
+{
+	assert(MeshIndex < m_Model.vMeshes.size());
+
+	if (m_vMeshBVHs.size() != m_Model.vMeshes.size())
+	{
+		m_vMeshBVHs.clear();
+		m_vMeshBVHs.resize(m_Model.vMeshes.size());
+		m_vMeshBVHRefitFlags.assign(m_Model.vMeshes.size(), false);
+	}
+
+	CMeshBVH& MeshBVH{ m_vMeshBVHs[MeshIndex] };
+	if (!MeshBVH.IsBuilt())
+	{
+		MeshBVH.Build(m_Model.vMeshes[MeshIndex]);
+	}
+	else if (m_vMeshBVHRefitFlags[MeshIndex])
+	{
+		MeshBVH.Refit(m_Model.vMeshes[MeshIndex]);
+	}
+	m_vMeshBVHRefitFlags[MeshIndex] = false;
+	return MeshBVH;
+}
+
+bool CObject3D::IntersectTessellatedSurface(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, const SCBTessCameraData& Camera, float MaxT,
+	float* const OutPtrT, XMVECTOR(&OutTriangle)[3])
+{
+	// The BVH is in object space; T is the same in both spaces
+	const XMMATRIX& KWorld{ ComponentTransform.MatrixWorld };
+	const XMMATRIX KWorldInverse{ XMMatrixInverse(nullptr, KWorld) };
+	const XMVECTOR KObjectSpaceRayOrigin{ XMVector3TransformCoord(RayOrigin, KWorldInverse) };
+	const XMVECTOR KObjectSpaceRayDirection{ XMVector3TransformNormal(RayDirection, KWorldInverse) };
+
+	if (IsPatches())
+	{
+		// The patches have no base mesh; the whole quad sphere is baked, again whenever the factors change
+		if (!m_PatchMeshBVH.IsBuilt() || m_PatchMeshTessFactorData.EdgeTessFactor != m_CBTessFactorData.EdgeTessFactor ||
+			m_PatchMeshTessFactorData.InsideTessFactor != m_CBTessFactorData.InsideTessFactor)
+		{
+			m_PatchMesh = GenerateQuadSphere(m_CBTessFactorData.EdgeTessFactor, m_CBTessFactorData.InsideTessFactor);
+			if (m_PatchMesh.vTriangles.empty()) return false;
+
+			m_PatchMeshBVH.Build(m_PatchMesh);
+			m_PatchMeshTessFactorData = m_CBTessFactorData;
+		}
+
+		SRayTriangleHit Hit{};
+		if (!m_PatchMeshBVH.Intersect(KObjectSpaceRayOrigin, KObjectSpaceRayDirection, MaxT, &Hit)) return false;
+
+		const STriangle& KHitTriangle{ m_PatchMesh.vTriangles[Hit.TriangleIndex] };
+		OutTriangle[0] = XMVector3TransformCoord(m_PatchMesh.vVertices[KHitTriangle.I0].Position, KWorld);
+		OutTriangle[1] = XMVector3TransformCoord(m_PatchMesh.vVertices[KHitTriangle.I1].Position, KWorld);
+		OutTriangle[2] = XMVector3TransformCoord(m_PatchMesh.vVertices[KHitTriangle.I2].Position, KWorld);
+		if (OutPtrT) *OutPtrT = Hit.T;
+		return true;
+	}
+
+	// With uniform factors every patch has the same domain points and triangles; screen-space ones are computed per patch
+	const bool KbIsUniform{ !(m_CBTessFactorData.TargetEdgePixelLength > 0.0f) };
+	CTessellator Tessellator{ m_eTessellationType };
+	if (KbIsUniform)
+	{
+		const float KEdgeFactors[3]{ m_CBTessFactorData.EdgeTessFactor, m_CBTessFactorData.EdgeTessFactor, m_CBTessFactorData.EdgeTessFactor };
+		if (!Tessellator.TessellateTri(KEdgeFactors, m_CBTessFactorData.InsideTessFactor)) return false;
+	}
+	const vector<XMFLOAT2>& KDomainPoints{ Tessellator.GetDomainPoints() };
+	const vector<STriangle>& KDomainTriangles{ Tessellator.GetTriangles() };
+	const float KMargin{ GetBoundingMargin() };
+
+	vector<XMFLOAT3> vPositions{};
+	STriangleSoA Triangles{};
+	float ClosestT{ MaxT };
+	bool bHasHit{ false };
+	for (size_t iMesh = 0; iMesh < m_Model.vMeshes.size(); ++iMesh)
+	{
+		const SMesh& KMesh{ m_Model.vMeshes[iMesh] };
+		GetMeshBVH(iMesh).QueryRay(KObjectSpaceRayOrigin, KObjectSpaceRayDirection, KMargin, ClosestT,
+			[&](uint32_t TriangleIndex, float CurrentMaxT)
+			{
+				// The control points are built from world-space positions and normals, as in VSBase.hlsl
+				const STriangle& KTriangle{ KMesh.vTriangles[TriangleIndex] };
+				const SVertex3D& KV0{ KMesh.vVertices[KTriangle.I0] };
+				const SVertex3D& KV1{ KMesh.vVertices[KTriangle.I1] };
+				const SVertex3D& KV2{ KMesh.vVertices[KTriangle.I2] };
+				const XMVECTOR KWorldPositions[3]{
+					XMVector3TransformCoord(KV0.Position, KWorld), XMVector3TransformCoord(KV1.Position, KWorld), XMVector3TransformCoord(KV2.Position, KWorld) };
+				const SPNTriangle KPatch{ MakePNTriangle(KWorldPositions[0], KWorldPositions[1], KWorldPositions[2],
+					XMVector3TransformNormal(KV0.Normal, KWorld), XMVector3TransformNormal(KV1.Normal, KWorld), XMVector3TransformNormal(KV2.Normal, KWorld)) };
+
+				XMVECTOR BoundsMin{}, BoundsMax{};
+				GetPNTriangleBounds(KPatch, BoundsMin, BoundsMax);
+				float BoxT{};
+				if (!IntersectRayAxisAlignedBox(RayOrigin, RayDirection, BoundsMin, BoundsMax, &BoxT) || BoxT >= CurrentMaxT) return CurrentMaxT;
+
+				if (!KbIsUniform)
+				{
+					float EdgeFactors[3]{};
+					float InsideFactor{};
+					GetPatchTessFactors(KWorldPositions, m_CBTessFactorData, Camera, EdgeFactors, InsideFactor);
+					if (!Tessellator.TessellateTri(EdgeFactors, InsideFactor)) return CurrentMaxT;
+				}
+				vPositions.resize(KDomainPoints.size());
+				EvaluatePNTriangle(KPatch, KDomainPoints.data(), KDomainPoints.size(), vPositions.data());
+				FillTriangleSoA(vPositions.data(), KDomainTriangles, Triangles);
+				SRayTriangleHit Hit{};
+				if (!IntersectRayTriangles(RayOrigin, RayDirection, Triangles, CurrentMaxT, &Hit)) return CurrentMaxT;
+
+				const STriangle& KHitTriangle{ KDomainTriangles[Hit.TriangleIndex] };
+				OutTriangle[0] = XMLoadFloat3(&vPositions[KHitTriangle.I0]);
+				OutTriangle[1] = XMLoadFloat3(&vPositions[KHitTriangle.I1]);
+				OutTriangle[2] = XMLoadFloat3(&vPositions[KHitTriangle.I2]);
+				ClosestT = Hit.T;
+				bHasHit = true;
+				return Hit.T;
+			});
+	}
+
+	if (bHasHit && OutPtrT) *OutPtrT = ClosestT;
+	return bHasHit;
+}
+
+void CObject3D::GetPatchTessFactors(const XMVECTOR(&WorldPositions)[3], const SCBTessFactorData& Factors, const SCBTessCameraData& Camera,
+	float(&OutEdgeFactors)[3], float& OutInsideFactor)
+{
+	if (!(Factors.TargetEdgePixelLength > 0.0f))
+	{
+		OutEdgeFactors[0] = OutEdgeFactors[1] = OutEdgeFactors[2] = Factors.EdgeTessFactor;
+		OutInsideFactor = Factors.InsideTessFactor;
+		return;
+	}
+
+	// Edge i is opposite to position i; see GetScreenSpaceEdgeTessFactor() in HSTri.hlsl
+	for (int iEdge = 0; iEdge < 3; ++iEdge)
+	{
+		const XMVECTOR& KP0{ WorldPositions[(iEdge + 1) % 3] };
+		const XMVECTOR& KP1{ WorldPositions[(iEdge + 2) % 3] };
+		const XMVECTOR KMidpoint{ XMVectorSetW((KP0 + KP1) * 0.5f, 1.0f) };
+		const float KDepth{ max(XMVectorGetW(XMVector4Transform(KMidpoint, Camera.ViewProjection)), KMinEdgeDepth) };
+		const float KPixelLength{ XMVectorGetX(XMVector3Length(KP1 - KP0)) * Camera.ProjectionScale / KDepth };
+		OutEdgeFactors[iEdge] = min(max(KPixelLength / Factors.TargetEdgePixelLength, 1.0f), Factors.EdgeTessFactor);
+	}
+	OutInsideFactor = min((OutEdgeFactors[0] + OutEdgeFactors[1] + OutEdgeFactors[2]) / 3.0f, Factors.InsideTessFactor);
+}
+
+size_t CObject3D::CountTessellatedTriangles(const SCBTessFactorData& Factors, const SCBTessCameraData& Camera) const
+{
+	if (!m_bShouldTesselate) return 0;
+
+	if (IsPatches())
+	{
+		// HSQuadSphere.hlsl
+		CTessellator Tessellator{ ETessellatorPartitioning::Integer };
+		const float KEdgeFactors[4]{ Factors.EdgeTessFactor, Factors.EdgeTessFactor, Factors.EdgeTessFactor, Factors.EdgeTessFactor };
+		const float KInsideFactors[2]{ Factors.InsideTessFactor, Factors.InsideTessFactor };
+		return Tessellator.GetQuadTriangleCount(KEdgeFactors, KInsideFactors) * m_PatchCount;
+	}
+
+	const CTessellator KTessellator{ m_eTessellationType };
+	const XMMATRIX& KWorld{ ComponentTransform.MatrixWorld };
+	const bool KbIsUniform{ !(Factors.TargetEdgePixelLength > 0.0f) };
+	size_t TriangleCount{};
+	for (const SMesh& KMesh : m_Model.vMeshes)
+	{
+		if (KbIsUniform)
+		{
+			const float KEdgeFactors[3]{ Factors.EdgeTessFactor, Factors.EdgeTessFactor, Factors.EdgeTessFactor };
+			TriangleCount += KTessellator.GetTriTriangleCount(KEdgeFactors, Factors.InsideTessFactor) * KMesh.vTriangles.size();
+			continue;
+		}
+
+		vector<XMVECTOR> vWorldPositions(KMesh.vVertices.size());
+		for (size_t iVertex = 0; iVertex < KMesh.vVertices.size(); ++iVertex)
+		{
+			vWorldPositions[iVertex] = XMVector3TransformCoord(KMesh.vVertices[iVertex].Position, KWorld);
+		}
+		for (const STriangle& KTriangle : KMesh.vTriangles)
+		{
+			const XMVECTOR KWorldPositions[3]{ vWorldPositions[KTriangle.I0], vWorldPositions[KTriangle.I1], vWorldPositions[KTriangle.I2] };
+			float EdgeFactors[3]{};
+			float InsideFactor{};
+			GetPatchTessFactors(KWorldPositions, Factors, Camera, EdgeFactors, InsideFactor);
+			TriangleCount += KTessellator.GetTriTriangleCount(EdgeFactors, InsideFactor);
+		}
+	}
+	return TriangleCount;
+}
+
+void CObject3D::CullMeshlets(const XMMATRIX& ViewProjection, const XMVECTOR& EyePosition)
+{
+	if (m_vMeshMeshlets.empty()) return;
+
+	// Everything is tested in object space
+	XMVECTOR FrustumPlanes[6]{};
+	ExtractFrustumPlanes(ComponentTransform.MatrixWorld * ViewProjection, FrustumPlanes);
+	const XMVECTOR KObjectSpaceEyePosition{ XMVector3TransformCoord(EyePosition, XMMatrixInverse(nullptr, ComponentTransform.MatrixWorld)) };
+
+	m_VisibleMeshletCount = 0;
+	for (size_t iMesh = 0; iMesh < m_vMeshMeshlets.size(); ++iMesh)
+	{
+		auto& vRanges{ m_vMeshVisibleRanges[iMesh] };
+		vRanges.clear();
+		for (const SMeshlet& Meshlet : m_vMeshMeshlets[iMesh])
+		{
+			if (CMeshletBuilder::IsMeshletCulled(Meshlet, FrustumPlanes, KObjectSpaceEyePosition)) continue;
+
+			// Neighboring visible meshlets are merged into one draw
+			if (!vRanges.empty() && vRanges.back().first + vRanges.back().second == Meshlet.TriangleOffset)
+			{
+				vRanges.back().second += Meshlet.TriangleCount;
+			}
+			else
+			{
+				vRanges.emplace_back(Meshlet.TriangleOffset, Meshlet.TriangleCount);
+			}
+			++m_VisibleMeshletCount;
+		}
+	}
+}
+
+SVertexPackingError CObject3D::GetVertexPackingError() const
+{
+	SVertexPackingError Result{};
+	for (const SMeshBuffers& MeshBuffers : m_vMeshBuffers)
+	{
+		Result.Position = max(Result.Position, MeshBuffers.PackingError.Position);
+		Result.NormalDegrees = max(Result.NormalDegrees, MeshBuffers.PackingError.NormalDegrees);
+		Result.TangentDegrees = max(Result.TangentDegrees, MeshBuffers.PackingError.TangentDegrees);
+		Result.TexCoord = max(Result.TexCoord, MeshBuffers.PackingError.TexCoord);
+		Result.Color = max(Result.Color, MeshBuffers.PackingError.Color);
+	}
+	return Result;
+}
+
+size_t CObject3D::GetMeshBufferByteSize() const
+{
+	size_t ByteSize{};
+	for (size_t iMesh = 0; iMesh < m_vMeshBuffers.size(); ++iMesh)
+	{
+		const SMesh& Mesh{ m_Model.vMeshes[iMesh] };
+		const SMeshBuffers& MeshBuffers{ m_vMeshBuffers[iMesh] };
+		const size_t KIndexSize{ (MeshBuffers.IndexFormat == DXGI_FORMAT_R16_UINT) ? sizeof(uint16_t) : sizeof(uint32_t) };
+		ByteSize += MeshBuffers.VertexBufferStride * Mesh.vVertices.size() + KIndexSize * Mesh.vTriangles.size() * 3;
+	}
+	return ByteSize;
+}
+
+size_t CObject3D::GetMeshletCount() const
+{
+	size_t Count{};
+	for (const auto& vMeshlets : m_vMeshMeshlets)
+	{
+		Count += vMeshlets.size();
+	}
+	return Count;
+}
+
 void CObject3D::LimitFloatRotation(float& Value, const float Min, const float Max)
 {
 	if (Value > Max) Value = Min;
 	if (Value < Min) Value = Max;
 }
 
+// XMMatrixRotationRollPitchYaw() in closed form for four objects at once; every vector holds one entry of the four matrices.
+// World = Scaling * Translation(-Pivot) * Rotation * Translation(Translation + Pivot), i.e. the rotation rows scaled and
+// Translation + Pivot - Pivot * Rotation in the last row.
+static void BuildWorldMatrices(const XMVECTOR& Pitch, const XMVECTOR& Yaw, const XMVECTOR& Roll, const XMMATRIX& Scaling,
+	const XMMATRIX& Translation, const XMMATRIX& Pivot, XMMATRIX(&OutMatrices)[4])
+{
+	XMVECTOR SinPitch{}, CosPitch{}, SinYaw{}, CosYaw{}, SinRoll{}, CosRoll{};
+	XMVectorSinCos(&SinPitch, &CosPitch, Pitch);
+	XMVectorSinCos(&SinYaw, &CosYaw, Yaw);
+	XMVectorSinCos(&SinRoll, &CosRoll, Roll);
+
+	const XMVECTOR KR00{ CosRoll * CosYaw + SinRoll * SinPitch * SinYaw };
+	const XMVECTOR KR01{ SinRoll * CosPitch };
+	const XMVECTOR KR02{ SinRoll * SinPitch * CosYaw - CosRoll * SinYaw };
+	const XMVECTOR KR10{ CosRoll * SinPitch * SinYaw - SinRoll * CosYaw };
+	const XMVECTOR KR11{ CosRoll * CosPitch };
+	const XMVECTOR KR12{ SinRoll * SinYaw + CosRoll * SinPitch * CosYaw };
+	const XMVECTOR KR20{ CosPitch * SinYaw };
+	const XMVECTOR KR21{ -SinPitch };
+	const XMVECTOR KR22{ CosPitch * CosYaw };
+
+	const XMVECTOR KT0{ Translation.r[0] + Pivot.r[0] - (Pivot.r[0] * KR00 + Pivot.r[1] * KR10 + Pivot.r[2] * KR20) };
+	const XMVECTOR KT1{ Translation.r[1] + Pivot.r[1] - (Pivot.r[0] * KR01 + Pivot.r[1] * KR11 + Pivot.r[2] * KR21) };
+	const XMVECTOR KT2{ Translation.r[2] + Pivot.r[2] - (Pivot.r[0] * KR02 + Pivot.r[1] * KR12 + Pivot.r[2] * KR22) };
+
+	// Back from one entry per vector to one row per vector
+	const XMMATRIX KRows0{ XMMatrixTranspose(XMMATRIX(KR00 * Scaling.r[0], KR01 * Scaling.r[0], KR02 * Scaling.r[0], XMVectorZero())) };
+	const XMMATRIX KRows1{ XMMatrixTranspose(XMMATRIX(KR10 * Scaling.r[1], KR11 * Scaling.r[1], KR12 * Scaling.r[1], XMVectorZero())) };
+	const XMMATRIX KRows2{ XMMatrixTranspose(XMMATRIX(KR20 * Scaling.r[2], KR21 * Scaling.r[2], KR22 * Scaling.r[2], XMVectorZero())) };
+	const XMMATRIX KRows3{ XMMatrixTranspose(XMMATRIX(KT0, KT1, KT2, XMVectorSplatOne())) };
+	for (int iMatrix = 0; iMatrix < 4; ++iMatrix)
+	{
+		OutMatrices[iMatrix] = XMMATRIX(KRows0.r[iMatrix], KRows1.r[iMatrix], KRows2.r[iMatrix], KRows3.r[iMatrix]);
+	}
+}
+
 void CObject3D::UpdateWorldMatrix()
+{
+	CObject3D* const PtrThis{ this };
+	UpdateWorldMatrices(&PtrThis, 1);
+}
+
+void CObject3D::UpdateWorldMatrices(CObject3D* const* const PtrObject3Ds, size_t Count, CThreadPool* const PtrThreadPool)
+{
+	const auto KUpdateRange{ [PtrObject3Ds](size_t Begin, size_t End)
+	{
+		for (size_t iFirst = Begin; iFirst < End; iFirst += 4)
+		{
+			// A short group repeats its last object in the unused lanes
+			const size_t KGroupSize{ min(End - iFirst, size_t(4)) };
+			CObject3D* Group[4]{};
+			for (size_t iLane = 0; iLane < 4; ++iLane) Group[iLane] = PtrObject3Ds[iFirst + min(iLane, KGroupSize - 1)];
+			for (size_t iLane = 0; iLane < KGroupSize; ++iLane) Group[iLane]->LimitTransform();
+
+			const SComponentTransform& KT0{ Group[0]->ComponentTransform };
+			const SComponentTransform& KT1{ Group[1]->ComponentTransform };
+			const SComponentTransform& KT2{ Group[2]->ComponentTransform };
+			const SComponentTransform& KT3{ Group[3]->ComponentTransform };
+			const XMMATRIX KScaling{ XMMatrixTranspose(XMMATRIX(KT0.Scaling, KT1.Scaling, KT2.Scaling, KT3.Scaling)) };
+			const XMMATRIX KTranslation{ XMMatrixTranspose(XMMATRIX(KT0.Translation, KT1.Translation, KT2.Translation, KT3.Translation)) };
+			const XMMATRIX KPivot{ XMMatrixTranspose(XMMATRIX(Group[0]->ComponentPhysics.BoundingSphere.CenterOffset,
+				Group[1]->ComponentPhysics.BoundingSphere.CenterOffset, Group[2]->ComponentPhysics.BoundingSphere.CenterOffset,
+				Group[3]->ComponentPhysics.BoundingSphere.CenterOffset)) };
+
+			XMMATRIX Matrices[4]{};
+			BuildWorldMatrices(XMVectorSet(KT0.Pitch, KT1.Pitch, KT2.Pitch, KT3.Pitch), XMVectorSet(KT0.Yaw, KT1.Yaw, KT2.Yaw, KT3.Yaw),
+				XMVectorSet(KT0.Roll, KT1.Roll, KT2.Roll, KT3.Roll), KScaling, KTranslation, KPivot, Matrices);
+
+			for (size_t iLane = 0; iLane < KGroupSize; ++iLane)
+			{
+				Group[iLane]->ComponentTransform.MatrixWorld = Matrices[iLane];
+				Group[iLane]->UpdateWorldBounds();
+			}
+		}
+	} };
+
+	if (PtrThreadPool && Count > KWorldMatrixGrainSize)
+	{
+		PtrThreadPool->ParallelFor(Count, KWorldMatrixGrainSize, KUpdateRange);
+	}
+	else
+	{
+		KUpdateRange(0, Count);
+	}
+
+	// The trees aren't thread-safe
+	for (size_t iObject3D = 0; iObject3D < Count; ++iObject3D)
+	{
+		CObject3D* const PtrObject3D{ PtrObject3Ds[iObject3D] };
+		if (PtrObject3D->m_PtrObject3DTree)
+		{
+			PtrObject3D->m_PtrObject3DTree->Move(PtrObject3D->m_Object3DTreeProxy, PtrObject3D->ComponentPhysics.BoundingSphere.Center,
+				PtrObject3D->ComponentPhysics.BoundingSphere.Radius);
+		}
+		PtrObject3D->m_bIsTransformDirty = false;
+	}
+}
+
+void CObject3D::LimitTransform()
 {
 	LimitFloatRotation(ComponentTransform.Pitch, CGame::KRotationMinLimit, CGame::KRotationMaxLimit);
 	LimitFloatRotation(ComponentTransform.Yaw, CGame::KRotationMinLimit, CGame::KRotationMaxLimit);
@@ -199,28 +874,79 @@ void CObject3D::UpdateWorldMatrix()
 		ComponentTransform.Scaling = XMVectorSetY(ComponentTransform.Scaling, CGame::KScalingMinLimit);
 	if (XMVectorGetZ(ComponentTransform.Scaling) < CGame::KScalingMinLimit)
 		ComponentTransform.Scaling = XMVectorSetZ(ComponentTransform.Scaling, CGame::KScalingMinLimit);
+}
 
-	XMMATRIX Translation{ XMMatrixTranslationFromVector(ComponentTransform.Translation) };
-	XMMATRIX Rotation{ XMMatrixRotationRollPitchYaw(ComponentTransform.Pitch,
-		ComponentTransform.Yaw, ComponentTransform.Roll) };
-	XMMATRIX Scaling{ XMMatrixScalingFromVector(ComponentTransform.Scaling) };
-
+void CObject3D::UpdateWorldBounds()
+{
 	// @important
 	float ScalingX{ XMVectorGetX(ComponentTransform.Scaling) };
 	float ScalingY{ XMVectorGetY(ComponentTransform.Scaling) };
 	float ScalingZ{ XMVectorGetZ(ComponentTransform.Scaling) };
 	float MaxScaling{ max(ScalingX, max(ScalingY, ScalingZ)) };
-	ComponentPhysics.BoundingSphere.Radius = ComponentPhysics.BoundingSphere.RadiusBias * MaxScaling;
 
-	XMMATRIX BoundingSphereTranslation{ XMMatrixTranslationFromVector(ComponentPhysics.BoundingSphere.CenterOffset) };
-	XMMATRIX BoundingSphereTranslationOpposite{ XMMatrixTranslationFromVector(-ComponentPhysics.BoundingSphere.CenterOffset) };
+	// The object-space bounds go through the same matrix; the sphere only needs its center transformed
+	SBoundingSphere& BoundingSphere{ ComponentPhysics.BoundingSphere };
+	const float KMargin{ GetBoundingMargin() };
+	BoundingSphere.Center = XMVector3TransformCoord(XMLoadFloat3(&m_BoundingVolumes.SphereCenter), ComponentTransform.MatrixWorld);
+	BoundingSphere.Radius = (m_BoundingVolumes.SphereRadius + KMargin) * BoundingSphere.RadiusBias * MaxScaling;
+	ComponentPhysics.OrientedBox = TransformOrientedBox(m_BoundingVolumes, KMargin, BoundingSphere.RadiusBias, ComponentTransform.MatrixWorld);
+}
+
+float CObject3D::GetBoundingMargin() const
+{
+	if (!m_bShouldTesselate || m_bIsPatch) return 0.0f;
 
-	ComponentTransform.MatrixWorld = Scaling * BoundingSphereTranslationOpposite * Rotation * Translation * BoundingSphereTranslation;
+	// The patches are built in world space; a non-uniform scaling can make them bulge further, relative to the object, by up to its ratio
+	const float KScalingX{ XMVectorGetX(ComponentTransform.Scaling) };
+	const float KScalingY{ XMVectorGetY(ComponentTransform.Scaling) };
+	const float KScalingZ{ XMVectorGetZ(ComponentTransform.Scaling) };
+	const float KMaxScaling{ max(KScalingX, max(KScalingY, KScalingZ)) };
+	const float KMinScaling{ min(KScalingX, min(KScalingY, KScalingZ)) };
+	return m_BoundingVolumes.TessellationMargin * KMaxScaling / KMinScaling;
+}
+
+bool CObject3D::IsOutsideFrustum(const XMVECTOR(&Planes)[6]) const
+{
+	// The sphere is cheaper and rejects most objects; the box is tighter for long or flat ones
+	if (IsSphereOutsideFrustum(Planes, ComponentPhysics.BoundingSphere.Center, ComponentPhysics.BoundingSphere.Radius)) return true;
+	return IsOrientedBoxOutsideFrustum(Planes, ComponentPhysics.OrientedBox);
+}
+
+void CObject3D::InsertIntoTree(CObject3DTree* const PtrObject3DTree)
+{
+	assert(PtrObject3DTree);
+	assert(!m_PtrObject3DTree);
+
+	m_PtrObject3DTree = PtrObject3DTree;
+	m_Object3DTreeProxy = m_PtrObject3DTree->Insert(this, ComponentPhysics.BoundingSphere.Center, ComponentPhysics.BoundingSphere.Radius);
 }
 
 void CObject3D::ShouldTessellate(bool Value)
 {
 	m_bShouldTesselate = Value;
+
+	// The bounds grow by the tessellation margin
+	m_bIsTransformDirty = true;
+}
+
+void CObject3D::ShouldPackVertices(bool Value)
+{
+	if (m_bShouldPackVertices == Value) return;
+	m_bShouldPackVertices = Value;
+	if (!m_bIsCreated || IsPatches()) return;
+
+	// LODs and meshlets only refer to the meshes, so only the buffers are recreated
+	for (size_t iMesh = 0; iMesh < m_Model.vMeshes.size(); ++iMesh)
+	{
+		CreateMeshBuffer(iMesh);
+	}
+	for (SLOD& LOD : m_vLODs)
+	{
+		for (size_t iMesh = 0; iMesh < LOD.vMeshes.size(); ++iMesh)
+		{
+			CreateMeshBuffer(LOD.vMeshes[iMesh], LOD.vMeshBuffers[iMesh]);
+		}
+	}
 }
 
 void CObject3D::TessellationType(ETessellationType eType)
@@ -284,9 +1010,11 @@ void CObject3D::Draw(bool bIgnoreOwnTexture, bool bIgnoreInstances) const
 	}
 	else
 	{
-		for (size_t iMesh = 0; iMesh < m_Model.vMeshes.size(); ++iMesh)
+		const vector<SMesh>& vMeshes{ (m_CurrentLOD == 0) ? m_Model.vMeshes : m_vLODs[m_CurrentLOD - 1].vMeshes };
+		const vector<SMeshBuffers>& vMeshBuffers{ (m_CurrentLOD == 0) ? m_vMeshBuffers : m_vLODs[m_CurrentLOD - 1].vMeshBuffers };
+		for (size_t iMesh = 0; iMesh < vMeshes.size(); ++iMesh)
 		{
-			const SMesh& Mesh{ m_Model.vMeshes[iMesh] };
+			const SMesh& Mesh{ vMeshes[iMesh] };
 			const CMaterialData& MaterialData{ m_Model.vMaterialData[Mesh.MaterialID] };
 
 			// per mesh
@@ -307,12 +1035,25 @@ void CObject3D::Draw(bool bIgnoreOwnTexture, bool bIgnoreInstances) const
 				m_PtrDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 			}
 
-			m_PtrDeviceContext->IASetIndexBuffer(m_vMeshBuffers[iMesh].IndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+			if (m_bShouldPackVertices) m_PtrGame->UpdateCBVertexQuantizationData(vMeshBuffers[iMesh].PositionQuantization);
 
-			m_PtrDeviceContext->IASetVertexBuffers(0, 1, m_vMeshBuffers[iMesh].VertexBuffer.GetAddressOf(),
-				&m_vMeshBuffers[iMesh].VertexBufferStride, &m_vMeshBuffers[iMesh].VertexBufferOffset);
+			m_PtrDeviceContext->IASetIndexBuffer(vMeshBuffers[iMesh].IndexBuffer.Get(), vMeshBuffers[iMesh].IndexFormat, 0);
 
-			m_PtrDeviceContext->DrawIndexed(static_cast<UINT>(Mesh.vTriangles.size() * 3), 0, 0);
+			m_PtrDeviceContext->IASetVertexBuffers(0, 1, vMeshBuffers[iMesh].VertexBuffer.GetAddressOf(),
+				&vMeshBuffers[iMesh].VertexBufferStride, &vMeshBuffers[iMesh].VertexBufferOffset);
+
+			// Meshlet culling is only valid for the undisplaced, untessellated model
+			if (m_CurrentLOD == 0 && HasMeshlets() && !ShouldTessellate())
+			{
+				for (const auto& Range : m_vMeshVisibleRanges[iMesh])
+				{
+					m_PtrDeviceContext->DrawIndexed(Range.second * 3, Range.first * 3, 0);
+				}
+			}
+			else
+			{
+				m_PtrDeviceContext->DrawIndexed(static_cast<UINT>(Mesh.vTriangles.size() * 3), 0, 0);
+			}
 		}
 	}
 }
\ No newline at end of file
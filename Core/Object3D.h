@@ -2,9 +2,20 @@
 
 #include "SharedHeader.h"
 #include "Material.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "MeshBVH.h"
+#include "BoundingVolume.h"
+#include "Object3DTree.h"
+#include "TangentGenerator.h"
+#include "Tessellator.h"
+#include "VertexPacking.h"
 
 class CGame;
 class CShader;
+class CTessellationCache;
+struct SCachedPrimitive;
 
 struct SModel
 {
@@ -24,12 +35,8 @@ public:
 		UseRawVertexColor = 0x08
 	};
 
-	enum class ETessellationType
-	{
-		FractionalOdd,
-		FractionalEven,
-		Integer
-	};
+	// HSTri.hlsl's entry points, which CTessellator reproduces
+	using ETessellationType = ETessellatorPartitioning;
 
 	struct SCBTessFactorData
 	{
@@ -38,7 +45,18 @@ public:
 
 		float		EdgeTessFactor{ 2.0f };
 		float		InsideTessFactor{ 2.0f };
-		float		Pads[2]{};
+		// Pixels per tessellated edge segment, see HSTri.hlsl; 0 applies the factors above to every patch, otherwise they are the maxima
+		float		TargetEdgePixelLength{};
+		float		Pad{};
+	};
+
+	// The camera that HSTri.hlsl measures screen-space factors with
+	struct SCBTessCameraData
+	{
+		XMMATRIX	ViewProjection{};
+		// (screen height / 2) / tan(FOV / 2)
+		float		ProjectionScale{};
+		float		Pads[3]{};
 	};
 
 	struct SCBDisplacementData
@@ -62,6 +80,8 @@ public:
 	struct SComponentPhysics
 	{
 		SBoundingSphere	BoundingSphere{};
+		// World space, computed with BoundingSphere
+		SOrientedBox	OrientedBox{};
 		bool			bIsPickable{ true };
 	};
 
@@ -73,7 +93,7 @@ public:
 		bool		bShouldAnimate{ false };
 	};
 
-private:
+public:
 	struct SMeshBuffers
 	{
 		ComPtr<ID3D11Buffer>	VertexBuffer{};
@@ -81,6 +101,19 @@ private:
 		UINT					VertexBufferOffset{};
 
 		ComPtr<ID3D11Buffer>	IndexBuffer{};
+		DXGI_FORMAT				IndexFormat{ DXGI_FORMAT_R32_UINT };
+
+		// Only used with packed vertices
+		SPositionQuantization	PositionQuantization{};
+		SVertexPackingError		PackingError{};
+	};
+
+private:
+	struct SLOD
+	{
+		std::vector<SMesh>			vMeshes{};
+		std::vector<SMeshBuffers>	vMeshBuffers{};
+		float						Error{};
 	};
 
 public:
@@ -91,7 +124,10 @@ public:
 		assert(m_PtrDeviceContext);
 		assert(m_PtrGame);
 	}
-	~CObject3D() {}
+	~CObject3D()
+	{
+		if (m_PtrObject3DTree) m_PtrObject3DTree->Remove(m_Object3DTreeProxy);
+	}
 
 public:
 	void* operator new(size_t Size)
@@ -105,9 +141,13 @@ public:
 	}
 
 public:
-	void Create(const SMesh& Mesh);
-	void Create(const SMesh& Mesh, const CMaterialData& MaterialData);
-	void Create(const SModel& Model);
+	// bShouldOptimizeMesh: run CMeshOptimizer over every mesh before the buffers are created (see GetMeshOptimizationStats())
+	void Create(const SMesh& Mesh, bool bShouldOptimizeMesh = false);
+	void Create(const SMesh& Mesh, const CMaterialData& MaterialData, bool bShouldOptimizeMesh = false);
+	void Create(const SModel& Model, bool bShouldOptimizeMesh = false);
+	// The object keeps its own editable copy of the mesh but uses the primitive's GPU buffers (see CPrimitiveCache).
+	// Anything that changes the mesh buffers (UpdateMeshBuffer(), CreateMeshlets(), bShouldOptimizeMesh) gives the object its own buffers.
+	void Create(const std::shared_ptr<const SCachedPrimitive>& Primitive, const CMaterialData& MaterialData, bool bShouldOptimizeMesh = false);
 	void CreatePatches(size_t ControlPointCountPerPatch, size_t PatchCount);
 
 public:
@@ -118,7 +158,64 @@ public:
 	void UpdateQuadUV(const XMFLOAT2& UVOffset, const XMFLOAT2& UVSize);
 	void UpdateMeshBuffer(size_t MeshIndex = 0);
 
+	// Also transforms the tight bounds to world space (ComponentPhysics) and moves the bounding sphere in the tree the object was inserted into
 	void UpdateWorldMatrix();
+	// UpdateWorldMatrix() for many objects: the matrices are built four at a time in SIMD lanes, in parallel chunks when there are
+	// more than KWorldMatrixGrainSize objects and a pool is given. The object trees are updated on the calling thread.
+	static void UpdateWorldMatrices(CObject3D* const* const PtrObject3Ds, size_t Count, CThreadPool* const PtrThreadPool = nullptr);
+
+	// Whoever writes ComponentTransform or the bounding sphere's CenterOffset and RadiusBias must call this; UpdateWorldMatrix() clears it
+	void MarkTransformDirty() { m_bIsTransformDirty = true; }
+	bool IsTransformDirty() const { return m_bIsTransformDirty; }
+
+	// Tests the world bounds of the last UpdateWorldMatrix()
+	bool IsOutsideFrustum(const XMVECTOR(&Planes)[6]) const;
+
+	// The object stays in the tree (see CObject3DTree) until it is destroyed; the tree must outlive it.
+	void InsertIntoTree(CObject3DTree* const PtrObject3DTree);
+
+	// Builds (LevelCount - 1) simplified levels of every mesh (see CMeshSimplifier::BuildLODChain()); level 0 is the model itself.
+	void CreateLODs(size_t LevelCount, float TriangleRatio = 0.5f, float MaxError = FLT_MAX);
+
+	// Picks the coarsest level whose error projects to at most KLODPixelError pixels, using the projected size of the bounding sphere.
+	// ProjectionScale = (screen height / 2) / tan(FOV / 2)
+	void UpdateLOD(const XMVECTOR& EyePosition, float ProjectionScale);
+
+	// Splits every mesh into meshlets (see CMeshletBuilder); this reorders the triangles of the model.
+	void CreateMeshlets();
+
+	// Recomputes the tangent frames of every mesh (see CTangentGenerator) and recreates the buffers, which drops LODs and meshlets.
+	void GenerateTangents(CThreadPool* const PtrThreadPool = nullptr);
+
+	// Replaces every mesh with its PN-triangle surface at Factors' edge and inside factors (the target edge length is ignored) and eType,
+	// baked by CTessellationBaker, and turns tessellation off, so that the object keeps its curved look without hull and domain shaders.
+	// With Displacement.bUseDisplacement, meshes whose material has a displacement texture are also displaced by it (see
+	// CTessellationBaker::Displace()), at the mip level that matches the edge factor.
+	// The surface is evaluated in object space, which is the GPU's world-space one unless the object is scaled non-uniformly.
+	// Meshes whose factors cull every patch are left as they are. This recreates the buffers, which drops LODs and meshlets.
+	// With PtrTessellationCache, the baked meshes come from (and go to) that cache; displacement is applied to a copy.
+	void FreezeTessellation(const SCBTessFactorData& Factors, ETessellationType eType, const SCBDisplacementData& Displacement,
+		CThreadPool* const PtrThreadPool = nullptr, CTessellationCache* const PtrTessellationCache = nullptr);
+
+	// Object-space BVH of a mesh for ray queries, built on first use and refitted after UpdateMeshBuffer()
+	const CMeshBVH& GetMeshBVH(size_t MeshIndex);
+
+	// Closest hit (0 < T < MaxT) of a world-space ray with the PN-triangle surface that HSTri.hlsl and DSTri.hlsl draw, tessellated on the CPU
+	// with the current factors (as seen by Camera) and partitioning; OutTriangle is the hit tessellated triangle in world space.
+	// Only the base triangles whose BVH leaves (grown by GetBoundingMargin()) and control-point bounds the ray enters are tessellated.
+	// Patches are intersected with the quad sphere of HSQuadSphere.hlsl and DSQuadSphere.hlsl instead (see GenerateQuadSphere()).
+	bool IntersectTessellatedSurface(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, const SCBTessCameraData& Camera, float MaxT,
+		float* const OutPtrT, XMVECTOR(&OutTriangle)[3]);
+
+	// HSTri.hlsl's CalcHSPatchConstants() for the patch of three world-space positions; float rounding can differ from the GPU's in the last bits
+	static void GetPatchTessFactors(const XMVECTOR(&WorldPositions)[3], const SCBTessFactorData& Factors, const SCBTessCameraData& Camera,
+		float(&OutEdgeFactors)[3], float& OutInsideFactor);
+	// Triangles the tessellator outputs for this object with Factors (not necessarily its own) as seen by Camera
+	size_t CountTessellatedTriangles(const SCBTessFactorData& Factors, const SCBTessCameraData& Camera) const;
+
+	// Frustum and normal-cone culling of the meshlets with the current world matrix.
+	// Draw() then only issues the visible triangle ranges (LOD 0 without tessellation only).
+	void CullMeshlets(const XMMATRIX& ViewProjection, const XMVECTOR& EyePosition);
 
 	void Draw(bool bIgnoreOwnTexture = false, bool bIgnoreInstances = false) const;
 
@@ -135,6 +232,10 @@ public:
 	void SetDisplacementData(const CObject3D::SCBDisplacementData& Data);
 	const CObject3D::SCBDisplacementData& GetDisplacementData() const;
 
+	// Packed vertices (SPackedVertex3D) are drawn with CGame's packed base vertex shader; this recreates the vertex buffers.
+	bool ShouldPackVertices() const { return m_bShouldPackVertices; }
+	void ShouldPackVertices(bool Value);
+
 public:
 	bool IsCreated() const { return m_bIsCreated; }
 	bool IsPatches() const { return m_bIsPatch; }
@@ -144,16 +245,45 @@ public:
 	SModel& GetModel() { return m_Model; }
 	const std::string& GetName() const { return m_Name; }
 	const std::string& GetModelFileName() const { return m_ModelFileName; }
+	// Empty unless the object was created with bShouldOptimizeMesh, otherwise one entry per mesh
+	const std::vector<SMeshOptimizationStats>& GetMeshOptimizationStats() const { return m_vMeshOptimizationStats; }
 	CMaterialTextureSet* GetMaterialTextureSet(size_t iMaterial);
+	size_t GetLODCount() const { return m_vLODs.size() + 1; }
+	size_t GetCurrentLOD() const { return m_CurrentLOD; }
+	float GetLODError(size_t LOD) const { return (LOD == 0) ? 0.0f : m_vLODs[LOD - 1].Error; }
+	bool HasMeshlets() const { return !m_vMeshMeshlets.empty(); }
+	size_t GetMeshletCount() const;
+	size_t GetVisibleMeshletCount() const { return m_VisibleMeshletCount; }
+	bool IsSharingPrimitive() const { return m_SharedPrimitive != nullptr; }
+	// Object space; computed whenever the mesh buffers are created or updated
+	const SBoundingVolumes& GetBoundingVolumes() const { return m_BoundingVolumes; }
+	// How far the drawn surface can be outside the bounding volumes (PN-triangle tessellation), in object space
+	float GetBoundingMargin() const;
+	// Largest round-trip error over the meshes (all zero unless the vertices are packed)
+	SVertexPackingError GetVertexPackingError() const;
+	// Vertex and index buffer sizes of LOD 0
+	size_t GetMeshBufferByteSize() const;
 
 private:
+	void OptimizeMeshes();
+
 	void CreateMeshBuffers();
 	void CreateMeshBuffer(size_t MeshIndex);
+	void CreateMeshBuffer(const SMesh& Mesh, SMeshBuffers& MeshBuffers);
 
 	void CreateMaterialTextures();
 	void CreateMaterialTexture(size_t Index);
 
 	void LimitFloatRotation(float& Value, const float Min, const float Max);
+	void LimitTransform();
+	// World bounds and the tree from ComponentTransform.MatrixWorld
+	void UpdateWorldBounds();
+
+public:
+	static constexpr float		KLODPixelError{ 1.0f };
+	// A level only changes once the projected size moves this far (relative) past its threshold, so LODs don't flicker.
+	static constexpr float		KLODHysteresis{ 0.1f };
+	static constexpr size_t		KWorldMatrixGrainSize{ 256 };
 
 public:
 	SComponentTransform			ComponentTransform{};
@@ -174,12 +304,37 @@ private:
 	size_t							m_ControlPointCountPerPatch{};
 	size_t							m_PatchCount{};
 	SModel							m_Model{};
+	SBoundingVolumes				m_BoundingVolumes{};
 	std::vector<std::unique_ptr<CMaterialTextureSet>> m_vMaterialTextureSets{};
 	std::vector<SMeshBuffers>		m_vMeshBuffers{};
+	std::shared_ptr<const SCachedPrimitive>	m_SharedPrimitive{};
+	std::vector<SMeshOptimizationStats>	m_vMeshOptimizationStats{};
+	std::vector<SLOD>				m_vLODs{};
+	size_t							m_CurrentLOD{};
+
+	// Per mesh: meshlets and the merged (TriangleOffset, TriangleCount) ranges that survived the last CullMeshlets()
+	std::vector<std::vector<SMeshlet>>						m_vMeshMeshlets{};
+	std::vector<std::vector<std::pair<uint32_t, uint32_t>>>	m_vMeshVisibleRanges{};
+	size_t							m_VisibleMeshletCount{};
+
+	// Per mesh; empty until GetMeshBVH() is first called
+	std::vector<CMeshBVH>			m_vMeshBVHs{};
+	std::vector<bool>				m_vMeshBVHRefitFlags{};
+
+	// Patches: the quad sphere of m_PatchMeshTessFactorData, baked by IntersectTessellatedSurface()
+	SMesh							m_PatchMesh{};
+	CMeshBVH						m_PatchMeshBVH{};
+	SCBTessFactorData				m_PatchMeshTessFactorData{};
+
+	CObject3DTree*					m_PtrObject3DTree{};
+	uint32_t						m_Object3DTreeProxy{ CObject3DTree::KNullNode };
+	bool							m_bIsTransformDirty{ true };
+
 	SCBTessFactorData				m_CBTessFactorData{};
 	SCBDisplacementData				m_CBDisplacementData{};
 
 	bool							m_bShouldTesselate{ false };
+	bool							m_bShouldPackVertices{ false };
 	ETessellationType				m_eTessellationType{};
 };
 
@@ -0,0 +1,470 @@
+#include "Object3DTree.h"
+#include "Math.h"
+
+using std::vector;
+using std::pair;
+using std::function;
+using std::min;
+using std::max;
+
+static float GetHalfSurfaceArea(const XMFLOAT3& Min, const XMFLOAT3& Max)
+{
+	const float KX{ Max.x - Min.x };
+	const float KY{ Max.y - Min.y };
+	const float KZ{ Max.z - Min.z };
+	return KX * KY + KY * KZ + KZ * KX;
+}
+
+static float GetUnionHalfSurfaceArea(const XMFLOAT3& MinA, const XMFLOAT3& MaxA, const XMFLOAT3& MinB, const XMFLOAT3& MaxB)
+{
+	const XMFLOAT3 KMin{ min(MinA.x, MinB.x), min(MinA.y, MinB.y), min(MinA.z, MinB.z) };
+	const XMFLOAT3 KMax{ max(MaxA.x, MaxB.x), max(MaxA.y, MaxB.y), max(MaxA.z, MaxB.z) };
+	return GetHalfSurfaceArea(KMin, KMax);
+}
+
+static float GetFatMargin(float Radius)
+{
+	const float KMargin{ Radius * CObject3DTree::KFatMarginRatio };
+	return (KMargin > CObject3DTree::KMinFatMargin) ? KMargin : CObject3DTree::KMinFatMargin;
+}
+
+// -1: outside a plane, 0: crosses a plane, +1: inside every plane
+static int ClassifyBox(const XMFLOAT4(&Planes)[6], const XMFLOAT3& Min, const XMFLOAT3& Max)
+{
+	int Result{ +1 };
+	for (const XMFLOAT4& Plane : Planes)
+	{
+		// The corners farthest along and against the plane normal
+		const float KFar{ Plane.x * ((Plane.x >= 0.0f) ? Max.x : Min.x) + Plane.y * ((Plane.y >= 0.0f) ? Max.y : Min.y) +
+			Plane.z * ((Plane.z >= 0.0f) ? Max.z : Min.z) + Plane.w };
+		if (KFar < 0.0f) return -1;
+
+		const float KNear{ Plane.x * ((Plane.x >= 0.0f) ? Min.x : Max.x) + Plane.y * ((Plane.y >= 0.0f) ? Min.y : Max.y) +
+			Plane.z * ((Plane.z >= 0.0f) ? Min.z : Max.z) + Plane.w };
+		if (KNear < 0.0f) Result = 0;
+	}
+	return Result;
+}
+
+uint32_t CObject3DTree::Insert(CObject3D* const PtrObject3D, const XMVECTOR& Center, float Radius)
+{
+	assert(PtrObject3D);
+
+	const uint32_t KLeaf{ AllocateNode() };
+	SNode& Leaf{ m_vNodes[KLeaf] };
+	Leaf.PtrObject3D = PtrObject3D;
+	SetLeafBounds(Leaf, Center, Radius);
+
+	InsertLeaf(KLeaf);
+	++m_ProxyCount;
+	return KLeaf;
+}
+
+void CObject3DTree::Remove(uint32_t Proxy)
+{
+	assert(Proxy < m_vNodes.size());
+	assert(m_vNodes[Proxy].IsLeaf() && m_vNodes[Proxy].Height == 0);
+
+	RemoveLeaf(Proxy);
+	FreeNode(Proxy);
+	--m_ProxyCount;
+}
+
+bool CObject3DTree::Move(uint32_t Proxy, const XMVECTOR& Center, float Radius)
+{
+	assert(Proxy < m_vNodes.size());
+	assert(m_vNodes[Proxy].IsLeaf() && m_vNodes[Proxy].Height == 0);
+
+	SNode& Leaf{ m_vNodes[Proxy] };
+	XMFLOAT3 SphereCenter{};
+	XMStoreFloat3(&SphereCenter, Center);
+
+	const bool KbIsContained{
+		SphereCenter.x - Radius >= Leaf.BoundsMin.x && SphereCenter.x + Radius <= Leaf.BoundsMax.x &&
+		SphereCenter.y - Radius >= Leaf.BoundsMin.y && SphereCenter.y + Radius <= Leaf.BoundsMax.y &&
+		SphereCenter.z - Radius >= Leaf.BoundsMin.z && SphereCenter.z + Radius <= Leaf.BoundsMax.z };
+
+	// A shrunk object would otherwise keep its old fat box forever
+	const float KFatHalfSize{ Radius + GetFatMargin(Radius) };
+	const bool KbIsTooLarge{ (Leaf.BoundsMax.x - Leaf.BoundsMin.x) * 0.5f > 2.0f * KFatHalfSize };
+
+	if (KbIsContained && !KbIsTooLarge)
+	{
+		Leaf.SphereCenter = SphereCenter;
+		Leaf.SphereRadius = Radius;
+		return false;
+	}
+
+	RemoveLeaf(Proxy);
+	SetLeafBounds(m_vNodes[Proxy], Center, Radius);
+	InsertLeaf(Proxy);
+	++m_ReinsertionCount;
+	return true;
+}
+
+void CObject3DTree::Clear()
+{
+	m_vNodes.clear();
+	m_Root = KNullNode;
+	m_FreeList = KNullNode;
+	m_ProxyCount = 0;
+	m_ReinsertionCount = 0;
+}
+
+void CObject3DTree::QueryRay(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, const function<void(CObject3D*, const XMVECTOR&)>& Callback) const
+{
+	if (m_Root == KNullNode) return;
+
+	XMFLOAT3 Origin{};
+	XMFLOAT3 Direction{};
+	XMStoreFloat3(&Origin, RayOrigin);
+	XMStoreFloat3(&Direction, RayDirection);
+
+	// A zero component gives huge but finite slab distances, so that no 0 * inf appears
+	const XMFLOAT3 KInverseDirection{
+		(Direction.x != 0.0f) ? 1.0f / Direction.x : FLT_MAX,
+		(Direction.y != 0.0f) ? 1.0f / Direction.y : FLT_MAX,
+		(Direction.z != 0.0f) ? 1.0f / Direction.z : FLT_MAX };
+
+	vector<uint32_t> vStack{};
+	vStack.reserve(64);
+	vStack.emplace_back(m_Root);
+	while (!vStack.empty())
+	{
+		const SNode& KNode{ m_vNodes[vStack.back()] };
+		vStack.pop_back();
+
+		const float KT0X{ (KNode.BoundsMin.x - Origin.x) * KInverseDirection.x }, KT1X{ (KNode.BoundsMax.x - Origin.x) * KInverseDirection.x };
+		const float KT0Y{ (KNode.BoundsMin.y - Origin.y) * KInverseDirection.y }, KT1Y{ (KNode.BoundsMax.y - Origin.y) * KInverseDirection.y };
+		const float KT0Z{ (KNode.BoundsMin.z - Origin.z) * KInverseDirection.z }, KT1Z{ (KNode.BoundsMax.z - Origin.z) * KInverseDirection.z };
+		const float KEntry{ max(0.0f, max(min(KT0X, KT1X), max(min(KT0Y, KT1Y), min(KT0Z, KT1Z)))) };
+		const float KExit{ min(max(KT0X, KT1X), min(max(KT0Y, KT1Y), max(KT0Z, KT1Z))) };
+		if (KEntry > KExit) continue;
+
+		if (KNode.IsLeaf())
+		{
+			XMVECTOR T{};
+			if (IntersectRaySphere(RayOrigin, RayDirection, KNode.SphereRadius, XMLoadFloat3(&KNode.SphereCenter), &T))
+			{
+				Callback(KNode.PtrObject3D, T);
+			}
+			continue;
+		}
+		vStack.emplace_back(KNode.Child0);
+		vStack.emplace_back(KNode.Child1);
+	}
+}
+
+void CObject3DTree::QuerySphere(const XMVECTOR& Center, float Radius, const function<void(CObject3D*)>& Callback) const
+{
+	if (m_Root == KNullNode) return;
+
+	XMFLOAT3 QueryCenter{};
+	XMStoreFloat3(&QueryCenter, Center);
+
+	vector<uint32_t> vStack{};
+	vStack.reserve(64);
+	vStack.emplace_back(m_Root);
+	while (!vStack.empty())
+	{
+		const SNode& KNode{ m_vNodes[vStack.back()] };
+		vStack.pop_back();
+
+		// Squared distance from the center to the box
+		const float KDX{ max(max(KNode.BoundsMin.x - QueryCenter.x, 0.0f), QueryCenter.x - KNode.BoundsMax.x) };
+		const float KDY{ max(max(KNode.BoundsMin.y - QueryCenter.y, 0.0f), QueryCenter.y - KNode.BoundsMax.y) };
+		const float KDZ{ max(max(KNode.BoundsMin.z - QueryCenter.z, 0.0f), QueryCenter.z - KNode.BoundsMax.z) };
+		if (KDX * KDX + KDY * KDY + KDZ * KDZ > Radius * Radius) continue;
+
+		if (KNode.IsLeaf())
+		{
+			const float KX{ KNode.SphereCenter.x - QueryCenter.x };
+			const float KY{ KNode.SphereCenter.y - QueryCenter.y };
+			const float KZ{ KNode.SphereCenter.z - QueryCenter.z };
+			const float KRadiusSum{ KNode.SphereRadius + Radius };
+			if (KX * KX + KY * KY + KZ * KZ <= KRadiusSum * KRadiusSum) Callback(KNode.PtrObject3D);
+			continue;
+		}
+		vStack.emplace_back(KNode.Child0);
+		vStack.emplace_back(KNode.Child1);
+	}
+}
+
+void CObject3DTree::QueryFrustum(const XMVECTOR(&Planes)[6], const function<void(CObject3D*)>& Callback) const
+{
+	if (m_Root == KNullNode) return;
+
+	XMFLOAT4 PlaneValues[6]{};
+	for (int iPlane = 0; iPlane < 6; ++iPlane)
+	{
+		XMStoreFloat4(&PlaneValues[iPlane], Planes[iPlane]);
+	}
+
+	// The second member says whether the node is known to be inside every plane, in which case its subtree is reported without tests
+	vector<pair<uint32_t, bool>> vStack{};
+	vStack.reserve(64);
+	vStack.emplace_back(m_Root, false);
+	while (!vStack.empty())
+	{
+		const pair<uint32_t, bool> KEntry{ vStack.back() };
+		vStack.pop_back();
+
+		const SNode& KNode{ m_vNodes[KEntry.first] };
+		bool bIsInside{ KEntry.second };
+		if (!bIsInside)
+		{
+			const int KClass{ ClassifyBox(PlaneValues, KNode.BoundsMin, KNode.BoundsMax) };
+			if (KClass < 0) continue;
+			bIsInside = (KClass > 0);
+		}
+
+		if (KNode.IsLeaf())
+		{
+			// The sphere lies inside its fat box
+			if (bIsInside || !IsSphereOutsideFrustum(Planes, XMLoadFloat3(&KNode.SphereCenter), KNode.SphereRadius))
+			{
+				Callback(KNode.PtrObject3D);
+			}
+			continue;
+		}
+		vStack.emplace_back(KNode.Child0, bIsInside);
+		vStack.emplace_back(KNode.Child1, bIsInside);
+	}
+}
+
+uint32_t CObject3DTree::AllocateNode()
+{
+	if (m_FreeList == KNullNode)
+	{
+		m_vNodes.emplace_back();
+		return static_cast<uint32_t>(m_vNodes.size() - 1);
+	}
+
+	const uint32_t KNode{ m_FreeList };
+	m_FreeList = m_vNodes[KNode].Parent;
+	m_vNodes[KNode] = SNode();
+	return KNode;
+}
+
+void CObject3DTree::FreeNode(uint32_t Node)
+{
+	m_vNodes[Node] = SNode();
+	m_vNodes[Node].Height = UINT32_MAX;
+	m_vNodes[Node].Parent = m_FreeList;
+	m_FreeList = Node;
+}
+
+void CObject3DTree::InsertLeaf(uint32_t Leaf)
+{
+	if (m_Root == KNullNode)
+	{
+		m_Root = Leaf;
+		m_vNodes[Leaf].Parent = KNullNode;
+		return;
+	}
+
+	const uint32_t KSibling{ FindBestSibling(Leaf) };
+	const uint32_t KOldParent{ m_vNodes[KSibling].Parent };
+
+	// Allocation may move the nodes, so no references are held across it
+	const uint32_t KNewParent{ AllocateNode() };
+	m_vNodes[KNewParent].Parent = KOldParent;
+	m_vNodes[KNewParent].Child0 = KSibling;
+	m_vNodes[KNewParent].Child1 = Leaf;
+	m_vNodes[KSibling].Parent = KNewParent;
+	m_vNodes[Leaf].Parent = KNewParent;
+
+	if (KOldParent == KNullNode)
+	{
+		m_Root = KNewParent;
+	}
+	else
+	{
+		SNode& OldParent{ m_vNodes[KOldParent] };
+		if (OldParent.Child0 == KSibling)
+		{
+			OldParent.Child0 = KNewParent;
+		}
+		else
+		{
+			OldParent.Child1 = KNewParent;
+		}
+	}
+
+	UpdateAncestors(KNewParent);
+}
+
+void CObject3DTree::RemoveLeaf(uint32_t Leaf)
+{
+	if (Leaf == m_Root)
+	{
+		m_Root = KNullNode;
+		return;
+	}
+
+	const uint32_t KParent{ m_vNodes[Leaf].Parent };
+	const uint32_t KGrandParent{ m_vNodes[KParent].Parent };
+	const uint32_t KSibling{ (m_vNodes[KParent].Child0 == Leaf) ? m_vNodes[KParent].Child1 : m_vNodes[KParent].Child0 };
+
+	m_vNodes[KSibling].Parent = KGrandParent;
+	if (KGrandParent == KNullNode)
+	{
+		m_Root = KSibling;
+	}
+	else
+	{
+		SNode& GrandParent{ m_vNodes[KGrandParent] };
+		if (GrandParent.Child0 == KParent)
+		{
+			GrandParent.Child0 = KSibling;
+		}
+		else
+		{
+			GrandParent.Child1 = KSibling;
+		}
+	}
+	FreeNode(KParent);
+	m_vNodes[Leaf].Parent = KNullNode;
+
+	if (KGrandParent != KNullNode) UpdateAncestors(KGrandParent);
+}
+
+uint32_t CObject3DTree::FindBestSibling(uint32_t Leaf) const
+{
+	const SNode& KLeaf{ m_vNodes[Leaf] };
+	const float KLeafArea{ GetHalfSurfaceArea(KLeaf.BoundsMin, KLeaf.BoundsMax) };
+
+	// Cost of a sibling: the area of the new parent plus the area every ancestor grows by.
+	// A subtree can only be cheaper than the best so far if the leaf's own area plus what its ancestors grow by is.
+	uint32_t BestSibling{ m_Root };
+	float BestCost{ FLT_MAX };
+
+	vector<pair<uint32_t, float>> vStack{};
+	vStack.reserve(64);
+	vStack.emplace_back(m_Root, 0.0f);
+	while (!vStack.empty())
+	{
+		const pair<uint32_t, float> KEntry{ vStack.back() };
+		vStack.pop_back();
+
+		const SNode& KNode{ m_vNodes[KEntry.first] };
+		const float KDirectCost{ GetUnionHalfSurfaceArea(KLeaf.BoundsMin, KLeaf.BoundsMax, KNode.BoundsMin, KNode.BoundsMax) };
+		const float KCost{ KDirectCost + KEntry.second };
+		if (KCost < BestCost)
+		{
+			BestCost = KCost;
+			BestSibling = KEntry.first;
+		}
+
+		if (KNode.IsLeaf()) continue;
+
+		const float KInheritedCost{ KEntry.second + KDirectCost - GetHalfSurfaceArea(KNode.BoundsMin, KNode.BoundsMax) };
+		if (KLeafArea + KInheritedCost < BestCost)
+		{
+			vStack.emplace_back(KNode.Child0, KInheritedCost);
+			vStack.emplace_back(KNode.Child1, KInheritedCost);
+		}
+	}
+	return BestSibling;
+}
+
+void CObject3DTree::UpdateAncestors(uint32_t Node)
+{
+	while (Node != KNullNode)
+	{
+		Refit(Node);
+		Rotate(Node);
+		Node = m_vNodes[Node].Parent;
+	}
+}
+
+void CObject3DTree::Rotate(uint32_t Node)
+{
+	SNode& A{ m_vNodes[Node] };
+	if (A.IsLeaf()) return;
+
+	SNode& B{ m_vNodes[A.Child0] };
+	SNode& C{ m_vNodes[A.Child1] };
+
+	// Swapping a child with a grandchild on the other side only changes the area of that side's child
+	enum class ERotation { None, BWithF, BWithG, CWithD, CWithE };
+	ERotation eBest{ ERotation::None };
+	float BestDifference{ 0.0f };
+	if (!B.IsLeaf())
+	{
+		const SNode& KD{ m_vNodes[B.Child0] };
+		const SNode& KE{ m_vNodes[B.Child1] };
+		const float KAreaB{ GetHalfSurfaceArea(B.BoundsMin, B.BoundsMax) };
+
+		const float KDifferenceCD{ GetUnionHalfSurfaceArea(C.BoundsMin, C.BoundsMax, KE.BoundsMin, KE.BoundsMax) - KAreaB };
+		if (KDifferenceCD < BestDifference) { BestDifference = KDifferenceCD; eBest = ERotation::CWithD; }
+
+		const float KDifferenceCE{ GetUnionHalfSurfaceArea(C.BoundsMin, C.BoundsMax, KD.BoundsMin, KD.BoundsMax) - KAreaB };
+		if (KDifferenceCE < BestDifference) { BestDifference = KDifferenceCE; eBest = ERotation::CWithE; }
+	}
+	if (!C.IsLeaf())
+	{
+		const SNode& KF{ m_vNodes[C.Child0] };
+		const SNode& KG{ m_vNodes[C.Child1] };
+		const float KAreaC{ GetHalfSurfaceArea(C.BoundsMin, C.BoundsMax) };
+
+		const float KDifferenceBF{ GetUnionHalfSurfaceArea(B.BoundsMin, B.BoundsMax, KG.BoundsMin, KG.BoundsMax) - KAreaC };
+		if (KDifferenceBF < BestDifference) { BestDifference = KDifferenceBF; eBest = ERotation::BWithF; }
+
+		const float KDifferenceBG{ GetUnionHalfSurfaceArea(B.BoundsMin, B.BoundsMax, KF.BoundsMin, KF.BoundsMax) - KAreaC };
+		if (KDifferenceBG < BestDifference) { BestDifference = KDifferenceBG; eBest = ERotation::BWithG; }
+	}
+
+	const uint32_t KB{ A.Child0 };
+	const uint32_t KC{ A.Child1 };
+	switch (eBest)
+	{
+	case ERotation::None:
+		return;
+	case ERotation::CWithD:
+	case ERotation::CWithE:
+	{
+		uint32_t& Grandchild{ (eBest == ERotation::CWithD) ? B.Child0 : B.Child1 };
+		const uint32_t KGrandchild{ Grandchild };
+		A.Child1 = KGrandchild;
+		m_vNodes[KGrandchild].Parent = Node;
+		Grandchild = KC;
+		C.Parent = KB;
+		Refit(KB);
+		break;
+	}
+	case ERotation::BWithF:
+	case ERotation::BWithG:
+	{
+		uint32_t& Grandchild{ (eBest == ERotation::BWithF) ? C.Child0 : C.Child1 };
+		const uint32_t KGrandchild{ Grandchild };
+		A.Child0 = KGrandchild;
+		m_vNodes[KGrandchild].Parent = Node;
+		Grandchild = KB;
+		B.Parent = KC;
+		Refit(KC);
+		break;
+	}
+	}
+	Refit(Node);
+}
+
+void CObject3DTree::Refit(uint32_t Node)
+{
+	SNode& Parent{ m_vNodes[Node] };
+	const SNode& KChild0{ m_vNodes[Parent.Child0] };
+	const SNode& KChild1{ m_vNodes[Parent.Child1] };
+	Parent.BoundsMin = XMFLOAT3(min(KChild0.BoundsMin.x, KChild1.BoundsMin.x), min(KChild0.BoundsMin.y, KChild1.BoundsMin.y), min(KChild0.BoundsMin.z, KChild1.BoundsMin.z));
+	Parent.BoundsMax = XMFLOAT3(max(KChild0.BoundsMax.x, KChild1.BoundsMax.x), max(KChild0.BoundsMax.y, KChild1.BoundsMax.y), max(KChild0.BoundsMax.z, KChild1.BoundsMax.z));
+	Parent.Height = 1 + max(KChild0.Height, KChild1.Height);
+}
+
+void CObject3DTree::SetLeafBounds(SNode& Leaf, const XMVECTOR& Center, float Radius) const
+{
+	XMStoreFloat3(&Leaf.SphereCenter, Center);
+	Leaf.SphereRadius = Radius;
+
+	const float KHalfSize{ Radius + GetFatMargin(Radius) };
+	Leaf.BoundsMin = XMFLOAT3(Leaf.SphereCenter.x - KHalfSize, Leaf.SphereCenter.y - KHalfSize, Leaf.SphereCenter.z - KHalfSize);
+	Leaf.BoundsMax = XMFLOAT3(Leaf.SphereCenter.x + KHalfSize, Leaf.SphereCenter.y + KHalfSize, Leaf.SphereCenter.z + KHalfSize);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include <functional>
+
+class CObject3D;
+
+// Dynamic AABB tree over the world-space bounding spheres of Object3Ds (Catto, "Dynamic Bounding Volume Hierarchies", GDC 2019).
+//  - Leaves store the sphere and an AABB fattened by KFatMarginRatio of the radius, so objects that move a little don't touch the tree.
+//  - A new leaf goes next to the sibling that increases the total surface area the least (branch and bound over the whole tree).
+//  - Every node on the way back up is rotated (a child swapped with a grandchild) whenever that shrinks it, which keeps the tree balanced
+//    without comparing heights.
+// Queries walk the fat boxes and then test the spheres, so their cost grows with the output and the depth, not with the object count.
+class CObject3DTree
+{
+	struct SNode
+	{
+		bool IsLeaf() const { return Child0 == KNullNode; }
+
+		// Fat for leaves
+		XMFLOAT3	BoundsMin{};
+		XMFLOAT3	BoundsMax{};
+
+		// Leaves only
+		XMFLOAT3	SphereCenter{};
+		float		SphereRadius{};
+		CObject3D*	PtrObject3D{};
+
+		// Next free node while the node is unused
+		uint32_t	Parent{ KNullNode };
+		uint32_t	Child0{ KNullNode };
+		uint32_t	Child1{ KNullNode };
+		// Leaves are 0, unused nodes UINT32_MAX
+		uint32_t	Height{};
+	};
+
+public:
+	CObject3DTree() {}
+	~CObject3DTree() {}
+
+public:
+	// Returns the proxy that identifies the object in the tree
+	uint32_t Insert(CObject3D* const PtrObject3D, const XMVECTOR& Center, float Radius);
+	void Remove(uint32_t Proxy);
+	// Returns whether the proxy had to be reinserted (the sphere left its fat box or the box got far too large for it)
+	bool Move(uint32_t Proxy, const XMVECTOR& Center, float Radius);
+	void Clear();
+
+	// Every object whose sphere the ray (T >= 0) hits, with the distance IntersectRaySphere() reports
+	void QueryRay(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, const std::function<void(CObject3D*, const XMVECTOR&)>& Callback) const;
+	// Every object whose sphere overlaps the given one
+	void QuerySphere(const XMVECTOR& Center, float Radius, const std::function<void(CObject3D*)>& Callback) const;
+	// Every object whose sphere is not outside the planes (see ExtractFrustumPlanes())
+	void QueryFrustum(const XMVECTOR(&Planes)[6], const std::function<void(CObject3D*)>& Callback) const;
+
+public:
+	size_t GetProxyCount() const { return m_ProxyCount; }
+	size_t GetHeight() const { return (m_Root == KNullNode) ? 0 : m_vNodes[m_Root].Height; }
+	// Proxies reinserted by Move() since the tree was created or cleared
+	size_t GetReinsertionCount() const { return m_ReinsertionCount; }
+
+private:
+	uint32_t AllocateNode();
+	void FreeNode(uint32_t Node);
+
+	void InsertLeaf(uint32_t Leaf);
+	void RemoveLeaf(uint32_t Leaf);
+	uint32_t FindBestSibling(uint32_t Leaf) const;
+
+	// Refits and rotates from Node up to the root
+	void UpdateAncestors(uint32_t Node);
+	void Rotate(uint32_t Node);
+	void Refit(uint32_t Node);
+
+	void SetLeafBounds(SNode& Leaf, const XMVECTOR& Center, float Radius) const;
+
+public:
+	static constexpr uint32_t	KNullNode{ UINT32_MAX };
+	static constexpr float		KFatMarginRatio{ 0.25f };
+	// Absolute part of the margin, so that points and tiny objects still get some slack
+	static constexpr float		KMinFatMargin{ 0.05f };
+
+private:
+	std::vector<SNode>	m_vNodes{};
+	uint32_t			m_Root{ KNullNode };
+	uint32_t			m_FreeList{ KNullNode };
+	size_t				m_ProxyCount{};
+	size_t				m_ReinsertionCount{};
+};
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "SharedHeader.h"
+
+// Curved PN triangle (Vlachos et al., "Curved PN Triangles", 2001) of three positions and normals; the same cubic Bezier patch and quadratic
+// normals as GetBezierPosition() and GetBezierNormal() in Shader/Shared.hlsli, which DSTri.hlsl evaluates at every SV_DomainLocation.
+struct SPNTriangle
+{
+	// B300, B030, B003, B210, B120, B021, B012, B102, B201, B111
+	XMVECTOR	ControlPoints[10]{};
+	// N200, N020, N002, N110, N011, N101
+	XMVECTOR	NormalControlPoints[6]{};
+};
+
+// The normals don't need to be normalized (DSTri.hlsl normalizes them)
+static SPNTriangle MakePNTriangle(const XMVECTOR& P1, const XMVECTOR& P2, const XMVECTOR& P3, const XMVECTOR& N1, const XMVECTOR& N2, const XMVECTOR& N3);
+// (u, v, w) weight (P1, P2, P3), as SV_DomainLocation
+static XMVECTOR GetPNTrianglePosition(const SPNTriangle& Triangle, float U, float V, float W);
+// Domain points are (u, v) with w = 1 - u - v, as CTessellator's; four points per step
+static void EvaluatePNTriangle(const SPNTriangle& Triangle, const XMFLOAT2* const PtrDomainPoints, size_t Count, XMFLOAT3* const OutPtrPositions);
+// The patch lies in the convex hull of its control points, so their bounds are conservative
+static void GetPNTriangleBounds(const SPNTriangle& Triangle, XMVECTOR& OutMin, XMVECTOR& OutMax);
+// Normalized
+static XMVECTOR GetPNTriangleNormal(const SPNTriangle& Triangle, float U, float V, float W);
+// EvaluatePNTriangle() for the normals, normalized
+static void EvaluatePNTriangleNormals(const SPNTriangle& Triangle, const XMFLOAT2* const PtrDomainPoints, size_t Count, XMFLOAT3* const OutPtrNormals);
+// Mid-edge normal of the edge from Pa to Pb: the corner normals' average reflected across the plane perpendicular to the edge
+static XMVECTOR GetPNTriangleEdgeNormal(const XMVECTOR& Pa, const XMVECTOR& Pb, const XMVECTOR& Na, const XMVECTOR& Nb);
+
+static SPNTriangle MakePNTriangle(const XMVECTOR& P1, const XMVECTOR& P2, const XMVECTOR& P3, const XMVECTOR& N1, const XMVECTOR& N2, const XMVECTOR& N3)
+{
+	const XMVECTOR KN1{ XMVector3Normalize(N1) };
+	const XMVECTOR KN2{ XMVector3Normalize(N2) };
+	const XMVECTOR KN3{ XMVector3Normalize(N3) };
+
+	// Each edge point is projected onto the tangent plane of its nearer corner
+	const XMVECTOR KW12{ XMVector3Dot(P2 - P1, KN1) };
+	const XMVECTOR KW21{ XMVector3Dot(P1 - P2, KN2) };
+	const XMVECTOR KW23{ XMVector3Dot(P3 - P2, KN2) };
+	const XMVECTOR KW32{ XMVector3Dot(P2 - P3, KN3) };
+	const XMVECTOR KW31{ XMVector3Dot(P1 - P3, KN3) };
+	const XMVECTOR KW13{ XMVector3Dot(P3 - P1, KN1) };
+
+	SPNTriangle Result{};
+	XMVECTOR* const B{ Result.ControlPoints };
+	B[0] = P1;
+	B[1] = P2;
+	B[2] = P3;
+	B[3] = (2.0f * P1 + P2 - KW12 * KN1) / 3.0f;
+	B[4] = (2.0f * P2 + P1 - KW21 * KN2) / 3.0f;
+	B[5] = (2.0f * P2 + P3 - KW23 * KN2) / 3.0f;
+	B[6] = (2.0f * P3 + P2 - KW32 * KN3) / 3.0f;
+	B[7] = (2.0f * P3 + P1 - KW31 * KN3) / 3.0f;
+	B[8] = (2.0f * P1 + P3 - KW13 * KN1) / 3.0f;
+
+	const XMVECTOR KE{ (B[3] + B[4] + B[5] + B[6] + B[7] + B[8]) / 6.0f };
+	const XMVECTOR KV{ (P1 + P2 + P3) / 3.0f };
+	B[9] = KE + (KE - KV) / 2.0f;
+
+	XMVECTOR* const N{ Result.NormalControlPoints };
+	N[0] = KN1;
+	N[1] = KN2;
+	N[2] = KN3;
+	N[3] = GetPNTriangleEdgeNormal(P1, P2, KN1, KN2);
+	N[4] = GetPNTriangleEdgeNormal(P2, P3, KN2, KN3);
+	N[5] = GetPNTriangleEdgeNormal(P3, P1, KN3, KN1);
+	return Result;
+}
+
+static XMVECTOR GetPNTrianglePosition(const SPNTriangle& Triangle, float U, float V, float W)
+{
+	const XMVECTOR* const B{ Triangle.ControlPoints };
+	return U * U * U * B[0] + V * V * V * B[1] + W * W * W * B[2] +
+		3.0f * U * U * V * B[3] + 3.0f * U * V * V * B[4] +
+		3.0f * V * V * W * B[5] + 3.0f * V * W * W * B[6] +
+		3.0f * U * W * W * B[7] + 3.0f * U * U * W * B[8] +
+		6.0f * U * V * W * B[9];
+}
+
+static void EvaluatePNTriangle(const SPNTriangle& Triangle, const XMFLOAT2* const PtrDomainPoints, size_t Count, XMFLOAT3* const OutPtrPositions)
+{
+	// [Control point][Axis], splatted
+	XMVECTOR Splats[10][3]{};
+	for (int iPoint = 0; iPoint < 10; ++iPoint)
+	{
+		Splats[iPoint][0] = XMVectorSplatX(Triangle.ControlPoints[iPoint]);
+		Splats[iPoint][1] = XMVectorSplatY(Triangle.ControlPoints[iPoint]);
+		Splats[iPoint][2] = XMVectorSplatZ(Triangle.ControlPoints[iPoint]);
+	}
+
+	const XMVECTOR KOne{ XMVectorSplatOne() };
+	const XMVECTOR KThree{ XMVectorReplicate(3.0f) };
+	const XMVECTOR KSix{ XMVectorReplicate(6.0f) };
+	size_t iPoint{};
+	for (; iPoint + 4 <= Count; iPoint += 4)
+	{
+		const XMFLOAT2* const KPtrDomain{ PtrDomainPoints + iPoint };
+		const XMVECTOR U{ XMVectorSet(KPtrDomain[0].x, KPtrDomain[1].x, KPtrDomain[2].x, KPtrDomain[3].x) };
+		const XMVECTOR V{ XMVectorSet(KPtrDomain[0].y, KPtrDomain[1].y, KPtrDomain[2].y, KPtrDomain[3].y) };
+		const XMVECTOR W{ KOne - U - V };
+
+		const XMVECTOR KUU{ U * U };
+		const XMVECTOR KVV{ V * V };
+		const XMVECTOR KWW{ W * W };
+		const XMVECTOR KWeights[10]{ KUU * U, KVV * V, KWW * W,
+			KThree * KUU * V, KThree * U * KVV, KThree * KVV * W, KThree * V * KWW, KThree * U * KWW, KThree * KUU * W,
+			KSix * U * V * W };
+
+		XMFLOAT4 Axes[3]{};
+		for (int iAxis = 0; iAxis < 3; ++iAxis)
+		{
+			XMVECTOR Sum{ KWeights[0] * Splats[0][iAxis] };
+			for (int iControlPoint = 1; iControlPoint < 10; ++iControlPoint)
+			{
+				Sum = XMVectorMultiplyAdd(KWeights[iControlPoint], Splats[iControlPoint][iAxis], Sum);
+			}
+			XMStoreFloat4(&Axes[iAxis], Sum);
+		}
+
+		OutPtrPositions[iPoint + 0] = XMFLOAT3(Axes[0].x, Axes[1].x, Axes[2].x);
+		OutPtrPositions[iPoint + 1] = XMFLOAT3(Axes[0].y, Axes[1].y, Axes[2].y);
+		OutPtrPositions[iPoint + 2] = XMFLOAT3(Axes[0].z, Axes[1].z, Axes[2].z);
+		OutPtrPositions[iPoint + 3] = XMFLOAT3(Axes[0].w, Axes[1].w, Axes[2].w);
+	}
+	for (; iPoint < Count; ++iPoint)
+	{
+		const XMFLOAT2& KDomain{ PtrDomainPoints[iPoint] };
+		XMStoreFloat3(&OutPtrPositions[iPoint], GetPNTrianglePosition(Triangle, KDomain.x, KDomain.y, 1.0f - KDomain.x - KDomain.y));
+	}
+}
+
+static void GetPNTriangleBounds(const SPNTriangle& Triangle, XMVECTOR& OutMin, XMVECTOR& OutMax)
+{
+	OutMin = OutMax = Triangle.ControlPoints[0];
+	for (int iPoint = 1; iPoint < 10; ++iPoint)
+	{
+		OutMin = XMVectorMin(OutMin, Triangle.ControlPoints[iPoint]);
+		OutMax = XMVectorMax(OutMax, Triangle.ControlPoints[iPoint]);
+	}
+}
+
+static XMVECTOR GetPNTriangleNormal(const SPNTriangle& Triangle, float U, float V, float W)
+{
+	const XMVECTOR* const N{ Triangle.NormalControlPoints };
+	return XMVector3Normalize(U * U * N[0] + V * V * N[1] + W * W * N[2] + U * V * N[3] + V * W * N[4] + U * W * N[5]);
+}
+
+static void EvaluatePNTriangleNormals(const SPNTriangle& Triangle, const XMFLOAT2* const PtrDomainPoints, size_t Count, XMFLOAT3* const OutPtrNormals)
+{
+	// [Control point][Axis], splatted
+	XMVECTOR Splats[6][3]{};
+	for (int iPoint = 0; iPoint < 6; ++iPoint)
+	{
+		Splats[iPoint][0] = XMVectorSplatX(Triangle.NormalControlPoints[iPoint]);
+		Splats[iPoint][1] = XMVectorSplatY(Triangle.NormalControlPoints[iPoint]);
+		Splats[iPoint][2] = XMVectorSplatZ(Triangle.NormalControlPoints[iPoint]);
+	}
+
+	const XMVECTOR KOne{ XMVectorSplatOne() };
+	size_t iPoint{};
+	for (; iPoint + 4 <= Count; iPoint += 4)
+	{
+		const XMFLOAT2* const KPtrDomain{ PtrDomainPoints + iPoint };
+		const XMVECTOR U{ XMVectorSet(KPtrDomain[0].x, KPtrDomain[1].x, KPtrDomain[2].x, KPtrDomain[3].x) };
+		const XMVECTOR V{ XMVectorSet(KPtrDomain[0].y, KPtrDomain[1].y, KPtrDomain[2].y, KPtrDomain[3].y) };
+		const XMVECTOR W{ KOne - U - V };
+		const XMVECTOR KWeights[6]{ U * U, V * V, W * W, U * V, V * W, U * W };
+
+		XMVECTOR Axes[3]{};
+		for (int iAxis = 0; iAxis < 3; ++iAxis)
+		{
+			Axes[iAxis] = KWeights[0] * Splats[0][iAxis];
+			for (int iControlPoint = 1; iControlPoint < 6; ++iControlPoint)
+			{
+				Axes[iAxis] = XMVectorMultiplyAdd(KWeights[iControlPoint], Splats[iControlPoint][iAxis], Axes[iAxis]);
+			}
+		}
+
+		// Same as XMVector3Normalize(), which leaves zero-length normals zero
+		const XMVECTOR KLengthSquared{ Axes[0] * Axes[0] + Axes[1] * Axes[1] + Axes[2] * Axes[2] };
+		const XMVECTOR KIsZero{ XMVectorEqual(KLengthSquared, XMVectorZero()) };
+		const XMVECTOR KInverseLength{ XMVectorSelect(KOne / XMVectorSqrt(KLengthSquared), XMVectorZero(), KIsZero) };
+		XMFLOAT4 Normalized[3]{};
+		for (int iAxis = 0; iAxis < 3; ++iAxis)
+		{
+			XMStoreFloat4(&Normalized[iAxis], Axes[iAxis] * KInverseLength);
+		}
+
+		OutPtrNormals[iPoint + 0] = XMFLOAT3(Normalized[0].x, Normalized[1].x, Normalized[2].x);
+		OutPtrNormals[iPoint + 1] = XMFLOAT3(Normalized[0].y, Normalized[1].y, Normalized[2].y);
+		OutPtrNormals[iPoint + 2] = XMFLOAT3(Normalized[0].z, Normalized[1].z, Normalized[2].z);
+		OutPtrNormals[iPoint + 3] = XMFLOAT3(Normalized[0].w, Normalized[1].w, Normalized[2].w);
+	}
+	for (; iPoint < Count; ++iPoint)
+	{
+		const XMFLOAT2& KDomain{ PtrDomainPoints[iPoint] };
+		XMStoreFloat3(&OutPtrNormals[iPoint], GetPNTriangleNormal(Triangle, KDomain.x, KDomain.y, 1.0f - KDomain.x - KDomain.y));
+	}
+}
+
+static XMVECTOR GetPNTriangleEdgeNormal(const XMVECTOR& Pa, const XMVECTOR& Pb, const XMVECTOR& Na, const XMVECTOR& Nb)
+{
+	const XMVECTOR KEdge{ XMVectorSetW(Pb - Pa, 0.0f) };
+	const XMVECTOR KSum{ XMVectorSetW(Na + Nb, 0.0f) };
+	const float KLengthSquared{ XMVectorGetX(XMVector3Dot(KEdge, KEdge)) };
+	if (KLengthSquared == 0.0f) return XMVector3Normalize(KSum);
+
+	const float KV{ 2.0f * XMVectorGetX(XMVector3Dot(KEdge, KSum)) / KLengthSquared };
+	return XMVector3Normalize(KSum - KV * KEdge);
+}
@@ -0,0 +1,160 @@
+#include "PositionWelder.h"
+
+using std::vector;
+using std::min;
+using std::max;
+using std::isfinite;
+
+static int64_t GetCellCoordinate(float Scaled)
+{
+	const float KBound{ CPositionWelder::KMaxCellCoordinate };
+	return static_cast<int64_t>(floorf(min(max(Scaled, -KBound), KBound)));
+}
+
+CPositionWelder::CPositionWelder(float Epsilon)
+{
+	SetEpsilon(Epsilon);
+}
+
+void CPositionWelder::SetEpsilon(float Epsilon)
+{
+	assert(Epsilon > 0.0f);
+
+	m_Epsilon = Epsilon;
+	m_InverseCellSize = 1.0f / (2.0f * m_Epsilon);
+}
+
+size_t CPositionWelder::Weld(const vector<SVertex3D>& vVertices)
+{
+	if (vVertices.empty()) return Weld(nullptr, 0);
+	return Weld(&vVertices[0].Position, vVertices.size(), sizeof(SVertex3D));
+}
+
+size_t CPositionWelder::Weld(const XMVECTOR* const PtrPositions, size_t PositionCount, size_t PositionStride)
+{
+	m_vGroupPositions.clear();
+	m_vGroupRepresentatives.clear();
+	m_vNextGroupInCell.clear();
+	m_vVertexToGroup.clear();
+
+	m_vGroupPositions.reserve(PositionCount);
+	m_vGroupRepresentatives.reserve(PositionCount);
+	m_vNextGroupInCell.reserve(PositionCount);
+	m_vVertexToGroup.resize(PositionCount);
+
+	// Keep the load factor of the open-addressing table at or below 0.5
+	size_t CellCapacity{ 16 };
+	while (CellCapacity < PositionCount * 2) CellCapacity <<= 1;
+	m_vCells.assign(CellCapacity, SCell());
+	m_CellMask = CellCapacity - 1;
+
+	const uint8_t* PtrBytes{ reinterpret_cast<const uint8_t*>(PtrPositions) };
+	for (size_t iPosition = 0; iPosition < PositionCount; ++iPosition)
+	{
+		XMFLOAT3 Position{};
+		XMStoreFloat3(&Position, *reinterpret_cast<const XMVECTOR*>(PtrBytes + iPosition * PositionStride));
+
+		// NaN and infinity can't be placed in a cell, and are never within Epsilon of anything
+		if (!isfinite(Position.x) || !isfinite(Position.y) || !isfinite(Position.z))
+		{
+			m_vVertexToGroup[iPosition] = static_cast<uint32_t>(m_vGroupRepresentatives.size());
+			m_vGroupPositions.emplace_back(Position);
+			m_vGroupRepresentatives.emplace_back(static_cast<uint32_t>(iPosition));
+			m_vNextGroupInCell.emplace_back(KInvalidIndex);
+			continue;
+		}
+
+		float ScaledX{ Position.x * m_InverseCellSize };
+		float ScaledY{ Position.y * m_InverseCellSize };
+		float ScaledZ{ Position.z * m_InverseCellSize };
+		int64_t CellX{ GetCellCoordinate(ScaledX) };
+		int64_t CellY{ GetCellCoordinate(ScaledY) };
+		int64_t CellZ{ GetCellCoordinate(ScaledZ) };
+
+		// Anything within Epsilon (= half a cell) is either in this cell or in the neighbour on the nearer side.
+		int64_t NeighborX{ (ScaledX - static_cast<float>(CellX) < 0.5f) ? CellX - 1 : CellX + 1 };
+		int64_t NeighborY{ (ScaledY - static_cast<float>(CellY) < 0.5f) ? CellY - 1 : CellY + 1 };
+		int64_t NeighborZ{ (ScaledZ - static_cast<float>(CellZ) < 0.5f) ? CellZ - 1 : CellZ + 1 };
+
+		uint32_t Group{ FindGroup(Position, CellX, CellY, CellZ) };
+		for (int iNeighbor = 1; iNeighbor < 8 && Group == KInvalidIndex; ++iNeighbor)
+		{
+			Group = FindGroup(Position,
+				(iNeighbor & 1) ? NeighborX : CellX,
+				(iNeighbor & 2) ? NeighborY : CellY,
+				(iNeighbor & 4) ? NeighborZ : CellZ);
+		}
+
+		if (Group == KInvalidIndex)
+		{
+			Group = static_cast<uint32_t>(m_vGroupRepresentatives.size());
+
+			SCell& Cell{ FindOrInsertCell(CellX, CellY, CellZ) };
+			m_vGroupPositions.emplace_back(Position);
+			m_vGroupRepresentatives.emplace_back(static_cast<uint32_t>(iPosition));
+			m_vNextGroupInCell.emplace_back(Cell.FirstGroup);
+			Cell.FirstGroup = Group;
+		}
+
+		m_vVertexToGroup[iPosition] = Group;
+	}
+
+	return m_vGroupRepresentatives.size();
+}
+
+uint32_t CPositionWelder::FindGroup(const XMFLOAT3& Position, int64_t CellX, int64_t CellY, int64_t CellZ) const
+{
+	const SCell* PtrCell{ FindCell(CellX, CellY, CellZ) };
+	if (!PtrCell) return KInvalidIndex;
+
+	const float KEpsilonSquare{ m_Epsilon * m_Epsilon };
+	for (uint32_t Group = PtrCell->FirstGroup; Group != KInvalidIndex; Group = m_vNextGroupInCell[Group])
+	{
+		const XMFLOAT3& GroupPosition{ m_vGroupPositions[Group] };
+		float DX{ GroupPosition.x - Position.x };
+		float DY{ GroupPosition.y - Position.y };
+		float DZ{ GroupPosition.z - Position.z };
+		if (DX * DX + DY * DY + DZ * DZ <= KEpsilonSquare) return Group;
+	}
+	return KInvalidIndex;
+}
+
+CPositionWelder::SCell& CPositionWelder::FindOrInsertCell(int64_t CellX, int64_t CellY, int64_t CellZ)
+{
+	size_t Slot{ HashCell(CellX, CellY, CellZ) };
+	while (true)
+	{
+		SCell& Cell{ m_vCells[Slot] };
+		if (Cell.FirstGroup == KInvalidIndex)
+		{
+			Cell.X = CellX;
+			Cell.Y = CellY;
+			Cell.Z = CellZ;
+			return Cell;
+		}
+		if (Cell.X == CellX && Cell.Y == CellY && Cell.Z == CellZ) return Cell;
+		Slot = (Slot + 1) & m_CellMask;
+	}
+}
+
+const CPositionWelder::SCell* CPositionWelder::FindCell(int64_t CellX, int64_t CellY, int64_t CellZ) const
+{
+	size_t Slot{ HashCell(CellX, CellY, CellZ) };
+	while (true)
+	{
+		const SCell& Cell{ m_vCells[Slot] };
+		if (Cell.FirstGroup == KInvalidIndex) return nullptr;
+		if (Cell.X == CellX && Cell.Y == CellY && Cell.Z == CellZ) return &Cell;
+		Slot = (Slot + 1) & m_CellMask;
+	}
+}
+
+size_t CPositionWelder::HashCell(int64_t CellX, int64_t CellY, int64_t CellZ) const
+{
+	uint64_t Hash{ static_cast<uint64_t>(CellX) * 73856093u ^ static_cast<uint64_t>(CellY) * 19349663u ^ static_cast<uint64_t>(CellZ) * 83492791u };
+	Hash ^= Hash >> 32;
+	Hash ^= Hash >> 16;
+	Hash *= 0x85ebca6bu;
+	Hash ^= Hash >> 13;
+	return static_cast<size_t>(Hash) & m_CellMask;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "SharedHeader.h"
+
+// Groups vertices whose positions lie within Epsilon of each other.
+// Positions are hashed into a uniform grid of (2 * Epsilon)-sized cells, so every weld candidate of a position
+// lies in one of the 8 cells nearest to it. Expected cost is O(n) and no per-vertex allocation is made.
+class CPositionWelder
+{
+	struct SCell
+	{
+		int64_t		X{};
+		int64_t		Y{};
+		int64_t		Z{};
+		uint32_t	FirstGroup{ KInvalidIndex };
+	};
+
+public:
+	CPositionWelder(float Epsilon = KDefaultEpsilon);
+	~CPositionWelder() {}
+
+public:
+	// Returns the number of weld groups.
+	// Groups are numbered in order of first appearance, so the result is deterministic.
+	// A position with a non-finite coordinate is never welded: it gets a group of its own.
+	size_t Weld(const std::vector<SVertex3D>& vVertices);
+	size_t Weld(const XMVECTOR* const PtrPositions, size_t PositionCount, size_t PositionStride = sizeof(XMVECTOR));
+
+public:
+	void SetEpsilon(float Epsilon);
+	float GetEpsilon() const { return m_Epsilon; }
+
+	size_t GetGroupCount() const { return m_vGroupRepresentatives.size(); }
+
+	// Vertex index -> group index
+	uint32_t GetGroup(size_t VertexIndex) const { return m_vVertexToGroup[VertexIndex]; }
+	const std::vector<uint32_t>& GetVertexToGroup() const { return m_vVertexToGroup; }
+
+	// Group index -> index of the first vertex that fell into the group
+	uint32_t GetGroupRepresentative(size_t GroupIndex) const { return m_vGroupRepresentatives[GroupIndex]; }
+	const std::vector<uint32_t>& GetGroupRepresentatives() const { return m_vGroupRepresentatives; }
+
+private:
+	uint32_t FindGroup(const XMFLOAT3& Position, int64_t CellX, int64_t CellY, int64_t CellZ) const;
+	SCell& FindOrInsertCell(int64_t CellX, int64_t CellY, int64_t CellZ);
+	const SCell* FindCell(int64_t CellX, int64_t CellY, int64_t CellZ) const;
+	size_t HashCell(int64_t CellX, int64_t CellY, int64_t CellZ) const;
+
+public:
+	static constexpr float KDefaultEpsilon{ 0.00001f };
+	static constexpr uint32_t KInvalidIndex{ UINT32_MAX };
+	// Cell coordinates are clamped to this so that the integer conversion is defined for any finite position;
+	// positions beyond it (about 10^14 units at the default epsilon) share the outermost cells
+	static constexpr float KMaxCellCoordinate{ 4'611'686'018'427'387'904.0f };
+
+private:
+	float					m_Epsilon{ KDefaultEpsilon };
+	float					m_InverseCellSize{};
+
+	std::vector<SCell>		m_vCells{};
+	size_t					m_CellMask{};
+
+	std::vector<XMFLOAT3>	m_vGroupPositions{};
+	std::vector<uint32_t>	m_vGroupRepresentatives{};
+	std::vector<uint32_t>	m_vNextGroupInCell{};
+	std::vector<uint32_t>	m_vVertexToGroup{};
+};
@@ -0,0 +1,144 @@
+#include "PrimitiveCache.h"
+
+using std::string;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::promise;
+using std::make_shared;
+
+CPrimitiveCache::SPrimitivePtr CPrimitiveCache::Get(const SPrimitiveDesc& Desc)
+{
+	const string KKey{ MakeKey(Desc) };
+
+	promise<SPrimitivePtr> Promise{};
+	{
+		unique_lock<mutex> Lock{ m_Mutex };
+		auto Found{ m_umEntries.find(KKey) };
+		if (Found != m_umEntries.end())
+		{
+			++m_Stats.HitCount;
+			SEntry& Entry{ Found->second };
+			if (Entry.bIsReady) m_lLRUKeys.splice(m_lLRUKeys.begin(), m_lLRUKeys, Entry.LRUIterator);
+
+			// The future is copied so that the entry may be evicted while this thread waits
+			std::shared_future<SPrimitivePtr> Future{ Entry.Future };
+			Lock.unlock();
+			return Future.get();
+		}
+
+		++m_Stats.MissCount;
+		m_umEntries[KKey].Future = Promise.get_future().share();
+	}
+
+	// Generation runs without the lock so that other primitives can be served meanwhile
+	auto PtrPrimitive{ make_shared<SCachedPrimitive>() };
+	try
+	{
+		PtrPrimitive->Mesh = GeneratePrimitive(Desc);
+	}
+	catch (...)
+	{
+		// The waiters get the exception too, and the next request generates again
+		Promise.set_exception(std::current_exception());
+		{
+			lock_guard<mutex> Lock{ m_Mutex };
+			auto Found{ m_umEntries.find(KKey) };
+			if (Found != m_umEntries.end() && !Found->second.bIsReady) m_umEntries.erase(Found);
+		}
+		throw;
+	}
+	Promise.set_value(PtrPrimitive);
+
+	{
+		lock_guard<mutex> Lock{ m_Mutex };
+		auto Found{ m_umEntries.find(KKey) };
+
+		// Clear() might have dropped the entry during generation
+		if (Found != m_umEntries.end() && !Found->second.bIsReady)
+		{
+			SEntry& Entry{ Found->second };
+			Entry.ByteSize = sizeof(SVertex3D) * PtrPrimitive->Mesh.vVertices.size() + sizeof(STriangle) * PtrPrimitive->Mesh.vTriangles.size();
+			Entry.bIsReady = true;
+			m_lLRUKeys.emplace_front(KKey);
+			Entry.LRUIterator = m_lLRUKeys.begin();
+			m_Stats.ByteSize += Entry.ByteSize;
+
+			EvictLocked();
+		}
+	}
+	return PtrPrimitive;
+}
+
+void CPrimitiveCache::SetMemoryLimit(size_t MemoryLimit)
+{
+	lock_guard<mutex> Lock{ m_Mutex };
+	m_MemoryLimit = MemoryLimit;
+	EvictLocked();
+}
+
+void CPrimitiveCache::Clear()
+{
+	lock_guard<mutex> Lock{ m_Mutex };
+
+	// Entries that are still being generated stay, so that their waiters are not orphaned
+	for (const string& Key : m_lLRUKeys)
+	{
+		m_umEntries.erase(Key);
+	}
+	m_lLRUKeys.clear();
+	m_Stats.ByteSize = 0;
+}
+
+SPrimitiveCacheStats CPrimitiveCache::GetStats() const
+{
+	lock_guard<mutex> Lock{ m_Mutex };
+	SPrimitiveCacheStats Result{ m_Stats };
+	Result.EntryCount = m_lLRUKeys.size();
+	return Result;
+}
+
+string CPrimitiveCache::MakeKey(const SPrimitiveDesc& Desc)
+{
+	// Every field byte for byte, so that only identical descs share a mesh
+	XMFLOAT4 Color{};
+	XMFLOAT4 Scaling{};
+	XMStoreFloat4(&Color, Desc.Color);
+	XMStoreFloat4(&Scaling, Desc.Scaling);
+
+	string Key{};
+	auto Append{ [&](const void* const PtrData, size_t ByteSize)
+		{
+			Key.append(static_cast<const char*>(PtrData), ByteSize);
+		}
+	};
+	Append(&Desc.eType, sizeof(Desc.eType));
+	Append(&Color, sizeof(Color));
+	Append(&Scaling, sizeof(Scaling));
+	Append(&Desc.SideCount, sizeof(Desc.SideCount));
+	Append(&Desc.SegmentCount, sizeof(Desc.SegmentCount));
+	Append(&Desc.Radius, sizeof(Desc.Radius));
+	Append(&Desc.RadiusFactor, sizeof(Desc.RadiusFactor));
+	Append(&Desc.Height, sizeof(Desc.Height));
+	Append(&Desc.InnerRadius, sizeof(Desc.InnerRadius));
+	Append(&Desc.Size, sizeof(Desc.Size));
+	Append(&Desc.TexCoordSubdivisionFactor, sizeof(Desc.TexCoordSubdivisionFactor));
+	Append(&Desc.bAverageNormals, sizeof(Desc.bAverageNormals));
+	Append(&Desc.SubdivisionLevel, sizeof(Desc.SubdivisionLevel));
+	Append(&Desc.MaxChordalError, sizeof(Desc.MaxChordalError));
+	return Key;
+}
+
+void CPrimitiveCache::EvictLocked()
+{
+	while (m_Stats.ByteSize > m_MemoryLimit && !m_lLRUKeys.empty())
+	{
+		auto Found{ m_umEntries.find(m_lLRUKeys.back()) };
+		assert(Found != m_umEntries.end());
+
+		m_Stats.ByteSize -= Found->second.ByteSize;
+		++m_Stats.EvictionCount;
+		m_umEntries.erase(Found);
+		m_lLRUKeys.pop_back();
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "PrimitiveGenerator.h"
+#include <list>
+
+// Result of one SPrimitiveDesc, shared by every object created from it.
+// MeshBuffers are created by the first CObject3D that uses the primitive (on the main thread only) and reused by the others.
+struct SCachedPrimitive
+{
+	SMesh							Mesh{};
+
+	mutable CObject3D::SMeshBuffers	MeshBuffers{};
+	mutable bool					bHasMeshBuffers{ false };
+};
+
+struct SPrimitiveCacheStats
+{
+	size_t		HitCount{};
+	size_t		MissCount{};
+	size_t		EvictionCount{};
+	size_t		EntryCount{};
+
+	// CPU size of the cached meshes
+	size_t		ByteSize{};
+};
+
+// Memoizes GeneratePrimitive() by every field of SPrimitiveDesc.
+// Get() is thread-safe; concurrent requests for a primitive that is being generated wait for that one generation.
+// If the generation throws, those requests rethrow its exception and nothing is cached, so a later request tries again.
+// Least recently used entries are dropped once the cache exceeds its memory limit;
+// objects that still use a dropped primitive keep it alive.
+class CPrimitiveCache
+{
+	using SPrimitivePtr = std::shared_ptr<const SCachedPrimitive>;
+
+	struct SEntry
+	{
+		std::shared_future<SPrimitivePtr>	Future{};
+		size_t								ByteSize{};
+		bool								bIsReady{ false };
+
+		// Position in m_lLRUKeys, only valid once bIsReady
+		std::list<std::string>::iterator	LRUIterator{};
+	};
+
+public:
+	CPrimitiveCache(size_t MemoryLimit = KDefaultMemoryLimit) : m_MemoryLimit{ MemoryLimit } {}
+	~CPrimitiveCache() {}
+
+public:
+	SPrimitivePtr Get(const SPrimitiveDesc& Desc);
+
+	void SetMemoryLimit(size_t MemoryLimit);
+	size_t GetMemoryLimit() const { return m_MemoryLimit; }
+
+	void Clear();
+
+	SPrimitiveCacheStats GetStats() const;
+
+private:
+	static std::string MakeKey(const SPrimitiveDesc& Desc);
+	void EvictLocked();
+
+public:
+	static constexpr size_t KDefaultMemoryLimit{ 64 * 1024 * 1024 };
+
+private:
+	mutable std::mutex							m_Mutex{};
+	std::unordered_map<std::string, SEntry>		m_umEntries{};
+	std::list<std::string>						m_lLRUKeys{};
+	size_t										m_MemoryLimit{};
+	SPrimitiveCacheStats						m_Stats{};
+};
@@ -4,18 +4,67 @@
 #include "Object3D.h"
 #include "Object3DLine.h"
 #include "Object2D.h"
-#include <unordered_map>
+#include "PositionWelder.h"
+#include "TangentGenerator.h"
+#include "ThreadPool.h"
+#include "MeshSoA.h"
 
 static constexpr uint32_t KDefaultPrimitiveDetail{ 32 };
 static constexpr uint32_t KMinPrimitiveDetail{ 3 };
 static constexpr uint32_t KMaxPrimitiveDetail{ 64 };
+static constexpr uint32_t KMaxIcosphereSubdivisionLevel{ 8 };
+static constexpr uint32_t KMaxCubeSphereSegmentCount{ 512 };
 
 static const XMVECTOR KColorWhite{ XMVectorSet(1, 1, 1 ,1) };
 
-static std::string ConvertXMVECTORToString(const XMVECTOR& Vector);
+enum class EPrimitiveType
+{
+	SquareXYPlane,
+	SquareXZPlane,
+	SquareYZPlane,
+	TerrainBase,
+	CircleXZPlane,
+	Pyramid,
+	Cube,
+	Cone,
+	Cylinder,
+	Sphere,
+	CubemapSphere,
+	Torus,
+	Icosphere,
+	CubeSphere
+};
+
+// Parameters of one primitive for GeneratePrimitive() and the batch API.
+// Only the members used by eType's generator are read; Scaling (if not 1) is applied with ScaleMesh() afterwards.
+struct SPrimitiveDesc
+{
+	SPrimitiveDesc() {}
+	SPrimitiveDesc(EPrimitiveType _eType) : eType{ _eType } {}
+
+	EPrimitiveType	eType{};
+	XMVECTOR		Color{ KColorWhite };
+	XMVECTOR		Scaling{ XMVectorSet(1, 1, 1, 0) };
+	uint32_t		SideCount{ 16 };
+	uint32_t		SegmentCount{ 16 };
+	float			Radius{ 1.0f };
+	float			RadiusFactor{ 0.0f };
+	float			Height{ 1.0f };
+	float			InnerRadius{ 0.2f };
+	XMFLOAT2		Size{ 2.0f, 2.0f };
+	int				TexCoordSubdivisionFactor{ 1 };
+	bool			bAverageNormals{ false };
+
+	// Icosphere: SubdivisionLevel, CubeSphere: SegmentCount, unless MaxChordalError > 0
+	uint32_t		SubdivisionLevel{ 3 };
+	float			MaxChordalError{ 0.0f };
+};
+
+static void AverageVertexAttribute(SMesh& Mesh, XMVECTOR SVertex3D::* Attribute, float HardEdgeAngle);
 static void CalculateNormals(SMesh& Mesh);
-static void AverageNormals(SMesh& Mesh);
-static void CalculateTangents(SMesh& Mesh);
+static void AverageNormals(SMesh& Mesh, float HardEdgeAngle = XM_PI);
+static void CalculateTangents(SMesh& Mesh, CThreadPool* const PtrThreadPool = nullptr);
+static void AverageTangents(SMesh& Mesh, float HardEdgeAngle = XM_PI);
 static std::vector<STriangle> GenerateContinuousQuads(int QuadCount);
 static SMesh GenerateTriangle(const XMVECTOR& V0, const XMVECTOR& V1, const XMVECTOR& V2, const XMVECTOR& Color = KColorWhite);
 static SMesh GenerateTriangle(const XMVECTOR& V0, const XMVECTOR& V1, const XMVECTOR& V2, const XMVECTOR& Color0, const XMVECTOR& Color1, const XMVECTOR& Color2);
@@ -31,13 +80,31 @@ static SMesh GenerateCylinder(float Radius = 1.0f, float Height = 1.0f, uint32_t
 static SMesh GenerateSphere(uint32_t SegmentCount, const XMVECTOR& ColorTop, const XMVECTOR& ColorBottom);
 static SMesh GenerateSphere(uint32_t SegmentCount = 16, const XMVECTOR& Color = KColorWhite);
 static SMesh GenerateCubemapSphere(uint32_t SegmentCount);
+static SMesh GenerateIcosphere(uint32_t SubdivisionLevel, const XMVECTOR& Color = KColorWhite);
+static SMesh GenerateIcosphereByError(float MaxChordalError, const XMVECTOR& Color = KColorWhite);
+static SMesh GenerateCubeSphere(uint32_t SegmentCount, const XMVECTOR& Color = KColorWhite);
+static SMesh GenerateCubeSphereByError(float MaxChordalError, const XMVECTOR& Color = KColorWhite);
+static float CalculateSphereChordalError(const SMesh& Mesh);
+static SMesh GenerateQuadSphere(float EdgeTessFactor, float InsideTessFactor, ETessellatorPartitioning ePartitioning = ETessellatorPartitioning::Integer);
 static SMesh GenerateTorus(float InnerRadius = 0.2f, uint32_t SideCount = 16, uint32_t SegmentCount = 24, const XMVECTOR& Color = KColorWhite);
+static XMMATRIX GetNormalMatrix(const XMMATRIX& Matrix);
+static void TransformMesh(SMesh& Mesh, const XMMATRIX& Matrix);
 static void TranslateMesh(SMesh& Mesh, const XMVECTOR& Translation);
 static void RotateMesh(SMesh& Mesh, float Pitch, float Yaw, float Roll);
 static void ScaleMesh(SMesh& Mesh, const XMVECTOR& Scaling);
 static void ScaleMeshTexCoord(SMesh& Mesh, const XMVECTOR& Scaling);
 static void SetMeshColor(SMesh& Mesh, const XMVECTOR& Color);
+static void TransformMesh(SMeshSoA& Mesh, const XMMATRIX& Matrix);
+static void TranslateMesh(SMeshSoA& Mesh, const XMVECTOR& Translation);
+static void RotateMesh(SMeshSoA& Mesh, float Pitch, float Yaw, float Roll);
+static void ScaleMesh(SMeshSoA& Mesh, const XMVECTOR& Scaling);
+static void ScaleMeshTexCoord(SMeshSoA& Mesh, const XMVECTOR& Scaling);
+static void SetMeshColor(SMeshSoA& Mesh, const XMVECTOR& Color);
 static SMesh MergeStaticMeshes(const SMesh& MeshA, const SMesh& MeshB);
+static SModel MergeStaticMeshes(const std::vector<SMesh>& vMeshes, const std::vector<CMaterialData>& vMaterialData, CThreadPool* const PtrThreadPool = nullptr);
+static SMesh GeneratePrimitive(const SPrimitiveDesc& Desc);
+static std::vector<std::future<SMesh>> GeneratePrimitives(CThreadPool& ThreadPool, const std::vector<SPrimitiveDesc>& vDescs);
+static void GeneratePrimitives(CThreadPool& ThreadPool, const std::vector<SPrimitiveDesc>& vDescs, std::function<void(std::vector<SMesh>&&)> OnCompleted);
 static std::vector<SVertex3DLine> Generate3DLineCircleYZ(const XMVECTOR& Color = KColorWhite, uint32_t SegmentCount = 32);
 static std::vector<SVertex3DLine> Generate3DGrid(int GuidelineCount = 10, float Interval = 1.0f);
 static CObject2D::SModel2D Generate2DRectangle(const XMFLOAT2& RectangleSize);
@@ -48,168 +115,148 @@ static bool operator==(const XMVECTOR& A, const XMVECTOR& B)
 	return XMVector3Equal(A, B);
 }
 
-static std::string ConvertXMVECTORToString(const XMVECTOR& Vector)
+// Every vertex receives the mean of the distinct attribute values found at its (welded) position.
+// With HardEdgeAngle < XM_PI only the values within that angle of the vertex's own value are averaged, so hard edges survive.
+static void AverageVertexAttribute(SMesh& Mesh, XMVECTOR SVertex3D::* Attribute, float HardEdgeAngle)
 {
-	using std::to_string;
-
-	float X{ XMVectorGetX(Vector) };
-	float Y{ XMVectorGetY(Vector) };
-	float Z{ XMVectorGetZ(Vector) };
-	float W{ XMVectorGetW(Vector) };
+	const size_t KVertexCount{ Mesh.vVertices.size() };
+	if (KVertexCount == 0) return;
 
-	std::string Result{ to_string(X) + "#" + to_string(Y) + "#" + to_string(Z) + "#" + to_string(W) };
-	return Result;
-}
+	CPositionWelder Welder{};
+	const size_t KGroupCount{ Welder.Weld(Mesh.vVertices) };
 
-static void CalculateNormals(SMesh& Mesh)
-{
+	std::vector<bool> vIsReferenced(KVertexCount);
 	for (const STriangle& Triangle : Mesh.vTriangles)
 	{
-		SVertex3D& V0{ Mesh.vVertices[Triangle.I0] };
-		SVertex3D& V1{ Mesh.vVertices[Triangle.I1] };
-		SVertex3D& V2{ Mesh.vVertices[Triangle.I2] };
-
-		XMVECTOR Edge01{ V1.Position - V0.Position };
-		XMVECTOR Edge02{ V2.Position - V0.Position };
-
-		XMVECTOR Normal{ XMVector3Normalize(XMVector3Cross(Edge01, Edge02)) };
+		vIsReferenced[Triangle.I0] = vIsReferenced[Triangle.I1] = vIsReferenced[Triangle.I2] = true;
+	}
 
-		V0.Normal = V1.Normal = V2.Normal = Normal;
+	// Bucket referenced vertices by group (counting sort keeps the vertex order, so results are deterministic)
+	std::vector<uint32_t> vGroupOffsets(KGroupCount + 1);
+	for (size_t iVertex = 0; iVertex < KVertexCount; ++iVertex)
+	{
+		if (vIsReferenced[iVertex]) ++vGroupOffsets[Welder.GetGroup(iVertex) + 1];
+	}
+	for (size_t iGroup = 0; iGroup < KGroupCount; ++iGroup)
+	{
+		vGroupOffsets[iGroup + 1] += vGroupOffsets[iGroup];
 	}
-}
 
-static void AverageNormals(SMesh& Mesh)
-{
-	std::unordered_map<std::string, std::vector<XMVECTOR>> mapVertexToNormals{};
-	for (const STriangle& Triangle : Mesh.vTriangles)
+	// Keep only distinct values per group, so that coplanar triangles sharing a corner don't bias the mean
+	std::vector<XMVECTOR> vValues(vGroupOffsets[KGroupCount]);
+	std::vector<uint32_t> vGroupValueCounts(KGroupCount);
+	for (size_t iVertex = 0; iVertex < KVertexCount; ++iVertex)
 	{
-		const SVertex3D& V0{ Mesh.vVertices[Triangle.I0] };
-		const SVertex3D& V1{ Mesh.vVertices[Triangle.I1] };
-		const SVertex3D& V2{ Mesh.vVertices[Triangle.I2] };
+		if (!vIsReferenced[iVertex]) continue;
 
-		std::string V0PositionStr{ ConvertXMVECTORToString(V0.Position) };
-		std::string V1PositionStr{ ConvertXMVECTORToString(V1.Position) };
-		std::string V2PositionStr{ ConvertXMVECTORToString(V2.Position) };
+		const uint32_t KGroup{ Welder.GetGroup(iVertex) };
+		const XMVECTOR& KValue{ Mesh.vVertices[iVertex].*Attribute };
+		XMVECTOR* const PtrGroupValues{ &vValues[vGroupOffsets[KGroup]] };
+		uint32_t& GroupValueCount{ vGroupValueCounts[KGroup] };
 
-		const std::vector<XMVECTOR>& vV0Normals{ mapVertexToNormals[V0PositionStr] };
+		bool bIsDuplicate{ false };
+		for (uint32_t iValue = 0; iValue < GroupValueCount; ++iValue)
 		{
-			auto found{ std::find(vV0Normals.begin(), vV0Normals.end(), V0.Normal) };
-			if (found == vV0Normals.end()) mapVertexToNormals[V0PositionStr].emplace_back(V0.Normal);
+			if (XMVector3Equal(PtrGroupValues[iValue], KValue))
+			{
+				bIsDuplicate = true;
+				break;
+			}
 		}
+		if (!bIsDuplicate) PtrGroupValues[GroupValueCount++] = KValue;
+	}
 
-		const std::vector<XMVECTOR>& vV1Normals{ mapVertexToNormals[V1PositionStr] };
+	if (HardEdgeAngle >= XM_PI)
+	{
+		std::vector<XMVECTOR> vGroupMeans(KGroupCount);
+		for (size_t iGroup = 0; iGroup < KGroupCount; ++iGroup)
 		{
-			auto found{ std::find(vV1Normals.begin(), vV1Normals.end(), V1.Normal) };
-			if (found == vV1Normals.end()) mapVertexToNormals[V1PositionStr].emplace_back(V1.Normal);
+			if (vGroupValueCounts[iGroup] == 0) continue;
+
+			XMVECTOR Sum{};
+			for (uint32_t iValue = 0; iValue < vGroupValueCounts[iGroup]; ++iValue)
+			{
+				Sum += vValues[vGroupOffsets[iGroup] + iValue];
+			}
+			vGroupMeans[iGroup] = Sum / (float)vGroupValueCounts[iGroup];
 		}
 
-		const std::vector<XMVECTOR>& vV2Normals{ mapVertexToNormals[V2PositionStr] };
+		for (size_t iVertex = 0; iVertex < KVertexCount; ++iVertex)
 		{
-			auto found{ std::find(vV2Normals.begin(), vV2Normals.end(), V2.Normal) };
-			if (found == vV2Normals.end()) mapVertexToNormals[V2PositionStr].emplace_back(V2.Normal);
+			const uint32_t KGroup{ Welder.GetGroup(iVertex) };
+			if (vGroupValueCounts[KGroup]) Mesh.vVertices[iVertex].*Attribute = vGroupMeans[KGroup];
 		}
 	}
-
-	for (SVertex3D& Vertex : Mesh.vVertices)
+	else
 	{
-		std::string VStr{ ConvertXMVECTORToString(Vertex.Position) };
+		const float KCosHardEdgeAngle{ cos(HardEdgeAngle) };
+		for (size_t iVertex = 0; iVertex < KVertexCount; ++iVertex)
+		{
+			const uint32_t KGroup{ Welder.GetGroup(iVertex) };
+			if (vGroupValueCounts[KGroup] == 0) continue;
 
-		const std::vector<XMVECTOR>& vNormals{ mapVertexToNormals[VStr] };
+			XMVECTOR& Value{ Mesh.vVertices[iVertex].*Attribute };
+			const XMVECTOR KDirection{ XMVector3Normalize(Value) };
 
-		XMVECTOR NormalSum{};
-		for (const auto& Normal : vNormals)
-		{
-			NormalSum += Normal;
+			XMVECTOR Sum{};
+			uint32_t Count{};
+			for (uint32_t iValue = 0; iValue < vGroupValueCounts[KGroup]; ++iValue)
+			{
+				const XMVECTOR& KCandidate{ vValues[vGroupOffsets[KGroup] + iValue] };
+				if (XMVectorGetX(XMVector3Dot(KDirection, XMVector3Normalize(KCandidate))) >= KCosHardEdgeAngle)
+				{
+					Sum += KCandidate;
+					++Count;
+				}
+			}
+			if (Count) Value = Sum / (float)Count;
 		}
-		XMVECTOR TriangleNormal{ NormalSum / (float)vNormals.size() };
-
-		Vertex.Normal = TriangleNormal;
 	}
 }
 
-static void CalculateTangents(SMesh& Mesh)
+static void CalculateNormals(SMesh& Mesh)
 {
-	for (STriangle& Triangle : Mesh.vTriangles)
+	for (const STriangle& Triangle : Mesh.vTriangles)
 	{
-		SVertex3D& Vert0{ Mesh.vVertices[Triangle.I0] };
-		SVertex3D& Vert1{ Mesh.vVertices[Triangle.I1] };
-		SVertex3D& Vert2{ Mesh.vVertices[Triangle.I2] };
-
-		XMVECTOR Edge01{ Vert1.Position - Vert0.Position };
-		XMVECTOR Edge02{ Vert2.Position - Vert0.Position };
-
-		XMVECTOR UV01{ Vert1.TexCoord - Vert0.TexCoord };
-		XMVECTOR UV02{ Vert2.TexCoord - Vert0.TexCoord };
-
-		float U01{ XMVectorGetX(UV01) };
-		float V01{ XMVectorGetY(UV01) };
-
-		float U02{ XMVectorGetX(UV02) };
-		float V02{ XMVectorGetY(UV02) };
-
-		// Edge01 = U01 * Tangent + V01 * Bitangent
-		// Edge02 = U02 * Tangent + V02 * Bitangent
-
-		// | Edge01 x y z | = | U01 V01 | * | Tangent	x y z |
-		// | Edge02 x y z |   | U02 V02 |   | Bitangent	x y z |
+		SVertex3D& V0{ Mesh.vVertices[Triangle.I0] };
+		SVertex3D& V1{ Mesh.vVertices[Triangle.I1] };
+		SVertex3D& V2{ Mesh.vVertices[Triangle.I2] };
 
-		// ( Determinant == U01 * V02 - V01 * U02 )
+		XMVECTOR Edge01{ V1.Position - V0.Position };
+		XMVECTOR Edge02{ V2.Position - V0.Position };
 
-		//       1		  *  |  V02 -V01 | * | Edge01 x y z | = | Tangent	x y z |
-		//	Determinant		 | -U02  U01 | * | Edge02 x y z | = | Bitangent	x y z |
+		XMVECTOR Normal{ XMVector3Normalize(XMVector3Cross(Edge01, Edge02)) };
 
-		float InverseDeterminant{ 1 / (U01 * V02 - V01 * U02) };
-		Vert2.Tangent = Vert1.Tangent = Vert0.Tangent = XMVector3Normalize(InverseDeterminant * V02 * Edge01 - V01 * Edge02);
-		//Vert2.Bitangent = Vert1.Bitangent = Vert0.Bitangent = XMVector3Normalize(InverseDeterminant * -U02 * Edge01 + U01 * Edge02);
+		V0.Normal = V1.Normal = V2.Normal = Normal;
 	}
 }
 
-static void AverageTangents(SMesh& Mesh)
+static void AverageNormals(SMesh& Mesh, float HardEdgeAngle)
 {
-	std::unordered_map<std::string, std::vector<XMVECTOR>> mapVertexToTangents{};
-	for (const STriangle& Triangle : Mesh.vTriangles)
-	{
-		const SVertex3D& V0{ Mesh.vVertices[Triangle.I0] };
-		const SVertex3D& V1{ Mesh.vVertices[Triangle.I1] };
-		const SVertex3D& V2{ Mesh.vVertices[Triangle.I2] };
-
-		std::string V0PositionStr{ ConvertXMVECTORToString(V0.Position) };
-		std::string V1PositionStr{ ConvertXMVECTORToString(V1.Position) };
-		std::string V2PositionStr{ ConvertXMVECTORToString(V2.Position) };
-
-		const std::vector<XMVECTOR>& vV0Tangents{ mapVertexToTangents[V0PositionStr] };
-		{
-			auto found{ std::find(vV0Tangents.begin(), vV0Tangents.end(), V0.Tangent) };
-			if (found == vV0Tangents.end()) mapVertexToTangents[V0PositionStr].emplace_back(V0.Tangent);
-		}
-
-		const std::vector<XMVECTOR>& vV1Tangents{ mapVertexToTangents[V1PositionStr] };
-		{
-			auto found{ std::find(vV1Tangents.begin(), vV1Tangents.end(), V1.Tangent) };
-			if (found == vV1Tangents.end()) mapVertexToTangents[V1PositionStr].emplace_back(V1.Tangent);
-		}
+	AverageVertexAttribute(Mesh, &SVertex3D::Normal, HardEdgeAngle);
+}
 
-		const std::vector<XMVECTOR>& vV2Tangents{ mapVertexToTangents[V2PositionStr] };
-		{
-			auto found{ std::find(vV2Tangents.begin(), vV2Tangents.end(), V2.Tangent) };
-			if (found == vV2Tangents.end()) mapVertexToTangents[V2PositionStr].emplace_back(V2.Tangent);
-		}
-	}
+// See CTangentGenerator; Tangent.w receives the bitangent sign.
+static void CalculateTangents(SMesh& Mesh, CThreadPool* const PtrThreadPool)
+{
+	CTangentGenerator TangentGenerator{};
+	TangentGenerator.Generate(Mesh, PtrThreadPool);
+}
 
-	for (SVertex3D& Vertex : Mesh.vVertices)
+static void AverageTangents(SMesh& Mesh, float HardEdgeAngle)
+{
+	// The bitangent signs are not averaged
+	std::vector<float> vSigns(Mesh.vVertices.size());
+	for (size_t iVertex = 0; iVertex < Mesh.vVertices.size(); ++iVertex)
 	{
-		std::string VStr{ ConvertXMVECTORToString(Vertex.Position) };
-
-		const std::vector<XMVECTOR>& vTangents{ mapVertexToTangents[VStr] };
+		vSigns[iVertex] = XMVectorGetW(Mesh.vVertices[iVertex].Tangent);
+	}
 
-		XMVECTOR TangentSum{};
-		for (const auto& Tangent : vTangents)
-		{
-			TangentSum += Tangent;
-		}
-		XMVECTOR TriangleTangent{ TangentSum / (float)vTangents.size() };
+	AverageVertexAttribute(Mesh, &SVertex3D::Tangent, HardEdgeAngle);
 
-		Vertex.Tangent = TriangleTangent;
+	for (size_t iVertex = 0; iVertex < Mesh.vVertices.size(); ++iVertex)
+	{
+		Mesh.vVertices[iVertex].Tangent = XMVectorSetW(Mesh.vVertices[iVertex].Tangent, vSigns[iVertex]);
 	}
 }
 
@@ -319,56 +366,51 @@ static SMesh GenerateTerrainBase(const XMFLOAT2& Size, int TexCoordSubdivisionFa
 	int SizeZ{ max((int)Size.y, 2) };
 	if (SizeX % 2) ++SizeX;
 	if (SizeZ % 2) ++SizeZ;
+	TexCoordSubdivisionFactor = max(TexCoordSubdivisionFactor, 1);
+
+	// Cells share their corner vertices: (SizeX + 1) * (SizeZ + 1) vertices instead of 4 per cell.
+	// Texture coordinates keep growing across the lattice instead of restarting per cell;
+	// the wrap sampler makes this equivalent to the per-cell [0, 1] (or [r / Factor, (r + 1) / Factor]) tiling.
+	const int KVertexCountX{ SizeX + 1 };
+	const int KVertexCountZ{ SizeZ + 1 };
+	const float KInverseSubdivisionFactor{ 1.0f / (float)TexCoordSubdivisionFactor };
+	const float KOffsetX{ static_cast<float>(-SizeX / 2) };
+	const float KOffsetZ{ static_cast<float>(SizeZ / 2) };
+	const XMVECTOR KNormal{ XMVectorSet(0, 1, 0, 0) };
+	const XMVECTOR KTangent{ XMVectorSet(1, 0, 0, 0) };
 
 	SMesh Mesh{};
-	float U0{}, V0{}, U1{}, V1{};
-	for (int z = 0; z < SizeZ; ++z)
+	Mesh.vVertices.resize((size_t)KVertexCountX * KVertexCountZ);
+	Mesh.vTriangles.resize((size_t)SizeX * SizeZ * 2);
+
+	SVertex3D* PtrVertex{ Mesh.vVertices.data() };
+	for (int z = 0; z < KVertexCountZ; ++z)
 	{
-		for (int x = 0; x < SizeX; ++x)
+		for (int x = 0; x < KVertexCountX; ++x)
 		{
-			U0 = V0 = 0.0f;
-			U1 = V1 = 1.0f;
-
-			Mesh.vVertices.emplace_back(XMVectorSet(static_cast<float>(x + 0), +0.0f, static_cast<float>(-z + 0), 1), Color, XMVectorSet(U0, V0, 0, 0));
-			Mesh.vVertices.emplace_back(XMVectorSet(static_cast<float>(x + 1), +0.0f, static_cast<float>(-z + 0), 1), Color, XMVectorSet(U1, V0, 0, 0));
-			Mesh.vVertices.emplace_back(XMVectorSet(static_cast<float>(x + 0), +0.0f, static_cast<float>(-z - 1), 1), Color, XMVectorSet(U0, V1, 0, 0));
-			Mesh.vVertices.emplace_back(XMVectorSet(static_cast<float>(x + 1), +0.0f, static_cast<float>(-z - 1), 1), Color, XMVectorSet(U1, V1, 0, 0));
+			PtrVertex->Position = XMVectorSet(static_cast<float>(x) + KOffsetX, +0.0f, static_cast<float>(-z) + KOffsetZ, 1);
+			PtrVertex->Color = Color;
+			PtrVertex->TexCoord = XMVectorSet((float)x * KInverseSubdivisionFactor, (float)z * KInverseSubdivisionFactor, 0, 0);
+			PtrVertex->Normal = KNormal;
+			PtrVertex->Tangent = KTangent;
+			++PtrVertex;
 		}
 	}
 
-	Mesh.vTriangles = GenerateContinuousQuads(SizeX * SizeZ);
-
-	CalculateNormals(Mesh);
-
-	CalculateTangents(Mesh);
-
-	// @important
-	if (TexCoordSubdivisionFactor > 1)
+	STriangle* PtrTriangle{ Mesh.vTriangles.data() };
+	for (int z = 0; z < SizeZ; ++z)
 	{
-		int iVertex{};
-		for (int z = 0; z < SizeZ; ++z)
+		for (int x = 0; x < SizeX; ++x)
 		{
-			for (int x = 0; x < SizeX; ++x)
-			{
-				int rX{ x % TexCoordSubdivisionFactor };
-				int rZ{ z % TexCoordSubdivisionFactor };
-
-				U0 = (float)(rX) / (float)TexCoordSubdivisionFactor;
-				U1 = (float)(rX + 1) / (float)TexCoordSubdivisionFactor;
-				V0 = (float)(rZ) / (float)TexCoordSubdivisionFactor;
-				V1 = (float)(rZ + 1) / (float)TexCoordSubdivisionFactor;
+			uint32_t I0{ static_cast<uint32_t>(z * KVertexCountX + x) };
+			uint32_t I1{ I0 + 1 };
+			uint32_t I2{ I0 + static_cast<uint32_t>(KVertexCountX) };
+			uint32_t I3{ I2 + 1 };
 
-				Mesh.vVertices[(size_t)iVertex + 0].TexCoord = XMVectorSet(U0, V0, 0, 0);
-				Mesh.vVertices[(size_t)iVertex + 1].TexCoord = XMVectorSet(U1, V0, 0, 0);
-				Mesh.vVertices[(size_t)iVertex + 2].TexCoord = XMVectorSet(U0, V1, 0, 0);
-				Mesh.vVertices[(size_t)iVertex + 3].TexCoord = XMVectorSet(U1, V1, 0, 0);
-
-				iVertex += 4;
-			}
+			*PtrTriangle++ = STriangle(I0, I1, I2);
+			*PtrTriangle++ = STriangle(I1, I3, I2);
 		}
 	}
-
-	TranslateMesh(Mesh, XMVectorSet(static_cast<float>(-SizeX / 2), 0, static_cast<float>(SizeZ / 2), 1));
 	
 	return Mesh;
 }
@@ -831,6 +873,384 @@ static SMesh GenerateCubemapSphere(uint32_t SegmentCount)
 	return Mesh;
 }
 
+// Unit-sphere attributes of a welded mesh: exact normals, GenerateSphere()'s UV mapping (u along the azimuth, v = 0 at +Y),
+// and tangents along +u. Vertices are only duplicated where a triangle crosses the u seam or touches a pole.
+static void SetUnitSphereAttributes(SMesh& Mesh, const XMVECTOR& Color)
+{
+	static constexpr uint32_t KNoDuplicate{ UINT32_MAX };
+	static constexpr float KPoleEpsilon{ 1e-6f };
+
+	const size_t KWeldedVertexCount{ Mesh.vVertices.size() };
+	std::vector<bool> vIsPole(KWeldedVertexCount);
+	for (size_t iVertex = 0; iVertex < KWeldedVertexCount; ++iVertex)
+	{
+		SVertex3D& Vertex{ Mesh.vVertices[iVertex] };
+		XMFLOAT3 Position{};
+		XMStoreFloat3(&Position, Vertex.Position);
+
+		float U{ atan2f(Position.z, Position.x) / XM_2PI };
+		if (U < 0.0f) U += 1.0f;
+		const float KV{ acosf(std::max(-1.0f, std::min(Position.y, 1.0f))) / XM_PI };
+
+		vIsPole[iVertex] = (fabsf(Position.x) < KPoleEpsilon && fabsf(Position.z) < KPoleEpsilon);
+		Vertex.TexCoord = XMVectorSet(U, KV, 0, 0);
+		Vertex.Color = Color;
+		Vertex.Normal = XMVectorSetW(Vertex.Position, 0.0f);
+	}
+
+	std::vector<uint32_t> vSeamDuplicates(KWeldedVertexCount, KNoDuplicate);
+	for (STriangle& Triangle : Mesh.vTriangles)
+	{
+		uint32_t* const PtrIndices[3]{ &Triangle.I0, &Triangle.I1, &Triangle.I2 };
+		// Read before the indices are redirected to duplicates, which vIsPole doesn't cover
+		const bool KbIsPoles[3]{ vIsPole[Triangle.I0], vIsPole[Triangle.I1], vIsPole[Triangle.I2] };
+
+		// Poles get the mean u of the other two vertices, so the first pass only looks at regular vertices
+		float MinU{ 1.0f };
+		float MaxU{ 0.0f };
+		for (int iCorner = 0; iCorner < 3; ++iCorner)
+		{
+			if (KbIsPoles[iCorner]) continue;
+			uint32_t* const PtrIndex{ PtrIndices[iCorner] };
+			const float KU{ XMVectorGetX(Mesh.vVertices[*PtrIndex].TexCoord) };
+			MinU = std::min(MinU, KU);
+			MaxU = std::max(MaxU, KU);
+		}
+
+		float USum{};
+		for (int iCorner = 0; iCorner < 3; ++iCorner)
+		{
+			if (KbIsPoles[iCorner]) continue;
+			uint32_t* const PtrIndex{ PtrIndices[iCorner] };
+			if (MaxU - MinU > 0.5f && XMVectorGetX(Mesh.vVertices[*PtrIndex].TexCoord) < 0.5f)
+			{
+				if (vSeamDuplicates[*PtrIndex] == KNoDuplicate)
+				{
+					vSeamDuplicates[*PtrIndex] = static_cast<uint32_t>(Mesh.vVertices.size());
+					SVertex3D Duplicate{ Mesh.vVertices[*PtrIndex] };
+					Duplicate.TexCoord = XMVectorSetX(Duplicate.TexCoord, XMVectorGetX(Duplicate.TexCoord) + 1.0f);
+					Mesh.vVertices.emplace_back(Duplicate);
+				}
+				*PtrIndex = vSeamDuplicates[*PtrIndex];
+			}
+			USum += XMVectorGetX(Mesh.vVertices[*PtrIndex].TexCoord);
+		}
+
+		for (int iCorner = 0; iCorner < 3; ++iCorner)
+		{
+			if (!KbIsPoles[iCorner]) continue;
+			uint32_t* const PtrIndex{ PtrIndices[iCorner] };
+			SVertex3D Duplicate{ Mesh.vVertices[*PtrIndex] };
+			Duplicate.TexCoord = XMVectorSetX(Duplicate.TexCoord, USum * 0.5f);
+			*PtrIndex = static_cast<uint32_t>(Mesh.vVertices.size());
+			Mesh.vVertices.emplace_back(Duplicate);
+		}
+	}
+
+	for (SVertex3D& Vertex : Mesh.vVertices)
+	{
+		const float KTheta{ XMVectorGetX(Vertex.TexCoord) * XM_2PI };
+		Vertex.Tangent = XMVectorSet(-sinf(KTheta), 0, cosf(KTheta), 1);
+	}
+}
+
+// Splits every triangle into four; vertices on shared edges are created once.
+static void SubdivideUnitSphere(SMesh& Mesh)
+{
+	std::unordered_map<uint64_t, uint32_t> umEdgeMidpoints{};
+	umEdgeMidpoints.reserve(Mesh.vTriangles.size() * 3 / 2);
+	auto GetMidpoint{ [&](uint32_t A, uint32_t B)
+		{
+			const uint64_t KKey{ (static_cast<uint64_t>(std::min(A, B)) << 32) | std::max(A, B) };
+			auto Found{ umEdgeMidpoints.find(KKey) };
+			if (Found != umEdgeMidpoints.end()) return Found->second;
+
+			const uint32_t KIndex{ static_cast<uint32_t>(Mesh.vVertices.size()) };
+			SVertex3D Midpoint{};
+			Midpoint.Position = XMVectorSetW(XMVector3Normalize(Mesh.vVertices[A].Position + Mesh.vVertices[B].Position), 1.0f);
+			Mesh.vVertices.emplace_back(Midpoint);
+			umEdgeMidpoints.emplace(KKey, KIndex);
+			return KIndex;
+		}
+	};
+
+	std::vector<STriangle> vTriangles{};
+	vTriangles.reserve(Mesh.vTriangles.size() * 4);
+	for (const STriangle& Triangle : Mesh.vTriangles)
+	{
+		const uint32_t K01{ GetMidpoint(Triangle.I0, Triangle.I1) };
+		const uint32_t K12{ GetMidpoint(Triangle.I1, Triangle.I2) };
+		const uint32_t K20{ GetMidpoint(Triangle.I2, Triangle.I0) };
+		vTriangles.emplace_back(Triangle.I0, K01, K20);
+		vTriangles.emplace_back(Triangle.I1, K12, K01);
+		vTriangles.emplace_back(Triangle.I2, K20, K12);
+		vTriangles.emplace_back(K01, K12, K20);
+	}
+	Mesh.vTriangles = std::move(vTriangles);
+}
+
+static SMesh GenerateIcosahedron()
+{
+	const float KT{ (1.0f + sqrtf(5.0f)) * 0.5f };
+	const XMVECTOR KPositions[12]{
+		XMVectorSet(-1, +KT, 0, 0), XMVectorSet(+1, +KT, 0, 0), XMVectorSet(-1, -KT, 0, 0), XMVectorSet(+1, -KT, 0, 0),
+		XMVectorSet(0, -1, +KT, 0), XMVectorSet(0, +1, +KT, 0), XMVectorSet(0, -1, -KT, 0), XMVectorSet(0, +1, -KT, 0),
+		XMVectorSet(+KT, 0, -1, 0), XMVectorSet(+KT, 0, +1, 0), XMVectorSet(-KT, 0, -1, 0), XMVectorSet(-KT, 0, +1, 0) };
+	const uint32_t KIndices[20][3]{
+		{ 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+		{ 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+		{ 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+		{ 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 } };
+
+	SMesh Mesh{};
+	for (const XMVECTOR& KPosition : KPositions)
+	{
+		Mesh.vVertices.emplace_back();
+		Mesh.vVertices.back().Position = XMVectorSetW(XMVector3Normalize(KPosition), 1.0f);
+	}
+	for (const auto& KTriangle : KIndices)
+	{
+		Mesh.vTriangles.emplace_back(KTriangle[0], KTriangle[1], KTriangle[2]);
+	}
+	return Mesh;
+}
+
+// 20 * 4^SubdivisionLevel triangles
+static SMesh GenerateIcosphere(uint32_t SubdivisionLevel, const XMVECTOR& Color)
+{
+	SubdivisionLevel = std::min(SubdivisionLevel, KMaxIcosphereSubdivisionLevel);
+
+	SMesh Mesh{ GenerateIcosahedron() };
+	for (uint32_t iLevel = 0; iLevel < SubdivisionLevel; ++iLevel)
+	{
+		SubdivideUnitSphere(Mesh);
+	}
+	SetUnitSphereAttributes(Mesh, Color);
+	return Mesh;
+}
+
+// The coarsest level whose chordal error (see CalculateSphereChordalError()) is at most MaxChordalError
+static SMesh GenerateIcosphereByError(float MaxChordalError, const XMVECTOR& Color)
+{
+	SMesh Mesh{ GenerateIcosahedron() };
+	for (uint32_t iLevel = 0; iLevel < KMaxIcosphereSubdivisionLevel; ++iLevel)
+	{
+		if (CalculateSphereChordalError(Mesh) <= MaxChordalError) break;
+		SubdivideUnitSphere(Mesh);
+	}
+	SetUnitSphereAttributes(Mesh, Color);
+	return Mesh;
+}
+
+// Normalized cube with an equi-angular grid of SegmentCount x SegmentCount quads per face (12 * SegmentCount^2 triangles).
+// Each quad is split along its shorter diagonal; vertices on cube edges and corners are shared by the faces.
+static SMesh GenerateCubeSphere(uint32_t SegmentCount, const XMVECTOR& Color)
+{
+	SegmentCount = std::max(std::min(SegmentCount, KMaxCubeSphereSegmentCount), (uint32_t)1);
+
+	// Per face: the axis it faces and the two axes its grid runs along, with Cross(U, V) pointing out of the cube
+	struct SCubeFace
+	{
+		int		Axis;
+		bool	bIsPositive;
+		int		U;
+		int		V;
+	};
+	static constexpr SCubeFace KFaces[6]{ { 0, true, 1, 2 }, { 0, false, 2, 1 }, { 1, true, 2, 0 }, { 1, false, 0, 2 }, { 2, true, 0, 1 }, { 2, false, 1, 0 } };
+
+	const uint32_t KLatticeSize{ SegmentCount + 1 };
+	std::vector<float> vWarped(KLatticeSize);
+	for (uint32_t iStep = 0; iStep < KLatticeSize; ++iStep)
+	{
+		vWarped[iStep] = tanf(XM_PIDIV4 * (2.0f * iStep / SegmentCount - 1.0f));
+	}
+
+	SMesh Mesh{};
+	std::unordered_map<uint64_t, uint32_t> umLatticeVertices{};
+	auto GetVertex{ [&](const uint32_t(&Lattice)[3])
+		{
+			const uint64_t KKey{ (static_cast<uint64_t>(Lattice[0]) * KLatticeSize + Lattice[1]) * KLatticeSize + Lattice[2] };
+			auto Found{ umLatticeVertices.find(KKey) };
+			if (Found != umLatticeVertices.end()) return Found->second;
+
+			const uint32_t KIndex{ static_cast<uint32_t>(Mesh.vVertices.size()) };
+			SVertex3D Vertex{};
+			Vertex.Position = XMVectorSetW(XMVector3Normalize(XMVectorSet(vWarped[Lattice[0]], vWarped[Lattice[1]], vWarped[Lattice[2]], 0)), 1.0f);
+			Mesh.vVertices.emplace_back(Vertex);
+			umLatticeVertices.emplace(KKey, KIndex);
+			return KIndex;
+		}
+	};
+
+	Mesh.vTriangles.reserve(12 * SegmentCount * SegmentCount);
+	for (const SCubeFace& KFace : KFaces)
+	{
+		uint32_t Lattice[3]{};
+		Lattice[KFace.Axis] = (KFace.bIsPositive) ? SegmentCount : 0;
+		for (uint32_t iV = 0; iV < SegmentCount; ++iV)
+		{
+			for (uint32_t iU = 0; iU < SegmentCount; ++iU)
+			{
+				uint32_t Corners[4]{};
+				const uint32_t KOffsets[4][2]{ { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+				for (int iCorner = 0; iCorner < 4; ++iCorner)
+				{
+					Lattice[KFace.U] = iU + KOffsets[iCorner][0];
+					Lattice[KFace.V] = iV + KOffsets[iCorner][1];
+					Corners[iCorner] = GetVertex(Lattice);
+				}
+
+				const XMVECTOR KDiagonal02{ Mesh.vVertices[Corners[2]].Position - Mesh.vVertices[Corners[0]].Position };
+				const XMVECTOR KDiagonal13{ Mesh.vVertices[Corners[3]].Position - Mesh.vVertices[Corners[1]].Position };
+				if (XMVectorGetX(XMVector3LengthSq(KDiagonal02)) <= XMVectorGetX(XMVector3LengthSq(KDiagonal13)))
+				{
+					Mesh.vTriangles.emplace_back(Corners[0], Corners[1], Corners[2]);
+					Mesh.vTriangles.emplace_back(Corners[0], Corners[2], Corners[3]);
+				}
+				else
+				{
+					Mesh.vTriangles.emplace_back(Corners[0], Corners[1], Corners[3]);
+					Mesh.vTriangles.emplace_back(Corners[1], Corners[2], Corners[3]);
+				}
+			}
+		}
+	}
+
+	SetUnitSphereAttributes(Mesh, Color);
+	return Mesh;
+}
+
+// The smallest SegmentCount whose chordal error is at most MaxChordalError
+static SMesh GenerateCubeSphereByError(float MaxChordalError, const XMVECTOR& Color)
+{
+	// The error falls with about 1 / SegmentCount^2: double until it is met, then bisect
+	uint32_t Low{};
+	uint32_t High{ 1 };
+	while (High < KMaxCubeSphereSegmentCount && CalculateSphereChordalError(GenerateCubeSphere(High)) > MaxChordalError)
+	{
+		Low = High;
+		High = std::min(High * 2, KMaxCubeSphereSegmentCount);
+	}
+	while (High - Low > 1)
+	{
+		const uint32_t KMiddle{ (Low + High) / 2 };
+		if (CalculateSphereChordalError(GenerateCubeSphere(KMiddle)) > MaxChordalError)
+		{
+			Low = KMiddle;
+		}
+		else
+		{
+			High = KMiddle;
+		}
+	}
+	return GenerateCubeSphere(High, Color);
+}
+
+// Largest distance between the unit sphere and the triangles of Mesh (which must approximate the unit sphere at the origin).
+// Uses the distance from the origin to each triangle's plane, which is exact when the foot of the perpendicular lies inside the triangle
+// and an overestimate otherwise.
+//
+// Fewest triangles that meet a given error, as "triangle count (actual error, SegmentCount)"
+// (GenerateSphere() with the smallest SegmentCount that meets it, GenerateIcosphereByError(), GenerateCubeSphereByError()):
+//
+//	| max error | GenerateSphere         | icosphere        | cube sphere           |
+//	|-----------|------------------------|------------------|-----------------------|
+//	| 0.01      | 960    (0.0096, 32)    | 1280   (0.0045)  | 768    (0.0094, 8)    |
+//	| 0.001     | 9800   (0.00099, 100)  | 20480  (0.00028) | 7500   (0.00099, 25)  |
+//	| 0.0001    | 99224  (0.00010, 316)  | 81920  (0.00007) | 74892  (0.00010, 79)  |
+//
+// The icosphere's triangles are the most uniform, but it can only quadruple its count; the cube sphere is the cheapest for any error.
+static float CalculateSphereChordalError(const SMesh& Mesh)
+{
+	float MaxError{};
+	for (const STriangle& Triangle : Mesh.vTriangles)
+	{
+		const XMVECTOR& KP0{ Mesh.vVertices[Triangle.I0].Position };
+		const XMVECTOR KNormal{ XMVector3Normalize(XMVector3Cross(Mesh.vVertices[Triangle.I1].Position - KP0, Mesh.vVertices[Triangle.I2].Position - KP0)) };
+		const float KDistance{ fabsf(XMVectorGetX(XMVector3Dot(KNormal, KP0))) };
+		MaxError = std::max(MaxError, 1.0f - KDistance);
+	}
+	return MaxError;
+}
+
+// The sphere that HSQuadSphere.hlsl and DSQuadSphere.hlsl draw from two 1-control-point quad patches (CObject3D::CreatePatches(1, 2)),
+// tessellated on the CPU with the same factors, so it has the GPU's points and triangles; the shader is integer-partitioned.
+// The patches meet at the equator, where they are welded; Normal is the position and TexCoord is unused, as in the shader.
+static SMesh GenerateQuadSphere(float EdgeTessFactor, float InsideTessFactor, ETessellatorPartitioning ePartitioning)
+{
+	SMesh Mesh{};
+
+	// HSQuadSphere.hlsl: every edge has EdgeTessFactor and both axes InsideTessFactor, triangle_ccw
+	CTessellator Tessellator{ ePartitioning, false };
+	const float KEdgeFactors[4]{ EdgeTessFactor, EdgeTessFactor, EdgeTessFactor, EdgeTessFactor };
+	const float KInsideFactors[2]{ InsideTessFactor, InsideTessFactor };
+	if (!Tessellator.TessellateQuad(KEdgeFactors, KInsideFactors)) return Mesh;
+
+	const std::vector<XMFLOAT2>& KDomainPoints{ Tessellator.GetDomainPoints() };
+	const std::vector<STriangle>& KDomainTriangles{ Tessellator.GetTriangles() };
+	const uint32_t KPointCount{ static_cast<uint32_t>(KDomainPoints.size()) };
+	// Domain points are 16.16 fixed point, so this is exact
+	auto GetDomainKey{ [](float U, float V) { return (static_cast<uint64_t>(U * 65'536.0f) << 32) | static_cast<uint64_t>(V * 65'536.0f); } };
+
+	// The first patch's border points, which the second patch's border shares.
+	// With an inside factor of 1 the fractional-odd inner ring lies on the corners, so a border location may hold several points; they share one vertex.
+	std::unordered_map<uint64_t, uint32_t> umBorderPoints{};
+	std::vector<uint32_t> vPointToVertex(KPointCount);
+	Mesh.vVertices.reserve(KPointCount * 2);
+	for (uint32_t iPatch = 0; iPatch < 2; ++iPatch)
+	{
+		// HemisphereDirection of SV_PrimitiveID
+		const float KDirection{ static_cast<float>(iPatch) * 2.0f - 1.0f };
+		for (uint32_t iPoint = 0; iPoint < KPointCount; ++iPoint)
+		{
+			const XMFLOAT2& KDomain{ KDomainPoints[iPoint] };
+			const bool KbIsOnBorder{ KDomain.x == 0.0f || KDomain.x == 1.0f || KDomain.y == 0.0f || KDomain.y == 1.0f };
+
+			// The border of a patch maps to z == 0 with x mirrored by its direction, so the points at (u, v) and (1 - u, v) meet;
+			// the edge points are placed symmetrically in fixed point, so the mirrored point exists with the same bits
+			if (KbIsOnBorder)
+			{
+				auto Found{ umBorderPoints.find((iPatch == 0) ? GetDomainKey(KDomain.x, KDomain.y) : GetDomainKey(1.0f - KDomain.x, KDomain.y)) };
+				if (Found != umBorderPoints.end())
+				{
+					vPointToVertex[iPoint] = Found->second;
+					continue;
+				}
+			}
+
+			const float KX{ KDomain.x * 2.0f - 1.0f };
+			const float KY{ KDomain.y * 2.0f - 1.0f };
+			const float KMaxLength{ std::max(fabsf(KX), fabsf(KY)) };
+
+			SVertex3D Vertex{};
+			Vertex.Normal = XMVector3Normalize(XMVectorSet(KX * KDirection, KY, (KMaxLength - 1.0f) * KDirection, 0));
+			Vertex.Position = XMVectorSetW(Vertex.Normal, 1.0f);
+			Vertex.Color = XMVectorSet(fabsf(KX), fabsf(KY), 0.5f, 1.0f);
+
+			vPointToVertex[iPoint] = static_cast<uint32_t>(Mesh.vVertices.size());
+			if (iPatch == 0 && KbIsOnBorder) umBorderPoints.emplace(GetDomainKey(KDomain.x, KDomain.y), vPointToVertex[iPoint]);
+			Mesh.vVertices.emplace_back(Vertex);
+		}
+
+		// That ring's outer strip is flat on the border (and so are triangles between points that now share a vertex);
+		// such triangles have no area and would overlap the other patch's, so they are left out
+		for (const STriangle& KTriangle : KDomainTriangles)
+		{
+			const XMFLOAT2& KA{ KDomainPoints[KTriangle.I0] };
+			const XMFLOAT2& KB{ KDomainPoints[KTriangle.I1] };
+			const XMFLOAT2& KC{ KDomainPoints[KTriangle.I2] };
+			if ((KA.x == KB.x && KB.x == KC.x) || (KA.y == KB.y && KB.y == KC.y)) continue;
+
+			const uint32_t KI0{ vPointToVertex[KTriangle.I0] };
+			const uint32_t KI1{ vPointToVertex[KTriangle.I1] };
+			const uint32_t KI2{ vPointToVertex[KTriangle.I2] };
+			if (KI0 == KI1 || KI1 == KI2 || KI2 == KI0) continue;
+			Mesh.vTriangles.emplace_back(KI0, KI1, KI2);
+		}
+	}
+	return Mesh;
+}
+
 static SMesh GenerateTorus(float InnerRadius, uint32_t SideCount, uint32_t SegmentCount, const XMVECTOR& Color)
 {
 	using std::max;
@@ -897,34 +1317,51 @@ static SMesh GenerateTorus(float InnerRadius, uint32_t SideCount, uint32_t Segme
 	return Mesh;
 }
 
+// Normals are transformed by the inverse-transpose of the upper 3x3 and tangents by the upper 3x3, both renormalized.
+// Tangent.w (handedness) is kept, and flipped if Matrix mirrors.
+static XMMATRIX GetNormalMatrix(const XMMATRIX& Matrix)
+{
+	XMMATRIX Linear{ Matrix };
+	Linear.r[3] = XMVectorSet(0, 0, 0, 1);
+	return XMMatrixTranspose(XMMatrixInverse(nullptr, Linear));
+}
+
+static void TransformMesh(SMesh& Mesh, const XMMATRIX& Matrix)
+{
+	const XMMATRIX KNormalMatrix{ GetNormalMatrix(Matrix) };
+	const float KHandedness{ (XMVectorGetX(XMMatrixDeterminant(Matrix)) < 0.0f) ? -1.0f : +1.0f };
+	for (auto& Vertex : Mesh.vVertices)
+	{
+		Vertex.Position = XMVector3TransformCoord(Vertex.Position, Matrix);
+		Vertex.Normal = XMVectorSetW(XMVector3Normalize(XMVector3TransformNormal(Vertex.Normal, KNormalMatrix)), XMVectorGetW(Vertex.Normal));
+		Vertex.Tangent = XMVectorSetW(XMVector3Normalize(XMVector3TransformNormal(Vertex.Tangent, Matrix)), XMVectorGetW(Vertex.Tangent) * KHandedness);
+	}
+}
+
 static void TranslateMesh(SMesh& Mesh, const XMVECTOR& Translation)
 {
 	XMMATRIX Matrix{ XMMatrixTranslationFromVector(Translation) };
 	for (auto& Vertex : Mesh.vVertices)
 	{
 		Vertex.Position = XMVector3TransformCoord(Vertex.Position, Matrix);
-		Vertex.Normal = XMVector3TransformNormal(Vertex.Normal, Matrix);
 	}
 }
 
 static void RotateMesh(SMesh& Mesh, float Pitch, float Yaw, float Roll)
 {
+	// A rotation is its own inverse-transpose and keeps lengths, so no renormalization is needed
 	XMMATRIX Matrix{ XMMatrixRotationRollPitchYaw(Pitch, Yaw, Roll) };
 	for (auto& Vertex : Mesh.vVertices)
 	{
 		Vertex.Position = XMVector3TransformCoord(Vertex.Position, Matrix);
-		Vertex.Normal = XMVector3TransformNormal(Vertex.Normal, Matrix);
+		Vertex.Normal = XMVectorSetW(XMVector3TransformNormal(Vertex.Normal, Matrix), XMVectorGetW(Vertex.Normal));
+		Vertex.Tangent = XMVectorSetW(XMVector3TransformNormal(Vertex.Tangent, Matrix), XMVectorGetW(Vertex.Tangent));
 	}
 }
 
 static void ScaleMesh(SMesh& Mesh, const XMVECTOR& Scaling)
 {
-	XMMATRIX Matrix{ XMMatrixScalingFromVector(Scaling) };
-	for (auto& Vertex : Mesh.vVertices)
-	{
-		Vertex.Position = XMVector3TransformCoord(Vertex.Position, Matrix);
-		Vertex.Normal = XMVector3TransformNormal(Vertex.Normal, Matrix);
-	}
+	TransformMesh(Mesh, XMMatrixScalingFromVector(Scaling));
 }
 
 static void ScaleMeshTexCoord(SMesh& Mesh, const XMVECTOR& Scaling)
@@ -944,30 +1381,271 @@ static void SetMeshColor(SMesh& Mesh, const XMVECTOR& Color)
 	}
 }
 
+// SoA fast paths: same results as the SMesh versions above, 8 (AVX2) or 4 (SSE) vertices at a time.
+
+static void TransformMesh(SMeshSoA& Mesh, const XMMATRIX& Matrix)
+{
+	TransformPositionStream(Mesh.Positions, Matrix);
+	TransformDirectionStream(Mesh.Normals, GetNormalMatrix(Matrix), true);
+	TransformDirectionStream(Mesh.Tangents, Matrix, true);
+	if (XMVectorGetX(XMMatrixDeterminant(Matrix)) < 0.0f)
+	{
+		for (float& W : Mesh.Tangents.vW)
+		{
+			W = -W;
+		}
+	}
+}
+
+static void TranslateMesh(SMeshSoA& Mesh, const XMVECTOR& Translation)
+{
+	TransformPositionStream(Mesh.Positions, XMMatrixTranslationFromVector(Translation));
+}
+
+static void RotateMesh(SMeshSoA& Mesh, float Pitch, float Yaw, float Roll)
+{
+	XMMATRIX Matrix{ XMMatrixRotationRollPitchYaw(Pitch, Yaw, Roll) };
+	TransformPositionStream(Mesh.Positions, Matrix);
+	TransformDirectionStream(Mesh.Normals, Matrix, false);
+	TransformDirectionStream(Mesh.Tangents, Matrix, false);
+}
+
+static void ScaleMesh(SMeshSoA& Mesh, const XMVECTOR& Scaling)
+{
+	TransformMesh(Mesh, XMMatrixScalingFromVector(Scaling));
+}
+
+static void ScaleMeshTexCoord(SMeshSoA& Mesh, const XMVECTOR& Scaling)
+{
+	TransformPositionStream(Mesh.TexCoords, XMMatrixScalingFromVector(Scaling));
+}
+
+static void SetMeshColor(SMeshSoA& Mesh, const XMVECTOR& Color)
+{
+	XMFLOAT4 Value{};
+	XMStoreFloat4(&Value, Color);
+	std::fill(Mesh.Colors.vX.begin(), Mesh.Colors.vX.end(), Value.x);
+	std::fill(Mesh.Colors.vY.begin(), Mesh.Colors.vY.end(), Value.y);
+	std::fill(Mesh.Colors.vZ.begin(), Mesh.Colors.vZ.end(), Value.z);
+	std::fill(Mesh.Colors.vW.begin(), Mesh.Colors.vW.end(), Value.w);
+}
+
 static SMesh MergeStaticMeshes(const SMesh& MeshA, const SMesh& MeshB)
 {
-	SMesh MergedMesh{ MeshA };
+	SMesh MergedMesh{};
+	MergedMesh.MaterialID = MeshA.MaterialID;
+	MergedMesh.vVertices.reserve(MeshA.vVertices.size() + MeshB.vVertices.size());
+	MergedMesh.vTriangles.reserve(MeshA.vTriangles.size() + MeshB.vTriangles.size());
+
+	MergedMesh.vVertices.insert(MergedMesh.vVertices.end(), MeshA.vVertices.begin(), MeshA.vVertices.end());
+	MergedMesh.vVertices.insert(MergedMesh.vVertices.end(), MeshB.vVertices.begin(), MeshB.vVertices.end());
+	MergedMesh.vTriangles.insert(MergedMesh.vTriangles.end(), MeshA.vTriangles.begin(), MeshA.vTriangles.end());
+	MergedMesh.vTriangles.resize(MeshA.vTriangles.size() + MeshB.vTriangles.size());
+
+	const uint32_t KVertexOffset{ static_cast<uint32_t>(MeshA.vVertices.size()) };
+	STriangle* const PtrDstTriangles{ &MergedMesh.vTriangles[MeshA.vTriangles.size()] };
+	for (size_t iTriangle = 0; iTriangle < MeshB.vTriangles.size(); ++iTriangle)
+	{
+		const STriangle& Triangle{ MeshB.vTriangles[iTriangle] };
+		PtrDstTriangles[iTriangle] = STriangle(KVertexOffset + Triangle.I0, KVertexOffset + Triangle.I1, KVertexOffset + Triangle.I2);
+	}
+
+	return MergedMesh;
+}
+
+// Merges any number of meshes into one mesh per distinct MaterialID, in ascending MaterialID order.
+// The result's materials are vMaterialData[MaterialID] (or a default material if out of range) and meshes refer to them by their new index,
+// so it can be passed to CObject3D::Create(const SModel&) directly.
+// All sizes are computed up front; each input is then bulk-copied and rebased independently, on the thread pool if given.
+static SModel MergeStaticMeshes(const std::vector<SMesh>& vMeshes, const std::vector<CMaterialData>& vMaterialData, CThreadPool* const PtrThreadPool)
+{
+	struct SPlacement
+	{
+		size_t		MergedMeshIndex{};
+		size_t		VertexOffset{};
+		size_t		TriangleOffset{};
+	};
+
+	SModel Model{};
 
-	size_t MeshAVertexCount{ MeshA.vVertices.size() };
+	std::map<size_t, size_t> mapMaterialIDToMergedMesh{};
+	for (const SMesh& Mesh : vMeshes)
+	{
+		mapMaterialIDToMergedMesh[Mesh.MaterialID] = 0;
+	}
+	for (auto& MaterialIDToMergedMesh : mapMaterialIDToMergedMesh)
+	{
+		const size_t KMaterialID{ MaterialIDToMergedMesh.first };
+		MaterialIDToMergedMesh.second = Model.vMeshes.size();
+
+		Model.vMeshes.emplace_back();
+		Model.vMeshes.back().MaterialID = Model.vMaterialData.size();
+
+		Model.vMaterialData.emplace_back((KMaterialID < vMaterialData.size()) ? vMaterialData[KMaterialID] : CMaterialData());
+		Model.vMaterialData.back().Index(Model.vMaterialData.size() - 1);
+	}
 
-	for (auto& Vertex : MeshB.vVertices)
+	std::vector<SPlacement> vPlacements(vMeshes.size());
+	std::vector<size_t> vMergedVertexCounts(Model.vMeshes.size());
+	std::vector<size_t> vMergedTriangleCounts(Model.vMeshes.size());
+	for (size_t iMesh = 0; iMesh < vMeshes.size(); ++iMesh)
 	{
-		MergedMesh.vVertices.emplace_back(Vertex);
+		SPlacement& Placement{ vPlacements[iMesh] };
+		Placement.MergedMeshIndex = mapMaterialIDToMergedMesh.at(vMeshes[iMesh].MaterialID);
+		Placement.VertexOffset = vMergedVertexCounts[Placement.MergedMeshIndex];
+		Placement.TriangleOffset = vMergedTriangleCounts[Placement.MergedMeshIndex];
+
+		vMergedVertexCounts[Placement.MergedMeshIndex] += vMeshes[iMesh].vVertices.size();
+		vMergedTriangleCounts[Placement.MergedMeshIndex] += vMeshes[iMesh].vTriangles.size();
 	}
 
-	for (auto& Triangle : MeshB.vTriangles)
+	for (size_t iMergedMesh = 0; iMergedMesh < Model.vMeshes.size(); ++iMergedMesh)
 	{
-		STriangle NewTriangle
+		assert(vMergedVertexCounts[iMergedMesh] <= UINT32_MAX);
+
+		Model.vMeshes[iMergedMesh].vVertices.resize(vMergedVertexCounts[iMergedMesh]);
+		Model.vMeshes[iMergedMesh].vTriangles.resize(vMergedTriangleCounts[iMergedMesh]);
+	}
+
+	auto CopyMeshes{ [&](size_t Begin, size_t End)
 		{
-			static_cast<uint32_t>(MeshAVertexCount + Triangle.I0),
-			static_cast<uint32_t>(MeshAVertexCount + Triangle.I1),
-			static_cast<uint32_t>(MeshAVertexCount + Triangle.I2)
-		};
+			for (size_t iMesh = Begin; iMesh < End; ++iMesh)
+			{
+				const SMesh& Src{ vMeshes[iMesh] };
+				const SPlacement& Placement{ vPlacements[iMesh] };
+				SMesh& Dst{ Model.vMeshes[Placement.MergedMeshIndex] };
+
+				if (!Src.vVertices.empty())
+				{
+					memcpy(&Dst.vVertices[Placement.VertexOffset], Src.vVertices.data(), sizeof(SVertex3D) * Src.vVertices.size());
+				}
+
+				const uint32_t KVertexOffset{ static_cast<uint32_t>(Placement.VertexOffset) };
+				const STriangle* const PtrSrcTriangles{ Src.vTriangles.data() };
+				STriangle* const PtrDstTriangles{ Dst.vTriangles.data() + Placement.TriangleOffset };
+				for (size_t iTriangle = 0; iTriangle < Src.vTriangles.size(); ++iTriangle)
+				{
+					PtrDstTriangles[iTriangle].I0 = PtrSrcTriangles[iTriangle].I0 + KVertexOffset;
+					PtrDstTriangles[iTriangle].I1 = PtrSrcTriangles[iTriangle].I1 + KVertexOffset;
+					PtrDstTriangles[iTriangle].I2 = PtrSrcTriangles[iTriangle].I2 + KVertexOffset;
+				}
+			}
+		}
+	};
 
-		MergedMesh.vTriangles.emplace_back(NewTriangle);
+	if (PtrThreadPool)
+	{
+		PtrThreadPool->ParallelFor(vMeshes.size(), 16, CopyMeshes);
+	}
+	else
+	{
+		CopyMeshes(0, vMeshes.size());
 	}
 
-	return MergedMesh;
+	return Model;
+}
+
+static SMesh GeneratePrimitive(const SPrimitiveDesc& Desc)
+{
+	SMesh Mesh{};
+	switch (Desc.eType)
+	{
+	case EPrimitiveType::SquareXYPlane:
+		Mesh = GenerateSquareXYPlane(Desc.Color);
+		break;
+	case EPrimitiveType::SquareXZPlane:
+		Mesh = GenerateSquareXZPlane(Desc.Color);
+		break;
+	case EPrimitiveType::SquareYZPlane:
+		Mesh = GenerateSquareYZPlane(Desc.Color);
+		break;
+	case EPrimitiveType::TerrainBase:
+		Mesh = GenerateTerrainBase(Desc.Size, Desc.TexCoordSubdivisionFactor, Desc.Color);
+		break;
+	case EPrimitiveType::CircleXZPlane:
+		Mesh = GenerateCircleXZPlane(Desc.SideCount, Desc.Color);
+		break;
+	case EPrimitiveType::Pyramid:
+		Mesh = GeneratePyramid(Desc.Color);
+		break;
+	case EPrimitiveType::Cube:
+		Mesh = GenerateCube(Desc.Color, Desc.bAverageNormals);
+		break;
+	case EPrimitiveType::Cone:
+		Mesh = GenerateCone(Desc.RadiusFactor, Desc.Radius, Desc.Height, Desc.SideCount, Desc.Color);
+		break;
+	case EPrimitiveType::Cylinder:
+		Mesh = GenerateCylinder(Desc.Radius, Desc.Height, Desc.SideCount, Desc.Color);
+		break;
+	case EPrimitiveType::Sphere:
+		Mesh = GenerateSphere(Desc.SegmentCount, Desc.Color);
+		break;
+	case EPrimitiveType::CubemapSphere:
+		Mesh = GenerateCubemapSphere(Desc.SegmentCount);
+		break;
+	case EPrimitiveType::Torus:
+		Mesh = GenerateTorus(Desc.InnerRadius, Desc.SideCount, Desc.SegmentCount, Desc.Color);
+		break;
+	case EPrimitiveType::Icosphere:
+		Mesh = (Desc.MaxChordalError > 0.0f) ?
+			GenerateIcosphereByError(Desc.MaxChordalError, Desc.Color) : GenerateIcosphere(Desc.SubdivisionLevel, Desc.Color);
+		break;
+	case EPrimitiveType::CubeSphere:
+		Mesh = (Desc.MaxChordalError > 0.0f) ?
+			GenerateCubeSphereByError(Desc.MaxChordalError, Desc.Color) : GenerateCubeSphere(Desc.SegmentCount, Desc.Color);
+		break;
+	default:
+		assert(false);
+		break;
+	}
+
+	if (!XMVector3Equal(Desc.Scaling, XMVectorSet(1, 1, 1, 0))) ScaleMesh(Mesh, Desc.Scaling);
+
+	return Mesh;
+}
+
+// Every primitive is generated by the same serial code path on one worker, so the results are identical to GeneratePrimitive().
+static std::vector<std::future<SMesh>> GeneratePrimitives(CThreadPool& ThreadPool, const std::vector<SPrimitiveDesc>& vDescs)
+{
+	std::vector<std::future<SMesh>> vFutures{};
+	vFutures.reserve(vDescs.size());
+	for (const SPrimitiveDesc& Desc : vDescs)
+	{
+		vFutures.emplace_back(ThreadPool.Submit([Desc]() { return GeneratePrimitive(Desc); }));
+	}
+	return vFutures;
+}
+
+// OnCompleted is called once, on the worker that finishes last, with the meshes in the order of vDescs.
+static void GeneratePrimitives(CThreadPool& ThreadPool, const std::vector<SPrimitiveDesc>& vDescs, std::function<void(std::vector<SMesh>&&)> OnCompleted)
+{
+	struct SBatch
+	{
+		std::vector<SMesh>							vMeshes{};
+		std::atomic<size_t>							RemainingCount{};
+		std::function<void(std::vector<SMesh>&&)>	OnCompleted{};
+	};
+
+	if (vDescs.empty())
+	{
+		if (OnCompleted) OnCompleted(std::vector<SMesh>());
+		return;
+	}
+
+	auto PtrBatch{ std::make_shared<SBatch>() };
+	PtrBatch->vMeshes.resize(vDescs.size());
+	PtrBatch->RemainingCount = vDescs.size();
+	PtrBatch->OnCompleted = std::move(OnCompleted);
+
+	for (size_t iDesc = 0; iDesc < vDescs.size(); ++iDesc)
+	{
+		const SPrimitiveDesc& KDesc{ vDescs[iDesc] };
+		ThreadPool.Enqueue([PtrBatch, iDesc, KDesc]()
+			{
+				PtrBatch->vMeshes[iDesc] = GeneratePrimitive(KDesc);
+				if (--PtrBatch->RemainingCount == 0 && PtrBatch->OnCompleted) PtrBatch->OnCompleted(std::move(PtrBatch->vMeshes));
+			});
+	}
 }
 
 static std::vector<SVertex3DLine> Generate3DLineCircleYZ(const XMVECTOR& Color, uint32_t SegmentCount)
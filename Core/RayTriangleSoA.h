@@ -0,0 +1,327 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include "SIMD.h"
+
+// Triangles with their corner positions split into one float array per corner and axis, for ray queries that test 8 (AVX2) or 4 (SSE) triangles at once.
+// The arrays are padded to a multiple of KBatchSize with degenerate triangles, which never produce hits.
+struct STriangleSoA
+{
+	size_t GetTriangleCount() const { return TriangleCount; }
+	size_t GetPaddedTriangleCount() const { return vPositions[0][0].size(); }
+
+	static constexpr size_t KBatchSize{ 8 };
+
+	// [Corner][Axis]
+	std::vector<float>	vPositions[3][3]{};
+	size_t				TriangleCount{};
+};
+
+struct SRayTriangleHit
+{
+	// Distance along the ray in units of the ray direction's length
+	float		T{ FLT_MAX };
+
+	// Barycentric coordinates: Point = (1 - U - V) * V0 + U * V1 + V * V2
+	float		U{};
+	float		V{};
+
+	uint32_t	TriangleIndex{ UINT32_MAX };
+};
+
+// The ray is translated to the origin and sheared so that it becomes the +Z axis (Woop, Benthin & Wald 2013).
+// Each edge function is then the 2D cross product of the edge's two sheared endpoints, which are computed the same way for every triangle
+// that shares the edge, so an edge's function has exactly opposite signs on its two sides and no ray slips between neighbouring triangles.
+struct SShearedRay
+{
+	// Axis permutation: Kz is the dominant axis of the direction
+	uint32_t	Kx{};
+	uint32_t	Ky{};
+	uint32_t	Kz{};
+
+	float		Origin[3]{};
+	float		Sx{};
+	float		Sy{};
+	float		Sz{};
+};
+
+static STriangleSoA ConvertMeshToTriangleSoA(const SMesh& Mesh);
+// Refills Out (keeping its capacity) with triangles that index PtrPositions
+static void FillTriangleSoA(const XMFLOAT3* const PtrPositions, const std::vector<STriangle>& vTriangles, STriangleSoA& Out);
+static SShearedRay MakeShearedRay(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection);
+static void IntersectRayTriangleRange(const SShearedRay& Ray, const STriangleSoA& Triangles, size_t Begin, size_t End, SRayTriangleHit& InOutHit);
+static bool IntersectRayTriangles(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, const STriangleSoA& Triangles, float MaxT, SRayTriangleHit* const OutPtrHit);
+
+namespace RayTriangleSoAInternal
+{
+	// Lane results that passed every test, kept for the horizontal reduction
+	struct SBatchResult
+	{
+		float	T[STriangleSoA::KBatchSize]{};
+		float	U[STriangleSoA::KBatchSize]{};
+		float	V[STriangleSoA::KBatchSize]{};
+		float	W[STriangleSoA::KBatchSize]{};
+		float	Determinant[STriangleSoA::KBatchSize]{};
+	};
+
+	// Strictly closer only, so that among equal distances the lowest triangle index wins whatever the lane width
+	static void ReduceBatch(const SBatchResult& Result, int LaneMask, size_t BatchBegin, SRayTriangleHit& Hit)
+	{
+		for (uint32_t iLane = 0; LaneMask != 0; ++iLane, LaneMask >>= 1)
+		{
+			if ((LaneMask & 1) == 0) continue;
+			if (Result.T[iLane] < Hit.T)
+			{
+				Hit.T = Result.T[iLane];
+				Hit.U = Result.V[iLane] / Result.Determinant[iLane];
+				Hit.V = Result.W[iLane] / Result.Determinant[iLane];
+				Hit.TriangleIndex = static_cast<uint32_t>(BatchBegin + iLane);
+			}
+		}
+	}
+
+	// Both kernels evaluate in the same order (no FMA), so they produce the same bits.
+	// Hit.T is the running upper bound: batches whose every lane fails the edge or distance tests cost no division and no reduction.
+
+	static void IntersectAVX2(const SShearedRay& Ray, const STriangleSoA& Triangles, size_t Begin, size_t End, SRayTriangleHit& Hit)
+	{
+		const float* const KPtrAx{ Triangles.vPositions[0][Ray.Kx].data() };
+		const float* const KPtrAy{ Triangles.vPositions[0][Ray.Ky].data() };
+		const float* const KPtrAz{ Triangles.vPositions[0][Ray.Kz].data() };
+		const float* const KPtrBx{ Triangles.vPositions[1][Ray.Kx].data() };
+		const float* const KPtrBy{ Triangles.vPositions[1][Ray.Ky].data() };
+		const float* const KPtrBz{ Triangles.vPositions[1][Ray.Kz].data() };
+		const float* const KPtrCx{ Triangles.vPositions[2][Ray.Kx].data() };
+		const float* const KPtrCy{ Triangles.vPositions[2][Ray.Ky].data() };
+		const float* const KPtrCz{ Triangles.vPositions[2][Ray.Kz].data() };
+
+		const __m256 KOx{ _mm256_set1_ps(Ray.Origin[Ray.Kx]) };
+		const __m256 KOy{ _mm256_set1_ps(Ray.Origin[Ray.Ky]) };
+		const __m256 KOz{ _mm256_set1_ps(Ray.Origin[Ray.Kz]) };
+		const __m256 KSx{ _mm256_set1_ps(Ray.Sx) };
+		const __m256 KSy{ _mm256_set1_ps(Ray.Sy) };
+		const __m256 KSz{ _mm256_set1_ps(Ray.Sz) };
+		const __m256 KZero{ _mm256_setzero_ps() };
+
+		SBatchResult Result{};
+		for (size_t i = Begin; i < End; i += 8)
+		{
+			const __m256 Az{ _mm256_sub_ps(_mm256_loadu_ps(KPtrAz + i), KOz) };
+			const __m256 Bz{ _mm256_sub_ps(_mm256_loadu_ps(KPtrBz + i), KOz) };
+			const __m256 Cz{ _mm256_sub_ps(_mm256_loadu_ps(KPtrCz + i), KOz) };
+			const __m256 Ax{ _mm256_sub_ps(_mm256_sub_ps(_mm256_loadu_ps(KPtrAx + i), KOx), _mm256_mul_ps(KSx, Az)) };
+			const __m256 Ay{ _mm256_sub_ps(_mm256_sub_ps(_mm256_loadu_ps(KPtrAy + i), KOy), _mm256_mul_ps(KSy, Az)) };
+			const __m256 Bx{ _mm256_sub_ps(_mm256_sub_ps(_mm256_loadu_ps(KPtrBx + i), KOx), _mm256_mul_ps(KSx, Bz)) };
+			const __m256 By{ _mm256_sub_ps(_mm256_sub_ps(_mm256_loadu_ps(KPtrBy + i), KOy), _mm256_mul_ps(KSy, Bz)) };
+			const __m256 Cx{ _mm256_sub_ps(_mm256_sub_ps(_mm256_loadu_ps(KPtrCx + i), KOx), _mm256_mul_ps(KSx, Cz)) };
+			const __m256 Cy{ _mm256_sub_ps(_mm256_sub_ps(_mm256_loadu_ps(KPtrCy + i), KOy), _mm256_mul_ps(KSy, Cz)) };
+
+			const __m256 U{ _mm256_sub_ps(_mm256_mul_ps(Cx, By), _mm256_mul_ps(Cy, Bx)) };
+			const __m256 V{ _mm256_sub_ps(_mm256_mul_ps(Ax, Cy), _mm256_mul_ps(Ay, Cx)) };
+			const __m256 W{ _mm256_sub_ps(_mm256_mul_ps(Bx, Ay), _mm256_mul_ps(By, Ax)) };
+
+			// Inside when no edge function has a sign opposite to another's (zero counts as either side)
+			const __m256 KHasNegative{ _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(U, KZero, _CMP_LT_OQ), _mm256_cmp_ps(V, KZero, _CMP_LT_OQ)), _mm256_cmp_ps(W, KZero, _CMP_LT_OQ)) };
+			const __m256 KHasPositive{ _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(U, KZero, _CMP_GT_OQ), _mm256_cmp_ps(V, KZero, _CMP_GT_OQ)), _mm256_cmp_ps(W, KZero, _CMP_GT_OQ)) };
+			const __m256 KDeterminant{ _mm256_add_ps(_mm256_add_ps(U, V), W) };
+			__m256 Mask{ _mm256_andnot_ps(_mm256_and_ps(KHasNegative, KHasPositive), _mm256_cmp_ps(KDeterminant, KZero, _CMP_NEQ_OQ)) };
+			if (_mm256_movemask_ps(Mask) == 0) continue;
+
+			const __m256 KScaledT{ _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(U, _mm256_mul_ps(KSz, Az)), _mm256_mul_ps(V, _mm256_mul_ps(KSz, Bz))),
+				_mm256_mul_ps(W, _mm256_mul_ps(KSz, Cz))) };
+			const __m256 KT{ _mm256_div_ps(KScaledT, KDeterminant) };
+			Mask = _mm256_and_ps(Mask, _mm256_and_ps(_mm256_cmp_ps(KT, KZero, _CMP_GT_OQ), _mm256_cmp_ps(KT, _mm256_set1_ps(Hit.T), _CMP_LT_OQ)));
+			const int KLaneMask{ _mm256_movemask_ps(Mask) };
+			if (KLaneMask == 0) continue;
+
+			_mm256_storeu_ps(Result.T, KT);
+			_mm256_storeu_ps(Result.U, U);
+			_mm256_storeu_ps(Result.V, V);
+			_mm256_storeu_ps(Result.W, W);
+			_mm256_storeu_ps(Result.Determinant, KDeterminant);
+			ReduceBatch(Result, KLaneMask, i, Hit);
+		}
+	}
+
+	static void IntersectSSE(const SShearedRay& Ray, const STriangleSoA& Triangles, size_t Begin, size_t End, SRayTriangleHit& Hit)
+	{
+		const float* const KPtrAx{ Triangles.vPositions[0][Ray.Kx].data() };
+		const float* const KPtrAy{ Triangles.vPositions[0][Ray.Ky].data() };
+		const float* const KPtrAz{ Triangles.vPositions[0][Ray.Kz].data() };
+		const float* const KPtrBx{ Triangles.vPositions[1][Ray.Kx].data() };
+		const float* const KPtrBy{ Triangles.vPositions[1][Ray.Ky].data() };
+		const float* const KPtrBz{ Triangles.vPositions[1][Ray.Kz].data() };
+		const float* const KPtrCx{ Triangles.vPositions[2][Ray.Kx].data() };
+		const float* const KPtrCy{ Triangles.vPositions[2][Ray.Ky].data() };
+		const float* const KPtrCz{ Triangles.vPositions[2][Ray.Kz].data() };
+
+		const __m128 KOx{ _mm_set1_ps(Ray.Origin[Ray.Kx]) };
+		const __m128 KOy{ _mm_set1_ps(Ray.Origin[Ray.Ky]) };
+		const __m128 KOz{ _mm_set1_ps(Ray.Origin[Ray.Kz]) };
+		const __m128 KSx{ _mm_set1_ps(Ray.Sx) };
+		const __m128 KSy{ _mm_set1_ps(Ray.Sy) };
+		const __m128 KSz{ _mm_set1_ps(Ray.Sz) };
+		const __m128 KZero{ _mm_setzero_ps() };
+
+		SBatchResult Result{};
+		for (size_t i = Begin; i < End; i += 4)
+		{
+			const __m128 Az{ _mm_sub_ps(_mm_loadu_ps(KPtrAz + i), KOz) };
+			const __m128 Bz{ _mm_sub_ps(_mm_loadu_ps(KPtrBz + i), KOz) };
+			const __m128 Cz{ _mm_sub_ps(_mm_loadu_ps(KPtrCz + i), KOz) };
+			const __m128 Ax{ _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(KPtrAx + i), KOx), _mm_mul_ps(KSx, Az)) };
+			const __m128 Ay{ _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(KPtrAy + i), KOy), _mm_mul_ps(KSy, Az)) };
+			const __m128 Bx{ _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(KPtrBx + i), KOx), _mm_mul_ps(KSx, Bz)) };
+			const __m128 By{ _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(KPtrBy + i), KOy), _mm_mul_ps(KSy, Bz)) };
+			const __m128 Cx{ _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(KPtrCx + i), KOx), _mm_mul_ps(KSx, Cz)) };
+			const __m128 Cy{ _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(KPtrCy + i), KOy), _mm_mul_ps(KSy, Cz)) };
+
+			const __m128 U{ _mm_sub_ps(_mm_mul_ps(Cx, By), _mm_mul_ps(Cy, Bx)) };
+			const __m128 V{ _mm_sub_ps(_mm_mul_ps(Ax, Cy), _mm_mul_ps(Ay, Cx)) };
+			const __m128 W{ _mm_sub_ps(_mm_mul_ps(Bx, Ay), _mm_mul_ps(By, Ax)) };
+
+			const __m128 KHasNegative{ _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(U, KZero), _mm_cmplt_ps(V, KZero)), _mm_cmplt_ps(W, KZero)) };
+			const __m128 KHasPositive{ _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(U, KZero), _mm_cmpgt_ps(V, KZero)), _mm_cmpgt_ps(W, KZero)) };
+			const __m128 KDeterminant{ _mm_add_ps(_mm_add_ps(U, V), W) };
+			__m128 Mask{ _mm_andnot_ps(_mm_and_ps(KHasNegative, KHasPositive), _mm_cmpneq_ps(KDeterminant, KZero)) };
+			if (_mm_movemask_ps(Mask) == 0) continue;
+
+			const __m128 KScaledT{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(U, _mm_mul_ps(KSz, Az)), _mm_mul_ps(V, _mm_mul_ps(KSz, Bz))),
+				_mm_mul_ps(W, _mm_mul_ps(KSz, Cz))) };
+			const __m128 KT{ _mm_div_ps(KScaledT, KDeterminant) };
+			Mask = _mm_and_ps(Mask, _mm_and_ps(_mm_cmpgt_ps(KT, KZero), _mm_cmplt_ps(KT, _mm_set1_ps(Hit.T))));
+			const int KLaneMask{ _mm_movemask_ps(Mask) };
+			if (KLaneMask == 0) continue;
+
+			_mm_storeu_ps(Result.T, KT);
+			_mm_storeu_ps(Result.U, U);
+			_mm_storeu_ps(Result.V, V);
+			_mm_storeu_ps(Result.W, W);
+			_mm_storeu_ps(Result.Determinant, KDeterminant);
+			ReduceBatch(Result, KLaneMask, i, Hit);
+		}
+	}
+}
+
+static STriangleSoA ConvertMeshToTriangleSoA(const SMesh& Mesh)
+{
+	const size_t KCount{ Mesh.vTriangles.size() };
+	const size_t KPaddedCount{ (KCount + STriangleSoA::KBatchSize - 1) / STriangleSoA::KBatchSize * STriangleSoA::KBatchSize };
+
+	STriangleSoA Triangles{};
+	Triangles.TriangleCount = KCount;
+	for (auto& Corner : Triangles.vPositions)
+	{
+		for (auto& Axis : Corner)
+		{
+			// Zero-area padding
+			Axis.resize(KPaddedCount);
+		}
+	}
+
+	for (size_t iTriangle = 0; iTriangle < KCount; ++iTriangle)
+	{
+		const STriangle& KTriangle{ Mesh.vTriangles[iTriangle] };
+		const uint32_t KIndices[3]{ KTriangle.I0, KTriangle.I1, KTriangle.I2 };
+		for (int iCorner = 0; iCorner < 3; ++iCorner)
+		{
+			XMFLOAT3 Position{};
+			XMStoreFloat3(&Position, Mesh.vVertices[KIndices[iCorner]].Position);
+			Triangles.vPositions[iCorner][0][iTriangle] = Position.x;
+			Triangles.vPositions[iCorner][1][iTriangle] = Position.y;
+			Triangles.vPositions[iCorner][2][iTriangle] = Position.z;
+		}
+	}
+	return Triangles;
+}
+
+static void FillTriangleSoA(const XMFLOAT3* const PtrPositions, const std::vector<STriangle>& vTriangles, STriangleSoA& Out)
+{
+	const size_t KCount{ vTriangles.size() };
+	const size_t KPaddedCount{ (KCount + STriangleSoA::KBatchSize - 1) / STriangleSoA::KBatchSize * STriangleSoA::KBatchSize };
+
+	Out.TriangleCount = KCount;
+	for (auto& Corner : Out.vPositions)
+	{
+		for (auto& Axis : Corner)
+		{
+			Axis.resize(KPaddedCount);
+
+			// Zero-area padding; resize() only zeroes what it adds
+			std::fill(Axis.begin() + KCount, Axis.end(), 0.0f);
+		}
+	}
+
+	for (size_t iTriangle = 0; iTriangle < KCount; ++iTriangle)
+	{
+		const STriangle& KTriangle{ vTriangles[iTriangle] };
+		const uint32_t KIndices[3]{ KTriangle.I0, KTriangle.I1, KTriangle.I2 };
+		for (int iCorner = 0; iCorner < 3; ++iCorner)
+		{
+			const XMFLOAT3& KPosition{ PtrPositions[KIndices[iCorner]] };
+			Out.vPositions[iCorner][0][iTriangle] = KPosition.x;
+			Out.vPositions[iCorner][1][iTriangle] = KPosition.y;
+			Out.vPositions[iCorner][2][iTriangle] = KPosition.z;
+		}
+	}
+}
+
+static SShearedRay MakeShearedRay(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection)
+{
+	XMFLOAT3 O{};
+	XMFLOAT3 D{};
+	XMStoreFloat3(&O, RayOrigin);
+	XMStoreFloat3(&D, RayDirection);
+	const float KDirection[3]{ D.x, D.y, D.z };
+
+	SShearedRay Ray{};
+	Ray.Kz = (fabsf(D.x) > fabsf(D.y)) ? ((fabsf(D.x) > fabsf(D.z)) ? 0 : 2) : ((fabsf(D.y) > fabsf(D.z)) ? 1 : 2);
+	Ray.Kx = (Ray.Kz + 1) % 3;
+	Ray.Ky = (Ray.Kx + 1) % 3;
+
+	// Keeps the winding (and so the sign of the edge functions) independent of the direction's sign
+	if (KDirection[Ray.Kz] < 0.0f) std::swap(Ray.Kx, Ray.Ky);
+
+	Ray.Origin[0] = O.x;
+	Ray.Origin[1] = O.y;
+	Ray.Origin[2] = O.z;
+	Ray.Sx = KDirection[Ray.Kx] / KDirection[Ray.Kz];
+	Ray.Sy = KDirection[Ray.Ky] / KDirection[Ray.Kz];
+	Ray.Sz = 1.0f / KDirection[Ray.Kz];
+	return Ray;
+}
+
+// Tests the triangles [Begin, End) of Triangles, which must both be multiples of STriangleSoA::KBatchSize, and replaces InOutHit with any closer hit.
+// InOutHit.T is the upper bound, so the same hit can be passed to many ranges (e.g. the leaves of a BVH).
+static void IntersectRayTriangleRange(const SShearedRay& Ray, const STriangleSoA& Triangles, size_t Begin, size_t End, SRayTriangleHit& InOutHit)
+{
+	using namespace RayTriangleSoAInternal;
+
+	assert(Begin % STriangleSoA::KBatchSize == 0);
+	assert(End % STriangleSoA::KBatchSize == 0);
+	assert(End <= Triangles.GetPaddedTriangleCount());
+
+	if (IsAVX2Supported())
+	{
+		IntersectAVX2(Ray, Triangles, Begin, End, InOutHit);
+	}
+	else
+	{
+		IntersectSSE(Ray, Triangles, Begin, End, InOutHit);
+	}
+}
+
+// Closest two-sided hit with 0 < T < MaxT, in the space of the triangles (transform the ray, not the triangles; T is preserved by affine transforms).
+// Rays that hit exactly on an edge or a vertex shared by several triangles report the one with the lowest index.
+static bool IntersectRayTriangles(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, const STriangleSoA& Triangles, float MaxT, SRayTriangleHit* const OutPtrHit)
+{
+	if (Triangles.GetTriangleCount() == 0 || XMVector3Equal(RayDirection, XMVectorZero())) return false;
+
+	SRayTriangleHit Hit{};
+	Hit.T = MaxT;
+	IntersectRayTriangleRange(MakeShearedRay(RayOrigin, RayDirection), Triangles, 0, Triangles.GetPaddedTriangleCount(), Hit);
+
+	if (Hit.TriangleIndex == UINT32_MAX) return false;
+	if (OutPtrHit) *OutPtrHit = Hit;
+	return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <intrin.h>
+#include <immintrin.h>
+
+// The project is built without /arch:AVX2, so AVX2 code paths are selected at run time.
+static bool IsAVX2Supported()
+{
+	static const bool KbIsSupported{ []()
+		{
+			int CPUInfo[4]{};
+			__cpuidex(CPUInfo, 0, 0);
+			if (CPUInfo[0] < 7) return false;
+
+			__cpuidex(CPUInfo, 1, 0);
+			const bool KbHasOSXSAVE{ (CPUInfo[2] & (1 << 27)) != 0 };
+			const bool KbHasAVX{ (CPUInfo[2] & (1 << 28)) != 0 };
+			if (!KbHasOSXSAVE || !KbHasAVX) return false;
+
+			// The OS must save YMM registers on context switches
+			if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+			__cpuidex(CPUInfo, 7, 0);
+			return (CPUInfo[1] & (1 << 5)) != 0;
+		}()
+	};
+	return KbIsSupported;
+}
+
+// Half <-> float conversion instructions (_mm_cvtps_ph, _mm_cvtph_ps)
+static bool IsF16CSupported()
+{
+	static const bool KbIsSupported{ []()
+		{
+			int CPUInfo[4]{};
+			__cpuidex(CPUInfo, 1, 0);
+			const bool KbHasOSXSAVE{ (CPUInfo[2] & (1 << 27)) != 0 };
+			const bool KbHasAVX{ (CPUInfo[2] & (1 << 28)) != 0 };
+			const bool KbHasF16C{ (CPUInfo[2] & (1 << 29)) != 0 };
+			if (!KbHasOSXSAVE || !KbHasAVX || !KbHasF16C) return false;
+
+			return (_xgetbv(0) & 0x6) == 0x6;
+		}()
+	};
+	return KbIsSupported;
+}
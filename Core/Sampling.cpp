@@ -0,0 +1,345 @@
+#include "Sampling.h"
+#include "SIMD.h"
+#include <atomic>
+
+using std::vector;
+using std::atomic;
+using std::min;
+using std::max;
+
+template<int Shift>
+static __m256i RotateLeftAVX2(const __m256i& Value)
+{
+	return _mm256_or_si256(_mm256_slli_epi32(Value, Shift), _mm256_srli_epi32(Value, 32 - Shift));
+}
+
+template<int Shift>
+static __m128i RotateLeftSSE(const __m128i& Value)
+{
+	return _mm_or_si128(_mm_slli_epi32(Value, Shift), _mm_srli_epi32(Value, 32 - Shift));
+}
+
+// One xoshiro128** step of every lane; the multiplications by 5 and 9 are shifts and adds, which SSE2 has for 32-bit lanes
+static __m256i NextAVX2(__m256i(&State)[4])
+{
+	const __m256i KTimes5{ _mm256_add_epi32(_mm256_slli_epi32(State[1], 2), State[1]) };
+	const __m256i KRotated{ RotateLeftAVX2<7>(KTimes5) };
+	const __m256i KResult{ _mm256_add_epi32(_mm256_slli_epi32(KRotated, 3), KRotated) };
+
+	const __m256i KT{ _mm256_slli_epi32(State[1], 9) };
+	State[2] = _mm256_xor_si256(State[2], State[0]);
+	State[3] = _mm256_xor_si256(State[3], State[1]);
+	State[1] = _mm256_xor_si256(State[1], State[2]);
+	State[0] = _mm256_xor_si256(State[0], State[3]);
+	State[2] = _mm256_xor_si256(State[2], KT);
+	State[3] = RotateLeftAVX2<11>(State[3]);
+	return KResult;
+}
+
+static __m128i NextSSE(__m128i(&State)[4])
+{
+	const __m128i KTimes5{ _mm_add_epi32(_mm_slli_epi32(State[1], 2), State[1]) };
+	const __m128i KRotated{ RotateLeftSSE<7>(KTimes5) };
+	const __m128i KResult{ _mm_add_epi32(_mm_slli_epi32(KRotated, 3), KRotated) };
+
+	const __m128i KT{ _mm_slli_epi32(State[1], 9) };
+	State[2] = _mm_xor_si128(State[2], State[0]);
+	State[3] = _mm_xor_si128(State[3], State[1]);
+	State[1] = _mm_xor_si128(State[1], State[2]);
+	State[0] = _mm_xor_si128(State[0], State[3]);
+	State[2] = _mm_xor_si128(State[2], KT);
+	State[3] = RotateLeftSSE<11>(State[3]);
+	return KResult;
+}
+
+static void FillUInt32AVX2(uint32_t(&LaneStates)[4][CRandom::KLaneCount], uint32_t* const OutPtrValues, size_t Count)
+{
+	__m256i State[4]{};
+	for (int iWord = 0; iWord < 4; ++iWord)
+	{
+		State[iWord] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(LaneStates[iWord]));
+	}
+
+	size_t iValue{};
+	for (; iValue + CRandom::KLaneCount <= Count; iValue += CRandom::KLaneCount)
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(OutPtrValues + iValue), NextAVX2(State));
+	}
+	if (iValue < Count)
+	{
+		uint32_t Last[CRandom::KLaneCount]{};
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(Last), NextAVX2(State));
+		memcpy(OutPtrValues + iValue, Last, (Count - iValue) * sizeof(uint32_t));
+	}
+
+	for (int iWord = 0; iWord < 4; ++iWord)
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(LaneStates[iWord]), State[iWord]);
+	}
+}
+
+// Lanes 0-3 and 4-7 in two registers, so that the output is the same as FillUInt32AVX2()'s
+static void FillUInt32SSE(uint32_t(&LaneStates)[4][CRandom::KLaneCount], uint32_t* const OutPtrValues, size_t Count)
+{
+	__m128i StateLow[4]{};
+	__m128i StateHigh[4]{};
+	for (int iWord = 0; iWord < 4; ++iWord)
+	{
+		StateLow[iWord] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(LaneStates[iWord]));
+		StateHigh[iWord] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(LaneStates[iWord] + 4));
+	}
+
+	size_t iValue{};
+	for (; iValue + CRandom::KLaneCount <= Count; iValue += CRandom::KLaneCount)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(OutPtrValues + iValue), NextSSE(StateLow));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(OutPtrValues + iValue + 4), NextSSE(StateHigh));
+	}
+	if (iValue < Count)
+	{
+		uint32_t Last[CRandom::KLaneCount]{};
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(Last), NextSSE(StateLow));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(Last + 4), NextSSE(StateHigh));
+		memcpy(OutPtrValues + iValue, Last, (Count - iValue) * sizeof(uint32_t));
+	}
+
+	for (int iWord = 0; iWord < 4; ++iWord)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(LaneStates[iWord]), StateLow[iWord]);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(LaneStates[iWord] + 4), StateHigh[iWord]);
+	}
+}
+
+// In place: the buffer holds random bits on input
+static void ConvertToFloatAVX2(float* const InOutPtrValues, size_t Count, float Min, float Max)
+{
+	const __m256 KScale{ _mm256_set1_ps(CRandom::KUInt24ToFloat) };
+	const __m256 KMin{ _mm256_set1_ps(Min) };
+	const __m256 KRange{ _mm256_set1_ps(Max - Min) };
+
+	size_t iValue{};
+	for (; iValue + 8 <= Count; iValue += 8)
+	{
+		const __m256i KBits{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(InOutPtrValues + iValue)) };
+		const __m256 KUnit{ _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(KBits, 8)), KScale) };
+		_mm256_storeu_ps(InOutPtrValues + iValue, _mm256_add_ps(KMin, _mm256_mul_ps(KUnit, KRange)));
+	}
+	for (; iValue < Count; ++iValue)
+	{
+		uint32_t Bits{};
+		memcpy(&Bits, InOutPtrValues + iValue, sizeof(Bits));
+		InOutPtrValues[iValue] = Min + static_cast<float>(Bits >> 8) * CRandom::KUInt24ToFloat * (Max - Min);
+	}
+}
+
+static void ConvertToFloatSSE(float* const InOutPtrValues, size_t Count, float Min, float Max)
+{
+	const __m128 KScale{ _mm_set1_ps(CRandom::KUInt24ToFloat) };
+	const __m128 KMin{ _mm_set1_ps(Min) };
+	const __m128 KRange{ _mm_set1_ps(Max - Min) };
+
+	size_t iValue{};
+	for (; iValue + 4 <= Count; iValue += 4)
+	{
+		const __m128i KBits{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(InOutPtrValues + iValue)) };
+		const __m128 KUnit{ _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(KBits, 8)), KScale) };
+		_mm_storeu_ps(InOutPtrValues + iValue, _mm_add_ps(KMin, _mm_mul_ps(KUnit, KRange)));
+	}
+	for (; iValue < Count; ++iValue)
+	{
+		uint32_t Bits{};
+		memcpy(&Bits, InOutPtrValues + iValue, sizeof(Bits));
+		InOutPtrValues[iValue] = Min + static_cast<float>(Bits >> 8) * CRandom::KUInt24ToFloat * (Max - Min);
+	}
+}
+
+void CRandom::SetSeed(uint64_t Seed)
+{
+	// SplitMix64, so that similar seeds still give unrelated states
+	for (int iHalf = 0; iHalf < 2; ++iHalf)
+	{
+		uint64_t Z{ (Seed += 0x9E37'79B9'7F4A'7C15) };
+		Z = (Z ^ (Z >> 30)) * 0xBF58'476D'1CE4'E5B9;
+		Z = (Z ^ (Z >> 27)) * 0x94D0'49BB'1331'11EB;
+		Z ^= Z >> 31;
+		m_State[iHalf * 2 + 0] = static_cast<uint32_t>(Z);
+		m_State[iHalf * 2 + 1] = static_cast<uint32_t>(Z >> 32);
+	}
+
+	// The all-zero state is the only one xoshiro never leaves
+	if ((m_State[0] | m_State[1] | m_State[2] | m_State[3]) == 0) m_State[0] = 1;
+
+	m_bAreLanesSeeded = false;
+}
+
+int CRandom::NextInt(int Min, int Max)
+{
+	if (Min >= Max) return Min;
+
+	// 0 for the full 32-bit range
+	const uint32_t KRange{ static_cast<uint32_t>(Max) - static_cast<uint32_t>(Min) + 1 };
+	if (KRange == 0) return static_cast<int>(NextUInt32());
+
+	uint64_t Product{ static_cast<uint64_t>(NextUInt32()) * KRange };
+	if (static_cast<uint32_t>(Product) < KRange)
+	{
+		// 2^32 mod Range values of the low word would otherwise map to some results once more than to others
+		const uint32_t KThreshold{ (0 - KRange) % KRange };
+		while (static_cast<uint32_t>(Product) < KThreshold)
+		{
+			Product = static_cast<uint64_t>(NextUInt32()) * KRange;
+		}
+	}
+	return static_cast<int>(static_cast<uint32_t>(Min) + static_cast<uint32_t>(Product >> 32));
+}
+
+void CRandom::Jump()
+{
+	static constexpr uint32_t KJump[4]{ 0x8764'000B, 0xF542'D2D3, 0x6FA0'35C3, 0x77F2'DB5B };
+
+	uint32_t State[4]{};
+	for (uint32_t Word : KJump)
+	{
+		for (int iBit = 0; iBit < 32; ++iBit)
+		{
+			if (Word & (1u << iBit))
+			{
+				for (int iWord = 0; iWord < 4; ++iWord) State[iWord] ^= m_State[iWord];
+			}
+			NextUInt32();
+		}
+	}
+	memcpy(m_State, State, sizeof(m_State));
+}
+
+void CRandom::FillUInt32(uint32_t* const OutPtrValues, size_t Count)
+{
+	assert(OutPtrValues || Count == 0);
+
+	if (!m_bAreLanesSeeded) SeedLanes();
+
+	if (IsAVX2Supported())
+	{
+		FillUInt32AVX2(m_LaneStates, OutPtrValues, Count);
+	}
+	else
+	{
+		FillUInt32SSE(m_LaneStates, OutPtrValues, Count);
+	}
+}
+
+void CRandom::FillFloat(float* const OutPtrValues, size_t Count, float Min, float Max)
+{
+	// The bits go through the output buffer, which only the intrinsics and memcpy() read as integers
+	FillUInt32(reinterpret_cast<uint32_t*>(OutPtrValues), Count);
+
+	if (IsAVX2Supported())
+	{
+		ConvertToFloatAVX2(OutPtrValues, Count, Min, Max);
+	}
+	else
+	{
+		ConvertToFloatSSE(OutPtrValues, Count, Min, Max);
+	}
+}
+
+CRandom& CRandom::GetThreadLocal()
+{
+	static atomic<uint64_t> s_ThreadCount{};
+	thread_local CRandom t_Random{ KDefaultSeed + s_ThreadCount.fetch_add(1) };
+	return t_Random;
+}
+
+void CRandom::SeedLanes()
+{
+	// Each lane starts 2^64 calls after the previous one, and the scalar stream continues after the last lane
+	for (size_t iLane = 0; iLane < KLaneCount; ++iLane)
+	{
+		Jump();
+		for (int iWord = 0; iWord < 4; ++iWord)
+		{
+			m_LaneStates[iWord][iLane] = m_State[iWord];
+		}
+	}
+	m_bAreLanesSeeded = true;
+}
+
+static float GetToroidalDistanceSq(const XMFLOAT2& A, const XMFLOAT2& B)
+{
+	float DX{ fabsf(A.x - B.x) };
+	float DY{ fabsf(A.y - B.y) };
+	DX = min(DX, 1.0f - DX);
+	DY = min(DY, 1.0f - DY);
+	return DX * DX + DY * DY;
+}
+
+// Searches the grid ring by ring; stops as soon as a point is at most sqrt(RejectDistanceSq) away, since the caller drops such candidates anyway
+static float GetNearestDistanceSq(const vector<XMFLOAT2>& vPoints, const vector<vector<uint32_t>>& vCells, int GridSize, const XMFLOAT2& Point,
+	float RejectDistanceSq)
+{
+	const int KCellX{ min(static_cast<int>(Point.x * GridSize), GridSize - 1) };
+	const int KCellY{ min(static_cast<int>(Point.y * GridSize), GridSize - 1) };
+	const float KCellSize{ 1.0f / GridSize };
+
+	float NearestDistanceSq{ FLT_MAX };
+	for (int Ring = 0; Ring <= GridSize / 2; ++Ring)
+	{
+		// Every point outside the rings searched so far is at least (Ring - 1) cells away
+		if (Ring >= 1)
+		{
+			const float KRingDistance{ (Ring - 1) * KCellSize };
+			if (NearestDistanceSq <= KRingDistance * KRingDistance) break;
+		}
+
+		for (int DY = -Ring; DY <= Ring; ++DY)
+		{
+			for (int DX = -Ring; DX <= Ring; ++DX)
+			{
+				if (max(abs(DX), abs(DY)) != Ring) continue;
+
+				const int KX{ (KCellX + DX + GridSize) % GridSize };
+				const int KY{ (KCellY + DY + GridSize) % GridSize };
+				for (uint32_t iPoint : vCells[KY * GridSize + KX])
+				{
+					NearestDistanceSq = min(NearestDistanceSq, GetToroidalDistanceSq(Point, vPoints[iPoint]));
+					if (NearestDistanceSq <= RejectDistanceSq) return NearestDistanceSq;
+				}
+			}
+		}
+	}
+	return NearestDistanceSq;
+}
+
+void GenerateBlueNoisePoints(CRandom& Random, size_t Count, vector<XMFLOAT2>& vOutPoints, size_t CandidateCount)
+{
+	assert(CandidateCount >= 1);
+
+	vOutPoints.clear();
+	if (Count == 0) return;
+	vOutPoints.reserve(Count);
+
+	// About one point per cell in the end
+	const int KGridSize{ max(1, static_cast<int>(ceil(sqrt(static_cast<double>(Count))))) };
+	vector<vector<uint32_t>> vCells(static_cast<size_t>(KGridSize) * KGridSize);
+
+	for (size_t iPoint = 0; iPoint < Count; ++iPoint)
+	{
+		XMFLOAT2 BestCandidate{};
+		float BestDistanceSq{ -1.0f };
+		for (size_t iCandidate = 0; iCandidate < CandidateCount; ++iCandidate)
+		{
+			const XMFLOAT2 KCandidate{ Random.NextFloat(), Random.NextFloat() };
+			const float KDistanceSq{ GetNearestDistanceSq(vOutPoints, vCells, KGridSize, KCandidate, BestDistanceSq) };
+			if (KDistanceSq > BestDistanceSq)
+			{
+				BestDistanceSq = KDistanceSq;
+				BestCandidate = KCandidate;
+			}
+		}
+
+		const int KCellX{ min(static_cast<int>(BestCandidate.x * KGridSize), KGridSize - 1) };
+		const int KCellY{ min(static_cast<int>(BestCandidate.y * KGridSize), KGridSize - 1) };
+		vCells[static_cast<size_t>(KCellY) * KGridSize + KCellX].emplace_back(static_cast<uint32_t>(iPoint));
+		vOutPoints.emplace_back(BestCandidate);
+	}
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "SharedHeader.h"
+
+// xoshiro128** (Blackman & Vigna, "Scrambled linear pseudorandom number generators", 2018), seeded through SplitMix64.
+// Replaces rand(), which is slow, shared by every thread and biased by the modulo.
+// The bulk fills run eight interleaved streams (jumped off this generator on first use) in AVX2 or SSE lanes;
+// both paths produce the same numbers, but not the sequence the scalar calls would.
+class CRandom
+{
+public:
+	CRandom(uint64_t Seed = KDefaultSeed) { SetSeed(Seed); }
+	~CRandom() {}
+
+public:
+	void SetSeed(uint64_t Seed);
+
+	uint32_t NextUInt32()
+	{
+		const uint32_t KResult{ RotateLeft(m_State[1] * 5, 7) * 9 };
+		const uint32_t KT{ m_State[1] << 9 };
+		m_State[2] ^= m_State[0];
+		m_State[3] ^= m_State[1];
+		m_State[1] ^= m_State[2];
+		m_State[0] ^= m_State[3];
+		m_State[2] ^= KT;
+		m_State[3] = RotateLeft(m_State[3], 11);
+		return KResult;
+	}
+
+	// [0, 1) on a 2^-24 grid, so that every value is exactly representable
+	float NextFloat() { return static_cast<float>(NextUInt32() >> 8) * KUInt24ToFloat; }
+
+	// [Min, Max)
+	float NextFloat(float Min, float Max) { return Min + NextFloat() * (Max - Min); }
+
+	// [Min, Max], without modulo bias (Lemire, "Fast random integer generation in an interval", 2019)
+	int NextInt(int Min, int Max);
+
+	// Advances the generator by 2^64 calls; every jump starts a stream that won't overlap the previous ones.
+	void Jump();
+
+	void FillUInt32(uint32_t* const OutPtrValues, size_t Count);
+	// [Min, Max), same mapping as NextFloat()
+	void FillFloat(float* const OutPtrValues, size_t Count, float Min = 0.0f, float Max = 1.0f);
+
+public:
+	// One generator per thread; each is seeded from KDefaultSeed and the order in which the threads first asked for one.
+	static CRandom& GetThreadLocal();
+
+private:
+	static uint32_t RotateLeft(uint32_t Value, int Shift) { return (Value << Shift) | (Value >> (32 - Shift)); }
+
+	void SeedLanes();
+
+public:
+	static constexpr uint64_t	KDefaultSeed{ 0x853C'49E6'748F'EA9B };
+	static constexpr float		KUInt24ToFloat{ 1.0f / 16'777'216.0f };
+	static constexpr size_t		KLaneCount{ 8 };
+
+private:
+	uint32_t	m_State[4]{};
+
+	// [Word][Lane]; seeded by the first bulk fill
+	uint32_t	m_LaneStates[4][KLaneCount]{};
+	bool		m_bAreLanesSeeded{ false };
+};
+
+// The sequences below have HLSL twins in Shader/Deferred.hlsli that give the same bits; keep them in sync.
+static uint32_t ReverseBits(uint32_t Value);
+static uint32_t GetHammersleyOrder(uint32_t SampleCount);
+static float GetHammersleyBase(uint32_t Order);
+static XMFLOAT2 Hammersley(uint32_t Seed, uint32_t SampleCount, uint32_t Order, float Base);
+static XMFLOAT2 Sobol(uint32_t Index, uint32_t ScrambleX = 0, uint32_t ScrambleY = 0);
+static float GetInterleavedGradientNoise(float PixelX, float PixelY);
+
+// Mitchell's best candidate over the unit torus: each point is the one of CandidateCount uniform candidates that is farthest from the points so far.
+// Blue-noise point sets for scattering on the CPU; more candidates give a more even set.
+void GenerateBlueNoisePoints(CRandom& Random, size_t Count, std::vector<XMFLOAT2>& vOutPoints, size_t CandidateCount = 16);
+
+static uint32_t ReverseBits(uint32_t Value)
+{
+	// Same as HLSL reversebits()
+	Value = ((Value >> 1) & 0x5555'5555) | ((Value & 0x5555'5555) << 1);
+	Value = ((Value >> 2) & 0x3333'3333) | ((Value & 0x3333'3333) << 2);
+	Value = ((Value >> 4) & 0x0F0F'0F0F) | ((Value & 0x0F0F'0F0F) << 4);
+	Value = ((Value >> 8) & 0x00FF'00FF) | ((Value & 0x00FF'00FF) << 8);
+	return (Value >> 16) | (Value << 16);
+}
+
+// Bits needed for the indices [0, SampleCount)
+static uint32_t GetHammersleyOrder(uint32_t SampleCount)
+{
+	assert(SampleCount >= 2);
+
+	uint32_t Order{};
+	for (uint32_t Max = SampleCount - 1; Max; Max >>= 1) ++Order;
+	return Order;
+}
+
+static float GetHammersleyBase(uint32_t Order)
+{
+	return ldexpf(1.0f, -static_cast<int>(Order));
+}
+
+// (Seed / 2^Order, radical inverse of Seed / 2^Order)
+static XMFLOAT2 Hammersley(uint32_t Seed, uint32_t SampleCount, uint32_t Order, float Base)
+{
+	assert(Order >= 1 && Order <= 32);
+	assert(Seed < SampleCount);
+
+	const uint32_t KInvertedBits{ ReverseBits(Seed) >> (32 - Order) };
+	return XMFLOAT2(Base * static_cast<float>(Seed), Base * static_cast<float>(KInvertedBits));
+}
+
+// First two Sobol dimensions (van der Corput and the (0, 2)-sequence of Kollig & Keller), with optional random digit scrambling
+static XMFLOAT2 Sobol(uint32_t Index, uint32_t ScrambleX, uint32_t ScrambleY)
+{
+	const uint32_t KX{ ReverseBits(Index) ^ ScrambleX };
+	uint32_t Y{ ScrambleY };
+	for (uint32_t Direction = 0x8000'0000; Index != 0; Index >>= 1)
+	{
+		if (Index & 1) Y ^= Direction;
+		Direction ^= Direction >> 1;
+	}
+	return XMFLOAT2(static_cast<float>(KX >> 8) * CRandom::KUInt24ToFloat, static_cast<float>(Y >> 8) * CRandom::KUInt24ToFloat);
+}
+
+// Jimenez, "Next Generation Post Processing in Call of Duty: Advanced Warfare", 2014.
+// Per-pixel noise in [0, 1) whose error looks like blue noise; float math, so GPUs that fuse the multiply-add can differ in the last bit.
+static float GetInterleavedGradientNoise(float PixelX, float PixelY)
+{
+	const float KInner{ 0.06711056f * PixelX + 0.00583715f * PixelY };
+	const float KOuter{ 52.9829189f * (KInner - floorf(KInner)) };
+	return KOuter - floorf(KOuter);
+}
@@ -0,0 +1,732 @@
+#include "SelfTest.h"
+#include "VertexPacking.h"
+#include "Tessellator.h"
+#include "RayTriangleSoA.h"
+#include "PrimitiveGenerator.h"
+#include <random>
+#include <chrono>
+#include <unordered_map>
+#include <string>
+
+using std::vector;
+using std::string;
+using std::to_string;
+using std::unordered_map;
+using std::max;
+using std::sort;
+using std::adjacent_find;
+using std::binary_search;
+using std::mt19937;
+using std::uniform_real_distribution;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+static constexpr ETessellatorPartitioning KPartitionings[3]{ ETessellatorPartitioning::FractionalOdd, ETessellatorPartitioning::FractionalEven,
+	ETessellatorPartitioning::Integer };
+static const char* const KPartitioningNames[3]{ "fractional_odd", "fractional_even", "integer" };
+
+// Returns 1 if the check failed
+static size_t CheckBound(FILE* const Output, const char* const Name, double Value, double Bound)
+{
+	const bool KbPassed{ Value <= Bound };
+	fprintf(Output, "[%s] %s: %g (at most %g)\n", (KbPassed) ? "PASS" : "FAIL", Name, Value, Bound);
+	return (KbPassed) ? 0 : 1;
+}
+
+static XMVECTOR GetRandomDirection(mt19937& Random)
+{
+	uniform_real_distribution<float> Distribution{ -1.0f, 1.0f };
+	while (true)
+	{
+		const XMVECTOR KDirection{ XMVectorSet(Distribution(Random), Distribution(Random), Distribution(Random), 0.0f) };
+		const float KLength{ XMVectorGetX(XMVector3Length(KDirection)) };
+		if (KLength > 0.1f && KLength <= 1.0f) return KDirection / KLength;
+	}
+}
+
+size_t TestVertexPacking(FILE* const Output)
+{
+	using namespace VertexPackingInternal;
+
+	mt19937 Random{ 2020 };
+	uniform_real_distribution<float> Unit{ -1.0f, 1.0f };
+	uniform_real_distribution<float> Exponent{ -14.0f, 6.0f };
+
+	// Random vertices, then the directions where the octahedral folds and the 10-bit rounding are tightest
+	vector<SVertex3D> vVertices(100'000);
+	for (SVertex3D& Vertex : vVertices)
+	{
+		Vertex.Position = XMVectorSet(1000.0f + Unit(Random) * 100.0f, Unit(Random) * 3.0f, -50.0f + Unit(Random), 1.0f);
+		Vertex.Color = XMVectorSet(Unit(Random), Unit(Random), Unit(Random), Unit(Random)) + XMVectorReplicate(0.5f);
+		// Half's normal range only
+		Vertex.TexCoord = XMVectorSet(copysignf(exp2f(Exponent(Random)), Unit(Random)), copysignf(exp2f(Exponent(Random)), Unit(Random)), 0, 0);
+		Vertex.Normal = GetRandomDirection(Random);
+		Vertex.Tangent = XMVectorSetW(GetRandomDirection(Random), (Unit(Random) < 0.0f) ? -1.0f : 1.0f);
+	}
+	const XMVECTOR KSpecialDirections[]{ XMVectorSet(1, 0, 0, 0), XMVectorSet(-1, 0, 0, 0), XMVectorSet(0, 1, 0, 0), XMVectorSet(0, -1, 0, 0),
+		XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 0, -1, 0), XMVector3Normalize(XMVectorSet(1, 1, -1, 0)), XMVector3Normalize(XMVectorSet(-1, 0, -1, 0)),
+		XMVector3Normalize(XMVectorSet(0, -1, -1, 0)), XMVector3Normalize(XMVectorSet(1, 1, 1, 0)) };
+	for (const XMVECTOR& KDirection : KSpecialDirections)
+	{
+		vVertices.emplace_back(vVertices.front());
+		vVertices.back().Normal = KDirection;
+		vVertices.back().Tangent = XMVectorSetW(KDirection, 0.0f);
+	}
+
+	const SPositionQuantization KQuantization{ CalculatePositionQuantization(vVertices) };
+	vector<SPackedVertex3D> vPackedVertices{};
+	vector<SVertex3D> vUnpackedVertices{};
+	PackVertices(vVertices, KQuantization, vPackedVertices);
+	UnpackVertices(vPackedVertices, KQuantization, vUnpackedVertices);
+
+	const XMVECTOR KScale{ XMLoadFloat4(&KQuantization.Scale) };
+	// Half a step, and a few ulps of the largest coordinate for the float math around it
+	const XMVECTOR KPositionBound{ KScale / 131070.0f + (XMVectorAbs(XMLoadFloat4(&KQuantization.Offset)) + KScale) * (4.0f * FLT_EPSILON) };
+	double PositionExcess{ -FLT_MAX };
+	double ColorError{};
+	double TexCoordError{};
+	double NormalDegrees{};
+	double TangentDegrees{};
+	double HandednessMismatchCount{};
+	for (size_t iVertex = 0; iVertex < vVertices.size(); ++iVertex)
+	{
+		const SVertex3D& KOriginal{ vVertices[iVertex] };
+		const SVertex3D& KUnpacked{ vUnpackedVertices[iVertex] };
+
+		// How far the worst axis is past (or, if negative, within) its bound
+		const XMVECTOR KPositionExcess{ XMVectorAbs(KOriginal.Position - KUnpacked.Position) - KPositionBound };
+		PositionExcess = max(PositionExcess, static_cast<double>(max(max(XMVectorGetX(KPositionExcess), XMVectorGetY(KPositionExcess)),
+			XMVectorGetZ(KPositionExcess))));
+
+		XMFLOAT4 Difference{};
+		XMStoreFloat4(&Difference, XMVectorAbs(XMVectorSaturate(KOriginal.Color) - KUnpacked.Color));
+		ColorError = max(ColorError, static_cast<double>(max(max(Difference.x, Difference.y), max(Difference.z, Difference.w))));
+
+		XMStoreFloat4(&Difference, XMVectorAbs(KOriginal.TexCoord - KUnpacked.TexCoord) / XMVectorAbs(KOriginal.TexCoord));
+		TexCoordError = max(TexCoordError, static_cast<double>(max(Difference.x, Difference.y)));
+
+		NormalDegrees = max(NormalDegrees, static_cast<double>(GetAngleDegrees(KOriginal.Normal, KUnpacked.Normal)));
+		TangentDegrees = max(TangentDegrees, static_cast<double>(GetAngleDegrees(KOriginal.Tangent, KUnpacked.Tangent)));
+
+		// w == 0 counts as +1
+		if ((XMVectorGetW(KOriginal.Tangent) < 0.0f) != (XMVectorGetW(KUnpacked.Tangent) < 0.0f)) ++HandednessMismatchCount;
+	}
+
+	size_t FailCount{};
+	FailCount += CheckBound(Output, "Packed position error beyond half a step", PositionExcess, 0.0);
+	FailCount += CheckBound(Output, "Packed color error", ColorError, 0.5 / 255.0 + 1e-6);
+	FailCount += CheckBound(Output, "Packed texcoord relative error", TexCoordError, 1.0 / 2048.0);
+	FailCount += CheckBound(Output, "Packed normal error (degrees)", NormalDegrees, 0.005);
+	FailCount += CheckBound(Output, "Packed tangent error (degrees)", TangentDegrees, 0.1);
+	FailCount += CheckBound(Output, "Packed handedness mismatches", HandednessMismatchCount, 0.0);
+
+	// A flat axis (Scale == 0) must come back exactly
+	vector<SVertex3D> vFlatVertices(2, vVertices.front());
+	vFlatVertices[1].Position = XMVectorSetX(vFlatVertices[1].Position, XMVectorGetX(vFlatVertices[1].Position) + 1.0f);
+	const SPositionQuantization KFlatQuantization{ CalculatePositionQuantization(vFlatVertices) };
+	PackVertices(vFlatVertices, KFlatQuantization, vPackedVertices);
+	UnpackVertices(vPackedVertices, KFlatQuantization, vUnpackedVertices);
+	const XMVECTOR KFlatError{ XMVectorAbs(vFlatVertices[1].Position - vUnpackedVertices[1].Position) };
+	FailCount += CheckBound(Output, "Packed position error on flat axes", max(XMVectorGetY(KFlatError), XMVectorGetZ(KFlatError)), 0.0);
+	return FailCount;
+}
+
+// Returns what is wrong with the last tessellation, or nullptr. vEdges is scratch.
+// DomainArea is the area of the domain and IsOnSide() tells whether an edge lies on one of its sides.
+static const char* ValidateDomain(const CTessellator& Tessellator, double DomainArea, bool(*IsOnSide)(const XMFLOAT2&, const XMFLOAT2&),
+	vector<uint64_t>& vEdges)
+{
+	const vector<XMFLOAT2>& KPoints{ Tessellator.GetDomainPoints() };
+	const vector<STriangle>& KTriangles{ Tessellator.GetTriangles() };
+
+	// Slivers of the fractional transitions may round to a tiny negative area
+	static constexpr double KAreaTolerance{ 2e-5 };
+	vector<bool> vIsUsed(KPoints.size());
+	vEdges.clear();
+	double AreaSum{};
+	for (const STriangle& KTriangle : KTriangles)
+	{
+		const uint32_t KIndices[3]{ KTriangle.I0, KTriangle.I1, KTriangle.I2 };
+		for (int iCorner = 0; iCorner < 3; ++iCorner)
+		{
+			if (KIndices[iCorner] >= KPoints.size()) return "index out of range";
+			vIsUsed[KIndices[iCorner]] = true;
+			vEdges.emplace_back((static_cast<uint64_t>(KIndices[iCorner]) << 32) | KIndices[(iCorner + 1) % 3]);
+		}
+
+		const XMFLOAT2& KA{ KPoints[KTriangle.I0] };
+		const XMFLOAT2& KB{ KPoints[KTriangle.I1] };
+		const XMFLOAT2& KC{ KPoints[KTriangle.I2] };
+		const double KArea{ 0.5 * (static_cast<double>(KB.x - KA.x) * (KC.y - KA.y) - static_cast<double>(KB.y - KA.y) * (KC.x - KA.x)) };
+		if (KArea < -KAreaTolerance) return "a triangle winds the other way";
+		AreaSum += KArea;
+	}
+	for (bool bIsUsed : vIsUsed)
+	{
+		if (!bIsUsed) return "a point is unused";
+	}
+	if (fabs(AreaSum - DomainArea) > 1e-4) return "the triangles don't cover the domain";
+
+	sort(vEdges.begin(), vEdges.end());
+	if (adjacent_find(vEdges.begin(), vEdges.end()) != vEdges.end()) return "an edge is duplicated";
+
+	// Edges without a twin must lie on a side of the domain.
+	// (Not their total length: the reference's rounded 16.16 reciprocals may fold the middle points of a fractional edge over each other.)
+	for (uint64_t Edge : vEdges)
+	{
+		if (binary_search(vEdges.begin(), vEdges.end(), (Edge << 32) | (Edge >> 32))) continue;
+		if (!IsOnSide(KPoints[Edge >> 32], KPoints[Edge & 0xFFFF'FFFF])) return "the domain has a hole";
+	}
+	return nullptr;
+}
+
+static const char* ValidateTriDomain(const CTessellator& Tessellator, vector<uint64_t>& vEdges)
+{
+	return ValidateDomain(Tessellator, 0.5, [](const XMFLOAT2& A, const XMFLOAT2& B)
+		{
+			return (A.x == 0.0f && B.x == 0.0f) || (A.y == 0.0f && B.y == 0.0f) || (fabsf(A.x + A.y - 1.0f) < 1e-6f && fabsf(B.x + B.y - 1.0f) < 1e-6f);
+		}, vEdges);
+}
+
+static const char* ValidateQuadDomain(const CTessellator& Tessellator, vector<uint64_t>& vEdges)
+{
+	return ValidateDomain(Tessellator, 1.0, [](const XMFLOAT2& A, const XMFLOAT2& B)
+		{
+			return (A.x == 0.0f && B.x == 0.0f) || (A.y == 0.0f && B.y == 0.0f) || (A.x == 1.0f && B.x == 1.0f) || (A.y == 1.0f && B.y == 1.0f);
+		}, vEdges);
+}
+
+size_t TestTessellator(FILE* const Output)
+{
+	size_t FailCount{};
+	vector<uint64_t> vEdges{};
+
+	// Triangle counts of the D3D11 tessellator for uniform factors
+	struct SReference
+	{
+		ETessellatorPartitioning	ePartitioning{};
+		float						Factor{};
+		size_t						TriangleCount{};
+	};
+	static constexpr SReference KReferences[]{ { ETessellatorPartitioning::Integer, 1.0f, 1 }, { ETessellatorPartitioning::Integer, 2.0f, 6 },
+		{ ETessellatorPartitioning::Integer, 3.0f, 13 }, { ETessellatorPartitioning::Integer, 4.0f, 24 },
+		{ ETessellatorPartitioning::Integer, 2.5f, 13 }, { ETessellatorPartitioning::FractionalOdd, 1.0f, 1 },
+		{ ETessellatorPartitioning::FractionalOdd, 3.0f, 13 }, { ETessellatorPartitioning::FractionalEven, 1.0f, 6 },
+		{ ETessellatorPartitioning::FractionalEven, 4.0f, 24 } };
+	for (const SReference& KReference : KReferences)
+	{
+		CTessellator Tessellator{ KReference.ePartitioning };
+		const float KEdgeFactors[3]{ KReference.Factor, KReference.Factor, KReference.Factor };
+		Tessellator.TessellateTri(KEdgeFactors, KReference.Factor);
+
+		char Name[128]{};
+		sprintf_s(Name, "Triangles of %s factor %g (expected %d)", KPartitioningNames[static_cast<int>(KReference.ePartitioning)],
+			KReference.Factor, static_cast<int>(KReference.TriangleCount));
+		const size_t KTriangleCount{ Tessellator.GetTriangles().size() };
+		const size_t KError{ (KTriangleCount > KReference.TriangleCount) ? KTriangleCount - KReference.TriangleCount :
+			KReference.TriangleCount - KTriangleCount };
+		FailCount += CheckBound(Output, Name, static_cast<double>(KError), 0.0);
+	}
+
+	// Culled patches
+	double CullFailCount{};
+	for (ETessellatorPartitioning ePartitioning : KPartitionings)
+	{
+		CTessellator Tessellator{ ePartitioning };
+		for (float CullingFactor : { 0.0f, -1.0f, NAN })
+		{
+			const float KEdgeFactors[3]{ 4.0f, CullingFactor, 4.0f };
+			uint32_t FixedEdgeFactors[3]{};
+			uint32_t FixedInsideFactor{};
+			if (Tessellator.TessellateTri(KEdgeFactors, 4.0f) || !Tessellator.GetTriangles().empty() ||
+				Tessellator.GetTriTriangleCount(KEdgeFactors, 4.0f) != 0 ||
+				Tessellator.QuantizeTriFactors(KEdgeFactors, 4.0f, FixedEdgeFactors, FixedInsideFactor))
+			{
+				++CullFailCount;
+			}
+		}
+	}
+	FailCount += CheckBound(Output, "Culled patches that produced output", CullFailCount, 0.0);
+
+	mt19937 Random{ 2020 };
+	uniform_real_distribution<float> Factor{ 0.5f, 70.0f };
+	uniform_real_distribution<float> Jitter{ -4.0f, 4.0f };
+	for (int iPartitioning = 0; iPartitioning < 3; ++iPartitioning)
+	{
+		CTessellator Tessellator{ KPartitionings[iPartitioning] };
+		CTessellator OtherTessellator{ KPartitionings[iPartitioning] };
+
+		// Random factor sets, then every edge factor against a few inside factors
+		vector<XMFLOAT4> vFactorSets(3'000);
+		for (XMFLOAT4& FactorSet : vFactorSets) FactorSet = XMFLOAT4(Factor(Random), Factor(Random), Factor(Random), Factor(Random));
+		for (int iEdge = 1; iEdge <= 64; ++iEdge)
+		{
+			for (int iInside = 1; iInside <= 64; iInside += 9)
+			{
+				vFactorSets.emplace_back(static_cast<float>(iEdge), static_cast<float>(iInside), static_cast<float>((iEdge + iInside) % 64 + 1),
+					static_cast<float>(iInside));
+			}
+		}
+
+		double InvalidCount{};
+		double CountMismatchCount{};
+		double QuantizationMismatchCount{};
+		size_t QuantizationComparisonCount{};
+		const char* PtrFirstProblem{};
+		for (const XMFLOAT4& KFactorSet : vFactorSets)
+		{
+			const float KEdgeFactors[3]{ KFactorSet.x, KFactorSet.y, KFactorSet.z };
+			Tessellator.TessellateTri(KEdgeFactors, KFactorSet.w);
+			if (const char* const PtrProblem = ValidateTriDomain(Tessellator, vEdges))
+			{
+				if (!PtrFirstProblem) PtrFirstProblem = PtrProblem;
+				++InvalidCount;
+			}
+			if (Tessellator.GetTriTriangleCount(KEdgeFactors, KFactorSet.w) != Tessellator.GetTriangles().size()) ++CountMismatchCount;
+
+			// Factors a few ulps away: whenever they quantize to the same values, the output must be the same bits
+			uint32_t FixedEdgeFactors[3]{};
+			uint32_t FixedInsideFactor{};
+			Tessellator.QuantizeTriFactors(KEdgeFactors, KFactorSet.w, FixedEdgeFactors, FixedInsideFactor);
+			const float KScale{ 1.0f + Jitter(Random) * FLT_EPSILON };
+			const float KOtherEdgeFactors[3]{ KEdgeFactors[0] * KScale, KEdgeFactors[1], KEdgeFactors[2] * KScale };
+			const float KOtherInsideFactor{ KFactorSet.w * KScale };
+			uint32_t OtherFixedEdgeFactors[3]{};
+			uint32_t OtherFixedInsideFactor{};
+			OtherTessellator.QuantizeTriFactors(KOtherEdgeFactors, KOtherInsideFactor, OtherFixedEdgeFactors, OtherFixedInsideFactor);
+			if (memcmp(FixedEdgeFactors, OtherFixedEdgeFactors, sizeof(FixedEdgeFactors)) == 0 && FixedInsideFactor == OtherFixedInsideFactor)
+			{
+				++QuantizationComparisonCount;
+				OtherTessellator.TessellateTri(KOtherEdgeFactors, KOtherInsideFactor);
+				const vector<XMFLOAT2>& KPoints{ Tessellator.GetDomainPoints() };
+				const vector<XMFLOAT2>& KOtherPoints{ OtherTessellator.GetDomainPoints() };
+				const vector<STriangle>& KTriangles{ Tessellator.GetTriangles() };
+				const vector<STriangle>& KOtherTriangles{ OtherTessellator.GetTriangles() };
+				if (KPoints.size() != KOtherPoints.size() || KTriangles.size() != KOtherTriangles.size() ||
+					memcmp(KPoints.data(), KOtherPoints.data(), sizeof(XMFLOAT2) * KPoints.size()) != 0 ||
+					memcmp(KTriangles.data(), KOtherTriangles.data(), sizeof(STriangle) * KTriangles.size()) != 0)
+				{
+					++QuantizationMismatchCount;
+				}
+			}
+		}
+
+		char Name[160]{};
+		sprintf_s(Name, "Invalid %s domains of %d factor sets%s%s", KPartitioningNames[iPartitioning], static_cast<int>(vFactorSets.size()),
+			(PtrFirstProblem) ? ", first: " : "", (PtrFirstProblem) ? PtrFirstProblem : "");
+		FailCount += CheckBound(Output, Name, InvalidCount, 0.0);
+		sprintf_s(Name, "Wrong %s GetTriTriangleCount()s", KPartitioningNames[iPartitioning]);
+		FailCount += CheckBound(Output, Name, CountMismatchCount, 0.0);
+		sprintf_s(Name, "Different %s outputs of %d pairs of equally quantized factors", KPartitioningNames[iPartitioning],
+			static_cast<int>(QuantizationComparisonCount));
+		FailCount += CheckBound(Output, Name, QuantizationMismatchCount, 0.0);
+	}
+	return FailCount;
+}
+
+size_t TestQuadTessellator(FILE* const Output)
+{
+	size_t FailCount{};
+	vector<uint64_t> vEdges{};
+
+	// Uniform factors that the partitioning keeps as they are make n x n quads
+	struct SReference
+	{
+		ETessellatorPartitioning	ePartitioning{};
+		float						Factor{};
+		size_t						TriangleCount{};
+	};
+	static constexpr SReference KReferences[]{ { ETessellatorPartitioning::Integer, 1.0f, 2 }, { ETessellatorPartitioning::Integer, 2.0f, 8 },
+		{ ETessellatorPartitioning::Integer, 3.0f, 18 }, { ETessellatorPartitioning::Integer, 4.0f, 32 },
+		{ ETessellatorPartitioning::Integer, 2.5f, 18 }, { ETessellatorPartitioning::FractionalOdd, 1.0f, 2 },
+		{ ETessellatorPartitioning::FractionalOdd, 3.0f, 18 }, { ETessellatorPartitioning::FractionalEven, 2.0f, 8 },
+		{ ETessellatorPartitioning::FractionalEven, 4.0f, 32 } };
+	for (const SReference& KReference : KReferences)
+	{
+		CTessellator Tessellator{ KReference.ePartitioning };
+		const float KEdgeFactors[4]{ KReference.Factor, KReference.Factor, KReference.Factor, KReference.Factor };
+		const float KInsideFactors[2]{ KReference.Factor, KReference.Factor };
+		Tessellator.TessellateQuad(KEdgeFactors, KInsideFactors);
+
+		char Name[128]{};
+		sprintf_s(Name, "Quad triangles of %s factor %g (expected %d)", KPartitioningNames[static_cast<int>(KReference.ePartitioning)],
+			KReference.Factor, static_cast<int>(KReference.TriangleCount));
+		const size_t KTriangleCount{ Tessellator.GetTriangles().size() };
+		const size_t KError{ (KTriangleCount > KReference.TriangleCount) ? KTriangleCount - KReference.TriangleCount :
+			KReference.TriangleCount - KTriangleCount };
+		FailCount += CheckBound(Output, Name, static_cast<double>(KError), 0.0);
+	}
+
+	// Culled patches
+	double CullFailCount{};
+	for (ETessellatorPartitioning ePartitioning : KPartitionings)
+	{
+		CTessellator Tessellator{ ePartitioning };
+		for (float CullingFactor : { 0.0f, -1.0f, NAN })
+		{
+			const float KEdgeFactors[4]{ 4.0f, 4.0f, CullingFactor, 4.0f };
+			const float KInsideFactors[2]{ 4.0f, 4.0f };
+			if (Tessellator.TessellateQuad(KEdgeFactors, KInsideFactors) || !Tessellator.GetTriangles().empty() ||
+				Tessellator.GetQuadTriangleCount(KEdgeFactors, KInsideFactors) != 0)
+			{
+				++CullFailCount;
+			}
+		}
+	}
+	FailCount += CheckBound(Output, "Culled quad patches that produced output", CullFailCount, 0.0);
+
+	mt19937 Random{ 2021 };
+	uniform_real_distribution<float> Factor{ 0.5f, 70.0f };
+	for (int iPartitioning = 0; iPartitioning < 3; ++iPartitioning)
+	{
+		CTessellator Tessellator{ KPartitionings[iPartitioning] };
+
+		// Random factor sets, then every edge factor against a few inside factors; the two inside factors differ so both strip axes are covered
+		struct SQuadFactorSet
+		{
+			float	EdgeFactors[4]{};
+			float	InsideFactors[2]{};
+		};
+		vector<SQuadFactorSet> vFactorSets(3'000);
+		for (SQuadFactorSet& FactorSet : vFactorSets)
+		{
+			for (float& EdgeFactor : FactorSet.EdgeFactors) EdgeFactor = Factor(Random);
+			for (float& InsideFactor : FactorSet.InsideFactors) InsideFactor = Factor(Random);
+		}
+		for (int iEdge = 1; iEdge <= 64; ++iEdge)
+		{
+			for (int iInside = 1; iInside <= 64; iInside += 9)
+			{
+				SQuadFactorSet FactorSet{};
+				FactorSet.EdgeFactors[0] = FactorSet.EdgeFactors[2] = static_cast<float>(iEdge);
+				FactorSet.EdgeFactors[1] = static_cast<float>((iEdge + iInside) % 64 + 1);
+				FactorSet.EdgeFactors[3] = static_cast<float>(iInside);
+				FactorSet.InsideFactors[0] = static_cast<float>(iInside);
+				FactorSet.InsideFactors[1] = static_cast<float>((iInside * 5) % 64 + 1);
+				vFactorSets.emplace_back(FactorSet);
+			}
+		}
+
+		double InvalidCount{};
+		double CountMismatchCount{};
+		const char* PtrFirstProblem{};
+		for (const SQuadFactorSet& KFactorSet : vFactorSets)
+		{
+			Tessellator.TessellateQuad(KFactorSet.EdgeFactors, KFactorSet.InsideFactors);
+			if (const char* const PtrProblem = ValidateQuadDomain(Tessellator, vEdges))
+			{
+				if (!PtrFirstProblem) PtrFirstProblem = PtrProblem;
+				++InvalidCount;
+			}
+			if (Tessellator.GetQuadTriangleCount(KFactorSet.EdgeFactors, KFactorSet.InsideFactors) != Tessellator.GetTriangles().size())
+			{
+				++CountMismatchCount;
+			}
+		}
+
+		char Name[160]{};
+		sprintf_s(Name, "Invalid %s quad domains of %d factor sets%s%s", KPartitioningNames[iPartitioning], static_cast<int>(vFactorSets.size()),
+			(PtrFirstProblem) ? ", first: " : "", (PtrFirstProblem) ? PtrFirstProblem : "");
+		FailCount += CheckBound(Output, Name, InvalidCount, 0.0);
+		sprintf_s(Name, "Wrong %s GetQuadTriangleCount()s", KPartitioningNames[iPartitioning]);
+		FailCount += CheckBound(Output, Name, CountMismatchCount, 0.0);
+	}
+
+	// GenerateQuadSphere() welds the two hemispheres' borders at the equator: every edge must meet its twin there or inside a patch
+	double OpenSphereCount{};
+	size_t SphereCount{};
+	for (ETessellatorPartitioning ePartitioning : KPartitionings)
+	{
+		for (float EdgeFactor : { 1.0f, 2.0f, 3.5f, 7.0f, 16.3f, 64.0f })
+		{
+			for (float InsideFactor : { 1.0f, 4.0f, 9.7f })
+			{
+				const SMesh KSphere{ GenerateQuadSphere(EdgeFactor, InsideFactor, ePartitioning) };
+				vEdges.clear();
+				for (const STriangle& KTriangle : KSphere.vTriangles)
+				{
+					const uint32_t KIndices[3]{ KTriangle.I0, KTriangle.I1, KTriangle.I2 };
+					for (int iCorner = 0; iCorner < 3; ++iCorner)
+					{
+						vEdges.emplace_back((static_cast<uint64_t>(KIndices[iCorner]) << 32) | KIndices[(iCorner + 1) % 3]);
+					}
+				}
+				sort(vEdges.begin(), vEdges.end());
+
+				bool bIsOpen{ KSphere.vTriangles.empty() || adjacent_find(vEdges.begin(), vEdges.end()) != vEdges.end() };
+				for (uint64_t Edge : vEdges)
+				{
+					if (!binary_search(vEdges.begin(), vEdges.end(), (Edge << 32) | (Edge >> 32))) bIsOpen = true;
+				}
+				if (bIsOpen) ++OpenSphereCount;
+				++SphereCount;
+			}
+		}
+	}
+	char Name[128]{};
+	sprintf_s(Name, "Quad spheres of %d factor pairs with an edge that has no twin", static_cast<int>(SphereCount));
+	FailCount += CheckBound(Output, Name, OpenSphereCount, 0.0);
+	return FailCount;
+}
+
+size_t RunSelfTests(FILE* const Output)
+{
+	size_t FailCount{};
+	FailCount += TestVertexPacking(Output);
+	FailCount += TestTessellator(Output);
+	FailCount += TestQuadTessellator(Output);
+	fprintf(Output, "%d check(s) failed\n", static_cast<int>(FailCount));
+	return FailCount;
+}
+
+void BenchmarkTessellator(FILE* const Output)
+{
+	// The first edge factor varies a little, as it does between the patches of an object tessellated by distance
+	for (int iPartitioning = 0; iPartitioning < 3; ++iPartitioning)
+	{
+		CTessellator Tessellator{ KPartitionings[iPartitioning] };
+		for (float Factor : { 4.0f, 16.0f, 63.0f })
+		{
+			const int KPatchCount{ (Factor > 32.0f) ? 2'000 : 20'000 };
+			float EdgeFactors[3]{ Factor, Factor * 0.9f, Factor * 0.8f };
+			size_t TriangleCount{};
+			const auto KBegin{ steady_clock::now() };
+			for (int iPatch = 0; iPatch < KPatchCount; ++iPatch)
+			{
+				EdgeFactors[0] = Factor - static_cast<float>(iPatch & 7) * 0.1f;
+				Tessellator.TessellateTri(EdgeFactors, Factor);
+				TriangleCount += Tessellator.GetTriangles().size();
+			}
+			const double KSeconds{ duration<double>(steady_clock::now() - KBegin).count() };
+			fprintf(Output, "%s factor %g: %.0f patches/s, %.1f M triangles/s\n", KPartitioningNames[iPartitioning], Factor,
+				KPatchCount / KSeconds, TriangleCount / KSeconds * 1e-6);
+		}
+	}
+}
+
+// The per-triangle loop that picking ran before IntersectRayTriangles()
+static bool IntersectRayTrianglesReference(const XMVECTOR& RayOrigin, const XMVECTOR& RayDirection, const SMesh& Mesh, SRayTriangleHit& OutHit)
+{
+	OutHit = SRayTriangleHit();
+	for (size_t iTriangle = 0; iTriangle < Mesh.vTriangles.size(); ++iTriangle)
+	{
+		const STriangle& KTriangle{ Mesh.vTriangles[iTriangle] };
+		XMVECTOR T{};
+		if (IntersectRayTriangle(RayOrigin, RayDirection, Mesh.vVertices[KTriangle.I0].Position, Mesh.vVertices[KTriangle.I1].Position,
+			Mesh.vVertices[KTriangle.I2].Position, &T) && XMVectorGetX(T) < OutHit.T)
+		{
+			OutHit.T = XMVectorGetX(T);
+			OutHit.TriangleIndex = static_cast<uint32_t>(iTriangle);
+		}
+	}
+	return OutHit.TriangleIndex != UINT32_MAX;
+}
+
+void BenchmarkRayTriangles(FILE* const Output)
+{
+	using namespace RayTriangleSoAInternal;
+
+	// The fast kernels are timed over several passes, so that each timing is long enough to measure
+	static constexpr int KRayCount{ 500 };
+	static constexpr int KPassCount{ 20 };
+
+	mt19937 Random{ 2020 };
+	uniform_real_distribution<float> Unit{ -1.0f, 1.0f };
+	for (uint32_t SubdivisionLevel : { 3u, 5u })
+	{
+		const SMesh KMesh{ GenerateIcosphere(SubdivisionLevel) };
+		const STriangleSoA KTriangles{ ConvertMeshToTriangleSoA(KMesh) };
+		const size_t KPaddedCount{ KTriangles.GetPaddedTriangleCount() };
+
+		// From outside the sphere towards random points around its center; most hit, some pass it by
+		vector<XMVECTOR> vOrigins(KRayCount);
+		vector<XMVECTOR> vDirections(KRayCount);
+		for (int iRay = 0; iRay < KRayCount; ++iRay)
+		{
+			vOrigins[iRay] = XMVectorSetW(GetRandomDirection(Random) * 3.0f, 1.0f);
+			vDirections[iRay] = XMVectorSet(Unit(Random), Unit(Random), Unit(Random), 0.0f) * 1.1f - XMVectorSetW(vOrigins[iRay], 0.0f);
+		}
+
+		vector<SRayTriangleHit> vReferenceHits(KRayCount);
+		auto Begin{ steady_clock::now() };
+		for (int iRay = 0; iRay < KRayCount; ++iRay) IntersectRayTrianglesReference(vOrigins[iRay], vDirections[iRay], KMesh, vReferenceHits[iRay]);
+		const double KReferenceSeconds{ duration<double>(steady_clock::now() - Begin).count() };
+
+		vector<SRayTriangleHit> vHits4(KRayCount);
+		Begin = steady_clock::now();
+		for (int iPass = 0; iPass < KPassCount; ++iPass)
+		{
+			for (int iRay = 0; iRay < KRayCount; ++iRay)
+			{
+				vHits4[iRay] = SRayTriangleHit();
+				IntersectSSE(MakeShearedRay(vOrigins[iRay], vDirections[iRay]), KTriangles, 0, KPaddedCount, vHits4[iRay]);
+			}
+		}
+		const double KSeconds4{ duration<double>(steady_clock::now() - Begin).count() / KPassCount };
+
+		vector<SRayTriangleHit> vHits8(KRayCount);
+		double Seconds8{};
+		if (IsAVX2Supported())
+		{
+			Begin = steady_clock::now();
+			for (int iPass = 0; iPass < KPassCount; ++iPass)
+			{
+				for (int iRay = 0; iRay < KRayCount; ++iRay)
+				{
+					vHits8[iRay] = SRayTriangleHit();
+					IntersectAVX2(MakeShearedRay(vOrigins[iRay], vDirections[iRay]), KTriangles, 0, KPaddedCount, vHits8[iRay]);
+				}
+			}
+			Seconds8 = duration<double>(steady_clock::now() - Begin).count() / KPassCount;
+		}
+
+		// The same triangle may be reported for rays through a shared edge or vertex only, so the distances are compared
+		double ReferenceMismatchCount{};
+		double WidthMismatchCount{};
+		int HitCount{};
+		for (int iRay = 0; iRay < KRayCount; ++iRay)
+		{
+			const SRayTriangleHit& KReference{ vReferenceHits[iRay] };
+			const SRayTriangleHit& KHit{ vHits4[iRay] };
+			if (KHit.TriangleIndex != UINT32_MAX) ++HitCount;
+			if ((KReference.TriangleIndex == UINT32_MAX) != (KHit.TriangleIndex == UINT32_MAX) ||
+				(KHit.TriangleIndex != UINT32_MAX && fabsf(KReference.T - KHit.T) > 1e-4f))
+			{
+				++ReferenceMismatchCount;
+			}
+			if (IsAVX2Supported() && memcmp(&vHits8[iRay], &KHit, sizeof(SRayTriangleHit)) != 0) ++WidthMismatchCount;
+		}
+
+		const double KMicroseconds{ 1e6 / KRayCount };
+		fprintf(Output, "icosphere %d triangles, %d rays (%d hit): IntersectRayTriangle() loop %.2f us/ray, 4-wide %.2f us/ray, ",
+			static_cast<int>(KMesh.vTriangles.size()), KRayCount, HitCount, KReferenceSeconds * KMicroseconds, KSeconds4 * KMicroseconds);
+		if (IsAVX2Supported())
+		{
+			fprintf(Output, "8-wide %.2f us/ray\n", Seconds8 * KMicroseconds);
+		}
+		else
+		{
+			fprintf(Output, "8-wide skipped (no AVX2)\n");
+		}
+		CheckBound(Output, "Rays whose hit differs from the IntersectRayTriangle() loop", ReferenceMismatchCount, 0.0);
+		if (IsAVX2Supported()) CheckBound(Output, "Rays whose 4- and 8-wide hits differ", WidthMismatchCount, 0.0);
+	}
+}
+
+static string GetPositionKeyReference(const XMVECTOR& Position)
+{
+	return to_string(XMVectorGetX(Position)) + "#" + to_string(XMVectorGetY(Position)) + "#" +
+		to_string(XMVectorGetZ(Position)) + "#" + to_string(XMVectorGetW(Position));
+}
+
+// The string-keyed averaging that AverageNormals() ran before CPositionWelder
+static void AverageNormalsReference(SMesh& Mesh)
+{
+	unordered_map<string, vector<XMVECTOR>> mapVertexToNormals{};
+	for (const STriangle& Triangle : Mesh.vTriangles)
+	{
+		for (uint32_t Index : { Triangle.I0, Triangle.I1, Triangle.I2 })
+		{
+			const SVertex3D& KVertex{ Mesh.vVertices[Index] };
+			vector<XMVECTOR>& vNormals{ mapVertexToNormals[GetPositionKeyReference(KVertex.Position)] };
+			if (std::find(vNormals.begin(), vNormals.end(), KVertex.Normal) == vNormals.end()) vNormals.emplace_back(KVertex.Normal);
+		}
+	}
+
+	for (SVertex3D& Vertex : Mesh.vVertices)
+	{
+		const vector<XMVECTOR>& vNormals{ mapVertexToNormals[GetPositionKeyReference(Vertex.Position)] };
+		XMVECTOR NormalSum{};
+		for (const XMVECTOR& Normal : vNormals)
+		{
+			NormalSum += Normal;
+		}
+		Vertex.Normal = NormalSum / (float)vNormals.size();
+	}
+}
+
+// Heightfield with 4 vertices per cell, as the terrain generator made before its cells shared corners
+static SMesh GenerateBumpyTerrainReference(int CellCount)
+{
+	SMesh Mesh{};
+	Mesh.vVertices.reserve((size_t)CellCount * CellCount * 4);
+	Mesh.vTriangles.reserve((size_t)CellCount * CellCount * 2);
+	for (int z = 0; z < CellCount; ++z)
+	{
+		for (int x = 0; x < CellCount; ++x)
+		{
+			const uint32_t KFirstIndex{ static_cast<uint32_t>(Mesh.vVertices.size()) };
+			for (int iCorner = 0; iCorner < 4; ++iCorner)
+			{
+				const float KX{ static_cast<float>(x + (iCorner & 1)) };
+				const float KZ{ static_cast<float>(z + (iCorner >> 1)) };
+				SVertex3D Vertex{};
+				Vertex.Position = XMVectorSet(KX, sinf(KX * 0.37f) * cosf(KZ * 0.23f) * 2.0f, 0.0f - KZ, 1.0f);
+				Mesh.vVertices.emplace_back(Vertex);
+			}
+			Mesh.vTriangles.emplace_back(KFirstIndex, KFirstIndex + 1, KFirstIndex + 2);
+			Mesh.vTriangles.emplace_back(KFirstIndex + 1, KFirstIndex + 3, KFirstIndex + 2);
+		}
+	}
+	CalculateNormals(Mesh);
+	return Mesh;
+}
+
+void BenchmarkAverageNormals(FILE* const Output)
+{
+	SMesh Sphere{ GenerateSphere(64) };
+	CalculateNormals(Sphere);
+	const SMesh KMeshes[2]{ Sphere, GenerateBumpyTerrainReference(256) };
+	const char* const KMeshNames[2]{ "sphere 64", "terrain 256" };
+	for (int iMesh = 0; iMesh < 2; ++iMesh)
+	{
+		SMesh ReferenceMesh{ KMeshes[iMesh] };
+		auto Begin{ steady_clock::now() };
+		AverageNormalsReference(ReferenceMesh);
+		const double KReferenceSeconds{ duration<double>(steady_clock::now() - Begin).count() };
+
+		SMesh Mesh{ KMeshes[iMesh] };
+		Begin = steady_clock::now();
+		AverageNormals(Mesh);
+		const double KSeconds{ duration<double>(steady_clock::now() - Begin).count() };
+
+		// The string keys tell -0 from 0 (as at the sphere's poles) and split positions closer than the weld epsilon,
+		// so weld groups whose positions don't share one key are left out of the comparison
+		CPositionWelder Welder{};
+		const size_t KGroupCount{ Welder.Weld(Mesh.vVertices) };
+		vector<bool> vIsGroupSplit(KGroupCount);
+		for (size_t iVertex = 0; iVertex < Mesh.vVertices.size(); ++iVertex)
+		{
+			const uint32_t KGroup{ Welder.GetGroup(iVertex) };
+			if (GetPositionKeyReference(Mesh.vVertices[iVertex].Position) !=
+				GetPositionKeyReference(Mesh.vVertices[Welder.GetGroupRepresentative(KGroup)].Position))
+			{
+				vIsGroupSplit[KGroup] = true;
+			}
+		}
+
+		double MaxDifference{};
+		size_t ComparedCount{};
+		for (size_t iVertex = 0; iVertex < Mesh.vVertices.size(); ++iVertex)
+		{
+			if (vIsGroupSplit[Welder.GetGroup(iVertex)]) continue;
+
+			const XMVECTOR KDifference{ Mesh.vVertices[iVertex].Normal - ReferenceMesh.vVertices[iVertex].Normal };
+			MaxDifference = max(MaxDifference, static_cast<double>(XMVectorGetX(XMVector3Length(KDifference))));
+			++ComparedCount;
+		}
+
+		fprintf(Output, "%s, %d vertices: string-keyed averaging %.2f ms, AverageNormals() %.2f ms\n", KMeshNames[iMesh],
+			static_cast<int>(Mesh.vVertices.size()), KReferenceSeconds * 1e3, KSeconds * 1e3);
+		char Name[128]{};
+		sprintf_s(Name, "Largest normal difference from the string-keyed averaging over %d vertices", static_cast<int>(ComparedCount));
+		CheckBound(Output, Name, MaxDifference, 1e-5);
+	}
+}
+
+void RunBenchmarks(FILE* const Output)
+{
+	BenchmarkTessellator(Output);
+	BenchmarkRayTriangles(Output);
+	BenchmarkAverageNormals(Output);
+}
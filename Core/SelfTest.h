@@ -0,0 +1,33 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include <cstdio>
+
+// Headless checks of the CPU-side kernels against the error bounds and invariants that their headers document.
+// main.cpp runs them instead of the editor when the executable is started with "-test", and returns the number of failed checks;
+// "-bench" runs the benchmarks instead. Every check prints one line to Output. Inputs come from fixed seeds, so every run checks the same data.
+
+// Round trip of every SPackedVertex3D format (see VertexPacking.h)
+size_t TestVertexPacking(FILE* const Output);
+// CTessellator's tri domain for every partitioning, over reference and seeded random factor sets:
+// the known triangle counts of uniform integer factors, a closed and consistently oriented domain that uses every point,
+// GetTriTriangleCount(), culling, and identical output for factors that QuantizeTriFactors() maps to the same values
+size_t TestTessellator(FILE* const Output);
+// The same for the quad domain: the known triangle counts of uniform factors, a closed and consistently oriented domain of area 1
+// that uses every point, GetQuadTriangleCount(), culling, and GenerateQuadSphere() closing at the equator where its patches meet
+size_t TestQuadTessellator(FILE* const Output);
+
+// All of the above
+size_t RunSelfTests(FILE* const Output);
+
+// Tri-domain patches and triangles per second of CTessellator, per partitioning
+void BenchmarkTessellator(FILE* const Output);
+// Ray/triangle tests per second of IntersectRayTriangles()'s 4- and 8-wide kernels against a loop of IntersectRayTriangle() (Math.h)
+// over the same icospheres and seeded rays, and whether they find the same hits
+void BenchmarkRayTriangles(FILE* const Output);
+// AverageNormals() (CPositionWelder) against the string-keyed averaging it replaced, on a sphere and a terrain with 4 vertices per cell,
+// and the largest difference between their normals
+void BenchmarkAverageNormals(FILE* const Output);
+
+// All of the above
+void RunBenchmarks(FILE* const Output);
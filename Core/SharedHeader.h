@@ -43,7 +43,7 @@ struct SVertex3D
 	XMVECTOR TexCoord{};
 	XMVECTOR Normal{};
 	XMVECTOR Tangent{};
-	// Bitangent is calculated dynamically using Normal and Tangent
+	// Bitangent is calculated dynamically: Tangent.w * cross(Normal, Tangent), where w == 0 counts as +1
 };
 
 struct STriangle
@@ -68,8 +68,13 @@ struct SBoundingSphere
 {
 	static constexpr float KDefaultRadius{ 1.0f };
 
+	// World space, computed from the object's tight bounds (see CObject3D::UpdateWorldMatrix())
 	float		Radius{ KDefaultRadius };
+	XMVECTOR	Center{};
+
+	// Scales the tight bounds
 	float		RadiusBias{ KDefaultRadius };
+	// Pivot of the object's rotation and of the gizmos, relative to ComponentTransform.Translation
 	XMVECTOR	CenterOffset{};
 };
 
@@ -0,0 +1,210 @@
+#include "TangentGenerator.h"
+#include "ThreadPool.h"
+
+using std::vector;
+using std::unordered_map;
+using std::function;
+using std::min;
+using std::max;
+
+// Corner orientations
+static constexpr uint8_t KOrientationNegative{ 0 };
+static constexpr uint8_t KOrientationPositive{ 1 };
+static constexpr uint8_t KOrientationNone{ 2 };
+
+static constexpr uint32_t KInvalidIndex{ UINT32_MAX };
+
+size_t CTangentGenerator::SVertexKeyHash::operator()(const SVertexKey& Key) const
+{
+	// FNV-1a over the bytes
+	size_t Hash{ 2166136261u };
+	const uint8_t* const KPtrBytes{ reinterpret_cast<const uint8_t*>(Key.Values) };
+	for (size_t iByte = 0; iByte < sizeof(Key.Values); ++iByte)
+	{
+		Hash = (Hash ^ KPtrBytes[iByte]) * 16777619u;
+	}
+	return Hash;
+}
+
+void CTangentGenerator::Generate(SMesh& Mesh, CThreadPool* const PtrThreadPool)
+{
+	m_SplitVertexCount = 0;
+
+	const size_t KVertexCount{ Mesh.vVertices.size() };
+	const size_t KTriangleCount{ Mesh.vTriangles.size() };
+	if (KVertexCount == 0) return;
+
+	// Vertices that only differ by index share their frame
+	vector<uint32_t> vVertexGroups(KVertexCount);
+	size_t GroupCount{};
+	{
+		unordered_map<SVertexKey, uint32_t, SVertexKeyHash> umGroups{};
+		umGroups.reserve(KVertexCount);
+		for (size_t iVertex = 0; iVertex < KVertexCount; ++iVertex)
+		{
+			const SVertex3D& KVertex{ Mesh.vVertices[iVertex] };
+			SVertexKey Key{};
+			XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(&Key.Values[0]), KVertex.Position);
+			XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(&Key.Values[3]), KVertex.Normal);
+			XMStoreFloat2(reinterpret_cast<XMFLOAT2*>(&Key.Values[6]), KVertex.TexCoord);
+
+			auto Inserted{ umGroups.emplace(Key, static_cast<uint32_t>(GroupCount)) };
+			if (Inserted.second) ++GroupCount;
+			vVertexGroups[iVertex] = Inserted.first->second;
+		}
+	}
+
+	// Per corner: the face tangent projected onto the vertex normal, times the corner angle
+	vector<XMFLOAT3> vCornerTangents(KTriangleCount * 3);
+	vector<uint8_t> vCornerOrientations(KTriangleCount * 3);
+	ParallelFor(PtrThreadPool, KTriangleCount, [&](size_t Begin, size_t End)
+		{
+			for (size_t iTriangle = Begin; iTriangle < End; ++iTriangle)
+			{
+				const STriangle& KTriangle{ Mesh.vTriangles[iTriangle] };
+				const SVertex3D* const KPtrVertices[3]{ &Mesh.vVertices[KTriangle.I0], &Mesh.vVertices[KTriangle.I1], &Mesh.vVertices[KTriangle.I2] };
+
+				const XMVECTOR KEdge01{ KPtrVertices[1]->Position - KPtrVertices[0]->Position };
+				const XMVECTOR KEdge02{ KPtrVertices[2]->Position - KPtrVertices[0]->Position };
+				const XMVECTOR KUV01{ KPtrVertices[1]->TexCoord - KPtrVertices[0]->TexCoord };
+				const XMVECTOR KUV02{ KPtrVertices[2]->TexCoord - KPtrVertices[0]->TexCoord };
+
+				// Edge01 = U01 * Tangent + V01 * Bitangent
+				// Edge02 = U02 * Tangent + V02 * Bitangent
+				// -> Tangent = (V02 * Edge01 - V01 * Edge02) / (U01 * V02 - V01 * U02)
+				const float KSignedUVArea{ XMVectorGetX(KUV01) * XMVectorGetY(KUV02) - XMVectorGetY(KUV01) * XMVectorGetX(KUV02) };
+				XMVECTOR FaceTangent{ XMVectorGetY(KUV02) * KEdge01 - XMVectorGetY(KUV01) * KEdge02 };
+				if (KSignedUVArea < 0.0f) FaceTangent = -FaceTangent;
+
+				uint8_t Orientation{ (KSignedUVArea > 0.0f) ? KOrientationPositive : KOrientationNegative };
+				if (KSignedUVArea == 0.0f || XMVector3Equal(FaceTangent, XMVectorZero())) Orientation = KOrientationNone;
+
+				for (int iCorner = 0; iCorner < 3; ++iCorner)
+				{
+					const size_t KCorner{ iTriangle * 3 + iCorner };
+					vCornerOrientations[KCorner] = Orientation;
+					vCornerTangents[KCorner] = XMFLOAT3();
+					if (Orientation == KOrientationNone) continue;
+
+					const SVertex3D& KVertex{ *KPtrVertices[iCorner] };
+					const XMVECTOR KNormal{ XMVector3Normalize(KVertex.Normal) };
+					auto Project{ [&](const XMVECTOR& V) { return V - KNormal * XMVector3Dot(KNormal, V); } };
+
+					const XMVECTOR KTangent{ Project(FaceTangent) };
+					if (XMVector3Equal(KTangent, XMVectorZero())) continue;
+
+					const XMVECTOR KToNext{ XMVector3Normalize(Project(KPtrVertices[(iCorner + 1) % 3]->Position - KVertex.Position)) };
+					const XMVECTOR KToPrev{ XMVector3Normalize(Project(KPtrVertices[(iCorner + 2) % 3]->Position - KVertex.Position)) };
+					const float KAngle{ acosf(max(-1.0f, min(XMVectorGetX(XMVector3Dot(KToNext, KToPrev)), 1.0f))) };
+
+					XMStoreFloat3(&vCornerTangents[KCorner], XMVector3Normalize(KTangent) * KAngle);
+				}
+			}
+		});
+
+	// Group -> corners, in corner order (counting sort)
+	vector<uint32_t> vGroupCornerOffsets(GroupCount + 1);
+	for (const STriangle& Triangle : Mesh.vTriangles)
+	{
+		++vGroupCornerOffsets[vVertexGroups[Triangle.I0] + 1];
+		++vGroupCornerOffsets[vVertexGroups[Triangle.I1] + 1];
+		++vGroupCornerOffsets[vVertexGroups[Triangle.I2] + 1];
+	}
+	for (size_t iGroup = 0; iGroup < GroupCount; ++iGroup)
+	{
+		vGroupCornerOffsets[iGroup + 1] += vGroupCornerOffsets[iGroup];
+	}
+	vector<uint32_t> vGroupCorners(KTriangleCount * 3);
+	{
+		vector<uint32_t> vCursors(vGroupCornerOffsets.begin(), vGroupCornerOffsets.end() - 1);
+		for (size_t iTriangle = 0; iTriangle < KTriangleCount; ++iTriangle)
+		{
+			const STriangle& KTriangle{ Mesh.vTriangles[iTriangle] };
+			vGroupCorners[vCursors[vVertexGroups[KTriangle.I0]]++] = static_cast<uint32_t>(iTriangle * 3 + 0);
+			vGroupCorners[vCursors[vVertexGroups[KTriangle.I1]]++] = static_cast<uint32_t>(iTriangle * 3 + 1);
+			vGroupCorners[vCursors[vVertexGroups[KTriangle.I2]]++] = static_cast<uint32_t>(iTriangle * 3 + 2);
+		}
+	}
+
+	// Gather: one sum per group and orientation
+	vector<XMFLOAT3> vGroupTangents(GroupCount * 2);
+	vector<uint8_t> vGroupOrientationMasks(GroupCount);
+	ParallelFor(PtrThreadPool, GroupCount, [&](size_t Begin, size_t End)
+		{
+			for (size_t iGroup = Begin; iGroup < End; ++iGroup)
+			{
+				XMVECTOR Sums[2]{ XMVectorZero(), XMVectorZero() };
+				uint8_t OrientationMask{};
+				for (uint32_t iCorner = vGroupCornerOffsets[iGroup]; iCorner < vGroupCornerOffsets[iGroup + 1]; ++iCorner)
+				{
+					const uint32_t KCorner{ vGroupCorners[iCorner] };
+					const uint8_t KOrientation{ vCornerOrientations[KCorner] };
+					if (KOrientation == KOrientationNone) continue;
+
+					Sums[KOrientation] += XMLoadFloat3(&vCornerTangents[KCorner]);
+					OrientationMask |= (1 << KOrientation);
+				}
+				XMStoreFloat3(&vGroupTangents[iGroup * 2 + 0], Sums[0]);
+				XMStoreFloat3(&vGroupTangents[iGroup * 2 + 1], Sums[1]);
+				vGroupOrientationMasks[iGroup] = OrientationMask;
+			}
+		});
+
+	// Corners of mirrored triangles get their own copy of vertices that unmirrored triangles also use
+	vector<uint32_t> vMirroredCopies(KVertexCount, KInvalidIndex);
+	for (size_t iTriangle = 0; iTriangle < KTriangleCount; ++iTriangle)
+	{
+		if (vCornerOrientations[iTriangle * 3] != KOrientationNegative) continue;
+
+		STriangle& Triangle{ Mesh.vTriangles[iTriangle] };
+		for (uint32_t* const PtrIndex : { &Triangle.I0, &Triangle.I1, &Triangle.I2 })
+		{
+			if (vGroupOrientationMasks[vVertexGroups[*PtrIndex]] != 3) continue;
+
+			if (vMirroredCopies[*PtrIndex] == KInvalidIndex)
+			{
+				const SVertex3D KCopy{ Mesh.vVertices[*PtrIndex] };
+				vMirroredCopies[*PtrIndex] = static_cast<uint32_t>(Mesh.vVertices.size());
+				Mesh.vVertices.emplace_back(KCopy);
+				++m_SplitVertexCount;
+			}
+			*PtrIndex = vMirroredCopies[*PtrIndex];
+		}
+	}
+
+	auto WriteTangent{ [&](SVertex3D& Vertex, uint32_t Group, uint8_t Orientation)
+		{
+			XMVECTOR Tangent{ XMLoadFloat3(&vGroupTangents[Group * 2 + Orientation]) };
+			if (XMVector3Equal(Tangent, XMVectorZero()))
+			{
+				// Any direction perpendicular to the normal
+				const XMVECTOR KNormal{ XMVector3Normalize(Vertex.Normal) };
+				const XMVECTOR KAxis{ (fabsf(XMVectorGetX(KNormal)) < 0.9f) ? XMVectorSet(1, 0, 0, 0) : XMVectorSet(0, 0, 1, 0) };
+				Tangent = KAxis - KNormal * XMVector3Dot(KNormal, KAxis);
+			}
+			Vertex.Tangent = XMVectorSetW(XMVector3Normalize(Tangent), (Orientation == KOrientationPositive) ? +1.0f : -1.0f);
+		}
+	};
+	ParallelFor(PtrThreadPool, KVertexCount, [&](size_t Begin, size_t End)
+		{
+			for (size_t iVertex = Begin; iVertex < End; ++iVertex)
+			{
+				const uint32_t KGroup{ vVertexGroups[iVertex] };
+				const uint8_t KMask{ vGroupOrientationMasks[KGroup] };
+				WriteTangent(Mesh.vVertices[iVertex], KGroup, (KMask == (1 << KOrientationNegative)) ? KOrientationNegative : KOrientationPositive);
+				if (vMirroredCopies[iVertex] != KInvalidIndex) WriteTangent(Mesh.vVertices[vMirroredCopies[iVertex]], KGroup, KOrientationNegative);
+			}
+		});
+}
+
+void CTangentGenerator::ParallelFor(CThreadPool* const PtrThreadPool, size_t Count, const function<void(size_t, size_t)>& Function) const
+{
+	if (PtrThreadPool && Count > KGrainSize)
+	{
+		PtrThreadPool->ParallelFor(Count, KGrainSize, Function);
+	}
+	else
+	{
+		Function(0, Count);
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include <functional>
+#include <cstring>
+
+class CThreadPool;
+
+// Per-vertex tangent frames compatible with MikkTSpace (Mikkelsen 2008), so normal maps baked by Mikk-based tools shade correctly.
+//  - Vertices with identical position, normal and texture coordinates are treated as one, whatever their indices.
+//  - Each triangle corner contributes its face tangent projected onto the vertex normal, weighted by the corner angle.
+//  - Triangles whose UVs are mirrored (negative UV area) are accumulated apart from the others, and vertices shared by both kinds are split.
+//  - Triangles with zero UV area contribute nothing; vertices that only belong to such triangles get any tangent perpendicular to the normal.
+// Tangent.w receives the bitangent sign: bitangent = Tangent.w * cross(Normal, Tangent).
+// Corner values are computed per triangle and gathered per vertex through a vertex -> corner table in corner order,
+// so the result does not depend on the thread count.
+class CTangentGenerator
+{
+	struct SVertexKey
+	{
+		float		Values[8]{};
+
+		bool operator==(const SVertexKey& B) const { return memcmp(Values, B.Values, sizeof(Values)) == 0; }
+	};
+
+	struct SVertexKeyHash
+	{
+		size_t operator()(const SVertexKey& Key) const;
+	};
+
+public:
+	CTangentGenerator() {}
+	~CTangentGenerator() {}
+
+public:
+	// Normals must be set beforehand. Vertices may be appended (see above); existing indices stay valid.
+	void Generate(SMesh& Mesh, CThreadPool* const PtrThreadPool = nullptr);
+
+	// Vertices appended by the last Generate() where mirrored and unmirrored triangles met
+	size_t GetSplitVertexCount() const { return m_SplitVertexCount; }
+
+private:
+	void ParallelFor(CThreadPool* const PtrThreadPool, size_t Count, const std::function<void(size_t, size_t)>& Function) const;
+
+public:
+	static constexpr size_t KGrainSize{ 4096 };
+
+private:
+	size_t		m_SplitVertexCount{};
+};
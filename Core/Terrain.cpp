@@ -0,0 +1,353 @@
+#include "Terrain.h"
+#include "ThreadPool.h"
+#include "Math.h"
+
+using std::vector;
+using std::future;
+using std::max;
+using std::min;
+
+// Integer lattice hash -> [0, 1)
+static float HashLattice(int32_t X, int32_t Z, uint32_t Seed)
+{
+	uint32_t Hash{ static_cast<uint32_t>(X) * 0x8DA6B343u ^ static_cast<uint32_t>(Z) * 0xD8163841u ^ Seed * 0xCB1AB31Fu };
+	Hash ^= Hash >> 16;
+	Hash *= 0x7FEB352Du;
+	Hash ^= Hash >> 15;
+	Hash *= 0x846CA68Bu;
+	Hash ^= Hash >> 16;
+	return static_cast<float>(Hash >> 8) * (1.0f / 16777216.0f);
+}
+
+static float SampleValueNoise(float X, float Z, uint32_t Seed)
+{
+	const float KFloorX{ floorf(X) };
+	const float KFloorZ{ floorf(Z) };
+	const int32_t KX{ static_cast<int32_t>(KFloorX) };
+	const int32_t KZ{ static_cast<int32_t>(KFloorZ) };
+
+	// Quintic fade, so the surface normal is continuous across lattice cells
+	auto Fade{ [](float T) { return T * T * T * (T * (T * 6.0f - 15.0f) + 10.0f); } };
+	const float KU{ Fade(X - KFloorX) };
+	const float KV{ Fade(Z - KFloorZ) };
+
+	const float KLower{ Lerp(HashLattice(KX, KZ, Seed), HashLattice(KX + 1, KZ, Seed), KU) };
+	const float KUpper{ Lerp(HashLattice(KX, KZ + 1, Seed), HashLattice(KX + 1, KZ + 1, Seed), KU) };
+	return Lerp(KLower, KUpper, KV);
+}
+
+float CTerrain::GetHeight(const STerrainDesc& Desc, float X, float Z)
+{
+	float Sum{};
+	float Amplitude{ 1.0f };
+	float AmplitudeSum{};
+	float Frequency{ Desc.NoiseFrequency };
+	for (uint32_t iOctave = 0; iOctave < Desc.NoiseOctaveCount; ++iOctave)
+	{
+		Sum += Amplitude * (SampleValueNoise(X * Frequency, Z * Frequency, Desc.Seed + iOctave) * 2.0f - 1.0f);
+		AmplitudeSum += Amplitude;
+		Amplitude *= 0.5f;
+		Frequency *= 2.0f;
+	}
+	return (AmplitudeSum > 0.0f) ? Desc.HeightScale * Sum / AmplitudeSum : 0.0f;
+}
+
+uint64_t CTerrain::MakeKey(int32_t ChunkX, int32_t ChunkZ)
+{
+	return (static_cast<uint64_t>(static_cast<uint32_t>(ChunkX)) << 32) | static_cast<uint32_t>(ChunkZ);
+}
+
+// Chunk (X, Z) covers [X, X + 1] * ChunkSize along x and [Z, Z + 1] * ChunkSize along z.
+// Rows run towards -z like GenerateTerrainBase(), and texture coordinates restart per chunk (the wrap sampler tiles them per cell).
+// Vertices sit on the global lattice (index * CellSize), so neighboring chunks compute their shared border from the same coordinates.
+CTerrain::SChunkData CTerrain::GenerateChunk(const STerrainDesc& Desc, int32_t ChunkX, int32_t ChunkZ)
+{
+	const uint32_t KVertexCountPerSide{ Desc.ChunkCellCount + 1 };
+	const int64_t KOriginX{ static_cast<int64_t>(ChunkX) * Desc.ChunkCellCount };
+	const int64_t KOriginZ{ (static_cast<int64_t>(ChunkZ) + 1) * Desc.ChunkCellCount };
+	const XMVECTOR KColor{ XMLoadFloat4(&Desc.Color) };
+
+	// Heights with a border of one cell, so that every vertex takes its central differences from the grid
+	// instead of evaluating the noise four more times
+	const uint32_t KHeightCountPerSide{ KVertexCountPerSide + 2 };
+	vector<float> vHeights(static_cast<size_t>(KHeightCountPerSide) * KHeightCountPerSide);
+	for (uint32_t z = 0; z < KHeightCountPerSide; ++z)
+	{
+		const float KZ{ static_cast<float>(KOriginZ - (static_cast<int64_t>(z) - 1)) * Desc.CellSize };
+		for (uint32_t x = 0; x < KHeightCountPerSide; ++x)
+		{
+			const float KX{ static_cast<float>(KOriginX + (static_cast<int64_t>(x) - 1)) * Desc.CellSize };
+			vHeights[static_cast<size_t>(z) * KHeightCountPerSide + x] = GetHeight(Desc, KX, KZ);
+		}
+	}
+
+	SChunkData Data{};
+	Data.vVertices.resize(static_cast<size_t>(KVertexCountPerSide) * KVertexCountPerSide);
+	Data.MinHeight = FLT_MAX;
+	Data.MaxHeight = -FLT_MAX;
+
+	SVertex3D* PtrVertex{ Data.vVertices.data() };
+	for (uint32_t z = 0; z < KVertexCountPerSide; ++z)
+	{
+		for (uint32_t x = 0; x < KVertexCountPerSide; ++x)
+		{
+			const float KX{ static_cast<float>(KOriginX + x) * Desc.CellSize };
+			const float KZ{ static_cast<float>(KOriginZ - z) * Desc.CellSize };
+			const float* const KPtrHeight{ &vHeights[static_cast<size_t>(z + 1) * KHeightCountPerSide + (x + 1)] };
+			const float KHeight{ *KPtrHeight };
+
+			// Rows run towards -z, so the row before is at z + CellSize
+			const float KDX{ (KPtrHeight[1] - KPtrHeight[-1]) / (2.0f * Desc.CellSize) };
+			const float KDZ{ (KPtrHeight[-static_cast<ptrdiff_t>(KHeightCountPerSide)] - KPtrHeight[KHeightCountPerSide]) / (2.0f * Desc.CellSize) };
+
+			PtrVertex->Position = XMVectorSet(KX, KHeight, KZ, 1);
+			PtrVertex->Color = KColor;
+			PtrVertex->TexCoord = XMVectorSet(static_cast<float>(x), static_cast<float>(z), 0, 0);
+			PtrVertex->Normal = XMVector3Normalize(XMVectorSet(-KDX, 1, -KDZ, 0));
+			PtrVertex->Tangent = XMVectorSetW(XMVector3Normalize(XMVectorSet(1, KDX, 0, 0)), 1.0f);
+			++PtrVertex;
+
+			Data.MinHeight = min(Data.MinHeight, KHeight);
+			Data.MaxHeight = max(Data.MaxHeight, KHeight);
+		}
+	}
+	return Data;
+}
+
+void CTerrain::Create(const STerrainDesc& Desc)
+{
+	// Pending chunks belong to the old desc; their tasks only hold copies of it, so they are simply dropped
+	m_umPendingChunks.clear();
+	m_umChunks.clear();
+	m_lLRUKeys.clear();
+	m_vFreeVertexBuffers.clear();
+	m_vVisibleChunks.clear();
+	m_Stats = STerrainStats();
+
+	m_Desc = Desc;
+	m_Desc.ChunkCellCount = max(min(m_Desc.ChunkCellCount, (uint32_t)254), (uint32_t)1);
+	m_Desc.CellSize = max(m_Desc.CellSize, 0.001f);
+
+	const uint32_t KVertexCountPerSide{ m_Desc.ChunkCellCount + 1 };
+	m_VertexBufferByteSize = static_cast<UINT>(sizeof(SVertex3D) * KVertexCountPerSide * KVertexCountPerSide);
+	CreateIndexBuffer();
+}
+
+void CTerrain::CreateIndexBuffer()
+{
+	// Every chunk has the same topology; (254 + 1)^2 vertices still fit 16-bit indices
+	const uint16_t KVertexCountPerSide{ static_cast<uint16_t>(m_Desc.ChunkCellCount + 1) };
+	vector<uint16_t> vIndices{};
+	vIndices.reserve(static_cast<size_t>(m_Desc.ChunkCellCount) * m_Desc.ChunkCellCount * 6);
+	for (uint16_t z = 0; z < m_Desc.ChunkCellCount; ++z)
+	{
+		for (uint16_t x = 0; x < m_Desc.ChunkCellCount; ++x)
+		{
+			const uint16_t I0{ static_cast<uint16_t>(z * KVertexCountPerSide + x) };
+			const uint16_t I1{ static_cast<uint16_t>(I0 + 1) };
+			const uint16_t I2{ static_cast<uint16_t>(I0 + KVertexCountPerSide) };
+			const uint16_t I3{ static_cast<uint16_t>(I2 + 1) };
+			vIndices.insert(vIndices.end(), { I0, I1, I2, I1, I3, I2 });
+		}
+	}
+	m_IndexCount = static_cast<UINT>(vIndices.size());
+
+	D3D11_BUFFER_DESC BufferDesc{};
+	BufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	BufferDesc.ByteWidth = static_cast<UINT>(sizeof(uint16_t) * vIndices.size());
+	BufferDesc.CPUAccessFlags = 0;
+	BufferDesc.MiscFlags = 0;
+	BufferDesc.StructureByteStride = 0;
+	BufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+
+	D3D11_SUBRESOURCE_DATA SubresourceData{};
+	SubresourceData.pSysMem = &vIndices[0];
+	m_IndexBuffer.Reset();
+	m_PtrDevice->CreateBuffer(&BufferDesc, &SubresourceData, &m_IndexBuffer);
+}
+
+void CTerrain::Update(const XMVECTOR& EyePosition, const XMMATRIX& ViewProjection)
+{
+	if (!IsCreated()) return;
+
+	++m_FrameIndex;
+
+	// Upload finished chunks
+	size_t UploadCount{};
+	for (auto iPending = m_umPendingChunks.begin(); iPending != m_umPendingChunks.end() && UploadCount < KMaxUploadCountPerFrame;)
+	{
+		if (iPending->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++iPending;
+			continue;
+		}
+
+		const uint64_t KKey{ iPending->first };
+		UploadChunk(static_cast<int32_t>(KKey >> 32), static_cast<int32_t>(KKey & 0xFFFFFFFF), iPending->second.get());
+		iPending = m_umPendingChunks.erase(iPending);
+		++UploadCount;
+	}
+
+	XMVECTOR FrustumPlanes[6]{};
+	ExtractFrustumPlanes(ViewProjection, FrustumPlanes);
+
+	// Touch the resident chunks in range and collect the missing ones
+	struct SRequest
+	{
+		int32_t		X{};
+		int32_t		Z{};
+		bool		bIsInView{};
+		float		DistanceSquare{};
+	};
+	vector<SRequest> vRequests{};
+
+	const float KChunkSize{ GetChunkSize() };
+	const float KEyeX{ XMVectorGetX(EyePosition) };
+	const float KEyeZ{ XMVectorGetZ(EyePosition) };
+	const int32_t KEyeChunkX{ static_cast<int32_t>(floorf(KEyeX / KChunkSize)) };
+	const int32_t KEyeChunkZ{ static_cast<int32_t>(floorf(KEyeZ / KChunkSize)) };
+	const int32_t KChunkRadius{ static_cast<int32_t>(ceilf(m_Desc.LoadRadius / KChunkSize)) };
+	const float KLoadRadiusSquare{ m_Desc.LoadRadius * m_Desc.LoadRadius };
+	const float KChunkBoundingRadius{ KChunkSize * 0.70711f + m_Desc.HeightScale };
+	for (int32_t ChunkZ = KEyeChunkZ - KChunkRadius; ChunkZ <= KEyeChunkZ + KChunkRadius; ++ChunkZ)
+	{
+		for (int32_t ChunkX = KEyeChunkX - KChunkRadius; ChunkX <= KEyeChunkX + KChunkRadius; ++ChunkX)
+		{
+			const float KCenterX{ (static_cast<float>(ChunkX) + 0.5f) * KChunkSize };
+			const float KCenterZ{ (static_cast<float>(ChunkZ) + 0.5f) * KChunkSize };
+			const float KDistanceSquare{ (KCenterX - KEyeX) * (KCenterX - KEyeX) + (KCenterZ - KEyeZ) * (KCenterZ - KEyeZ) };
+			if (KDistanceSquare > KLoadRadiusSquare) continue;
+
+			const uint64_t KKey{ MakeKey(ChunkX, ChunkZ) };
+			auto Found{ m_umChunks.find(KKey) };
+			if (Found != m_umChunks.end())
+			{
+				Found->second.LastUsedFrame = m_FrameIndex;
+				m_lLRUKeys.splice(m_lLRUKeys.begin(), m_lLRUKeys, Found->second.LRUIterator);
+				continue;
+			}
+			if (m_umPendingChunks.count(KKey)) continue;
+
+			// The heights are unknown before generation, so the test uses the whole height range
+			const bool KbIsInView{ !IsSphereOutsideFrustum(FrustumPlanes, XMVectorSet(KCenterX, 0, KCenterZ, 1), KChunkBoundingRadius) };
+			vRequests.push_back(SRequest{ ChunkX, ChunkZ, KbIsInView, KDistanceSquare });
+		}
+	}
+
+	// In-view chunks first, then the nearest
+	std::sort(vRequests.begin(), vRequests.end(), [](const SRequest& A, const SRequest& B)
+		{
+			if (A.bIsInView != B.bIsInView) return A.bIsInView;
+			return A.DistanceSquare < B.DistanceSquare;
+		});
+	for (const SRequest& Request : vRequests)
+	{
+		if (m_umPendingChunks.size() >= KMaxPendingChunkCount) break;
+
+		const STerrainDesc KDesc{ m_Desc };
+		const int32_t KX{ Request.X };
+		const int32_t KZ{ Request.Z };
+		m_umPendingChunks.emplace(MakeKey(KX, KZ), m_ThreadPool.Submit([KDesc, KX, KZ]() { return GenerateChunk(KDesc, KX, KZ); }));
+	}
+
+	EvictChunks();
+
+	m_vVisibleChunks.clear();
+	for (const auto& KeyChunk : m_umChunks)
+	{
+		const SChunk& Chunk{ KeyChunk.second };
+		if (IsSphereOutsideFrustum(FrustumPlanes, XMVectorSetW(XMLoadFloat3(&Chunk.BoundingSphereCenter), 1.0f), Chunk.BoundingSphereRadius)) continue;
+		m_vVisibleChunks.emplace_back(&Chunk);
+	}
+}
+
+void CTerrain::UploadChunk(int32_t ChunkX, int32_t ChunkZ, const SChunkData& Data)
+{
+	SChunk Chunk{};
+	Chunk.X = ChunkX;
+	Chunk.Z = ChunkZ;
+	Chunk.LastUsedFrame = m_FrameIndex;
+
+	if (m_vFreeVertexBuffers.empty())
+	{
+		D3D11_BUFFER_DESC BufferDesc{};
+		BufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		BufferDesc.ByteWidth = m_VertexBufferByteSize;
+		BufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		BufferDesc.MiscFlags = 0;
+		BufferDesc.StructureByteStride = 0;
+		BufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+
+		D3D11_SUBRESOURCE_DATA SubresourceData{};
+		SubresourceData.pSysMem = &Data.vVertices[0];
+		if (FAILED(m_PtrDevice->CreateBuffer(&BufferDesc, &SubresourceData, &Chunk.VertexBuffer))) return;
+		++m_Stats.CreatedVertexBufferCount;
+	}
+	else
+	{
+		Chunk.VertexBuffer = std::move(m_vFreeVertexBuffers.back());
+		m_vFreeVertexBuffers.pop_back();
+
+		D3D11_MAPPED_SUBRESOURCE MappedSubresource{};
+		if (FAILED(m_PtrDeviceContext->Map(Chunk.VertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedSubresource)))
+		{
+			// Back to the pool; the chunk is requested again while it is in range
+			m_vFreeVertexBuffers.emplace_back(std::move(Chunk.VertexBuffer));
+			return;
+		}
+		memcpy(MappedSubresource.pData, &Data.vVertices[0], m_VertexBufferByteSize);
+		m_PtrDeviceContext->Unmap(Chunk.VertexBuffer.Get(), 0);
+	}
+
+	const float KChunkSize{ GetChunkSize() };
+	const float KHalfHeight{ (Data.MaxHeight - Data.MinHeight) * 0.5f };
+	Chunk.BoundingSphereCenter = XMFLOAT3((static_cast<float>(ChunkX) + 0.5f) * KChunkSize, Data.MinHeight + KHalfHeight, (static_cast<float>(ChunkZ) + 0.5f) * KChunkSize);
+	Chunk.BoundingSphereRadius = sqrtf(KChunkSize * KChunkSize * 0.5f + KHalfHeight * KHalfHeight);
+
+	const uint64_t KKey{ MakeKey(ChunkX, ChunkZ) };
+	m_lLRUKeys.emplace_front(KKey);
+	Chunk.LRUIterator = m_lLRUKeys.begin();
+	m_umChunks[KKey] = std::move(Chunk);
+	++m_Stats.GeneratedChunkCount;
+}
+
+void CTerrain::EvictChunks()
+{
+	// Chunks in range were moved to the front this frame, so eviction stops before reaching them
+	while (m_umChunks.size() > m_Desc.MaxResidentChunkCount && !m_lLRUKeys.empty())
+	{
+		auto Found{ m_umChunks.find(m_lLRUKeys.back()) };
+		assert(Found != m_umChunks.end());
+		if (Found->second.LastUsedFrame == m_FrameIndex) break;
+
+		m_vFreeVertexBuffers.emplace_back(std::move(Found->second.VertexBuffer));
+		m_umChunks.erase(Found);
+		m_lLRUKeys.pop_back();
+		++m_Stats.EvictedChunkCount;
+	}
+}
+
+void CTerrain::Draw() const
+{
+	if (!IsCreated() || m_vVisibleChunks.empty()) return;
+
+	const UINT KStride{ sizeof(SVertex3D) };
+	const UINT KOffset{};
+	m_PtrDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	m_PtrDeviceContext->IASetIndexBuffer(m_IndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
+	for (const SChunk* const Chunk : m_vVisibleChunks)
+	{
+		m_PtrDeviceContext->IASetVertexBuffers(0, 1, Chunk->VertexBuffer.GetAddressOf(), &KStride, &KOffset);
+		m_PtrDeviceContext->DrawIndexed(m_IndexCount, 0, 0);
+	}
+}
+
+STerrainStats CTerrain::GetStats() const
+{
+	STerrainStats Result{ m_Stats };
+	Result.ResidentChunkCount = m_umChunks.size();
+	Result.PendingChunkCount = m_umPendingChunks.size();
+	Result.VisibleChunkCount = m_vVisibleChunks.size();
+	Result.PooledVertexBufferCount = m_vFreeVertexBuffers.size();
+	return Result;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include <list>
+#include <future>
+
+class CThreadPool;
+
+struct STerrainDesc
+{
+	// Cells per chunk side; a chunk has (ChunkCellCount + 1)^2 vertices and shares its index buffer with every other chunk
+	uint32_t	ChunkCellCount{ 64 };
+	float		CellSize{ 1.0f };
+
+	// Chunks whose centers lie within LoadRadius of the eye (on the XZ plane) are generated.
+	// Chunks that fall out of it stay resident until there are more than MaxResidentChunkCount, least recently used first.
+	float		LoadRadius{ 384.0f };
+	size_t		MaxResidentChunkCount{ 160 };
+
+	// fBm value noise
+	float		HeightScale{ 24.0f };
+	float		NoiseFrequency{ 1.0f / 160.0f };
+	uint32_t	NoiseOctaveCount{ 5 };
+	uint32_t	Seed{ 1 };
+
+	XMFLOAT4	Color{ 1.0f, 1.0f, 1.0f, 1.0f };
+};
+
+struct STerrainStats
+{
+	size_t		ResidentChunkCount{};
+	size_t		PendingChunkCount{};
+	size_t		VisibleChunkCount{};
+	size_t		PooledVertexBufferCount{};
+
+	// Totals since Create()
+	size_t		GeneratedChunkCount{};
+	size_t		EvictedChunkCount{};
+	size_t		CreatedVertexBufferCount{};
+};
+
+// Endless heightfield terrain made of fixed-size chunks that are paged in and out around the camera.
+// Chunk vertices are generated on the thread pool from a continuous height function (see GetHeight()), so chunk borders match,
+// and uploaded on the main thread into vertex buffers recycled from evicted chunks.
+// Requests are issued in-view first and then by distance, so the first frames only pay for what the camera sees.
+class CTerrain
+{
+	struct SChunkData
+	{
+		std::vector<SVertex3D>	vVertices{};
+		float					MinHeight{};
+		float					MaxHeight{};
+	};
+
+	struct SChunk
+	{
+		int32_t					X{};
+		int32_t					Z{};
+		ComPtr<ID3D11Buffer>	VertexBuffer{};
+
+		// World space
+		XMFLOAT3				BoundingSphereCenter{};
+		float					BoundingSphereRadius{};
+
+		uint64_t				LastUsedFrame{};
+		std::list<uint64_t>::iterator	LRUIterator{};
+	};
+
+public:
+	CTerrain(ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext, CThreadPool& ThreadPool) :
+		m_PtrDevice{ PtrDevice }, m_PtrDeviceContext{ PtrDeviceContext }, m_ThreadPool{ ThreadPool }
+	{
+		assert(m_PtrDevice);
+		assert(m_PtrDeviceContext);
+	}
+	~CTerrain() {}
+
+public:
+	// Drops every chunk; nothing is generated until the first Update()
+	void Create(const STerrainDesc& Desc);
+
+	// Main thread only: uploads finished chunks, requests missing ones, evicts and culls against ViewProjection.
+	void Update(const XMVECTOR& EyePosition, const XMMATRIX& ViewProjection);
+
+	// Draws the chunks that passed the last Update()'s culling with the currently bound shaders (world matrix = identity).
+	void Draw() const;
+
+public:
+	bool IsCreated() const { return m_IndexBuffer.Get() != nullptr; }
+	const STerrainDesc& GetDesc() const { return m_Desc; }
+	STerrainStats GetStats() const;
+
+	// The surface every chunk samples
+	float GetHeight(float X, float Z) const { return GetHeight(m_Desc, X, Z); }
+	static float GetHeight(const STerrainDesc& Desc, float X, float Z);
+
+private:
+	static SChunkData GenerateChunk(const STerrainDesc& Desc, int32_t ChunkX, int32_t ChunkZ);
+	static uint64_t MakeKey(int32_t ChunkX, int32_t ChunkZ);
+
+	void CreateIndexBuffer();
+	void UploadChunk(int32_t ChunkX, int32_t ChunkZ, const SChunkData& Data);
+	void EvictChunks();
+
+	float GetChunkSize() const { return m_Desc.CellSize * static_cast<float>(m_Desc.ChunkCellCount); }
+
+public:
+	// Bounds the work in flight (and so the latency of newly needed chunks) and the upload cost per frame
+	static constexpr size_t KMaxPendingChunkCount{ 16 };
+	static constexpr size_t KMaxUploadCountPerFrame{ 8 };
+
+private:
+	ID3D11Device*						m_PtrDevice{};
+	ID3D11DeviceContext*				m_PtrDeviceContext{};
+	CThreadPool&						m_ThreadPool;
+
+	STerrainDesc						m_Desc{};
+	ComPtr<ID3D11Buffer>				m_IndexBuffer{};
+	UINT								m_IndexCount{};
+	UINT								m_VertexBufferByteSize{};
+
+	std::unordered_map<uint64_t, SChunk>					m_umChunks{};
+	std::list<uint64_t>										m_lLRUKeys{};
+	std::unordered_map<uint64_t, std::future<SChunkData>>	m_umPendingChunks{};
+	std::vector<ComPtr<ID3D11Buffer>>						m_vFreeVertexBuffers{};
+	std::vector<const SChunk*>								m_vVisibleChunks{};
+
+	uint64_t							m_FrameIndex{};
+	STerrainStats						m_Stats{};
+};
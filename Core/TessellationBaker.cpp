@@ -0,0 +1,411 @@
+#include "TessellationBaker.h"
+#include "DisplacementMap.h"
+#include "PNTriangle.h"
+#include "PositionWelder.h"
+#include "ThreadPool.h"
+
+using std::vector;
+using std::unordered_map;
+using std::function;
+using std::pair;
+using std::sort;
+
+static constexpr uint32_t KInvalidIndex{ UINT32_MAX };
+
+// SplitMix64's finalizer, so that sums of different index sets practically never collide
+static uint64_t HashIndex(uint32_t Index)
+{
+	uint64_t Hash{ Index + 0x9E37'79B9'7F4A'7C15ull };
+	Hash = (Hash ^ (Hash >> 30)) * 0xBF58'476D'1CE4'E5B9ull;
+	Hash = (Hash ^ (Hash >> 27)) * 0x94D0'49BB'1331'11EBull;
+	return Hash ^ (Hash >> 31);
+}
+
+bool CTessellationBaker::Bake(const SMesh& Mesh, float EdgeTessFactor, float InsideTessFactor, ETessellatorPartitioning ePartitioning, SMesh& OutMesh,
+	CThreadPool* const PtrThreadPool)
+{
+	m_WeldedPointCount = 0;
+
+	OutMesh.vVertices.clear();
+	OutMesh.vTriangles.clear();
+	OutMesh.MaterialID = Mesh.MaterialID;
+	if (Mesh.vTriangles.empty()) return false;
+
+	// HSTri.hlsl is triangle_cw
+	m_Tessellator.SetPartitioning(ePartitioning);
+	m_Tessellator.SetClockwise(true);
+	const float KEdgeFactors[3]{ EdgeTessFactor, EdgeTessFactor, EdgeTessFactor };
+	if (!m_Tessellator.TessellateTri(KEdgeFactors, InsideTessFactor)) return false;
+
+	LocatePoints();
+	NumberVertices(Mesh);
+
+	const size_t KTriangleCount{ Mesh.vTriangles.size() };
+	OutMesh.vVertices.resize(m_VertexCount);
+	OutMesh.vTriangles.resize(KTriangleCount * m_Tessellator.GetTriangles().size());
+	ParallelFor(PtrThreadPool, KTriangleCount, [&](size_t Begin, size_t End) { BakeTriangles(Mesh, Begin, End, OutMesh); });
+
+	m_WeldedPointCount = KTriangleCount * m_vPointLocations.size() - m_VertexCount;
+	return true;
+}
+
+void CTessellationBaker::Displace(SMesh& Mesh, const CDisplacementMap& Map, float Level, float Factor, CThreadPool* const PtrThreadPool) const
+{
+	// Normals of copies split only at a texcoord seam agree to within this; those split at a hard edge don't
+	static constexpr float KSameNormalCosine{ 0.9999f };
+
+	const size_t KVertexCount{ Mesh.vVertices.size() };
+	const size_t KTriangleCount{ Mesh.vTriangles.size() };
+
+	// Copies of a vertex split at a seam would sample different texels and move along different normals, which opens the seam.
+	// They lie on edges that only one triangle uses: the hashes of the vertices that a vertex's edges lead to, minus those of the vertices
+	// they come from, cancel out if its triangles close around it. Only the remaining vertices are welded.
+	vector<uint64_t> vEdgeHashSums(KVertexCount);
+	for (const STriangle& KTriangle : Mesh.vTriangles)
+	{
+		const uint32_t KIndices[3]{ KTriangle.I0, KTriangle.I1, KTriangle.I2 };
+		for (int iCorner = 0; iCorner < 3; ++iCorner)
+		{
+			const uint32_t KFrom{ KIndices[iCorner] };
+			const uint32_t KTo{ KIndices[(iCorner + 1) % 3] };
+			vEdgeHashSums[KFrom] += HashIndex(KTo);
+			vEdgeHashSums[KTo] -= HashIndex(KFrom);
+		}
+	}
+
+	vector<uint32_t> vOpenVertices{};
+	vector<XMVECTOR> vOpenPositions{};
+	for (uint32_t iVertex = 0; iVertex < static_cast<uint32_t>(KVertexCount); ++iVertex)
+	{
+		if (vEdgeHashSums[iVertex] == 0) continue;
+
+		vOpenVertices.emplace_back(iVertex);
+		vOpenPositions.emplace_back(Mesh.vVertices[iVertex].Position);
+	}
+	CPositionWelder PositionWelder{};
+	const size_t KGroupCount{ PositionWelder.Weld(vOpenPositions.data(), vOpenPositions.size()) };
+
+	// Groups of more than one vertex are seams
+	vector<uint32_t> vGroupVertexCounts(KGroupCount);
+	for (size_t iOpenVertex = 0; iOpenVertex < vOpenVertices.size(); ++iOpenVertex) ++vGroupVertexCounts[PositionWelder.GetGroup(iOpenVertex)];
+
+	// Each seam moves once, by the average height along the average normal of its copies
+	vector<uint32_t> vSeamGroups(KVertexCount, KInvalidIndex);
+	vector<float> vGroupHeights(KGroupCount);
+	vector<XMFLOAT3> vGroupNormals(KGroupCount);
+	for (size_t iOpenVertex = 0; iOpenVertex < vOpenVertices.size(); ++iOpenVertex)
+	{
+		const uint32_t KGroup{ PositionWelder.GetGroup(iOpenVertex) };
+		if (vGroupVertexCounts[KGroup] < 2) continue;
+
+		const SVertex3D& KVertex{ Mesh.vVertices[vOpenVertices[iOpenVertex]] };
+		vSeamGroups[vOpenVertices[iOpenVertex]] = KGroup;
+		vGroupHeights[KGroup] += Map.SampleLevel(XMVectorGetX(KVertex.TexCoord), XMVectorGetY(KVertex.TexCoord), Level);
+
+		XMFLOAT3 Normal{};
+		XMStoreFloat3(&Normal, XMVector3Normalize(XMVectorSetW(KVertex.Normal, 0.0f)));
+		vGroupNormals[KGroup].x += Normal.x;
+		vGroupNormals[KGroup].y += Normal.y;
+		vGroupNormals[KGroup].z += Normal.z;
+	}
+
+	vector<XMFLOAT3> vGroupPositions(KGroupCount);
+	for (uint32_t iGroup = 0; iGroup < static_cast<uint32_t>(KGroupCount); ++iGroup)
+	{
+		if (vGroupVertexCounts[iGroup] < 2) continue;
+
+		const SVertex3D& KRepresentative{ Mesh.vVertices[vOpenVertices[PositionWelder.GetGroupRepresentative(iGroup)]] };
+		XMVECTOR Direction{ XMLoadFloat3(&vGroupNormals[iGroup]) };
+		// Opposite normals cancel out
+		if (XMVector3Equal(Direction, XMVectorZero())) Direction = XMVectorSetW(KRepresentative.Normal, 0.0f);
+
+		const float KDisplacement{ vGroupHeights[iGroup] / static_cast<float>(vGroupVertexCounts[iGroup]) * Factor };
+		XMStoreFloat3(&vGroupPositions[iGroup], KRepresentative.Position + XMVector3Normalize(Direction) * KDisplacement);
+	}
+
+	// Copies split only at a texcoord seam will share the recomputed normal; those at a hard edge keep their own
+	vector<uint8_t> vIsSmoothSeam(vOpenVertices.size());
+	for (size_t iOpenVertex = 0; iOpenVertex < vOpenVertices.size(); ++iOpenVertex)
+	{
+		const uint32_t KGroup{ PositionWelder.GetGroup(iOpenVertex) };
+		if (vGroupVertexCounts[KGroup] < 2) continue;
+
+		const XMVECTOR KNormal{ XMVector3Normalize(XMVectorSetW(Mesh.vVertices[vOpenVertices[iOpenVertex]].Normal, 0.0f)) };
+		const XMVECTOR KGroupNormal{ XMVector3Normalize(XMLoadFloat3(&vGroupNormals[KGroup])) };
+		vIsSmoothSeam[iOpenVertex] = (XMVectorGetX(XMVector3Dot(KNormal, KGroupNormal)) >= KSameNormalCosine) ? 1 : 0;
+	}
+
+	ParallelFor(PtrThreadPool, KVertexCount, [&](size_t Begin, size_t End)
+		{
+			for (size_t iVertex = Begin; iVertex < End; ++iVertex)
+			{
+				SVertex3D& Vertex{ Mesh.vVertices[iVertex] };
+				if (vSeamGroups[iVertex] != KInvalidIndex)
+				{
+					Vertex.Position = XMVectorSetW(XMLoadFloat3(&vGroupPositions[vSeamGroups[iVertex]]), 1.0f);
+					continue;
+				}
+
+				const float KDisplacement{ Map.SampleLevel(XMVectorGetX(Vertex.TexCoord), XMVectorGetY(Vertex.TexCoord), Level) * Factor };
+				Vertex.Position = XMVectorSetW(Vertex.Position + XMVectorSetW(Vertex.Normal, 0.0f) * KDisplacement, 1.0f);
+			}
+		});
+
+	// Twice the area times the normal
+	vector<XMFLOAT3> vTriangleNormals(KTriangleCount);
+	ParallelFor(PtrThreadPool, KTriangleCount, [&](size_t Begin, size_t End)
+		{
+			for (size_t iTriangle = Begin; iTriangle < End; ++iTriangle)
+			{
+				const STriangle& KTriangle{ Mesh.vTriangles[iTriangle] };
+				const XMVECTOR& KP0{ Mesh.vVertices[KTriangle.I0].Position };
+				XMStoreFloat3(&vTriangleNormals[iTriangle],
+					XMVector3Cross(Mesh.vVertices[KTriangle.I1].Position - KP0, Mesh.vVertices[KTriangle.I2].Position - KP0));
+			}
+		});
+
+	// Summed in triangle order, so the result does not depend on the thread count
+	vector<XMFLOAT3> vVertexNormals(KVertexCount);
+	for (size_t iTriangle = 0; iTriangle < KTriangleCount; ++iTriangle)
+	{
+		const STriangle& KTriangle{ Mesh.vTriangles[iTriangle] };
+		const XMFLOAT3& KNormal{ vTriangleNormals[iTriangle] };
+		for (const uint32_t KIndex : { KTriangle.I0, KTriangle.I1, KTriangle.I2 })
+		{
+			vVertexNormals[KIndex].x += KNormal.x;
+			vVertexNormals[KIndex].y += KNormal.y;
+			vVertexNormals[KIndex].z += KNormal.z;
+		}
+	}
+
+	vector<XMFLOAT3> vGroupSmoothNormals(KGroupCount);
+	for (size_t iOpenVertex = 0; iOpenVertex < vOpenVertices.size(); ++iOpenVertex)
+	{
+		if (!vIsSmoothSeam[iOpenVertex]) continue;
+
+		XMFLOAT3& GroupNormal{ vGroupSmoothNormals[PositionWelder.GetGroup(iOpenVertex)] };
+		const XMFLOAT3& KNormal{ vVertexNormals[vOpenVertices[iOpenVertex]] };
+		GroupNormal.x += KNormal.x;
+		GroupNormal.y += KNormal.y;
+		GroupNormal.z += KNormal.z;
+	}
+	for (size_t iOpenVertex = 0; iOpenVertex < vOpenVertices.size(); ++iOpenVertex)
+	{
+		if (vIsSmoothSeam[iOpenVertex]) vVertexNormals[vOpenVertices[iOpenVertex]] = vGroupSmoothNormals[PositionWelder.GetGroup(iOpenVertex)];
+	}
+
+	ParallelFor(PtrThreadPool, KVertexCount, [&](size_t Begin, size_t End)
+		{
+			for (size_t iVertex = Begin; iVertex < End; ++iVertex)
+			{
+				SVertex3D& Vertex{ Mesh.vVertices[iVertex] };
+				const XMVECTOR KNormal{ XMLoadFloat3(&vVertexNormals[iVertex]) };
+				// Vertices of degenerate triangles only keep their interpolated normal
+				if (XMVector3Equal(KNormal, XMVectorZero())) continue;
+
+				Vertex.Normal = XMVector3Normalize(KNormal);
+				const XMVECTOR KTangent{ Vertex.Tangent - Vertex.Normal * XMVector3Dot(Vertex.Normal, Vertex.Tangent) };
+				Vertex.Tangent = XMVectorSetW(XMVector3Normalize(KTangent), XMVectorGetW(Vertex.Tangent));
+			}
+		});
+}
+
+void CTessellationBaker::LocatePoints()
+{
+	const vector<XMFLOAT2>& KDomainPoints{ m_Tessellator.GetDomainPoints() };
+	m_vPointLocations.resize(KDomainPoints.size());
+	m_InsidePointCount = 0;
+
+	// Per edge: (weight of the corner the edge runs towards, point)
+	vector<pair<float, uint32_t>> vEdgePoints[3]{};
+	for (uint32_t iPoint = 0; iPoint < static_cast<uint32_t>(KDomainPoints.size()); ++iPoint)
+	{
+		// Domain points are 16.16 fixed point, so w and the comparisons are exact
+		const float KWeights[3]{ KDomainPoints[iPoint].x, KDomainPoints[iPoint].y, 1.0f - KDomainPoints[iPoint].x - KDomainPoints[iPoint].y };
+
+		SPointLocation& Location{ m_vPointLocations[iPoint] };
+		Location = SPointLocation();
+		Location.eType = EPointType::Inside;
+		for (uint32_t iCorner = 0; iCorner < 3; ++iCorner)
+		{
+			if (KWeights[iCorner] == 1.0f)
+			{
+				Location.eType = EPointType::Corner;
+				Location.Index = iCorner;
+				break;
+			}
+		}
+		if (Location.eType == EPointType::Corner) continue;
+
+		for (uint32_t iEdge = 0; iEdge < 3; ++iEdge)
+		{
+			if (KWeights[iEdge] == 0.0f)
+			{
+				Location.eType = EPointType::Edge;
+				Location.Index = iEdge;
+				vEdgePoints[iEdge].emplace_back(KWeights[(iEdge + 2) % 3], iPoint);
+				break;
+			}
+		}
+		if (Location.eType == EPointType::Inside) Location.Rank = m_InsidePointCount++;
+	}
+
+	for (uint32_t iEdge = 0; iEdge < 3; ++iEdge)
+	{
+		sort(vEdgePoints[iEdge].begin(), vEdgePoints[iEdge].end());
+		for (uint32_t iRank = 0; iRank < static_cast<uint32_t>(vEdgePoints[iEdge].size()); ++iRank)
+		{
+			m_vPointLocations[vEdgePoints[iEdge][iRank].second].Rank = iRank;
+		}
+	}
+
+	// The factors are uniform and the points of an edge are symmetric about its middle, which is what makes the welding possible
+	m_EdgePointCount = static_cast<uint32_t>(vEdgePoints[0].size());
+	assert(vEdgePoints[1].size() == m_EdgePointCount && vEdgePoints[2].size() == m_EdgePointCount);
+	for (uint32_t iRank = 0; iRank < m_EdgePointCount; ++iRank)
+	{
+		assert(vEdgePoints[0][iRank].first + vEdgePoints[0][m_EdgePointCount - 1 - iRank].first == 1.0f);
+	}
+}
+
+void CTessellationBaker::NumberVertices(const SMesh& Mesh)
+{
+	const size_t KTriangleCount{ Mesh.vTriangles.size() };
+	m_vVertexCorners.assign(Mesh.vVertices.size(), KInvalidIndex);
+	m_vCornerWriters.assign(Mesh.vVertices.size(), KInvalidIndex);
+	m_vTriangleEdges.resize(KTriangleCount * 3);
+	m_vEdgeVertexBases.clear();
+	m_vEdgeWriters.clear();
+	m_vEdgeReversals.assign(KTriangleCount, 0);
+	m_vInsideVertexBases.resize(KTriangleCount);
+
+	// Output vertices are 32-bit indices
+	size_t VertexCount{};
+
+	// (lower vertex index, higher vertex index) -> edge
+	unordered_map<uint64_t, uint32_t> umEdges{};
+	umEdges.reserve(KTriangleCount * 2);
+	for (uint32_t iTriangle = 0; iTriangle < static_cast<uint32_t>(KTriangleCount); ++iTriangle)
+	{
+		const STriangle& KTriangle{ Mesh.vTriangles[iTriangle] };
+		const uint32_t KIndices[3]{ KTriangle.I0, KTriangle.I1, KTriangle.I2 };
+		for (uint32_t iCorner = 0; iCorner < 3; ++iCorner)
+		{
+			if (m_vVertexCorners[KIndices[iCorner]] != KInvalidIndex) continue;
+
+			m_vVertexCorners[KIndices[iCorner]] = static_cast<uint32_t>(VertexCount++);
+			m_vCornerWriters[KIndices[iCorner]] = iTriangle;
+		}
+
+		for (uint32_t iEdge = 0; iEdge < 3; ++iEdge)
+		{
+			const uint32_t KFrom{ KIndices[(iEdge + 1) % 3] };
+			const uint32_t KTo{ KIndices[(iEdge + 2) % 3] };
+			const uint64_t KKey{ (static_cast<uint64_t>(std::min(KFrom, KTo)) << 32) | std::max(KFrom, KTo) };
+			const auto KInserted{ umEdges.emplace(KKey, static_cast<uint32_t>(m_vEdgeWriters.size())) };
+			if (KInserted.second)
+			{
+				m_vEdgeVertexBases.emplace_back(static_cast<uint32_t>(VertexCount));
+				m_vEdgeWriters.emplace_back(iTriangle);
+				VertexCount += m_EdgePointCount;
+			}
+
+			m_vTriangleEdges[iTriangle * 3 + iEdge] = KInserted.first->second;
+			if (KFrom > KTo) m_vEdgeReversals[iTriangle] |= static_cast<uint8_t>(1 << iEdge);
+		}
+
+		m_vInsideVertexBases[iTriangle] = static_cast<uint32_t>(VertexCount);
+		VertexCount += m_InsidePointCount;
+	}
+	assert(VertexCount <= UINT32_MAX);
+	m_VertexCount = VertexCount;
+}
+
+void CTessellationBaker::BakeTriangles(const SMesh& Mesh, size_t Begin, size_t End, SMesh& OutMesh) const
+{
+	const vector<XMFLOAT2>& KDomainPoints{ m_Tessellator.GetDomainPoints() };
+	const vector<STriangle>& KDomainTriangles{ m_Tessellator.GetTriangles() };
+	const size_t KPointCount{ KDomainPoints.size() };
+	const size_t KDomainTriangleCount{ KDomainTriangles.size() };
+
+	vector<XMFLOAT3> vPositions(KPointCount);
+	vector<XMFLOAT3> vNormals(KPointCount);
+	vector<uint32_t> vPointVertices(KPointCount);
+	vector<uint8_t> vIsWriter(KPointCount);
+	for (size_t iTriangle = Begin; iTriangle < End; ++iTriangle)
+	{
+		const STriangle& KTriangle{ Mesh.vTriangles[iTriangle] };
+		const uint32_t KIndices[3]{ KTriangle.I0, KTriangle.I1, KTriangle.I2 };
+		for (size_t iPoint = 0; iPoint < KPointCount; ++iPoint)
+		{
+			const SPointLocation& KLocation{ m_vPointLocations[iPoint] };
+			switch (KLocation.eType)
+			{
+			case EPointType::Corner:
+			{
+				vPointVertices[iPoint] = m_vVertexCorners[KIndices[KLocation.Index]];
+				vIsWriter[iPoint] = (m_vCornerWriters[KIndices[KLocation.Index]] == iTriangle);
+				break;
+			}
+			case EPointType::Edge:
+			{
+				// Ranks run from the lower vertex index to the higher one
+				const uint32_t KEdge{ m_vTriangleEdges[iTriangle * 3 + KLocation.Index] };
+				const bool KbIsReversed{ (m_vEdgeReversals[iTriangle] & (1 << KLocation.Index)) != 0 };
+				const uint32_t KRank{ (KbIsReversed) ? m_EdgePointCount - 1 - KLocation.Rank : KLocation.Rank };
+				vPointVertices[iPoint] = m_vEdgeVertexBases[KEdge] + KRank;
+				vIsWriter[iPoint] = (m_vEdgeWriters[KEdge] == iTriangle);
+				break;
+			}
+			case EPointType::Inside:
+			default:
+				vPointVertices[iPoint] = m_vInsideVertexBases[iTriangle] + KLocation.Rank;
+				vIsWriter[iPoint] = 1;
+				break;
+			}
+		}
+
+		for (size_t iDomainTriangle = 0; iDomainTriangle < KDomainTriangleCount; ++iDomainTriangle)
+		{
+			const STriangle& KDomainTriangle{ KDomainTriangles[iDomainTriangle] };
+			OutMesh.vTriangles[iTriangle * KDomainTriangleCount + iDomainTriangle] =
+				STriangle(vPointVertices[KDomainTriangle.I0], vPointVertices[KDomainTriangle.I1], vPointVertices[KDomainTriangle.I2]);
+		}
+
+		const SVertex3D& KV0{ Mesh.vVertices[KIndices[0]] };
+		const SVertex3D& KV1{ Mesh.vVertices[KIndices[1]] };
+		const SVertex3D& KV2{ Mesh.vVertices[KIndices[2]] };
+		const SPNTriangle KPatch{ MakePNTriangle(KV0.Position, KV1.Position, KV2.Position, KV0.Normal, KV1.Normal, KV2.Normal) };
+		EvaluatePNTriangle(KPatch, KDomainPoints.data(), KPointCount, vPositions.data());
+		EvaluatePNTriangleNormals(KPatch, KDomainPoints.data(), KPointCount, vNormals.data());
+
+		for (size_t iPoint = 0; iPoint < KPointCount; ++iPoint)
+		{
+			if (!vIsWriter[iPoint]) continue;
+
+			const float KU{ KDomainPoints[iPoint].x };
+			const float KV{ KDomainPoints[iPoint].y };
+			const float KW{ 1.0f - KU - KV };
+			const XMVECTOR KTangent{ KU * KV0.Tangent + KV * KV1.Tangent + KW * KV2.Tangent };
+
+			SVertex3D& Vertex{ OutMesh.vVertices[vPointVertices[iPoint]] };
+			Vertex.Position = XMVectorSetW(XMLoadFloat3(&vPositions[iPoint]), 1.0f);
+			Vertex.Normal = XMLoadFloat3(&vNormals[iPoint]);
+			Vertex.Color = KU * KV0.Color + KV * KV1.Color + KW * KV2.Color;
+			Vertex.TexCoord = KU * KV0.TexCoord + KV * KV1.TexCoord + KW * KV2.TexCoord;
+			Vertex.Tangent = XMVectorSetW(XMVector3Normalize(KTangent), (XMVectorGetW(KTangent) < 0.0f) ? -1.0f : 1.0f);
+		}
+	}
+}
+
+void CTessellationBaker::ParallelFor(CThreadPool* const PtrThreadPool, size_t Count, const function<void(size_t, size_t)>& Function) const
+{
+	if (PtrThreadPool && Count > KGrainSize)
+	{
+		PtrThreadPool->ParallelFor(Count, KGrainSize, Function);
+	}
+	else
+	{
+		Function(0, Count);
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include "Tessellator.h"
+#include <functional>
+
+class CThreadPool;
+class CDisplacementMap;
+
+// "Freezes" tessellation: bakes the PN-triangle surface that HSTri.hlsl and DSTri.hlsl draw with uniform factors into an indexed mesh,
+// for machines that run without hull and domain shaders.
+//  - Every patch has the same domain points and triangles, so the patch is tessellated once (see CTessellator) and each triangle of the mesh
+//    only evaluates its PN triangle (see PNTriangle.h) at those points, four at a time in SIMD lanes, in parallel chunks.
+//  - The mesh is welded by topology: the tessellator places the points of an edge symmetrically, so two triangles that share an edge
+//    (the same two vertex indices) share its points, and triangles that share a vertex share its corner. Split vertices (UV seams)
+//    stay split, as the attributes differ there.
+//  - Output vertices are numbered in the order the triangles first use them, so each triangle's vertices lie close together in memory.
+//  - Shared points are written by the first triangle that uses them, so the result does not depend on the thread count.
+// Color, TexCoord and Tangent are interpolated linearly (Tangent is normalized and keeps the sign of its interpolated w), as in DSTri.hlsl.
+class CTessellationBaker
+{
+	enum class EPointType
+	{
+		Corner,
+		Edge,
+		Inside
+	};
+
+	// Where a domain point of the patch lies; the same for every patch
+	struct SPointLocation
+	{
+		EPointType	eType{};
+		// Corner i is control point i, edge i is opposite to it
+		uint32_t	Index{};
+		// Edge: rank of the point from corner (Index + 1) % 3 towards corner (Index + 2) % 3; Inside: rank among the inside points
+		uint32_t	Rank{};
+	};
+
+public:
+	CTessellationBaker() {}
+	~CTessellationBaker() {}
+
+public:
+	// OutMesh is left empty and false is returned if the factors cull every patch (or the mesh has no triangles).
+	bool Bake(const SMesh& Mesh, float EdgeTessFactor, float InsideTessFactor, ETessellatorPartitioning ePartitioning, SMesh& OutMesh,
+		CThreadPool* const PtrThreadPool = nullptr);
+
+	// Moves every vertex of a mesh baked by Bake() along its normal by Factor times Map sampled at its TexCoord and Level, then recomputes the
+	// normals from the displaced triangles (weighted by area) and makes the tangents perpendicular to them again.
+	// Welded vertices move once, so the triangles that share them stay closed. So do the copies of a vertex that Bake() split at a texcoord or
+	// normal seam (any vertices on edges of a single triangle that share a position, see CPositionWelder): they move by their average height
+	// along their average normal, and those split only at a texcoord seam also share the recomputed normal.
+	void Displace(SMesh& Mesh, const CDisplacementMap& Map, float Level, float Factor, CThreadPool* const PtrThreadPool = nullptr) const;
+
+	// Of the last Bake(): domain points that were welded to another triangle's (the points of every triangle minus the output vertices)
+	size_t GetWeldedPointCount() const { return m_WeldedPointCount; }
+
+private:
+	void LocatePoints();
+	// Numbers the output vertices of Mesh's corners, edges and insides in order of first use and records which triangle writes them
+	void NumberVertices(const SMesh& Mesh);
+	void BakeTriangles(const SMesh& Mesh, size_t Begin, size_t End, SMesh& OutMesh) const;
+
+	void ParallelFor(CThreadPool* const PtrThreadPool, size_t Count, const std::function<void(size_t, size_t)>& Function) const;
+
+public:
+	// Triangles of the input mesh per chunk
+	static constexpr size_t	KGrainSize{ 512 };
+
+private:
+	CTessellator				m_Tessellator{};
+
+	std::vector<SPointLocation>	m_vPointLocations{};
+	uint32_t					m_EdgePointCount{};
+	uint32_t					m_InsidePointCount{};
+
+	// Input vertex -> output vertex of its corner, and the input triangle that writes it
+	std::vector<uint32_t>		m_vVertexCorners{};
+	std::vector<uint32_t>		m_vCornerWriters{};
+	// Input triangle -> its three edges; edge -> its first output vertex, and the input triangle that writes its points
+	std::vector<uint32_t>		m_vTriangleEdges{};
+	std::vector<uint32_t>		m_vEdgeVertexBases{};
+	std::vector<uint32_t>		m_vEdgeWriters{};
+	// Input triangle -> whether the edge of the same index runs from its higher vertex index to its lower one, bits 0 - 2
+	std::vector<uint8_t>		m_vEdgeReversals{};
+	// Input triangle -> its first inside output vertex
+	std::vector<uint32_t>		m_vInsideVertexBases{};
+	size_t						m_VertexCount{};
+
+	size_t						m_WeldedPointCount{};
+};
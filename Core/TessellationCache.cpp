@@ -0,0 +1,386 @@
+#include "TessellationCache.h"
+#include <thread>
+
+using std::mutex;
+using std::lock_guard;
+using std::promise;
+using std::shared_future;
+using std::make_shared;
+using std::make_unique;
+using std::current_exception;
+using std::memory_order_relaxed;
+using std::memory_order_acquire;
+using std::memory_order_release;
+
+static constexpr uint64_t KHashSeed{ 0xCBF2'9CE4'8422'2325 };
+
+// SplitMix64's finalizer: every input bit reaches every output bit
+static uint64_t MixHash(uint64_t Hash)
+{
+	Hash = (Hash ^ (Hash >> 30)) * 0xBF58'476D'1CE4'E5B9;
+	Hash = (Hash ^ (Hash >> 27)) * 0x94D0'49BB'1331'11EB;
+	return Hash ^ (Hash >> 31);
+}
+
+// Every 64-bit word is mixed into the state before the next one comes in. (A bare multiply only carries differences towards the high bits,
+// so flipping the sign bits of two floats, as mirroring a mesh does, could cancel out.)
+// Four independent lanes hide the latency of the mix.
+static uint64_t HashBytes(uint64_t Hash, const void* const PtrData, size_t ByteSize)
+{
+	const uint8_t* const KPtrBytes{ static_cast<const uint8_t*>(PtrData) };
+	uint64_t Lanes[4]{ Hash, Hash + 1, Hash + 2, Hash + 3 };
+	size_t Offset{};
+	for (; Offset + sizeof(Lanes) <= ByteSize; Offset += sizeof(Lanes))
+	{
+		uint64_t Words[4]{};
+		memcpy(Words, KPtrBytes + Offset, sizeof(Words));
+		for (int iLane = 0; iLane < 4; ++iLane) Lanes[iLane] = MixHash(Lanes[iLane] ^ Words[iLane]);
+	}
+
+	// The tail, zero-padded; the byte size tells it apart from a longer input that ends in zeros
+	uint64_t Tail[4]{};
+	if (Offset < ByteSize) memcpy(Tail, KPtrBytes + Offset, ByteSize - Offset);
+	Hash = MixHash(Hash ^ ByteSize);
+	for (int iLane = 0; iLane < 4; ++iLane) Hash = MixHash(Hash ^ MixHash(Lanes[iLane] ^ Tail[iLane]));
+	return Hash;
+}
+
+static size_t GetMeshByteSize(const SMesh& Mesh)
+{
+	return sizeof(SVertex3D) * Mesh.vVertices.size() + sizeof(STriangle) * Mesh.vTriangles.size();
+}
+
+CTessellationCache::CReadGuard::CReadGuard(const CTessellationCache& Cache) : m_Cache{ Cache }
+{
+	while (true)
+	{
+		m_Epoch = m_Cache.m_Epoch.load();
+		m_Cache.m_ReaderCounts[m_Epoch & 1].fetch_add(1);
+
+		// A writer that flipped the epoch in between no longer waits for this counter
+		if (m_Cache.m_Epoch.load() == m_Epoch) break;
+		m_Cache.m_ReaderCounts[m_Epoch & 1].fetch_sub(1);
+	}
+}
+
+CTessellationCache::CReadGuard::~CReadGuard()
+{
+	m_Cache.m_ReaderCounts[m_Epoch & 1].fetch_sub(1);
+}
+
+CTessellationCache::CTessellationCache(size_t MemoryLimit) : m_PtrTable{ new STable(KMinSlotCount) }, m_MemoryLimit{ MemoryLimit }
+{
+}
+
+CTessellationCache::~CTessellationCache()
+{
+	delete m_PtrTable.load();
+}
+
+CTessellationCache::SMeshPtr CTessellationCache::Get(const SMesh& Mesh, float EdgeTessFactor, float InsideTessFactor,
+	ETessellatorPartitioning ePartitioning, CThreadPool* const PtrThreadPool)
+{
+	STessellationCacheKey Key{};
+	if (!MakeKey(Mesh, EdgeTessFactor, InsideTessFactor, ePartitioning, Key)) return nullptr;
+	const uint64_t KKeyHash{ HashKey(Key) };
+
+	// The future is copied so that the entry may be evicted while this thread waits
+	shared_future<SMeshPtr> Future{};
+	{
+		CReadGuard Guard{ *this };
+		SEntry* const PtrFound{ FindEntry(*m_PtrTable.load(), Key, KKeyHash) };
+		if (PtrFound)
+		{
+			Touch(*PtrFound);
+			Future = PtrFound->Future;
+		}
+	}
+
+	promise<SMeshPtr> Promise{};
+	SEntry* PtrEntry{};
+	if (!Future.valid())
+	{
+		lock_guard<mutex> Lock{ m_Mutex };
+
+		// Another thread might have missed the same key meanwhile
+		SEntry* const PtrFound{ FindEntry(*m_PtrTable.load(), Key, KKeyHash) };
+		if (PtrFound)
+		{
+			Touch(*PtrFound);
+			Future = PtrFound->Future;
+		}
+		else
+		{
+			m_vEntries.emplace_back(make_unique<SEntry>());
+			PtrEntry = m_vEntries.back().get();
+			PtrEntry->Key = Key;
+			PtrEntry->KeyHash = KKeyHash;
+			PtrEntry->Future = Promise.get_future().share();
+			Touch(*PtrEntry);
+			InsertLocked(PtrEntry);
+		}
+	}
+	if (Future.valid())
+	{
+		++m_HitCount;
+		return Future.get();
+	}
+	++m_MissCount;
+
+	// Baking runs without the lock so that other keys can be served meanwhile
+	SMeshPtr PtrBakedMesh{};
+	try
+	{
+		auto PtrMesh{ make_shared<SMesh>() };
+		CTessellationBaker TessellationBaker{};
+		if (TessellationBaker.Bake(Mesh, EdgeTessFactor, InsideTessFactor, ePartitioning, *PtrMesh, PtrThreadPool)) PtrBakedMesh = PtrMesh;
+	}
+	catch (...)
+	{
+		// The threads that already wait for this bake get the exception; the key is dropped so that the next Get() bakes again
+		Promise.set_exception(current_exception());
+		{
+			lock_guard<mutex> Lock{ m_Mutex };
+			for (size_t iEntry = 0; iEntry < m_vEntries.size(); ++iEntry)
+			{
+				if (m_vEntries[iEntry].get() != PtrEntry) continue;
+
+				RetireLocked(iEntry);
+				break;
+			}
+			ReclaimLocked();
+		}
+		throw;
+	}
+	Promise.set_value(PtrBakedMesh);
+
+	{
+		lock_guard<mutex> Lock{ m_Mutex };
+
+		// Entries that are being baked are neither evicted nor cleared
+		PtrEntry->ByteSize = (PtrBakedMesh) ? GetMeshByteSize(*PtrBakedMesh) : 0;
+		PtrEntry->bIsReady = true;
+		m_ByteSize += PtrEntry->ByteSize;
+
+		EvictLocked();
+	}
+	return PtrBakedMesh;
+}
+
+CTessellationCache::SMeshPtr CTessellationCache::Find(const STessellationCacheKey& Key) const
+{
+	shared_future<SMeshPtr> Future{};
+	{
+		CReadGuard Guard{ *this };
+		SEntry* const PtrFound{ FindEntry(*m_PtrTable.load(), Key, HashKey(Key)) };
+		if (PtrFound)
+		{
+			Touch(*PtrFound);
+			Future = PtrFound->Future;
+		}
+	}
+	if (!Future.valid())
+	{
+		++m_MissCount;
+		return nullptr;
+	}
+	++m_HitCount;
+	return Future.get();
+}
+
+bool CTessellationCache::MakeKey(const SMesh& Mesh, float EdgeTessFactor, float InsideTessFactor, ETessellatorPartitioning ePartitioning,
+	STessellationCacheKey& OutKey)
+{
+	// As CTessellationBaker::Bake() tessellates
+	const CTessellator KTessellator{ ePartitioning };
+	const float KEdgeFactors[3]{ EdgeTessFactor, EdgeTessFactor, EdgeTessFactor };
+	uint32_t FixedEdgeFactors[3]{};
+	if (!KTessellator.QuantizeTriFactors(KEdgeFactors, InsideTessFactor, FixedEdgeFactors, OutKey.FixedInsideFactor)) return false;
+
+	OutKey.MeshHash = HashMesh(Mesh);
+	OutKey.VertexCount = Mesh.vVertices.size();
+	OutKey.TriangleCount = Mesh.vTriangles.size();
+	OutKey.FixedEdgeFactor = FixedEdgeFactors[0];
+	OutKey.ePartitioning = ePartitioning;
+	return true;
+}
+
+uint64_t CTessellationCache::HashMesh(const SMesh& Mesh)
+{
+	// The counts keep the vertex and triangle bytes apart
+	const uint64_t KCounts[2]{ Mesh.vVertices.size(), Mesh.vTriangles.size() };
+	uint64_t Hash{ HashBytes(KHashSeed, KCounts, sizeof(KCounts)) };
+	Hash = HashBytes(Hash, Mesh.vVertices.data(), sizeof(SVertex3D) * Mesh.vVertices.size());
+	return HashBytes(Hash, Mesh.vTriangles.data(), sizeof(STriangle) * Mesh.vTriangles.size());
+}
+
+void CTessellationCache::SetMemoryLimit(size_t MemoryLimit)
+{
+	lock_guard<mutex> Lock{ m_Mutex };
+	m_MemoryLimit = MemoryLimit;
+	EvictLocked();
+}
+
+void CTessellationCache::Clear()
+{
+	lock_guard<mutex> Lock{ m_Mutex };
+
+	// Entries that are still being baked stay, so that their waiters are not orphaned
+	for (size_t iEntry = 0; iEntry < m_vEntries.size();)
+	{
+		if (m_vEntries[iEntry]->bIsReady)
+		{
+			RetireLocked(iEntry);
+		}
+		else
+		{
+			++iEntry;
+		}
+	}
+	m_ByteSize = 0;
+	ReclaimLocked();
+}
+
+STessellationCacheStats CTessellationCache::GetStats() const
+{
+	lock_guard<mutex> Lock{ m_Mutex };
+	STessellationCacheStats Result{};
+	Result.HitCount = m_HitCount.load(memory_order_relaxed);
+	Result.MissCount = m_MissCount.load(memory_order_relaxed);
+	Result.EvictionCount = m_EvictionCount.load(memory_order_relaxed);
+	for (const auto& Entry : m_vEntries)
+	{
+		if (Entry->bIsReady) ++Result.EntryCount;
+	}
+	Result.ByteSize = m_ByteSize;
+	return Result;
+}
+
+uint64_t CTessellationCache::HashKey(const STessellationCacheKey& Key)
+{
+	uint64_t Hash{ MixHash(Key.MeshHash ^ Key.VertexCount) };
+	Hash = MixHash(Hash ^ Key.TriangleCount);
+	Hash = MixHash(Hash ^ ((static_cast<uint64_t>(Key.FixedEdgeFactor) << 32) | Key.FixedInsideFactor));
+	return MixHash(Hash ^ static_cast<uint64_t>(Key.ePartitioning));
+}
+
+bool CTessellationCache::IsSameKey(const STessellationCacheKey& A, const STessellationCacheKey& B)
+{
+	return A.MeshHash == B.MeshHash && A.VertexCount == B.VertexCount && A.TriangleCount == B.TriangleCount &&
+		A.FixedEdgeFactor == B.FixedEdgeFactor && A.FixedInsideFactor == B.FixedInsideFactor && A.ePartitioning == B.ePartitioning;
+}
+
+CTessellationCache::SEntry* CTessellationCache::FindEntry(const STable& Table, const STessellationCacheKey& Key, uint64_t KeyHash) const
+{
+	// The table is never more than half used, so every probe reaches an empty slot
+	const size_t KMask{ Table.vSlots.size() - 1 };
+	for (size_t iSlot = static_cast<size_t>(KeyHash) & KMask; ; iSlot = (iSlot + 1) & KMask)
+	{
+		SEntry* const PtrEntry{ Table.vSlots[iSlot].load(memory_order_acquire) };
+		if (!PtrEntry) return nullptr;
+		if (PtrEntry != &m_Tombstone && PtrEntry->KeyHash == KeyHash && IsSameKey(PtrEntry->Key, Key)) return PtrEntry;
+	}
+}
+
+void CTessellationCache::Touch(SEntry& Entry) const
+{
+	Entry.LastUse.store(m_UseClock.fetch_add(1, memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+void CTessellationCache::InsertLocked(SEntry* const PtrEntry)
+{
+	if ((m_PtrTable.load()->UsedSlotCount + 1) * 2 > m_PtrTable.load()->vSlots.size()) RehashLocked();
+
+	// The key isn't in the table, so the first tombstone on its probe can be reused
+	STable& Table{ *m_PtrTable.load() };
+	const size_t KMask{ Table.vSlots.size() - 1 };
+	for (size_t iSlot = static_cast<size_t>(PtrEntry->KeyHash) & KMask; ; iSlot = (iSlot + 1) & KMask)
+	{
+		SEntry* const PtrSlotEntry{ Table.vSlots[iSlot].load(memory_order_relaxed) };
+		if (PtrSlotEntry && PtrSlotEntry != &m_Tombstone) continue;
+
+		if (!PtrSlotEntry) ++Table.UsedSlotCount;
+		Table.vSlots[iSlot].store(PtrEntry, memory_order_release);
+		return;
+	}
+}
+
+void CTessellationCache::UnlinkLocked(const SEntry* const PtrEntry)
+{
+	// A tombstone, not an empty slot, so that the probes that pass this slot still reach the entries after it
+	STable& Table{ *m_PtrTable.load() };
+	const size_t KMask{ Table.vSlots.size() - 1 };
+	for (size_t iSlot = static_cast<size_t>(PtrEntry->KeyHash) & KMask; ; iSlot = (iSlot + 1) & KMask)
+	{
+		if (Table.vSlots[iSlot].load(memory_order_relaxed) != PtrEntry) continue;
+
+		Table.vSlots[iSlot].store(&m_Tombstone, memory_order_release);
+		return;
+	}
+}
+
+void CTessellationCache::RehashLocked()
+{
+	size_t SlotCount{ KMinSlotCount };
+	while (SlotCount < (m_vEntries.size() + 1) * 4) SlotCount *= 2;
+
+	auto PtrTable{ make_unique<STable>(SlotCount) };
+	const size_t KMask{ SlotCount - 1 };
+	for (const auto& Entry : m_vEntries)
+	{
+		size_t iSlot{ static_cast<size_t>(Entry->KeyHash) & KMask };
+		while (PtrTable->vSlots[iSlot].load(memory_order_relaxed)) iSlot = (iSlot + 1) & KMask;
+		PtrTable->vSlots[iSlot].store(Entry.get(), memory_order_relaxed);
+		++PtrTable->UsedSlotCount;
+	}
+
+	// Readers that still probe the old table are waited for in ReclaimLocked()
+	m_vRetiredTables.emplace_back(m_PtrTable.exchange(PtrTable.release()));
+	ReclaimLocked();
+}
+
+void CTessellationCache::EvictLocked()
+{
+	while (m_ByteSize > m_MemoryLimit)
+	{
+		// The least recently used of the entries that are baked
+		size_t iOldest{ m_vEntries.size() };
+		uint64_t OldestUse{ UINT64_MAX };
+		for (size_t iEntry = 0; iEntry < m_vEntries.size(); ++iEntry)
+		{
+			const SEntry& KEntry{ *m_vEntries[iEntry] };
+			const uint64_t KLastUse{ KEntry.LastUse.load(memory_order_relaxed) };
+			if (KEntry.bIsReady && KLastUse < OldestUse)
+			{
+				iOldest = iEntry;
+				OldestUse = KLastUse;
+			}
+		}
+		if (iOldest == m_vEntries.size()) break;
+
+		m_ByteSize -= m_vEntries[iOldest]->ByteSize;
+		++m_EvictionCount;
+		RetireLocked(iOldest);
+	}
+	ReclaimLocked();
+}
+
+void CTessellationCache::RetireLocked(size_t EntryIndex)
+{
+	UnlinkLocked(m_vEntries[EntryIndex].get());
+	m_vRetiredEntries.emplace_back(std::move(m_vEntries[EntryIndex]));
+	m_vEntries[EntryIndex] = std::move(m_vEntries.back());
+	m_vEntries.pop_back();
+}
+
+void CTessellationCache::ReclaimLocked()
+{
+	if (m_vRetiredEntries.empty() && m_vRetiredTables.empty()) return;
+
+	// Readers that enter from now on can't see what was unlinked; the ones of the previous epoch might
+	const uint32_t KPreviousEpoch{ m_Epoch.fetch_add(1) };
+	while (m_ReaderCounts[KPreviousEpoch & 1].load() != 0) std::this_thread::yield();
+
+	m_vRetiredEntries.clear();
+	m_vRetiredTables.clear();
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "TessellationBaker.h"
+#include <atomic>
+#include <mutex>
+#include <future>
+
+class CThreadPool;
+
+// Two bakes with the same key give the same mesh
+struct STessellationCacheKey
+{
+	// See CTessellationCache::HashMesh()
+	uint64_t					MeshHash{};
+	// Compared along with the hash, so that meshes of different sizes never share an entry
+	uint64_t					VertexCount{};
+	uint64_t					TriangleCount{};
+	// 16.16, see CTessellator::QuantizeTriFactors()
+	uint32_t					FixedEdgeFactor{};
+	uint32_t					FixedInsideFactor{};
+	ETessellatorPartitioning	ePartitioning{};
+};
+
+struct STessellationCacheStats
+{
+	size_t		HitCount{};
+	size_t		MissCount{};
+	size_t		EvictionCount{};
+	size_t		EntryCount{};
+
+	// CPU size of the cached meshes
+	size_t		ByteSize{};
+
+	float GetHitRate() const { return (HitCount + MissCount == 0) ? 0.0f : static_cast<float>(HitCount) / static_cast<float>(HitCount + MissCount); }
+};
+
+// Memoizes CTessellationBaker::Bake() by the mesh's content, the factors quantized the way the tessellator quantizes them and the partitioning,
+// so that scrubbing back to a factor, or objects that share a mesh and settings, don't bake again.
+//  - Lookups are lock-free: entries sit in an open-addressed table of atomic slots that only the writer (under m_Mutex) changes.
+//    Readers announce themselves in a counter of the current epoch; a writer that unlinked entries or replaced the table flips the epoch and
+//    waits for the previous epoch's readers to leave before deleting them.
+//  - Concurrent misses of the same key wait for that one bake.
+//  - Least recently used entries are dropped once the cache exceeds its memory limit; callers that still hold a dropped mesh keep it alive.
+class CTessellationCache
+{
+public:
+	using SMeshPtr = std::shared_ptr<const SMesh>;
+
+private:
+	struct SEntry
+	{
+		STessellationCacheKey			Key{};
+		uint64_t						KeyHash{};
+		std::shared_future<SMeshPtr>	Future{};
+
+		// Written by the writer only
+		size_t							ByteSize{};
+		bool							bIsReady{ false };
+
+		// Value of m_UseClock at the last lookup
+		std::atomic<uint64_t>			LastUse{};
+	};
+
+	struct STable
+	{
+		STable(size_t SlotCount) : vSlots(SlotCount) {}
+
+		// A power of two; nullptr ends a probe, m_Tombstone continues it
+		std::vector<std::atomic<SEntry*>>	vSlots;
+		// Entries and tombstones
+		size_t								UsedSlotCount{};
+	};
+
+	// Keeps the calling thread in the current epoch for its lifetime
+	class CReadGuard
+	{
+	public:
+		CReadGuard(const CTessellationCache& Cache);
+		~CReadGuard();
+
+	private:
+		const CTessellationCache&	m_Cache;
+		uint32_t					m_Epoch{};
+	};
+
+public:
+	CTessellationCache(size_t MemoryLimit = KDefaultMemoryLimit);
+	~CTessellationCache();
+
+public:
+	// Bake()'s result, or nullptr if the factors cull every patch (or the mesh has no triangles).
+	// The cached mesh keeps the MaterialID of the first mesh baked with its key.
+	// If Bake() throws, the exception reaches this call and every call that waits for the same key, and the key is not cached.
+	SMeshPtr Get(const SMesh& Mesh, float EdgeTessFactor, float InsideTessFactor, ETessellatorPartitioning ePartitioning,
+		CThreadPool* const PtrThreadPool = nullptr);
+	// Lock-free; nullptr if the key isn't cached. Waits if the key is being baked.
+	SMeshPtr Find(const STessellationCacheKey& Key) const;
+
+	// Returns false if the factors cull every patch
+	static bool MakeKey(const SMesh& Mesh, float EdgeTessFactor, float InsideTessFactor, ETessellatorPartitioning ePartitioning,
+		STessellationCacheKey& OutKey);
+	// Of the vertices and triangles (not MaterialID)
+	static uint64_t HashMesh(const SMesh& Mesh);
+
+	void SetMemoryLimit(size_t MemoryLimit);
+	size_t GetMemoryLimit() const { return m_MemoryLimit; }
+
+	void Clear();
+
+	STessellationCacheStats GetStats() const;
+
+private:
+	static uint64_t HashKey(const STessellationCacheKey& Key);
+	static bool IsSameKey(const STessellationCacheKey& A, const STessellationCacheKey& B);
+
+	SEntry* FindEntry(const STable& Table, const STessellationCacheKey& Key, uint64_t KeyHash) const;
+	void Touch(SEntry& Entry) const;
+
+	// The following need m_Mutex
+	void InsertLocked(SEntry* const PtrEntry);
+	void UnlinkLocked(const SEntry* const PtrEntry);
+	// Rebuilds the table without tombstones, with room for twice the entries
+	void RehashLocked();
+	void EvictLocked();
+	// Unlinks m_vEntries[EntryIndex] and moves it to m_vRetiredEntries (the last entry takes its index)
+	void RetireLocked(size_t EntryIndex);
+	// Deletes the retired entries and tables once no reader can see them
+	void ReclaimLocked();
+
+public:
+	static constexpr size_t KDefaultMemoryLimit{ 64 * 1024 * 1024 };
+	static constexpr size_t KMinSlotCount{ 64 };
+
+private:
+	mutable std::mutex							m_Mutex{};
+	std::atomic<STable*>						m_PtrTable{};
+	// Owns the entries in m_PtrTable
+	std::vector<std::unique_ptr<SEntry>>		m_vEntries{};
+	std::vector<std::unique_ptr<SEntry>>		m_vRetiredEntries{};
+	std::vector<std::unique_ptr<STable>>		m_vRetiredTables{};
+	SEntry										m_Tombstone{};
+	size_t										m_MemoryLimit{};
+	size_t										m_ByteSize{};
+
+	mutable std::atomic<uint32_t>				m_Epoch{};
+	mutable std::atomic<uint32_t>				m_ReaderCounts[2]{};
+	mutable std::atomic<uint64_t>				m_UseClock{};
+
+	mutable std::atomic<size_t>					m_HitCount{};
+	mutable std::atomic<size_t>					m_MissCount{};
+	std::atomic<size_t>							m_EvictionCount{};
+};
@@ -0,0 +1,1058 @@
+#include "Tessellator.h"
+#include "SIMD.h"
+
+using std::max;
+using std::min;
+using std::vector;
+
+// 16.16 fixed point, as in the reference tessellator
+static constexpr uint32_t KFixedFractionBits{ 16 };
+static constexpr uint32_t KFixedFractionMask{ 0xFFFF };
+static constexpr uint32_t KFixedOne{ 0x1'0000 };
+static constexpr uint32_t KFixedHalf{ 0x8000 };
+static constexpr uint32_t KFixedOneThird{ 0x5555 };
+static constexpr uint32_t KFixedTwoThirds{ 0xAAAA };
+static constexpr float KFixedEpsilon{ 1.0f / 65'536.0f };
+static constexpr float KFixedToFloat{ 1.0f / 65'536.0f };
+
+// Points are placed on the half edges in this order as the factor grows, so that a fractional factor only moves the points that appear
+// last; stitching the outer ring to the first inner ring walks it to add the triangles in the same order.
+static constexpr int KFinalPointPositions[33]{ 0, 32, 16, 8, 17, 4, 18, 9, 19, 2, 20, 10, 21, 5, 22, 11, 23, 1, 24, 12, 25, 6, 26, 13, 27, 3,
+	28, 14, 29, 7, 30, 15, 31 };
+
+static uint32_t FloatToFixed(float Value)
+{
+	return static_cast<uint32_t>(Value * 65'536.0f + 0.5f);
+}
+
+static uint32_t FloorFixed(uint32_t Value)
+{
+	return Value & ~KFixedFractionMask;
+}
+
+static uint32_t CeilFixed(uint32_t Value)
+{
+	return (Value + KFixedFractionMask) & ~KFixedFractionMask;
+}
+
+// 1 / SegmentCount rounded to 16.16; the reference tessellator's table holds the same values
+static uint32_t GetFixedReciprocal(int SegmentCount)
+{
+	if (SegmentCount <= 0) return 0xFFFF'FFFF;
+	return (KFixedOne + static_cast<uint32_t>(SegmentCount / 2)) / static_cast<uint32_t>(SegmentCount);
+}
+
+static int RemoveMostSignificantBit(int Value)
+{
+	int Bit{ 1 };
+	while ((Bit << 1) <= Value) Bit <<= 1;
+	return Value & ~Bit;
+}
+
+static bool IsEven(int Value)
+{
+	return (Value & 1) == 0;
+}
+
+// NaN goes to the lower bound
+static float ClampFactor(float Factor, float Lower, float Upper)
+{
+	return (Factor > Lower) ? ((Factor < Upper) ? Factor : Upper) : Lower;
+}
+
+// Every lane is a point index; see CTessellator::PlacePoints() for the scalar version
+static __m256i PlacePointsAVX2(const __m256i& Points, int HalfCount, bool bIsOdd, int SplitPoint,
+	uint32_t InverseFloor, uint32_t InverseCeil, uint32_t Fraction)
+{
+	const __m256i KHalfCount{ _mm256_set1_epi32(HalfCount) };
+	const __m256i KFixedOneLanes{ _mm256_set1_epi32(static_cast<int>(KFixedOne)) };
+	const __m256i KFixedHalfLanes{ _mm256_set1_epi32(static_cast<int>(KFixedHalf)) };
+
+	// Points past the middle mirror the first half
+	const __m256i KFlipMask{ _mm256_cmpgt_epi32(Points, _mm256_sub_epi32(KHalfCount, _mm256_set1_epi32(1))) };
+	const __m256i KMirrored{ _mm256_sub_epi32(_mm256_sub_epi32(_mm256_add_epi32(KHalfCount, KHalfCount), Points), _mm256_set1_epi32(bIsOdd ? 1 : 0)) };
+	const __m256i KPoints{ _mm256_blendv_epi8(Points, KMirrored, KFlipMask) };
+	const __m256i KMiddleMask{ _mm256_cmpeq_epi32(KPoints, KHalfCount) };
+
+	// The comparison mask is -1 where the point is past the split
+	const __m256i KFloorPoints{ _mm256_add_epi32(KPoints, _mm256_cmpgt_epi32(KPoints, _mm256_set1_epi32(SplitPoint))) };
+	const __m256i KFloorLocations{ _mm256_mullo_epi32(KFloorPoints, _mm256_set1_epi32(static_cast<int>(InverseFloor))) };
+	const __m256i KCeilLocations{ _mm256_mullo_epi32(KPoints, _mm256_set1_epi32(static_cast<int>(InverseCeil))) };
+	const __m256i KBlended{ _mm256_add_epi32(
+		_mm256_add_epi32(
+			_mm256_mullo_epi32(KFloorLocations, _mm256_set1_epi32(static_cast<int>(KFixedOne - Fraction))),
+			_mm256_mullo_epi32(KCeilLocations, _mm256_set1_epi32(static_cast<int>(Fraction)))),
+		KFixedHalfLanes) };
+	const __m256i KLocations{ _mm256_srli_epi32(KBlended, KFixedFractionBits) };
+	const __m256i KFlipped{ _mm256_blendv_epi8(KLocations, _mm256_sub_epi32(KFixedOneLanes, KLocations), KFlipMask) };
+	return _mm256_blendv_epi8(KFlipped, KFixedHalfLanes, KMiddleMask);
+}
+
+static __m128i SelectSSE(const __m128i& Mask, const __m128i& IfTrue, const __m128i& IfFalse)
+{
+	return _mm_or_si128(_mm_and_si128(Mask, IfTrue), _mm_andnot_si128(Mask, IfFalse));
+}
+
+// SSE2 has no _mm_mullo_epi32; the low halves of two 32 x 32 -> 64-bit products are the same bits
+static __m128i MultiplyLowSSE(const __m128i& A, const __m128i& B)
+{
+	const __m128i KEven{ _mm_mul_epu32(A, B) };
+	const __m128i KOdd{ _mm_mul_epu32(_mm_srli_epi64(A, 32), _mm_srli_epi64(B, 32)) };
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(KEven, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(KOdd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static __m128i PlacePointsSSE(const __m128i& Points, int HalfCount, bool bIsOdd, int SplitPoint,
+	uint32_t InverseFloor, uint32_t InverseCeil, uint32_t Fraction)
+{
+	const __m128i KHalfCount{ _mm_set1_epi32(HalfCount) };
+	const __m128i KFixedOneLanes{ _mm_set1_epi32(static_cast<int>(KFixedOne)) };
+	const __m128i KFixedHalfLanes{ _mm_set1_epi32(static_cast<int>(KFixedHalf)) };
+
+	const __m128i KFlipMask{ _mm_cmpgt_epi32(Points, _mm_sub_epi32(KHalfCount, _mm_set1_epi32(1))) };
+	const __m128i KMirrored{ _mm_sub_epi32(_mm_sub_epi32(_mm_add_epi32(KHalfCount, KHalfCount), Points), _mm_set1_epi32(bIsOdd ? 1 : 0)) };
+	const __m128i KPoints{ SelectSSE(KFlipMask, KMirrored, Points) };
+	const __m128i KMiddleMask{ _mm_cmpeq_epi32(KPoints, KHalfCount) };
+
+	const __m128i KFloorPoints{ _mm_add_epi32(KPoints, _mm_cmpgt_epi32(KPoints, _mm_set1_epi32(SplitPoint))) };
+	const __m128i KFloorLocations{ MultiplyLowSSE(KFloorPoints, _mm_set1_epi32(static_cast<int>(InverseFloor))) };
+	const __m128i KCeilLocations{ MultiplyLowSSE(KPoints, _mm_set1_epi32(static_cast<int>(InverseCeil))) };
+	const __m128i KBlended{ _mm_add_epi32(
+		_mm_add_epi32(
+			MultiplyLowSSE(KFloorLocations, _mm_set1_epi32(static_cast<int>(KFixedOne - Fraction))),
+			MultiplyLowSSE(KCeilLocations, _mm_set1_epi32(static_cast<int>(Fraction)))),
+		KFixedHalfLanes) };
+	const __m128i KLocations{ _mm_srli_epi32(KBlended, KFixedFractionBits) };
+	const __m128i KFlipped{ SelectSSE(KFlipMask, _mm_sub_epi32(KFixedOneLanes, KLocations), KLocations) };
+	return SelectSSE(KMiddleMask, KFixedHalfLanes, KFlipped);
+}
+
+static void ConvertFixedToFloatAVX2(const uint32_t* const PtrValues, size_t Count, float* const OutPtrValues)
+{
+	const __m256 KScale{ _mm256_set1_ps(KFixedToFloat) };
+	size_t iValue{};
+	for (; iValue + 8 <= Count; iValue += 8)
+	{
+		const __m256i KValues{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(PtrValues + iValue)) };
+		_mm256_storeu_ps(OutPtrValues + iValue, _mm256_mul_ps(_mm256_cvtepi32_ps(KValues), KScale));
+	}
+	for (; iValue < Count; ++iValue) OutPtrValues[iValue] = static_cast<float>(PtrValues[iValue]) * KFixedToFloat;
+}
+
+static void ConvertFixedToFloatSSE(const uint32_t* const PtrValues, size_t Count, float* const OutPtrValues)
+{
+	const __m128 KScale{ _mm_set1_ps(KFixedToFloat) };
+	size_t iValue{};
+	for (; iValue + 4 <= Count; iValue += 4)
+	{
+		const __m128i KValues{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(PtrValues + iValue)) };
+		_mm_storeu_ps(OutPtrValues + iValue, _mm_mul_ps(_mm_cvtepi32_ps(KValues), KScale));
+	}
+	for (; iValue < Count; ++iValue) OutPtrValues[iValue] = static_cast<float>(PtrValues[iValue]) * KFixedToFloat;
+}
+
+CTessellator::CTessellator(ETessellatorPartitioning ePartitioning, bool bIsClockwise) :
+	m_ePartitioning{ ePartitioning }, m_bIsClockwise{ bIsClockwise }
+{
+}
+
+bool CTessellator::TessellateTri(const float(&EdgeFactors)[3], float InsideFactor)
+{
+	m_vDomainPoints.clear();
+	m_vTriangles.clear();
+
+	STriFactors Factors{};
+	ProcessTriFactors(EdgeFactors, InsideFactor, Factors);
+	if (Factors.bIsCulled) return false;
+
+	if (Factors.bIsMinimum)
+	{
+		m_vDomainPoints.emplace_back(1.0f, 0.0f);
+		m_vDomainPoints.emplace_back(0.0f, 1.0f);
+		m_vDomainPoints.emplace_back(0.0f, 0.0f);
+		AddTriangle(0, 1, 2);
+		return true;
+	}
+
+	GenerateTriPoints(Factors);
+	GenerateTriTriangles(Factors);
+	return true;
+}
+
+size_t CTessellator::GetTriTriangleCount(const float(&EdgeFactors)[3], float InsideFactor) const
+{
+	STriFactors Factors{};
+	ProcessTriFactors(EdgeFactors, InsideFactor, Factors);
+	if (Factors.bIsCulled) return 0;
+	if (Factors.bIsMinimum) return 1;
+
+	// Every ring's edge is a strip between InsideEdgePointCount and OutsideEdgePointCount points
+	int EdgePointCounts[3]{ Factors.EdgePointCounts[0], Factors.EdgePointCounts[1], Factors.EdgePointCounts[2] };
+	size_t TriangleCount{};
+	const int KRingCount{ (Factors.InsidePointCount + 1) >> 1 };
+	for (int iRing = 1; iRing < KRingCount; ++iRing)
+	{
+		const int KInsideEdgePointCount{ Factors.InsidePointCount - 2 * iRing };
+		for (int iEdge = 0; iEdge < 3; ++iEdge)
+		{
+			TriangleCount += static_cast<size_t>(KInsideEdgePointCount + EdgePointCounts[iEdge] - 2);
+			EdgePointCounts[iEdge] = KInsideEdgePointCount;
+		}
+	}
+	if (Factors.InsideContext.eParity == EParity::Odd) ++TriangleCount;
+	return TriangleCount;
+}
+
+bool CTessellator::QuantizeTriFactors(const float(&EdgeFactors)[3], float InsideFactor, uint32_t(&OutFixedEdgeFactors)[3],
+	uint32_t& OutFixedInsideFactor) const
+{
+	float Edges[3]{};
+	float Inside{};
+	if (!ClampTriFactors(EdgeFactors, InsideFactor, Edges, Inside)) return false;
+
+	for (int iEdge = 0; iEdge < 3; ++iEdge) OutFixedEdgeFactors[iEdge] = FloatToFixed(Edges[iEdge]);
+	OutFixedInsideFactor = FloatToFixed(Inside);
+	return true;
+}
+
+bool CTessellator::ClampTriFactors(const float(&EdgeFactors)[3], float InsideFactor, float(&OutEdges)[3], float& OutInside) const
+{
+	// !(Factor > 0) also catches NaN
+	if (!(EdgeFactors[0] > 0.0f) || !(EdgeFactors[1] > 0.0f) || !(EdgeFactors[2] > 0.0f)) return false;
+
+	float LowerBound{ (m_ePartitioning == ETessellatorPartitioning::FractionalEven) ? 2.0f : 1.0f };
+	float UpperBound{ (m_ePartitioning == ETessellatorPartitioning::FractionalOdd) ? KMaxFactor - 1.0f : KMaxFactor };
+
+	for (int iEdge = 0; iEdge < 3; ++iEdge)
+	{
+		OutEdges[iEdge] = ClampFactor(EdgeFactors[iEdge], LowerBound, UpperBound);
+		if (IsIntegerPartitioning()) OutEdges[iEdge] = ceilf(OutEdges[iEdge]);
+	}
+
+	// An odd inside factor of exactly 1 would collapse the inner rings while an edge is tessellated
+	if (m_ePartitioning == ETessellatorPartitioning::FractionalOdd)
+	{
+		const float KHalfEpsilon{ KFixedEpsilon / 2.0f };
+		if (OutEdges[0] > 1.0f + KHalfEpsilon || OutEdges[1] > 1.0f + KHalfEpsilon || OutEdges[2] > 1.0f + KHalfEpsilon)
+		{
+			LowerBound = 1.0f + KFixedEpsilon;
+		}
+	}
+	OutInside = ClampFactor(InsideFactor, LowerBound, UpperBound);
+	if (IsIntegerPartitioning()) OutInside = ceilf(OutInside);
+	return true;
+}
+
+void CTessellator::ProcessTriFactors(const float(&EdgeFactors)[3], float InsideFactor, STriFactors& Out) const
+{
+	float Edges[3]{};
+	float Inside{};
+	if (!ClampTriFactors(EdgeFactors, InsideFactor, Edges, Inside))
+	{
+		Out.bIsCulled = true;
+		return;
+	}
+
+	EParity eParity{ (m_ePartitioning == ETessellatorPartitioning::FractionalEven) ? EParity::Even : EParity::Odd };
+	EParity EdgeParities[3]{ eParity, eParity, eParity };
+	EParity eInsideParity{ eParity };
+	if (IsIntegerPartitioning())
+	{
+		for (int iEdge = 0; iEdge < 3; ++iEdge)
+		{
+			EdgeParities[iEdge] = IsEven(static_cast<int>(Edges[iEdge])) ? EParity::Even : EParity::Odd;
+		}
+		eInsideParity = (IsEven(static_cast<int>(Inside)) || Inside == 1.0f) ? EParity::Even : EParity::Odd;
+	}
+
+	uint32_t FixedEdges[3]{};
+	for (int iEdge = 0; iEdge < 3; ++iEdge) FixedEdges[iEdge] = FloatToFixed(Edges[iEdge]);
+	const uint32_t KFixedInside{ FloatToFixed(Inside) };
+
+	if (m_ePartitioning != ETessellatorPartitioning::FractionalEven &&
+		FixedEdges[0] == KFixedOne && FixedEdges[1] == KFixedOne && FixedEdges[2] == KFixedOne && KFixedInside == KFixedOne)
+	{
+		Out.bIsMinimum = true;
+		return;
+	}
+
+	Out.PointCount = 0;
+	for (int iEdge = 0; iEdge < 3; ++iEdge)
+	{
+		ComputeFactorContext(FixedEdges[iEdge], EdgeParities[iEdge], Out.EdgeContexts[iEdge]);
+		Out.EdgePointCounts[iEdge] = GetPointCount(FixedEdges[iEdge], EdgeParities[iEdge]);
+		Out.PointCount += Out.EdgePointCounts[iEdge];
+	}
+	// The corners are shared
+	Out.PointCount -= 3;
+
+	ComputeFactorContext(KFixedInside, eInsideParity, Out.InsideContext);
+	const int KMinInsidePointCount{ (eInsideParity == EParity::Odd) ? 4 : 3 };
+	Out.InsidePointCount = max(KMinInsidePointCount, GetPointCount(KFixedInside, eInsideParity));
+	Out.InsidePointBaseOffset = Out.PointCount;
+
+	const int KInnerRingCount{ (Out.InsidePointCount >> 1) - 1 };
+	if (eInsideParity == EParity::Odd)
+	{
+		Out.PointCount += 3 * KInnerRingCount * KInnerRingCount;
+	}
+	else
+	{
+		// And the center point
+		Out.PointCount += 3 * KInnerRingCount * (KInnerRingCount + 1) + 1;
+	}
+}
+
+void CTessellator::GenerateTriPoints(const STriFactors& Factors)
+{
+	for (int iEdge = 0; iEdge < 3; ++iEdge)
+	{
+		m_vEdgeLocations[iEdge].resize(Factors.EdgePointCounts[iEdge]);
+		PlacePoints(Factors.EdgeContexts[iEdge], Factors.EdgePointCounts[iEdge], m_vEdgeLocations[iEdge].data());
+	}
+	m_vInsideLocations[0].resize(Factors.InsidePointCount);
+	PlacePoints(Factors.InsideContext, Factors.InsidePointCount, m_vInsideLocations[0].data());
+
+	m_vFixedPoints.resize(static_cast<size_t>(Factors.PointCount) * 2);
+	uint32_t* PtrPoint{ m_vFixedPoints.data() };
+
+	// Outer ring: from (0, 1) down the u == 0 edge, along v == 0 and back up w == 0; the last point of an edge is the next one's first
+	for (int iEdge = 0; iEdge < 3; ++iEdge)
+	{
+		const uint32_t* const KPtrLocations{ m_vEdgeLocations[iEdge].data() };
+		const int KEnd{ Factors.EdgePointCounts[iEdge] - 1 };
+		for (int iPoint = 0; iPoint < KEnd; ++iPoint)
+		{
+			const uint32_t KParameter{ KPtrLocations[(iEdge & 1) ? iPoint : KEnd - iPoint] };
+			switch (iEdge)
+			{
+			case 0:
+				*PtrPoint++ = 0;
+				*PtrPoint++ = KParameter;
+				break;
+			case 1:
+				*PtrPoint++ = KParameter;
+				*PtrPoint++ = 0;
+				break;
+			default:
+				*PtrPoint++ = KParameter;
+				*PtrPoint++ = KFixedOne - KParameter;
+				break;
+			}
+		}
+	}
+
+	// Inner rings: the inside factor's points, moved a third of the way in per ring and centered on the shorter edge
+	const uint32_t* const KPtrInside{ m_vInsideLocations[0].data() };
+	const int KRingCount{ Factors.InsidePointCount >> 1 };
+	for (int iRing = 1; iRing < KRingCount; ++iRing)
+	{
+		const int KStart{ iRing };
+		const int KEnd{ Factors.InsidePointCount - 1 - iRing };
+		const uint32_t KPerpendicular{ (KPtrInside[KStart] * KFixedTwoThirds + KFixedHalf) >> KFixedFractionBits };
+		const uint32_t KHalfPerpendicular{ (KPerpendicular + 1) / 2 };
+		for (int iEdge = 0; iEdge < 3; ++iEdge)
+		{
+			for (int iPoint = KStart; iPoint < KEnd; ++iPoint)
+			{
+				const uint32_t KParameter{ KPtrInside[(iEdge & 1) ? iPoint : KEnd - (iPoint - KStart)] - KHalfPerpendicular };
+				switch (iEdge)
+				{
+				case 0:
+					*PtrPoint++ = KPerpendicular;
+					*PtrPoint++ = KParameter;
+					break;
+				case 1:
+					*PtrPoint++ = KParameter;
+					*PtrPoint++ = KPerpendicular;
+					break;
+				default:
+					*PtrPoint++ = KParameter;
+					*PtrPoint++ = KFixedOne - KParameter - KPerpendicular;
+					break;
+				}
+			}
+		}
+	}
+	if (Factors.InsideContext.eParity == EParity::Even)
+	{
+		*PtrPoint++ = KFixedOneThird;
+		*PtrPoint++ = KFixedOneThird;
+	}
+	assert(PtrPoint == m_vFixedPoints.data() + m_vFixedPoints.size());
+
+	ConvertPoints();
+}
+
+void CTessellator::GenerateTriTriangles(const STriFactors& Factors)
+{
+	int EdgePointCounts[3]{ Factors.EdgePointCounts[0], Factors.EdgePointCounts[1], Factors.EdgePointCounts[2] };
+	int InsideBase{ Factors.InsidePointBaseOffset };
+	int OutsideBase{};
+
+	const int KRingCount{ (Factors.InsidePointCount + 1) >> 1 };
+	for (int iRing = 1; iRing < KRingCount; ++iRing)
+	{
+		const int KInsideEdgePointCount{ Factors.InsidePointCount - 2 * iRing };
+		const int KRingInsideBase{ InsideBase };
+		const int KRingOutsideBase{ OutsideBase };
+		for (int iEdge = 0; iEdge < 3; ++iEdge)
+		{
+			int InsideOffset{ InsideBase };
+			int OutsideOffset{ OutsideBase };
+			if (iEdge == 2)
+			{
+				// The last points of the last edge are the first points of the ring
+				m_IndexPatch.InsideDelta = InsideBase;
+				m_IndexPatch.InsideBadIndex = KInsideEdgePointCount - 1;
+				m_IndexPatch.InsideReplacement = KRingInsideBase;
+				m_IndexPatch.OutsideBase = m_IndexPatch.InsideBadIndex + 1;
+				m_IndexPatch.OutsideDelta = OutsideBase - m_IndexPatch.OutsideBase;
+				m_IndexPatch.OutsideBadIndex = m_IndexPatch.OutsideBase + EdgePointCounts[iEdge] - 1;
+				m_IndexPatch.OutsideReplacement = KRingOutsideBase;
+				m_bIsPatchingIndices = true;
+
+				InsideOffset = 0;
+				OutsideOffset = m_IndexPatch.OutsideBase;
+			}
+
+			if (iRing == 1)
+			{
+				StitchTransition(InsideOffset, Factors.InsideContext, OutsideOffset, Factors.EdgeContexts[iEdge]);
+			}
+			else
+			{
+				StitchRegular(true, EDiagonals::Mirrored, KInsideEdgePointCount, InsideOffset, OutsideOffset);
+			}
+			m_bIsPatchingIndices = false;
+
+			OutsideBase += EdgePointCounts[iEdge] - 1;
+			InsideBase += KInsideEdgePointCount - 1;
+			EdgePointCounts[iEdge] = KInsideEdgePointCount;
+		}
+	}
+
+	// Odd inside factors end in a triangle instead of a point
+	if (Factors.InsideContext.eParity == EParity::Odd) AddTriangle(OutsideBase, OutsideBase + 1, OutsideBase + 2);
+}
+
+bool CTessellator::TessellateQuad(const float(&EdgeFactors)[4], const float(&InsideFactors)[2])
+{
+	m_vDomainPoints.clear();
+	m_vTriangles.clear();
+
+	SQuadFactors Factors{};
+	ProcessQuadFactors(EdgeFactors, InsideFactors, Factors);
+	if (Factors.bIsCulled) return false;
+
+	if (Factors.bIsMinimum)
+	{
+		m_vDomainPoints.emplace_back(0.0f, 0.0f);
+		m_vDomainPoints.emplace_back(1.0f, 0.0f);
+		m_vDomainPoints.emplace_back(1.0f, 1.0f);
+		m_vDomainPoints.emplace_back(0.0f, 1.0f);
+		AddTriangle(0, 1, 3);
+		AddTriangle(1, 2, 3);
+		return true;
+	}
+
+	GenerateQuadPoints(Factors);
+	GenerateQuadTriangles(Factors);
+	return true;
+}
+
+size_t CTessellator::GetQuadTriangleCount(const float(&EdgeFactors)[4], const float(&InsideFactors)[2]) const
+{
+	SQuadFactors Factors{};
+	ProcessQuadFactors(EdgeFactors, InsideFactors, Factors);
+	if (Factors.bIsCulled) return 0;
+	if (Factors.bIsMinimum) return 2;
+
+	const int(&KInsidePointCounts)[2]{ Factors.InsidePointCounts };
+	int EdgePointCounts[4]{ Factors.EdgePointCounts[0], Factors.EdgePointCounts[1], Factors.EdgePointCounts[2], Factors.EdgePointCounts[3] };
+	size_t TriangleCount{};
+	const int KRingCount{ min((KInsidePointCounts[0] + 1) >> 1, (KInsidePointCounts[1] + 1) >> 1) };
+	for (int iRing = 1; iRing < KRingCount; ++iRing)
+	{
+		for (int iEdge = 0; iEdge < 4; ++iEdge)
+		{
+			const int KInsideEdgePointCount{ KInsidePointCounts[(iEdge + 1) & 1] - 2 * iRing };
+			TriangleCount += static_cast<size_t>(KInsideEdgePointCount + EdgePointCounts[iEdge] - 2);
+			EdgePointCounts[iEdge] = KInsideEdgePointCount;
+		}
+	}
+	TriangleCount += static_cast<size_t>(GetQuadStripQuadCount(Factors)) * 2;
+	return TriangleCount;
+}
+
+void CTessellator::ProcessQuadFactors(const float(&EdgeFactors)[4], const float(&InsideFactors)[2], SQuadFactors& Out) const
+{
+	if (!(EdgeFactors[0] > 0.0f) || !(EdgeFactors[1] > 0.0f) || !(EdgeFactors[2] > 0.0f) || !(EdgeFactors[3] > 0.0f))
+	{
+		Out.bIsCulled = true;
+		return;
+	}
+
+	EParity eParity{ (m_ePartitioning == ETessellatorPartitioning::FractionalEven) ? EParity::Even : EParity::Odd };
+	float LowerBound{ (m_ePartitioning == ETessellatorPartitioning::FractionalEven) ? 2.0f : 1.0f };
+	float UpperBound{ (m_ePartitioning == ETessellatorPartitioning::FractionalOdd) ? KMaxFactor - 1.0f : KMaxFactor };
+
+	float Edges[4]{};
+	for (int iEdge = 0; iEdge < 4; ++iEdge)
+	{
+		Edges[iEdge] = ClampFactor(EdgeFactors[iEdge], LowerBound, UpperBound);
+		if (IsIntegerPartitioning()) Edges[iEdge] = ceilf(Edges[iEdge]);
+	}
+
+	// Unlike tris, the inside factors count too: either one above 1 needs the other's rows
+	if (m_ePartitioning == ETessellatorPartitioning::FractionalOdd)
+	{
+		const float KHalfEpsilon{ KFixedEpsilon / 2.0f };
+		bool bIsAboveOne{ InsideFactors[0] > 1.0f + KHalfEpsilon || InsideFactors[1] > 1.0f + KHalfEpsilon };
+		for (int iEdge = 0; iEdge < 4; ++iEdge) bIsAboveOne = bIsAboveOne || Edges[iEdge] > 1.0f + KHalfEpsilon;
+		if (bIsAboveOne) LowerBound = 1.0f + KFixedEpsilon;
+	}
+	float Insides[2]{};
+	for (int iAxis = 0; iAxis < 2; ++iAxis)
+	{
+		Insides[iAxis] = ClampFactor(InsideFactors[iAxis], LowerBound, UpperBound);
+		if (IsIntegerPartitioning()) Insides[iAxis] = ceilf(Insides[iAxis]);
+	}
+
+	EParity EdgeParities[4]{ eParity, eParity, eParity, eParity };
+	EParity InsideParities[2]{ eParity, eParity };
+	if (IsIntegerPartitioning())
+	{
+		for (int iEdge = 0; iEdge < 4; ++iEdge)
+		{
+			EdgeParities[iEdge] = IsEven(static_cast<int>(Edges[iEdge])) ? EParity::Even : EParity::Odd;
+		}
+		for (int iAxis = 0; iAxis < 2; ++iAxis)
+		{
+			InsideParities[iAxis] = (IsEven(static_cast<int>(Insides[iAxis])) || Insides[iAxis] == 1.0f) ? EParity::Even : EParity::Odd;
+		}
+	}
+
+	uint32_t FixedEdges[4]{};
+	for (int iEdge = 0; iEdge < 4; ++iEdge) FixedEdges[iEdge] = FloatToFixed(Edges[iEdge]);
+	const uint32_t KFixedInsides[2]{ FloatToFixed(Insides[0]), FloatToFixed(Insides[1]) };
+
+	if (m_ePartitioning != ETessellatorPartitioning::FractionalEven &&
+		FixedEdges[0] == KFixedOne && FixedEdges[1] == KFixedOne && FixedEdges[2] == KFixedOne && FixedEdges[3] == KFixedOne &&
+		KFixedInsides[0] == KFixedOne && KFixedInsides[1] == KFixedOne)
+	{
+		Out.bIsMinimum = true;
+		return;
+	}
+
+	Out.PointCount = 0;
+	for (int iEdge = 0; iEdge < 4; ++iEdge)
+	{
+		ComputeFactorContext(FixedEdges[iEdge], EdgeParities[iEdge], Out.EdgeContexts[iEdge]);
+		Out.EdgePointCounts[iEdge] = GetPointCount(FixedEdges[iEdge], EdgeParities[iEdge]);
+		Out.PointCount += Out.EdgePointCounts[iEdge];
+	}
+	Out.PointCount -= 4;
+
+	for (int iAxis = 0; iAxis < 2; ++iAxis)
+	{
+		ComputeFactorContext(KFixedInsides[iAxis], InsideParities[iAxis], Out.InsideContexts[iAxis]);
+		const int KMinInsidePointCount{ (InsideParities[iAxis] == EParity::Odd) ? 4 : 3 };
+		Out.InsidePointCounts[iAxis] = max(KMinInsidePointCount, GetPointCount(KFixedInsides[iAxis], InsideParities[iAxis]));
+	}
+	Out.InsidePointBaseOffset = Out.PointCount;
+
+	// Every point of the inside grid but its border
+	Out.PointCount += (Out.InsidePointCounts[0] - 2) * (Out.InsidePointCounts[1] - 2);
+}
+
+void CTessellator::GenerateQuadPoints(const SQuadFactors& Factors)
+{
+	for (int iEdge = 0; iEdge < 4; ++iEdge)
+	{
+		m_vEdgeLocations[iEdge].resize(Factors.EdgePointCounts[iEdge]);
+		PlacePoints(Factors.EdgeContexts[iEdge], Factors.EdgePointCounts[iEdge], m_vEdgeLocations[iEdge].data());
+	}
+	for (int iAxis = 0; iAxis < 2; ++iAxis)
+	{
+		m_vInsideLocations[iAxis].resize(Factors.InsidePointCounts[iAxis]);
+		PlacePoints(Factors.InsideContexts[iAxis], Factors.InsidePointCounts[iAxis], m_vInsideLocations[iAxis].data());
+	}
+
+	m_vFixedPoints.resize(static_cast<size_t>(Factors.PointCount) * 2);
+	uint32_t* PtrPoint{ m_vFixedPoints.data() };
+
+	// Outer ring: from (0, 1) down the u == 0 edge, then along v == 0, up u == 1 and back along v == 1
+	for (int iEdge = 0; iEdge < 4; ++iEdge)
+	{
+		const uint32_t* const KPtrLocations{ m_vEdgeLocations[iEdge].data() };
+		const int KEnd{ Factors.EdgePointCounts[iEdge] - 1 };
+		for (int iPoint = 0; iPoint < KEnd; ++iPoint)
+		{
+			const uint32_t KParameter{ KPtrLocations[(iEdge == 1 || iEdge == 2) ? iPoint : KEnd - iPoint] };
+			if (iEdge & 1)
+			{
+				*PtrPoint++ = KParameter;
+				*PtrPoint++ = (iEdge == 3) ? KFixedOne : 0;
+			}
+			else
+			{
+				*PtrPoint++ = (iEdge == 2) ? KFixedOne : 0;
+				*PtrPoint++ = KParameter;
+			}
+		}
+	}
+
+	// Inner rings, in the same order; the u rows take the u inside factor's points and the v rows the v one's
+	const int(&KInsidePointCounts)[2]{ Factors.InsidePointCounts };
+	const int KRingCount{ min(KInsidePointCounts[0], KInsidePointCounts[1]) >> 1 };
+	for (int iRing = 1; iRing < KRingCount; ++iRing)
+	{
+		const int KStart{ iRing };
+		const int KEnds[2]{ KInsidePointCounts[0] - 1 - iRing, KInsidePointCounts[1] - 1 - iRing };
+		for (int iEdge = 0; iEdge < 4; ++iEdge)
+		{
+			// The axis across the edge and the one along it
+			const int KAcross{ iEdge & 1 };
+			const int KAlong{ (iEdge + 1) & 1 };
+			const uint32_t KPerpendicular{ m_vInsideLocations[KAcross][(iEdge < 2) ? KStart : KEnds[KAcross]] };
+			const uint32_t* const KPtrLocations{ m_vInsideLocations[KAlong].data() };
+			const int KEnd{ KEnds[KAlong] };
+			for (int iPoint = KStart; iPoint < KEnd; ++iPoint)
+			{
+				const uint32_t KParameter{ KPtrLocations[(iEdge == 1 || iEdge == 2) ? iPoint : KEnd - (iPoint - KStart)] };
+				if (KAlong)
+				{
+					*PtrPoint++ = KPerpendicular;
+					*PtrPoint++ = KParameter;
+				}
+				else
+				{
+					*PtrPoint++ = KParameter;
+					*PtrPoint++ = KPerpendicular;
+				}
+			}
+		}
+	}
+
+	// An even inside factor on the shorter axis ends in a row of points through the middle instead of a ring
+	if (KInsidePointCounts[0] > KInsidePointCounts[1] && Factors.InsideContexts[1].eParity == EParity::Even)
+	{
+		for (int iPoint = KRingCount; iPoint <= KInsidePointCounts[0] - 1 - KRingCount; ++iPoint)
+		{
+			*PtrPoint++ = m_vInsideLocations[0][iPoint];
+			*PtrPoint++ = KFixedHalf;
+		}
+	}
+	else if (KInsidePointCounts[1] >= KInsidePointCounts[0] && Factors.InsideContexts[0].eParity == EParity::Even)
+	{
+		for (int iPoint = KInsidePointCounts[1] - 1 - KRingCount; iPoint >= KRingCount; --iPoint)
+		{
+			*PtrPoint++ = KFixedHalf;
+			*PtrPoint++ = m_vInsideLocations[1][iPoint];
+		}
+	}
+	assert(PtrPoint == m_vFixedPoints.data() + m_vFixedPoints.size());
+
+	ConvertPoints();
+}
+
+void CTessellator::GenerateQuadTriangles(const SQuadFactors& Factors)
+{
+	const int(&KInsidePointCounts)[2]{ Factors.InsidePointCounts };
+	const int KRowsToCenter[2]{ (KInsidePointCounts[0] + 1) >> 1, (KInsidePointCounts[1] + 1) >> 1 };
+	const int KRingCount{ min(KRowsToCenter[0], KRowsToCenter[1]) };
+	// The ring (by the axis along its edges) whose u == 1 and v == 1 edges are the middle row of points, walked backwards
+	const int KDegenerateRings[2]{
+		(Factors.InsideContexts[1].eParity == EParity::Even) ? KRowsToCenter[1] - 1 : -1,
+		(Factors.InsideContexts[0].eParity == EParity::Even) ? KRowsToCenter[0] - 1 : -1 };
+
+	int EdgePointCounts[4]{ Factors.EdgePointCounts[0], Factors.EdgePointCounts[1], Factors.EdgePointCounts[2], Factors.EdgePointCounts[3] };
+	int InsideBase{ Factors.InsidePointBaseOffset };
+	int OutsideBase{};
+	for (int iRing = 1; iRing < KRingCount; ++iRing)
+	{
+		const int KInsideEdgePointCounts[2]{ KInsidePointCounts[0] - 2 * iRing, KInsidePointCounts[1] - 2 * iRing };
+		const int KRingInsideBase{ InsideBase };
+		const int KRingOutsideBase{ OutsideBase };
+		for (int iEdge = 0; iEdge < 4; ++iEdge)
+		{
+			const int KAlong{ (iEdge + 1) & 1 };
+			const int KInsideEdgePointCount{ KInsideEdgePointCounts[KAlong] };
+			const bool KbIsDegenerate{ iRing == KDegenerateRings[KAlong] };
+			int InsideOffset{ InsideBase };
+			int OutsideOffset{ OutsideBase };
+			if (iEdge == 3 && KbIsDegenerate)
+			{
+				m_IndexInversion.BaseIndex = InsideBase + 1;
+				m_IndexInversion.InversionEndPoint = (m_IndexInversion.BaseIndex << 1) - 1;
+				m_IndexInversion.BadIndex = OutsideBase + EdgePointCounts[iEdge] - 1;
+				m_IndexInversion.Replacement = KRingOutsideBase;
+				m_bIsInvertingIndices = true;
+
+				InsideOffset = m_IndexInversion.BaseIndex;
+			}
+			else if (iEdge == 3)
+			{
+				// The last points of the last edge are the first points of the ring, as for tris
+				m_IndexPatch.InsideDelta = InsideBase;
+				m_IndexPatch.InsideBadIndex = KInsideEdgePointCount - 1;
+				m_IndexPatch.InsideReplacement = KRingInsideBase;
+				m_IndexPatch.OutsideBase = m_IndexPatch.InsideBadIndex + 1;
+				m_IndexPatch.OutsideDelta = OutsideBase - m_IndexPatch.OutsideBase;
+				m_IndexPatch.OutsideBadIndex = m_IndexPatch.OutsideBase + EdgePointCounts[iEdge] - 1;
+				m_IndexPatch.OutsideReplacement = KRingOutsideBase;
+				m_bIsPatchingIndices = true;
+
+				InsideOffset = 0;
+				OutsideOffset = m_IndexPatch.OutsideBase;
+			}
+			else if (iEdge == 2 && KbIsDegenerate)
+			{
+				m_IndexInversion.BaseIndex = InsideBase;
+				m_IndexInversion.InversionEndPoint = m_IndexInversion.BaseIndex << 1;
+				m_IndexInversion.BadIndex = -1;
+				m_IndexInversion.Replacement = -1;
+				m_bIsInvertingIndices = true;
+			}
+
+			if (iRing == 1)
+			{
+				StitchTransition(InsideOffset, Factors.InsideContexts[KAlong], OutsideOffset, Factors.EdgeContexts[iEdge]);
+			}
+			else
+			{
+				StitchRegular(true, EDiagonals::Mirrored, KInsideEdgePointCount, InsideOffset, OutsideOffset);
+			}
+			m_bIsPatchingIndices = false;
+			m_bIsInvertingIndices = false;
+
+			OutsideBase += EdgePointCounts[iEdge] - 1;
+			// The middle row is walked back along the u == 1 edge
+			InsideBase += (iEdge == 2 && KbIsDegenerate) ? -(KInsideEdgePointCount - 1) : KInsideEdgePointCount - 1;
+			EdgePointCounts[iEdge] = KInsideEdgePointCount;
+		}
+	}
+
+	// An odd inside factor on the shorter axis leaves a strip of quads in the middle
+	const int KStripQuadCount{ GetQuadStripQuadCount(Factors) };
+	if (KStripQuadCount == 0) return;
+
+	m_bIsInvertingIndices = true;
+	if (KInsidePointCounts[0] > KInsidePointCounts[1])
+	{
+		m_IndexInversion.BaseIndex = OutsideBase + KStripQuadCount + 2;
+		m_IndexInversion.InversionEndPoint = 2 * m_IndexInversion.BaseIndex + KStripQuadCount;
+		m_IndexInversion.BadIndex = m_IndexInversion.BaseIndex;
+		m_IndexInversion.Replacement = OutsideBase;
+		StitchRegular(false, EDiagonals::InsideToOutside, KStripQuadCount + 1, m_IndexInversion.BaseIndex, OutsideBase + 1);
+	}
+	else
+	{
+		m_IndexInversion.BaseIndex = OutsideBase + KStripQuadCount + 1;
+		m_IndexInversion.InversionEndPoint = 2 * m_IndexInversion.BaseIndex + KStripQuadCount;
+		m_IndexInversion.BadIndex = -1;
+		m_IndexInversion.Replacement = -1;
+		const EDiagonals KeDiagonals{ (Factors.InsideContexts[1].eParity == EParity::Even) ?
+			EDiagonals::InsideToOutside : EDiagonals::InsideToOutsideExceptMiddle };
+		StitchRegular(false, KeDiagonals, KStripQuadCount + 1, m_IndexInversion.BaseIndex, OutsideBase);
+	}
+	m_bIsInvertingIndices = false;
+}
+
+int CTessellator::GetQuadStripQuadCount(const SQuadFactors& Factors)
+{
+	const int(&KInsidePointCounts)[2]{ Factors.InsidePointCounts };
+	if (KInsidePointCounts[0] > KInsidePointCounts[1] && Factors.InsideContexts[1].eParity == EParity::Odd)
+	{
+		return (((KInsidePointCounts[0] >> 1) - (KInsidePointCounts[1] >> 1)) << 1) + ((Factors.InsideContexts[0].eParity == EParity::Even) ? 2 : 1);
+	}
+	if (KInsidePointCounts[1] >= KInsidePointCounts[0] && Factors.InsideContexts[0].eParity == EParity::Odd)
+	{
+		return (((KInsidePointCounts[1] >> 1) - (KInsidePointCounts[0] >> 1)) << 1) + ((Factors.InsideContexts[1].eParity == EParity::Even) ? 2 : 1);
+	}
+	return 0;
+}
+
+void CTessellator::ConvertPoints()
+{
+	// XMFLOAT2 is two packed floats, so the (u, v) pairs convert as one array
+	m_vDomainPoints.resize(m_vFixedPoints.size() / 2);
+	float* const PtrDomainPoints{ reinterpret_cast<float*>(m_vDomainPoints.data()) };
+	if (IsAVX2Supported())
+	{
+		ConvertFixedToFloatAVX2(m_vFixedPoints.data(), m_vFixedPoints.size(), PtrDomainPoints);
+	}
+	else
+	{
+		ConvertFixedToFloatSSE(m_vFixedPoints.data(), m_vFixedPoints.size(), PtrDomainPoints);
+	}
+}
+
+void CTessellator::ComputeFactorContext(uint32_t FixedFactor, EParity eParity, SFactorContext& Out)
+{
+	Out.eParity = eParity;
+
+	// An even factor of 1 is placed like 2, which is the same points
+	uint32_t HalfFactor{ (FixedFactor + 1) / 2 };
+	if (eParity == EParity::Odd || HalfFactor == KFixedHalf) HalfFactor += KFixedHalf;
+
+	const uint32_t KFloorHalfFactor{ FloorFixed(HalfFactor) };
+	const uint32_t KCeilHalfFactor{ CeilFixed(HalfFactor) };
+	Out.HalfFactorFraction = HalfFactor - KFloorHalfFactor;
+	Out.HalfFactorPointCount = static_cast<int>(KCeilHalfFactor >> KFixedFractionBits);
+	if (KCeilHalfFactor == KFloorHalfFactor)
+	{
+		// No point is moving
+		Out.SplitPoint = Out.HalfFactorPointCount + 1;
+	}
+	else if (eParity == EParity::Odd)
+	{
+		Out.SplitPoint = (KFloorHalfFactor == KFixedOne) ? 0 :
+			(RemoveMostSignificantBit(static_cast<int>(KFloorHalfFactor >> KFixedFractionBits) - 1) << 1) + 1;
+	}
+	else
+	{
+		Out.SplitPoint = (RemoveMostSignificantBit(static_cast<int>(KFloorHalfFactor >> KFixedFractionBits)) << 1) + 1;
+	}
+
+	int FloorSegmentCount{ static_cast<int>((KFloorHalfFactor * 2) >> KFixedFractionBits) };
+	int CeilSegmentCount{ static_cast<int>((KCeilHalfFactor * 2) >> KFixedFractionBits) };
+	if (eParity == EParity::Odd)
+	{
+		--FloorSegmentCount;
+		--CeilSegmentCount;
+	}
+	Out.InverseFloorSegmentCount = GetFixedReciprocal(FloorSegmentCount);
+	Out.InverseCeilSegmentCount = GetFixedReciprocal(CeilSegmentCount);
+}
+
+int CTessellator::GetPointCount(uint32_t FixedFactor, EParity eParity)
+{
+	if (eParity == EParity::Odd)
+	{
+		return static_cast<int>((CeilFixed(KFixedHalf + (FixedFactor + 1) / 2) * 2) >> KFixedFractionBits);
+	}
+	return static_cast<int>((CeilFixed((FixedFactor + 1) / 2) * 2) >> KFixedFractionBits) + 1;
+}
+
+void CTessellator::PlacePoints(const SFactorContext& Context, int Count, uint32_t* const OutPtrLocations)
+{
+	const bool KbIsOdd{ Context.eParity == EParity::Odd };
+	int iPoint{};
+	if (IsAVX2Supported())
+	{
+		for (; iPoint + 8 <= Count; iPoint += 8)
+		{
+			const __m256i KPoints{ _mm256_add_epi32(_mm256_set1_epi32(iPoint), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)) };
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(OutPtrLocations + iPoint),
+				PlacePointsAVX2(KPoints, Context.HalfFactorPointCount, KbIsOdd, Context.SplitPoint,
+					Context.InverseFloorSegmentCount, Context.InverseCeilSegmentCount, Context.HalfFactorFraction));
+		}
+	}
+	for (; iPoint + 4 <= Count; iPoint += 4)
+	{
+		const __m128i KPoints{ _mm_add_epi32(_mm_set1_epi32(iPoint), _mm_setr_epi32(0, 1, 2, 3)) };
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(OutPtrLocations + iPoint),
+			PlacePointsSSE(KPoints, Context.HalfFactorPointCount, KbIsOdd, Context.SplitPoint,
+				Context.InverseFloorSegmentCount, Context.InverseCeilSegmentCount, Context.HalfFactorFraction));
+	}
+
+	// The remainder, one point at a time with the same integer math
+	for (; iPoint < Count; ++iPoint)
+	{
+		int Point{ iPoint };
+		bool bIsFlipped{ false };
+		if (Point >= Context.HalfFactorPointCount)
+		{
+			Point = (Context.HalfFactorPointCount << 1) - Point - (KbIsOdd ? 1 : 0);
+			bIsFlipped = true;
+		}
+		if (Point == Context.HalfFactorPointCount)
+		{
+			OutPtrLocations[iPoint] = KFixedHalf;
+			continue;
+		}
+
+		const uint32_t KCeilPoint{ static_cast<uint32_t>(Point) };
+		const uint32_t KFloorPoint{ KCeilPoint - ((Point > Context.SplitPoint) ? 1 : 0) };
+		const uint32_t KFloorLocation{ KFloorPoint * Context.InverseFloorSegmentCount };
+		const uint32_t KCeilLocation{ KCeilPoint * Context.InverseCeilSegmentCount };
+		const uint32_t KLocation{ (KFloorLocation * (KFixedOne - Context.HalfFactorFraction) +
+			KCeilLocation * Context.HalfFactorFraction + KFixedHalf) >> KFixedFractionBits };
+		OutPtrLocations[iPoint] = bIsFlipped ? KFixedOne - KLocation : KLocation;
+	}
+}
+
+// Strips between two rows of points: InsidePointCount - 1 quads, and for trapezoids (rings) a triangle at each end to the outer row's
+// extra points. Ring edges use mirrored diagonals, the middle row of a quad with an odd inside factor leans one way.
+void CTessellator::StitchRegular(bool bIsTrapezoid, EDiagonals eDiagonals, int InsidePointCount, int InsideBase, int OutsideBase)
+{
+	int Inside{ InsideBase };
+	int Outside{ OutsideBase };
+
+	if (bIsTrapezoid)
+	{
+		AddTriangle(Outside, Outside + 1, Inside);
+		++Outside;
+	}
+
+	int iPoint{};
+	switch (eDiagonals)
+	{
+	case EDiagonals::InsideToOutside:
+		for (; iPoint < InsidePointCount - 1; ++iPoint)
+		{
+			AddTriangle(Inside, Outside, Outside + 1);
+			AddTriangle(Inside, Outside + 1, Inside + 1);
+			++Inside;
+			++Outside;
+		}
+		break;
+	case EDiagonals::InsideToOutsideExceptMiddle:
+		for (; iPoint < InsidePointCount / 2 - 1; ++iPoint)
+		{
+			AddTriangle(Inside, Outside, Outside + 1);
+			AddTriangle(Inside, Outside + 1, Inside + 1);
+			++Inside;
+			++Outside;
+		}
+
+		AddTriangle(Outside, Inside + 1, Inside);
+		AddTriangle(Outside, Outside + 1, Inside + 1);
+		++Inside;
+		++Outside;
+		iPoint += 2;
+
+		for (; iPoint < InsidePointCount; ++iPoint)
+		{
+			AddTriangle(Inside, Outside, Outside + 1);
+			AddTriangle(Inside, Outside + 1, Inside + 1);
+			++Inside;
+			++Outside;
+		}
+		break;
+	case EDiagonals::Mirrored:
+		for (; iPoint < InsidePointCount / 2; ++iPoint)
+		{
+			AddTriangle(Outside, Inside + 1, Inside);
+			AddTriangle(Outside, Outside + 1, Inside + 1);
+			++Inside;
+			++Outside;
+		}
+		for (; iPoint < InsidePointCount - 1; ++iPoint)
+		{
+			AddTriangle(Inside, Outside, Outside + 1);
+			AddTriangle(Inside, Outside + 1, Inside + 1);
+			++Inside;
+			++Outside;
+		}
+		break;
+	}
+
+	if (bIsTrapezoid) AddTriangle(Outside, Outside + 1, Inside);
+}
+
+// Strip between an edge and the first inner ring, which have unrelated point counts; points of each half are consumed in the order they
+// appear as the factor grows (KFinalPointPositions), symmetrically about the middle.
+void CTessellator::StitchTransition(int InsideBase, const SFactorContext& InsideContext, int OutsideBase, const SFactorContext& OutsideContext)
+{
+	const bool KbIsInsideOdd{ InsideContext.eParity == EParity::Odd };
+	const bool KbIsOutsideOdd{ OutsideContext.eParity == EParity::Odd };
+	const int KInsideHalfCount{ InsideContext.HalfFactorPointCount - (KbIsInsideOdd ? 1 : 0) };
+	const int KOutsideHalfCount{ OutsideContext.HalfFactorPointCount - (KbIsOutsideOdd ? 1 : 0) };
+
+	int Inside{ InsideBase };
+	int Outside{ OutsideBase };
+
+	if (KFinalPointPositions[0] < KOutsideHalfCount)
+	{
+		AddTriangle(Outside, Outside + 1, Inside);
+		++Outside;
+	}
+	for (int iPosition = 1; iPosition < 33; ++iPosition)
+	{
+		if (KFinalPointPositions[iPosition] < KInsideHalfCount)
+		{
+			AddTriangle(Inside, Outside, Inside + 1);
+			++Inside;
+		}
+		if (KFinalPointPositions[iPosition] < KOutsideHalfCount)
+		{
+			AddTriangle(Outside, Outside + 1, Inside);
+			++Outside;
+		}
+	}
+
+	// The middle segment(s) of odd factors
+	if (KbIsInsideOdd != KbIsOutsideOdd || KbIsInsideOdd)
+	{
+		if (KbIsInsideOdd == KbIsOutsideOdd)
+		{
+			AddTriangle(Inside, Outside, Inside + 1);
+			AddTriangle(Inside + 1, Outside, Outside + 1);
+			++Inside;
+			++Outside;
+		}
+		else if (!KbIsInsideOdd)
+		{
+			AddTriangle(Inside, Outside, Outside + 1);
+			++Outside;
+		}
+		else
+		{
+			AddTriangle(Inside, Outside, Inside + 1);
+			++Inside;
+		}
+	}
+
+	for (int iPosition = 32; iPosition >= 1; --iPosition)
+	{
+		if (KFinalPointPositions[iPosition] < KOutsideHalfCount)
+		{
+			AddTriangle(Outside, Outside + 1, Inside);
+			++Outside;
+		}
+		if (KFinalPointPositions[iPosition] < KInsideHalfCount)
+		{
+			AddTriangle(Inside, Outside, Inside + 1);
+			++Inside;
+		}
+	}
+	if (KFinalPointPositions[0] < KOutsideHalfCount)
+	{
+		AddTriangle(Outside, Outside + 1, Inside);
+	}
+}
+
+void CTessellator::AddTriangle(int I0, int I1, int I2)
+{
+	const uint32_t K0{ static_cast<uint32_t>(PatchIndex(I0)) };
+	const uint32_t K1{ static_cast<uint32_t>(PatchIndex(I1)) };
+	const uint32_t K2{ static_cast<uint32_t>(PatchIndex(I2)) };
+	if (m_bIsClockwise)
+	{
+		m_vTriangles.emplace_back(K0, K1, K2);
+	}
+	else
+	{
+		m_vTriangles.emplace_back(K0, K2, K1);
+	}
+}
+
+int CTessellator::PatchIndex(int Index) const
+{
+	if (m_bIsPatchingIndices)
+	{
+		if (Index >= m_IndexPatch.OutsideBase)
+		{
+			return (Index == m_IndexPatch.OutsideBadIndex) ? m_IndexPatch.OutsideReplacement : Index + m_IndexPatch.OutsideDelta;
+		}
+		return (Index == m_IndexPatch.InsideBadIndex) ? m_IndexPatch.InsideReplacement : Index + m_IndexPatch.InsideDelta;
+	}
+	if (m_bIsInvertingIndices)
+	{
+		if (Index == m_IndexInversion.BadIndex) return m_IndexInversion.Replacement;
+		if (Index >= m_IndexInversion.BaseIndex) return m_IndexInversion.InversionEndPoint - Index;
+	}
+	return Index;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "SharedHeader.h"
+
+// HSTri.hlsl's partitioning modes, in the order of its entry points (main, even, integer)
+enum class ETessellatorPartitioning
+{
+	FractionalOdd,
+	FractionalEven,
+	Integer
+};
+
+// The D3D11 fixed-function tessellator on the CPU, after the reference implementation that comes with the D3D11 specification,
+// so that the domain points and triangles of a patch are known without a GPU:
+//  - factors are clamped, rounded and converted to 16.16 fixed point the way the hardware does, and points are placed on the edges in
+//    fixed point, so the domain locations are the GPU's bit for bit;
+//  - the outer ring is stitched to the first inner ring in ruler-function order and the inner rings to each other with mirrored diagonals,
+//    so the triangles (and their count) are the GPU's for every combination of edge and inside factors.
+// Tri domain points are (u, v), w = 1 - u - v; u weights the first control point (SV_DomainLocation.x). Quad domain points are (u, v) on [0, 1]^2.
+// The 1D point placements and the fixed- to floating-point conversion run in AVX2 or SSE2 lanes; both paths give the same bits.
+class CTessellator
+{
+	enum class EParity
+	{
+		Even,
+		Odd
+	};
+
+	// One factor's placement of points on [0, 1], see ComputeFactorContext()
+	struct SFactorContext
+	{
+		EParity		eParity{};
+		// 16.16
+		uint32_t	HalfFactorFraction{};
+		uint32_t	InverseFloorSegmentCount{};
+		uint32_t	InverseCeilSegmentCount{};
+		int			HalfFactorPointCount{};
+		// The point that exists on the ceil half factor but not on the floor one
+		int			SplitPoint{};
+	};
+
+	struct STriFactors
+	{
+		bool			bIsCulled{};
+		// Every factor is 1: a single triangle
+		bool			bIsMinimum{};
+
+		SFactorContext	EdgeContexts[3]{};
+		SFactorContext	InsideContext{};
+		int				EdgePointCounts[3]{};
+		int				InsidePointCount{};
+		int				InsidePointBaseOffset{};
+		int				PointCount{};
+	};
+
+	struct SQuadFactors
+	{
+		bool			bIsCulled{};
+		bool			bIsMinimum{};
+
+		// u == 0, v == 0, u == 1, v == 1
+		SFactorContext	EdgeContexts[4]{};
+		// u, v
+		SFactorContext	InsideContexts[2]{};
+		int				EdgePointCounts[4]{};
+		int				InsidePointCounts[2]{};
+		int				InsidePointBaseOffset{};
+		int				PointCount{};
+	};
+
+	// Which way the diagonals of a strip of quads lean
+	enum class EDiagonals
+	{
+		InsideToOutside,
+		// The middle quad leans the other way (odd point counts)
+		InsideToOutsideExceptMiddle,
+		// Each half leans toward the middle
+		Mirrored
+	};
+
+	// Stitching the last edge of a ring wraps around to the ring's first points; indices in that range are remapped (see PatchIndex())
+	struct SIndexPatch
+	{
+		int		InsideDelta{};
+		int		InsideBadIndex{};
+		int		InsideReplacement{};
+		int		OutsideBase{};
+		int		OutsideDelta{};
+		int		OutsideBadIndex{};
+		int		OutsideReplacement{};
+	};
+
+	// Quads with an even inside factor end in a row of points instead of a ring; the ring around it is walked backwards from BaseIndex
+	struct SIndexInversion
+	{
+		int		BaseIndex{};
+		int		InversionEndPoint{};
+		int		BadIndex{ -1 };
+		int		Replacement{ -1 };
+	};
+
+public:
+	CTessellator(ETessellatorPartitioning ePartitioning = ETessellatorPartitioning::FractionalOdd, bool bIsClockwise = true);
+	~CTessellator() {}
+
+public:
+	// EdgeFactors[i] is SV_TessFactor[i], the factor of the edge opposite to the i-th control point (the u == 0, v == 0 and w == 0 edges).
+	// Returns false if the patch is culled (a factor that is not > 0), which leaves no points and no triangles.
+	bool TessellateTri(const float(&EdgeFactors)[3], float InsideFactor);
+	// TessellateTri() without generating anything
+	size_t GetTriTriangleCount(const float(&EdgeFactors)[3], float InsideFactor) const;
+	// The factors as TessellateTri() uses them: clamped to the partitioning's range, rounded up for integer partitioning and in 16.16.
+	// Factors that quantize to the same values give the same points and triangles. Returns false if the patch is culled.
+	bool QuantizeTriFactors(const float(&EdgeFactors)[3], float InsideFactor, uint32_t(&OutFixedEdgeFactors)[3], uint32_t& OutFixedInsideFactor) const;
+
+	// EdgeFactors are the u == 0, v == 0, u == 1 and v == 1 edges' (SV_TessFactor[0..3]), InsideFactors the u and v ones (SV_InsideTessFactor)
+	bool TessellateQuad(const float(&EdgeFactors)[4], const float(&InsideFactors)[2]);
+	size_t GetQuadTriangleCount(const float(&EdgeFactors)[4], const float(&InsideFactors)[2]) const;
+
+	void SetClockwise(bool bIsClockwise) { m_bIsClockwise = bIsClockwise; }
+
+	void SetPartitioning(ETessellatorPartitioning ePartitioning) { m_ePartitioning = ePartitioning; }
+	ETessellatorPartitioning GetPartitioning() const { return m_ePartitioning; }
+
+	// Of the last TessellateTri() or TessellateQuad()
+	const std::vector<XMFLOAT2>& GetDomainPoints() const { return m_vDomainPoints; }
+	const std::vector<STriangle>& GetTriangles() const { return m_vTriangles; }
+
+private:
+	// Returns false if the patch is culled
+	bool ClampTriFactors(const float(&EdgeFactors)[3], float InsideFactor, float(&OutEdges)[3], float& OutInside) const;
+	void ProcessTriFactors(const float(&EdgeFactors)[3], float InsideFactor, STriFactors& Out) const;
+	void GenerateTriPoints(const STriFactors& Factors);
+	void GenerateTriTriangles(const STriFactors& Factors);
+
+	void ProcessQuadFactors(const float(&EdgeFactors)[4], const float(&InsideFactors)[2], SQuadFactors& Out) const;
+	void GenerateQuadPoints(const SQuadFactors& Factors);
+	void GenerateQuadTriangles(const SQuadFactors& Factors);
+	// Quads in the middle strip left by an odd inside factor on the shorter axis (0 if it ends in a ring or a row of points)
+	static int GetQuadStripQuadCount(const SQuadFactors& Factors);
+
+	// Converts m_vFixedPoints to m_vDomainPoints
+	void ConvertPoints();
+
+	bool IsIntegerPartitioning() const { return m_ePartitioning == ETessellatorPartitioning::Integer; }
+
+	static void ComputeFactorContext(uint32_t FixedFactor, EParity eParity, SFactorContext& Out);
+	static int GetPointCount(uint32_t FixedFactor, EParity eParity);
+	// Locations of the points [0, Count) on [0, 1], 16.16
+	static void PlacePoints(const SFactorContext& Context, int Count, uint32_t* const OutPtrLocations);
+
+	// A trapezoid strip has one more point on the outside at each end
+	void StitchRegular(bool bIsTrapezoid, EDiagonals eDiagonals, int InsidePointCount, int InsideBase, int OutsideBase);
+	void StitchTransition(int InsideBase, const SFactorContext& InsideContext, int OutsideBase, const SFactorContext& OutsideContext);
+	// Takes the corners in clockwise order
+	void AddTriangle(int I0, int I1, int I2);
+	int PatchIndex(int Index) const;
+
+public:
+	static constexpr float	KMaxFactor{ 64.0f };
+
+private:
+	ETessellatorPartitioning	m_ePartitioning{};
+	bool						m_bIsClockwise{};
+
+	// Scratch, kept to avoid allocations
+	std::vector<uint32_t>		m_vEdgeLocations[4]{};
+	std::vector<uint32_t>		m_vInsideLocations[2]{};
+	// (u, v) pairs, 16.16
+	std::vector<uint32_t>		m_vFixedPoints{};
+
+	SIndexPatch					m_IndexPatch{};
+	bool						m_bIsPatchingIndices{};
+	SIndexInversion				m_IndexInversion{};
+	bool						m_bIsInvertingIndices{};
+
+	std::vector<XMFLOAT2>		m_vDomainPoints{};
+	std::vector<STriangle>		m_vTriangles{};
+};
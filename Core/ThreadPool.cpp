@@ -0,0 +1,211 @@
+#include "ThreadPool.h"
+
+using std::vector;
+using std::function;
+using std::mutex;
+using std::unique_lock;
+using std::lock_guard;
+using std::thread;
+
+static thread_local const CThreadPool* t_PtrOwnerPool{};
+static thread_local size_t t_WorkerIndex{};
+
+CThreadPool::CThreadPool(size_t ThreadCount)
+{
+	if (ThreadCount == 0)
+	{
+		size_t HardwareConcurrency{ thread::hardware_concurrency() };
+		ThreadCount = (HardwareConcurrency > 1) ? HardwareConcurrency - 1 : 1;
+	}
+
+	m_vQueues.reserve(ThreadCount);
+	for (size_t iQueue = 0; iQueue < ThreadCount; ++iQueue)
+	{
+		m_vQueues.emplace_back(std::make_unique<SWorkerQueue>());
+	}
+
+	m_vThreads.reserve(ThreadCount);
+	for (size_t iThread = 0; iThread < ThreadCount; ++iThread)
+	{
+		m_vThreads.emplace_back(&CThreadPool::Work, this, iThread);
+	}
+}
+
+CThreadPool::~CThreadPool()
+{
+	{
+		lock_guard<mutex> Lock{ m_WakeMutex };
+		m_bShouldStop = true;
+	}
+	m_WakeCondition.notify_all();
+
+	for (auto& Thread : m_vThreads)
+	{
+		if (Thread.joinable()) Thread.join();
+	}
+}
+
+void CThreadPool::Enqueue(function<void()> Task)
+{
+	// Workers push to their own queue (the back is the hot end), other threads distribute round-robin.
+	size_t QueueIndex{ (t_PtrOwnerPool == this) ? t_WorkerIndex : m_NextQueue++ % m_vQueues.size() };
+	{
+		SWorkerQueue& Queue{ *m_vQueues[QueueIndex] };
+		lock_guard<mutex> Lock{ Queue.Mutex };
+		Queue.dTasks.emplace_back(std::move(Task));
+
+		// Counted under the queue's lock, which PopTask() takes to take the task, so the count never drops below zero
+		++m_PendingTaskCount;
+	}
+
+	// A worker that saw no pending task either holds m_WakeMutex until it waits or sees the count, so the notification can't be lost
+	{
+		lock_guard<mutex> Lock{ m_WakeMutex };
+	}
+	m_WakeCondition.notify_one();
+}
+
+void CThreadPool::ParallelFor(size_t Count, size_t GrainSize, const function<void(size_t, size_t)>& Function)
+{
+	if (Count == 0) return;
+	if (GrainSize == 0) GrainSize = 1;
+
+	const size_t KChunkCount{ (Count + GrainSize - 1) / GrainSize };
+	if (KChunkCount == 1)
+	{
+		Function(0, Count);
+		return;
+	}
+
+	std::atomic<size_t> NextChunk{};
+	std::atomic<size_t> CompletedChunkCount{};
+
+	// An exception must not leave this frame while helpers still run chunks, so the first one is kept and rethrown after the wait.
+	// Chunks taken after a failure are skipped but still counted.
+	mutex ExceptionMutex{};
+	std::exception_ptr FirstException{};
+	std::atomic<bool> bFailed{ false };
+	auto RunChunks{ [&]()
+		{
+			size_t iChunk{};
+			while ((iChunk = NextChunk++) < KChunkCount)
+			{
+				if (!bFailed)
+				{
+					size_t Begin{ iChunk * GrainSize };
+					size_t End{ std::min(Begin + GrainSize, Count) };
+					try
+					{
+						Function(Begin, End);
+					}
+					catch (...)
+					{
+						lock_guard<mutex> Lock{ ExceptionMutex };
+						if (!FirstException) FirstException = std::current_exception();
+						bFailed = true;
+					}
+				}
+				++CompletedChunkCount;
+			}
+		}
+	};
+
+	// Helpers only pull chunks, so a helper that starts after all chunks are taken returns immediately.
+	// We still have to wait for every helper to return because they reference this stack frame.
+	const size_t KHelperCount{ std::min(KChunkCount - 1, GetThreadCount()) };
+	std::atomic<size_t> FinishedHelperCount{};
+	for (size_t iHelper = 0; iHelper < KHelperCount; ++iHelper)
+	{
+		Enqueue([&]()
+			{
+				RunChunks();
+				++FinishedHelperCount;
+			});
+	}
+
+	RunChunks();
+
+	while (CompletedChunkCount < KChunkCount || FinishedHelperCount < KHelperCount)
+	{
+		if (!RunPendingTask()) std::this_thread::yield();
+	}
+
+	if (FirstException) std::rethrow_exception(FirstException);
+}
+
+bool CThreadPool::RunPendingTask()
+{
+	function<void()> Task{};
+	size_t StartIndex{ (t_PtrOwnerPool == this) ? t_WorkerIndex : 0 };
+	if (!PopTask(StartIndex, Task)) return false;
+
+	RunTask(Task);
+	return true;
+}
+
+void CThreadPool::RunTask(const function<void()>& Task)
+{
+	// Enqueue()d tasks have no one to report to; an exception escaping here would terminate a worker
+	// or unwind a waiting ParallelFor() frame. Submit() delivers exceptions through its future instead.
+	try
+	{
+		Task();
+	}
+	catch (...)
+	{
+	}
+}
+
+void CThreadPool::Work(size_t WorkerIndex)
+{
+	t_PtrOwnerPool = this;
+	t_WorkerIndex = WorkerIndex;
+
+	while (true)
+	{
+		function<void()> Task{};
+		if (PopTask(WorkerIndex, Task))
+		{
+			RunTask(Task);
+			continue;
+		}
+
+		unique_lock<mutex> Lock{ m_WakeMutex };
+		m_WakeCondition.wait(Lock, [&]() { return m_bShouldStop || m_PendingTaskCount > 0; });
+		if (m_bShouldStop && m_PendingTaskCount == 0) break;
+	}
+}
+
+bool CThreadPool::PopTask(size_t WorkerIndex, function<void()>& Task)
+{
+	const size_t KQueueCount{ m_vQueues.size() };
+
+	// Own queue: LIFO
+	{
+		SWorkerQueue& Queue{ *m_vQueues[WorkerIndex] };
+		lock_guard<mutex> Lock{ Queue.Mutex };
+		if (!Queue.dTasks.empty())
+		{
+			Task = std::move(Queue.dTasks.back());
+			Queue.dTasks.pop_back();
+			--m_PendingTaskCount;
+			return true;
+		}
+	}
+
+	// Steal: FIFO
+	for (size_t iOffset = 1; iOffset < KQueueCount; ++iOffset)
+	{
+		SWorkerQueue& Queue{ *m_vQueues[(WorkerIndex + iOffset) % KQueueCount] };
+		lock_guard<mutex> Lock{ Queue.Mutex };
+		if (!Queue.dTasks.empty())
+		{
+			Task = std::move(Queue.dTasks.front());
+			Queue.dTasks.pop_front();
+			--m_PendingTaskCount;
+			return true;
+		}
+	}
+
+	return false;
+}
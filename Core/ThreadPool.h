@@ -0,0 +1,78 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <future>
+#include <functional>
+#include <deque>
+
+// Work-stealing thread pool.
+// Every worker owns a deque; it pops its own work from the back and steals from the front of the others.
+// Threads that wait on the pool (Wait(), ParallelFor()) run pending tasks instead of blocking,
+// so nested parallel work cannot deadlock.
+class CThreadPool
+{
+	struct SWorkerQueue
+	{
+		std::mutex							Mutex{};
+		std::deque<std::function<void()>>	dTasks{};
+	};
+
+public:
+	// ThreadCount == 0 -> (hardware concurrency - 1), at least 1
+	CThreadPool(size_t ThreadCount = 0);
+	~CThreadPool();
+
+public:
+	void Enqueue(std::function<void()> Task);
+
+	template<typename TFunction>
+	auto Submit(TFunction&& Function)->std::future<decltype(Function())>
+	{
+		using TResult = decltype(Function());
+
+		auto PtrTask{ std::make_shared<std::packaged_task<TResult()>>(std::forward<TFunction>(Function)) };
+		std::future<TResult> Future{ PtrTask->get_future() };
+		Enqueue([PtrTask]() { (*PtrTask)(); });
+		return Future;
+	}
+
+	// Runs pending tasks on the calling thread until the future is ready.
+	template<typename TResult>
+	void Wait(const std::future<TResult>& Future)
+	{
+		while (Future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			if (!RunPendingTask()) std::this_thread::yield();
+		}
+	}
+
+	// Calls Function(Begin, End) over [0, Count) split into chunks of at most GrainSize and blocks until all chunks are done.
+	// The calling thread takes part in the work.
+	// If Function throws, the remaining chunks are skipped and the first exception is rethrown once every helper has returned.
+	void ParallelFor(size_t Count, size_t GrainSize, const std::function<void(size_t, size_t)>& Function);
+
+	// Returns false if there was nothing to run.
+	bool RunPendingTask();
+
+public:
+	size_t GetThreadCount() const { return m_vThreads.size(); }
+
+private:
+	void Work(size_t WorkerIndex);
+	void RunTask(const std::function<void()>& Task);
+	bool PopTask(size_t WorkerIndex, std::function<void()>& Task);
+
+private:
+	std::vector<std::thread>					m_vThreads{};
+	std::vector<std::unique_ptr<SWorkerQueue>>	m_vQueues{};
+
+	std::mutex						m_WakeMutex{};
+	std::condition_variable			m_WakeCondition{};
+	std::atomic<size_t>				m_PendingTaskCount{};
+	std::atomic<size_t>				m_NextQueue{};
+	std::atomic<bool>				m_bShouldStop{ false };
+};
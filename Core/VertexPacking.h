@@ -0,0 +1,237 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include "SIMD.h"
+#include <DirectXPackedVector.h>
+
+// 24-byte counterpart of SVertex3D (80 bytes), see KPackedInputElementDescs in Game.cpp and VSBase.hlsl's "packed" entry point
+struct SPackedVertex3D
+{
+	// R16G16B16A16_UNORM, Position = Offset + Value * Scale (see SPositionQuantization); w is unused.
+	// Off by at most half a step (Scale / 131070) per axis, plus the float rounding of the position.
+	uint16_t	Position[4]{};
+
+	// R8G8B8A8_UNORM, so colors are clamped to [0, 1]; off by at most 0.5 / 255 per channel after that
+	uint32_t	Color{};
+
+	// R16G16_FLOAT; TexCoord.z is dropped. Off by at most 2^-11 relative to the value in half's normal range ([2^-14, 65504])
+	uint16_t	TexCoord[2]{};
+
+	// R16G16_SNORM, octahedral encoding; off by at most 0.005 degrees
+	int16_t		Normal[2]{};
+
+	// R10G10B10A2_UNORM, xyz * 0.5 + 0.5; a is 1 when Tangent.w < 0 (the handedness of the bitangent).
+	// Off by at most 0.1 degrees (sqrt(3) / 1023 radians); the handedness is exact.
+	uint32_t	Tangent{};
+};
+static_assert(sizeof(SPackedVertex3D) == 24, "SPackedVertex3D must match KPackedInputElementDescs");
+
+// Object-space AABB of a mesh; also the data of the vertex quantization constant buffer
+struct SPositionQuantization
+{
+	XMFLOAT4	Offset{};
+	XMFLOAT4	Scale{ 1, 1, 1, 0 };
+};
+
+// Largest round-trip error over all vertices of a mesh
+struct SVertexPackingError
+{
+	float		Position{};
+	float		NormalDegrees{};
+	float		TangentDegrees{};
+	float		TexCoord{};
+	float		Color{};
+};
+
+static SPositionQuantization CalculatePositionQuantization(const std::vector<SVertex3D>& vVertices);
+static void PackVertices(const std::vector<SVertex3D>& vVertices, const SPositionQuantization& Quantization, std::vector<SPackedVertex3D>& vOutPackedVertices);
+static void UnpackVertices(const std::vector<SPackedVertex3D>& vPackedVertices, const SPositionQuantization& Quantization, std::vector<SVertex3D>& vOutVertices);
+static SVertexPackingError MeasureVertexPackingError(const std::vector<SVertex3D>& vVertices, const std::vector<SPackedVertex3D>& vPackedVertices,
+	const SPositionQuantization& Quantization);
+
+namespace VertexPackingInternal
+{
+	// x, y of the octahedral projection of a unit vector, in [-1, 1]
+	static XMVECTOR EncodeOctahedral(const XMVECTOR& Direction)
+	{
+		const XMVECTOR KAbs{ XMVectorAbs(Direction) };
+		const XMVECTOR KL1Norm{ XMVectorSplatX(KAbs) + XMVectorSplatY(KAbs) + XMVectorSplatZ(KAbs) };
+		const XMVECTOR KProjected{ Direction / XMVectorMax(KL1Norm, XMVectorReplicate(FLT_MIN)) };
+
+		// The lower hemisphere is folded over the diagonals
+		const XMVECTOR KProjectedAbs{ XMVectorAbs(KProjected) };
+		const XMVECTOR KFoldedMagnitude{ XMVectorSplatOne() - XMVectorSwizzle<1, 0, 3, 3>(KProjectedAbs) };
+		const XMVECTOR KSign{ XMVectorSelect(XMVectorReplicate(-1.0f), XMVectorSplatOne(), XMVectorGreaterOrEqual(KProjected, XMVectorZero())) };
+		const XMVECTOR KIsLower{ XMVectorLess(XMVectorSplatZ(KProjected), XMVectorZero()) };
+		return XMVectorSelect(KProjected, KFoldedMagnitude * KSign, KIsLower);
+	}
+
+	static XMVECTOR DecodeOctahedral(const XMVECTOR& Encoded)
+	{
+		const XMVECTOR KAbs{ XMVectorAbs(Encoded) };
+		const XMVECTOR KZ{ XMVectorSplatOne() - XMVectorSplatX(KAbs) - XMVectorSplatY(KAbs) };
+		const XMVECTOR KT{ XMVectorMax(-KZ, XMVectorZero()) };
+		const XMVECTOR KXY{ XMVectorSelect(Encoded + KT, Encoded - KT, XMVectorGreaterOrEqual(Encoded, XMVectorZero())) };
+		return XMVector3Normalize(XMVectorSelect(KXY, KZ, g_XMSelect0010));
+	}
+
+	// Saturating float -> uint16 in the low 64 bits (SSE2 has no unsigned 32 -> 16 pack)
+	static __m128i ConvertToUInt16(const XMVECTOR& Value)
+	{
+		const __m128i KInt32{ _mm_cvtps_epi32(Value) };
+		const __m128i KBias{ _mm_set1_epi32(32768) };
+		return _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(KInt32, KBias), KBias), _mm_set1_epi16(INT16_MIN));
+	}
+
+	static uint32_t PackHalf2(const XMVECTOR& Value)
+	{
+		if (IsF16CSupported())
+		{
+			return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_cvtps_ph(Value, _MM_FROUND_TO_NEAREST_INT)));
+		}
+		const uint32_t KX{ PackedVector::XMConvertFloatToHalf(XMVectorGetX(Value)) };
+		const uint32_t KY{ PackedVector::XMConvertFloatToHalf(XMVectorGetY(Value)) };
+		return KX | (KY << 16);
+	}
+
+	static XMVECTOR UnpackHalf2(uint32_t Value)
+	{
+		if (IsF16CSupported())
+		{
+			return _mm_cvtph_ps(_mm_cvtsi32_si128(static_cast<int>(Value)));
+		}
+		return XMVectorSet(PackedVector::XMConvertHalfToFloat(static_cast<PackedVector::HALF>(Value & 0xFFFF)),
+			PackedVector::XMConvertHalfToFloat(static_cast<PackedVector::HALF>(Value >> 16)), 0, 0);
+	}
+
+	// atan2 rather than acos, which can't resolve the small angles of the encodings in float
+	static float GetAngleDegrees(const XMVECTOR& A, const XMVECTOR& B)
+	{
+		if (XMVector3Equal(A, XMVectorZero()) || XMVector3Equal(B, XMVectorZero())) return 0.0f;
+		const XMVECTOR KA{ XMVector3Normalize(A) };
+		const XMVECTOR KB{ XMVector3Normalize(B) };
+		return XMConvertToDegrees(atan2f(XMVectorGetX(XMVector3Length(XMVector3Cross(KA, KB))), XMVectorGetX(XMVector3Dot(KA, KB))));
+	}
+}
+
+static SPositionQuantization CalculatePositionQuantization(const std::vector<SVertex3D>& vVertices)
+{
+	SPositionQuantization Result{};
+	if (vVertices.empty()) return Result;
+
+	XMVECTOR Min{ vVertices.front().Position };
+	XMVECTOR Max{ Min };
+	for (const SVertex3D& Vertex : vVertices)
+	{
+		Min = XMVectorMin(Min, Vertex.Position);
+		Max = XMVectorMax(Max, Vertex.Position);
+	}
+	XMStoreFloat4(&Result.Offset, XMVectorSetW(Min, 0.0f));
+	XMStoreFloat4(&Result.Scale, XMVectorSetW(Max - Min, 0.0f));
+	return Result;
+}
+
+static void PackVertices(const std::vector<SVertex3D>& vVertices, const SPositionQuantization& Quantization, std::vector<SPackedVertex3D>& vOutPackedVertices)
+{
+	using namespace VertexPackingInternal;
+
+	const XMVECTOR KOffset{ XMLoadFloat4(&Quantization.Offset) };
+	const XMVECTOR KScale{ XMLoadFloat4(&Quantization.Scale) };
+
+	// Flat axes (Scale == 0) quantize to 0
+	const XMVECTOR KInverseScale{ XMVectorSelect(XMVectorReciprocal(KScale), XMVectorZero(), XMVectorEqual(KScale, XMVectorZero())) };
+	const XMVECTOR KUNorm16Max{ XMVectorReplicate(65535.0f) };
+	const XMVECTOR KUNorm8Max{ XMVectorReplicate(255.0f) };
+	const XMVECTOR KUNorm10Max{ XMVectorReplicate(1023.0f) };
+	const XMVECTOR KSNorm16Max{ XMVectorReplicate(32767.0f) };
+	const __m128i KZero{ _mm_setzero_si128() };
+
+	vOutPackedVertices.resize(vVertices.size());
+	for (size_t iVertex = 0; iVertex < vVertices.size(); ++iVertex)
+	{
+		const SVertex3D& Vertex{ vVertices[iVertex] };
+		SPackedVertex3D& Packed{ vOutPackedVertices[iVertex] };
+
+		const XMVECTOR KPosition{ XMVectorSaturate((Vertex.Position - KOffset) * KInverseScale) * KUNorm16Max };
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(Packed.Position), ConvertToUInt16(KPosition));
+
+		const __m128i KColor{ _mm_cvtps_epi32(XMVectorSaturate(Vertex.Color) * KUNorm8Max) };
+		Packed.Color = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(KColor, KColor), KZero)));
+
+		const uint32_t KTexCoord{ PackHalf2(Vertex.TexCoord) };
+		memcpy(Packed.TexCoord, &KTexCoord, sizeof(KTexCoord));
+
+		const __m128i KNormal{ _mm_cvtps_epi32(XMVectorClamp(EncodeOctahedral(Vertex.Normal), -XMVectorSplatOne(), XMVectorSplatOne()) * KSNorm16Max) };
+		const uint32_t KNormalBits{ static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packs_epi32(KNormal, KNormal))) };
+		memcpy(Packed.Normal, &KNormalBits, sizeof(KNormalBits));
+
+		alignas(16) uint32_t Tangent[4]{};
+		_mm_store_si128(reinterpret_cast<__m128i*>(Tangent), _mm_cvtps_epi32(XMVectorSaturate(Vertex.Tangent * 0.5f + XMVectorReplicate(0.5f)) * KUNorm10Max));
+		Packed.Tangent = Tangent[0] | (Tangent[1] << 10) | (Tangent[2] << 20) | ((XMVectorGetW(Vertex.Tangent) < 0.0f) ? (3u << 30) : 0u);
+	}
+}
+
+static void UnpackVertices(const std::vector<SPackedVertex3D>& vPackedVertices, const SPositionQuantization& Quantization, std::vector<SVertex3D>& vOutVertices)
+{
+	using namespace VertexPackingInternal;
+
+	const XMVECTOR KOffset{ XMVectorSetW(XMLoadFloat4(&Quantization.Offset), 1.0f) };
+	const XMVECTOR KScale{ XMVectorSetW(XMLoadFloat4(&Quantization.Scale), 0.0f) / 65535.0f };
+	const XMVECTOR KInverseUNorm8Max{ XMVectorReplicate(1.0f / 255.0f) };
+	const XMVECTOR KInverseUNorm10Max{ XMVectorReplicate(1.0f / 1023.0f) };
+	const XMVECTOR KInverseSNorm16Max{ XMVectorReplicate(1.0f / 32767.0f) };
+	const __m128i KZero{ _mm_setzero_si128() };
+
+	vOutVertices.resize(vPackedVertices.size());
+	for (size_t iVertex = 0; iVertex < vPackedVertices.size(); ++iVertex)
+	{
+		const SPackedVertex3D& Packed{ vPackedVertices[iVertex] };
+		SVertex3D& Vertex{ vOutVertices[iVertex] };
+
+		const __m128i KPosition{ _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(Packed.Position)), KZero) };
+		Vertex.Position = _mm_cvtepi32_ps(KPosition) * KScale + KOffset;
+
+		const __m128i KColor{ _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(Packed.Color)), KZero), KZero) };
+		Vertex.Color = _mm_cvtepi32_ps(KColor) * KInverseUNorm8Max;
+
+		uint32_t TexCoordBits{};
+		memcpy(&TexCoordBits, Packed.TexCoord, sizeof(TexCoordBits));
+		Vertex.TexCoord = UnpackHalf2(TexCoordBits);
+
+		uint32_t NormalBits{};
+		memcpy(&NormalBits, Packed.Normal, sizeof(NormalBits));
+		const __m128i KNormal{ _mm_srai_epi32(_mm_unpacklo_epi16(KZero, _mm_cvtsi32_si128(static_cast<int>(NormalBits))), 16) };
+		const XMVECTOR KEncodedNormal{ XMVectorMax(_mm_cvtepi32_ps(KNormal) * KInverseSNorm16Max, -XMVectorSplatOne()) };
+		Vertex.Normal = XMVectorSetW(DecodeOctahedral(KEncodedNormal), 0.0f);
+
+		const __m128i KTangent{ _mm_and_si128(_mm_set_epi32(0, static_cast<int>(Packed.Tangent >> 20), static_cast<int>(Packed.Tangent >> 10),
+			static_cast<int>(Packed.Tangent)), _mm_set1_epi32(0x3FF)) };
+		Vertex.Tangent = XMVectorSetW(_mm_cvtepi32_ps(KTangent) * KInverseUNorm10Max * 2.0f - XMVectorSplatOne(), (Packed.Tangent >> 30) ? -1.0f : 1.0f);
+	}
+}
+
+static SVertexPackingError MeasureVertexPackingError(const std::vector<SVertex3D>& vVertices, const std::vector<SPackedVertex3D>& vPackedVertices,
+	const SPositionQuantization& Quantization)
+{
+	using namespace VertexPackingInternal;
+
+	assert(vVertices.size() == vPackedVertices.size());
+
+	std::vector<SVertex3D> vUnpackedVertices{};
+	UnpackVertices(vPackedVertices, Quantization, vUnpackedVertices);
+
+	SVertexPackingError Result{};
+	for (size_t iVertex = 0; iVertex < vVertices.size(); ++iVertex)
+	{
+		const SVertex3D& Original{ vVertices[iVertex] };
+		const SVertex3D& Unpacked{ vUnpackedVertices[iVertex] };
+
+		Result.Position = std::max(Result.Position, XMVectorGetX(XMVector3Length(Original.Position - Unpacked.Position)));
+		Result.NormalDegrees = std::max(Result.NormalDegrees, GetAngleDegrees(Original.Normal, Unpacked.Normal));
+		Result.TangentDegrees = std::max(Result.TangentDegrees, GetAngleDegrees(Original.Tangent, Unpacked.Tangent));
+		Result.TexCoord = std::max(Result.TexCoord,
+			XMVectorGetX(XMVector2Length(Original.TexCoord - Unpacked.TexCoord)));
+		Result.Color = std::max(Result.Color, XMVectorGetX(XMVector4Length(XMVectorSaturate(Original.Color) - Unpacked.Color)));
+	}
+	return Result;
+}
@@ -9,6 +9,35 @@ struct VS_INPUT
 	float4 Tangent		: TANGENT;
 };
 
+// See SPackedVertex3D (VertexPacking.h)
+struct VS_INPUT_PACKED
+{
+	float4 Position		: POSITION;	// unorm16, dequantized with cbVertexQuantization
+	float4 Color		: COLOR;	// unorm8
+	float2 TexCoord		: TEXCOORD;	// half
+	float2 Normal		: NORMAL;	// snorm16, octahedral
+	float4 Tangent		: TANGENT;	// unorm10 xyz, w = 1 if the bitangent is flipped
+};
+
+float3 DecodeOctahedral(float2 Encoded)
+{
+	float3 Result = float3(Encoded.xy, 1 - abs(Encoded.x) - abs(Encoded.y));
+	float T = saturate(-Result.z);
+	Result.xy += (Result.xy >= 0) ? -T : T;
+	return normalize(Result);
+}
+
+VS_INPUT DecodePackedVertex(VS_INPUT_PACKED Input, float3 PositionOffset, float3 PositionScale)
+{
+	VS_INPUT Output;
+	Output.Position = float4(PositionOffset + Input.Position.xyz * PositionScale, 1);
+	Output.Color = Input.Color;
+	Output.TexCoord = float3(Input.TexCoord, 0);
+	Output.Normal = float4(DecodeOctahedral(Input.Normal), 0);
+	Output.Tangent = float4(Input.Tangent.xyz * 2 - 1, (Input.Tangent.w > 0.5) ? -1 : 1);
+	return Output;
+}
+
 struct VS_OUTPUT
 {
 	float4	Position		: SV_POSITION;
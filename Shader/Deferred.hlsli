@@ -58,33 +58,45 @@ float3 ImportanceSampleGGX(float2 HammersleyPoint, float Roughness, float3 Norma
 	return CubeSpaceX * H.x + Normal * H.y + CubeSpaceZ * H.z;
 }
 
+// Keep the sampling functions below in sync with their CPU twins in Core/Sampling.h
+
+// Bits needed for the indices [0, SampleCount)
 uint GetHammersleyOrder(uint SampleCount)
 {
-	return (uint)log2((float)(SampleCount - 1)) + 1;
+	return firstbithigh(SampleCount - 1) + 1;
 }
 
 float GetHammersleyBase(uint Order)
 {
-	return pow(2.0f, -(float)Order);
+	return ldexp(1.0f, -(float)Order);
 }
 
+// (Seed / 2^Order, radical inverse of Seed / 2^Order)
 float2 Hammersley(uint Seed, uint SampleCount, uint Order, float Base)
 {
-	uint InvertedBits = 0;
-	uint ShiftStep = Order - 1;
-	while (true)
-	{
-		InvertedBits |=
-			((Seed & 0x1 << ((Order / 2 + (ShiftStep + 1) / 2) - 1)) >> ShiftStep) |
-			((Seed & 0x1 << (Order / 2 - (ShiftStep + 1) / 2)) << ShiftStep);
-
-		if (ShiftStep <= 1) break;
-
-		ShiftStep -= 2;
-	}
+	uint InvertedBits = reversebits(Seed) >> (32 - Order);
 
 	float X = Base * (float)Seed;
 	float Y = Base * (float)InvertedBits;
 
 	return float2(X, Y);
+}
+
+// First two Sobol dimensions (van der Corput and the (0, 2)-sequence of Kollig & Keller), with optional random digit scrambling
+float2 Sobol(uint Index, uint2 Scramble)
+{
+	uint X = reversebits(Index) ^ Scramble.x;
+	uint Y = Scramble.y;
+	for (uint Direction = 0x80000000; Index != 0; Index >>= 1)
+	{
+		if (Index & 1) Y ^= Direction;
+		Direction ^= Direction >> 1;
+	}
+	return float2((float)(X >> 8), (float)(Y >> 8)) * (1.0f / 16777216.0f);
+}
+
+// Jimenez, "Next Generation Post Processing in Call of Duty: Advanced Warfare", 2014
+float GetInterleavedGradientNoise(float2 Pixel)
+{
+	return frac(52.9829189f * frac(dot(float2(0.06711056f, 0.00583715f), Pixel)));
 }
\ No newline at end of file
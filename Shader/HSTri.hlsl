@@ -4,18 +4,54 @@ cbuffer cbTessFactor : register(b0)
 {
 	float EdgeTessFactor;
 	float InsideTessFactor;
-	float2 Pads;
+	// 0: the factors above on every patch, otherwise they are the maxima of the screen-space factors
+	float TargetEdgePixelLength;
+	float Pad;
+}
+
+cbuffer cbTessCamera : register(b1)
+{
+	float4x4 ViewProjection;
+	// (screen height / 2) / tan(FOV / 2)
+	float ProjectionScale;
+	float3 Pads;
+}
+
+// Keeps edges through or behind the eye finite; they get the largest factor
+static const float KMinEdgeDepth = 0.001;
+
+// The edge is measured as the diameter of a sphere around its midpoint, which depends on neither the order of its points nor the direction
+// it is seen from, so the two patches that share an edge compute the same factor and no cracks open between them.
+// See CObject3D::GetPatchTessFactors() for the CPU version.
+float GetScreenSpaceEdgeTessFactor(float3 P0, float3 P1)
+{
+	float3 Midpoint = (P0 + P1) * 0.5;
+	float Depth = max(mul(float4(Midpoint, 1), ViewProjection).w, KMinEdgeDepth);
+	float PixelLength = distance(P0, P1) * ProjectionScale / Depth;
+	return clamp(PixelLength / TargetEdgePixelLength, 1.0, EdgeTessFactor);
 }
 
 HS_CONSTANT_DATA_OUTPUT CalcHSPatchConstants(InputPatch<VS_OUTPUT, 3> ControlPoints, uint PatchID : SV_PrimitiveID)
 {
 	HS_CONSTANT_DATA_OUTPUT Output;
 
-	Output.EdgeTessFactor[0] = EdgeTessFactor;
-	Output.EdgeTessFactor[1] = EdgeTessFactor;
-	Output.EdgeTessFactor[2] = EdgeTessFactor;
+	if (TargetEdgePixelLength > 0)
+	{
+		// Edge i is opposite to control point i
+		Output.EdgeTessFactor[0] = GetScreenSpaceEdgeTessFactor(ControlPoints[1].WorldPosition.xyz, ControlPoints[2].WorldPosition.xyz);
+		Output.EdgeTessFactor[1] = GetScreenSpaceEdgeTessFactor(ControlPoints[2].WorldPosition.xyz, ControlPoints[0].WorldPosition.xyz);
+		Output.EdgeTessFactor[2] = GetScreenSpaceEdgeTessFactor(ControlPoints[0].WorldPosition.xyz, ControlPoints[1].WorldPosition.xyz);
+
+		Output.InsideTessFactor = min((Output.EdgeTessFactor[0] + Output.EdgeTessFactor[1] + Output.EdgeTessFactor[2]) / 3.0, InsideTessFactor);
+	}
+	else
+	{
+		Output.EdgeTessFactor[0] = EdgeTessFactor;
+		Output.EdgeTessFactor[1] = EdgeTessFactor;
+		Output.EdgeTessFactor[2] = EdgeTessFactor;
 
-	Output.InsideTessFactor = InsideTessFactor;
+		Output.InsideTessFactor = InsideTessFactor;
+	}
 
 	return Output;
 }
@@ -100,9 +100,10 @@ static float4 GetBezierNormal(float4 P1, float4 P2, float4 P3, float4 N1, float4
 	float4 n020 = N2;
 	float4 n002 = N3;
 
-	float4 h110 = N1 + N2 - GetBezierNormalV(P1, P2, N1, N2);
-	float4 h011 = N2 + N3 - GetBezierNormalV(P2, P3, N2, N3);
-	float4 h101 = N3 + N1 - GetBezierNormalV(P3, P1, N3, N1);
+	// The average normal reflected across the plane perpendicular to the edge; see GetPNTriangleEdgeNormal() in PNTriangle.h
+	float4 h110 = N1 + N2 - GetBezierNormalV(P1, P2, N1, N2) * (P2 - P1);
+	float4 h011 = N2 + N3 - GetBezierNormalV(P2, P3, N2, N3) * (P3 - P2);
+	float4 h101 = N3 + N1 - GetBezierNormalV(P3, P1, N3, N1) * (P1 - P3);
 	
 	float4 n110 = normalize(h110);
 	float4 n011 = normalize(h011);
@@ -7,6 +7,12 @@ cbuffer cbSpace : register(b0)
 	float4x4 WVP;
 }
 
+cbuffer cbVertexQuantization : register(b1)
+{
+	float4 PositionOffset;
+	float4 PositionScale;
+}
+
 VS_OUTPUT main(VS_INPUT Input)
 {
 	VS_OUTPUT Output;
@@ -20,6 +26,7 @@ VS_OUTPUT main(VS_INPUT Input)
 	float4 ResultNormal = normalize(mul(Input.Normal, World));
 	float4 ResultBitangent = normalize(float4(cross(ResultNormal.xyz, Input.Tangent.xyz), 0));
 	float4 ResultTangent = normalize(float4(cross(ResultBitangent.xyz, ResultNormal.xyz), 0));
+	ResultBitangent *= (Input.Tangent.w < 0) ? -1 : 1; // Bitangent sign, see CTangentGenerator
 	Output.WorldNormal = ResultNormal;
 	Output.WorldTangent = normalize(mul(ResultTangent, World));
 	Output.WorldBitangent = normalize(mul(ResultBitangent, World));
@@ -27,4 +34,9 @@ VS_OUTPUT main(VS_INPUT Input)
 	Output.bUseVertexColor = 0;
 
 	return Output;
+}
+
+VS_OUTPUT packed(VS_INPUT_PACKED Input)
+{
+	return main(DecodePackedVertex(Input, PositionOffset.xyz, PositionScale.xyz));
 }
\ No newline at end of file
@@ -19,7 +19,7 @@ VS_OUTPUT main(VS_INPUT input)
 	output.TexCoord = input.TexCoord;
 
 	output.WorldNormal = normalize(mul(input.Normal, World));
-	output.WorldTangent = normalize(mul(input.Tangent, World));
+	output.WorldTangent = normalize(mul(float4(input.Tangent.xyz, 0), World));
 	output.WorldBitangent = CalculateBitangent(output.WorldNormal, output.WorldTangent);
 
 	output.bUseVertexColor = 0;
@@ -19,7 +19,7 @@ VS_OUTPUT main(VS_INPUT input)
 	//output.TexCoord = normalize(input.Position.xyz); // dynamic TexCoord
 
 	output.WorldNormal = normalize(input.Normal);
-	output.WorldTangent = normalize(mul(input.Tangent, World));
+	output.WorldTangent = normalize(mul(float4(input.Tangent.xyz, 0), World));
 	output.WorldBitangent = CalculateBitangent(output.WorldNormal, output.WorldTangent);
 
 	output.bUseVertexColor = 0;
@@ -1,10 +1,24 @@
 #include "Core/Game.h"
+#include "Core/SelfTest.h"
 
 IMGUI_IMPL_API LRESULT  ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 LRESULT CALLBACK WndProc(_In_ HWND hWnd, _In_ UINT Msg, _In_ WPARAM wParam, _In_ LPARAM lParam);
 
 int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
 {
+	// Headless checks or benchmarks instead of the editor (see SelfTest.h), printed to the console that started the process
+	const bool KbIsTest{ strstr(lpCmdLine, "-test") != nullptr };
+	const bool KbIsBenchmark{ strstr(lpCmdLine, "-bench") != nullptr };
+	if (KbIsTest || KbIsBenchmark)
+	{
+		FILE* PtrOutput{};
+		if (AttachConsole(ATTACH_PARENT_PROCESS) || AllocConsole()) freopen_s(&PtrOutput, "CONOUT$", "w", stdout);
+		if (KbIsTest) return static_cast<int>(RunSelfTests(stdout));
+
+		RunBenchmarks(stdout);
+		return 0;
+	}
+
 	static constexpr XMFLOAT2 KGameWindowSize{ 1280.0f, 720.0f };
 	CGame Game{ hInstance, KGameWindowSize };
 